@@ -9,6 +9,9 @@
 #include <stdio.h>
 #include <HAL/HAL.h>
 #include <stdlib.h>
+#include "Words.h"
+#include "Screens.h"
+#include "Round.h"
 
 #define MAX_PLAYERS 4
 
@@ -31,19 +34,9 @@ bool added;
 typedef struct _Application Application;
 
 
-/* Enum to represent tilt state */
-enum accel_state {UP, NORMAL, DOWN};
-static enum accel_state my_state = NORMAL;
-
-/* Words to display */
-char* words[30] = {"elephant", "airplane", "guitar","Swimming","Balloon","Whisper","Robot","Spider","Dancing","Pirate","Fireworks","Chef","Lion","Sleeping","Rainbow","Doctor","Superhero","Fishing","Laughing","Astronaut","Washer","Dinosaur","Painting","Surfing","Clapping","Ghost","Bowling","Magician","Juggling","Campfire"};
-
 /* Function prototypes */
-void drawTitle(void);
-void drawAccelData(void);
-void displayWord(void);
-void displayScore(void);
-void displayTimeRemaining(void);
+bool drawAccelData(void);
+void followOrientation(uint8_t facing);
 void next_word(void);
 void reset_timer(void);
 void applicationLoop(Application *app, HAL *hal);
@@ -54,10 +47,6 @@ void handleGame(Application *app, HAL *hal);
 void handleSettings(Application *app, HAL *hal);
 void handleResults();
 void initialize();
-void drawInstructions();
-void drawGame();
-void drawSettings();
-void end_game();
 void handleScores();
 void initTimer();
 
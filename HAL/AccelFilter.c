@@ -0,0 +1,244 @@
+/*
+ * AccelFilter.c
+ *
+ *  Created on: Nov 30, 2024
+ */
+
+#include <HAL/AccelFilter.h>
+
+// The IIR's Q14 sum starts out rounding to nearest; after that, what each
+// shift drops is carried into the next sum
+#define IIR_ROUND   (ACCEL_FILTER_ALPHA_ONE / 2)
+#define IIR_CARRY   (ACCEL_FILTER_ALPHA_ONE - 1)
+
+//*****************************************************************************
+//
+// Two-lane arithmetic on words of two signed halfwords
+//
+//*****************************************************************************
+#if defined(__ARM_FEATURE_DSP) && __ARM_FEATURE_DSP
+
+// Puts the lower of each pair of halves in *a and the higher in *b. SSUB16
+// sets a GE flag per half where *a >= *b, and SEL picks by them.
+static inline void AccelFilter_sort2(uint32_t* a, uint32_t* b)
+{
+    uint32_t lo, hi;
+
+    (void) __SSUB16(*a, *b);
+    lo = __SEL(*b, *a);
+    hi = __SEL(*a, *b);
+    *a = lo;
+    *b = hi;
+}
+
+#define AccelFilter_add2(a, b)          __SADD16((a), (b))
+#define AccelFilter_dot2(a, b, acc)     ((int32_t) __SMLAD((a), (b), (acc)))
+
+#else
+
+static inline int32_t AccelFilter_lo(uint32_t w)
+{
+    return (int16_t) (w & 0xFFFF);
+}
+
+static inline int32_t AccelFilter_hi(uint32_t w)
+{
+    return (int16_t) (w >> 16);
+}
+
+static inline uint32_t AccelFilter_pack(int32_t lo, int32_t hi)
+{
+    return ((uint32_t) hi << 16) | ((uint32_t) lo & 0xFFFF);
+}
+
+static inline void AccelFilter_sort2(uint32_t* a, uint32_t* b)
+{
+    int32_t aLo = AccelFilter_lo(*a), bLo = AccelFilter_lo(*b);
+    int32_t aHi = AccelFilter_hi(*a), bHi = AccelFilter_hi(*b);
+
+    *a = AccelFilter_pack(aLo < bLo ? aLo : bLo, aHi < bHi ? aHi : bHi);
+    *b = AccelFilter_pack(aLo < bLo ? bLo : aLo, aHi < bHi ? bHi : aHi);
+}
+
+static inline uint32_t AccelFilter_add2(uint32_t a, uint32_t b)
+{
+    return AccelFilter_pack(AccelFilter_lo(a) + AccelFilter_lo(b),
+                            AccelFilter_hi(a) + AccelFilter_hi(b));
+}
+
+static inline int32_t AccelFilter_dot2(uint32_t a, uint32_t b, int32_t acc)
+{
+    return acc + AccelFilter_lo(a) * AccelFilter_lo(b)
+            + AccelFilter_hi(a) * AccelFilter_hi(b);
+}
+
+#endif
+
+void AccelFilter_init(AccelFilter* filter, const AccelFilterConfig* config)
+{
+    filter->config = *config;
+    if (filter->config.medianTaps > ACCEL_FILTER_MEDIAN_MAX)
+    {
+        filter->config.medianTaps = ACCEL_FILTER_MEDIAN_MAX;
+    }
+    filter->config.medianTaps |= 1;
+    if (filter->config.alpha == 0
+            || filter->config.alpha > ACCEL_FILTER_ALPHA_ONE)
+    {
+        filter->config.alpha = ACCEL_FILTER_ALPHA_ONE;
+    }
+    AccelFilter_reset(filter);
+}
+
+void AccelFilter_reset(AccelFilter* filter)
+{
+    filter->next = 0;
+    filter->primed = false;
+}
+
+// The first sample after a reset stands in for the whole history
+static void AccelFilter_prime(AccelFilter* filter, AccelSample in)
+{
+    uint32_t i;
+
+    for (i = 0; i < filter->config.medianTaps; i++)
+    {
+        filter->xy[i] = ((uint32_t) in.y << 16) | in.x;
+        filter->z[i] = in.z;
+    }
+    filter->next = 0;
+    filter->state[0] = (int16_t) (in.x * 2);
+    filter->state[1] = (int16_t) (in.y * 2);
+    filter->state[2] = (int16_t) (in.z * 2);
+    for (i = 0; i < ACCEL_RING_AXES; i++)
+    {
+        filter->carry[i] = IIR_ROUND;
+    }
+    filter->primed = true;
+}
+
+AccelSample AccelFilter_run(AccelFilter* filter, AccelSample in)
+{
+    const uint32_t taps = filter->config.medianTaps;
+    const uint32_t alpha = filter->config.alpha;
+    uint32_t xy[ACCEL_FILTER_MEDIAN_MAX], z[ACCEL_FILTER_MEDIAN_MAX];
+    uint32_t i, j, xy2, z2;
+    int32_t sum[ACCEL_RING_AXES];
+    AccelSample out;
+
+    if (!filter->primed)
+    {
+        AccelFilter_prime(filter, in);
+    }
+    filter->xy[filter->next] = ((uint32_t) in.y << 16) | in.x;
+    filter->z[filter->next] = in.z;
+    if (++filter->next == taps)
+    {
+        filter->next = 0;
+    }
+
+    // Selection: pass i leaves the i'th lowest in slot i, so after half the
+    // passes the middle slot holds the median, of each half on its own
+    for (i = 0; i < taps; i++)
+    {
+        xy[i] = filter->xy[i];
+        z[i] = filter->z[i];
+    }
+    for (i = 0; i <= taps / 2; i++)
+    {
+        for (j = i + 1; j < taps; j++)
+        {
+            AccelFilter_sort2(&xy[i], &xy[j]);
+            AccelFilter_sort2(&z[i], &z[j]);
+        }
+    }
+
+    // The median in Q1, X and Y at once, then per axis
+    //   state = (alpha * in + (ONE - alpha) * state + carry) / ONE
+    // as one dual multiply-accumulate of (in, state) by (alpha, ONE - alpha)
+    xy2 = AccelFilter_add2(xy[taps / 2], xy[taps / 2]);
+    z2 = AccelFilter_add2(z[taps / 2], z[taps / 2]);
+
+    sum[0] = AccelFilter_dot2(
+            (xy2 & 0xFFFF) | ((uint32_t) filter->state[0] << 16),
+            ((ACCEL_FILTER_ALPHA_ONE - alpha) << 16) | alpha, filter->carry[0]);
+    sum[1] = AccelFilter_dot2(
+            (xy2 & 0xFFFF0000) | (uint16_t) filter->state[1],
+            (alpha << 16) | (ACCEL_FILTER_ALPHA_ONE - alpha), filter->carry[1]);
+    sum[2] = AccelFilter_dot2(
+            (z2 & 0xFFFF) | ((uint32_t) filter->state[2] << 16),
+            ((ACCEL_FILTER_ALPHA_ONE - alpha) << 16) | alpha, filter->carry[2]);
+    for (i = 0; i < ACCEL_RING_AXES; i++)
+    {
+        filter->state[i] = (int16_t) (sum[i] >> 14);
+        filter->carry[i] = (uint16_t) (sum[i] & IIR_CARRY);
+    }
+
+    out.x = (uint16_t) ((filter->state[0] + 1) >> 1);
+    out.y = (uint16_t) ((filter->state[1] + 1) >> 1);
+    out.z = (uint16_t) ((filter->state[2] + 1) >> 1);
+    return out;
+}
+
+// Median of one axis' history, by insertion sort
+static int32_t AccelFilter_medianOf(const uint16_t* history, uint32_t taps)
+{
+    int32_t sorted[ACCEL_FILTER_MEDIAN_MAX];
+    uint32_t i, j;
+
+    for (i = 0; i < taps; i++)
+    {
+        int32_t v = history[i];
+
+        for (j = i; j > 0 && sorted[j - 1] > v; j--)
+        {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = v;
+    }
+    return sorted[taps / 2];
+}
+
+AccelSample AccelFilter_runReference(AccelFilter* filter, AccelSample in)
+{
+    const uint32_t taps = filter->config.medianTaps;
+    const int32_t alpha = filter->config.alpha;
+    uint16_t history[ACCEL_RING_AXES][ACCEL_FILTER_MEDIAN_MAX];
+    uint16_t result[ACCEL_RING_AXES];
+    uint32_t i, axis;
+    AccelSample out;
+
+    if (!filter->primed)
+    {
+        AccelFilter_prime(filter, in);
+    }
+    filter->xy[filter->next] = ((uint32_t) in.y << 16) | in.x;
+    filter->z[filter->next] = in.z;
+    if (++filter->next == taps)
+    {
+        filter->next = 0;
+    }
+
+    for (i = 0; i < taps; i++)
+    {
+        history[0][i] = (uint16_t) filter->xy[i];
+        history[1][i] = (uint16_t) (filter->xy[i] >> 16);
+        history[2][i] = (uint16_t) filter->z[i];
+    }
+    for (axis = 0; axis < ACCEL_RING_AXES; axis++)
+    {
+        int32_t median = AccelFilter_medianOf(history[axis], taps);
+        int32_t sum = alpha * (median * 2)
+                + (ACCEL_FILTER_ALPHA_ONE - alpha) * filter->state[axis]
+                + filter->carry[axis];
+
+        filter->state[axis] = (int16_t) (sum / ACCEL_FILTER_ALPHA_ONE);
+        filter->carry[axis] = (uint16_t) (sum % ACCEL_FILTER_ALPHA_ONE);
+        result[axis] = (uint16_t) ((filter->state[axis] + 1) >> 1);
+    }
+
+    out.x = result[0];
+    out.y = result[1];
+    out.z = result[2];
+    return out;
+}
@@ -0,0 +1,73 @@
+/*
+ * AccelFilter.h
+ *
+ *  Created on: Nov 30, 2024
+ *
+ * The accelerometer's filter stage: a median of the last few samples, which
+ * throws out single-sample spikes, then a first-order IIR low-pass, which
+ * smooths what is left.  Each axis is filtered on its own.
+ *
+ * Samples are 14-bit, so two fit a word as signed halfwords: X and Y share
+ * one, Z has one to itself.  AccelFilter_run() works on those with the
+ * Cortex-M4's SIMD instructions - __SSUB16 and __SEL for the median's
+ * compare-exchanges, on both halves at once, __SADD16 and __SMLAD for the
+ * IIR - where the compiler has them (__ARM_FEATURE_DSP), and with the same
+ * arithmetic in plain C where it does not.  AccelFilter_runReference() is
+ * the scalar definition both must match bit for bit; the host tools check
+ * them against it.
+ *
+ * The IIR keeps one fraction bit (its state is Q1) and carries what each
+ * step's shift drops into the next, so however small alpha is it settles
+ * on the input rather than short of it.
+ */
+
+#ifndef HAL_ACCELFILTER_H_
+#define HAL_ACCELFILTER_H_
+
+#include <HAL/AccelRing.h>
+
+// The IIR's alpha is Q14: ACCEL_FILTER_ALPHA_ONE takes each sample as is
+#define ACCEL_FILTER_ALPHA_ONE      16384
+#define ACCEL_FILTER_MEDIAN_MAX     7
+
+typedef struct
+{
+    // Weight of the new sample in the IIR, 1..ACCEL_FILTER_ALPHA_ONE. At
+    // sampleHz the cut-off is about alpha / ALPHA_ONE * sampleHz / 2pi.
+    uint16_t alpha;
+
+    // Samples the median is taken over: odd, 1..ACCEL_FILTER_MEDIAN_MAX. 1
+    // turns it off; each two more delay the output a sample.
+    uint8_t medianTaps;
+} AccelFilterConfig;
+
+typedef struct
+{
+    AccelFilterConfig config;
+
+    // The last medianTaps samples, X and Y packed as (y << 16) | x
+    uint32_t xy[ACCEL_FILTER_MEDIAN_MAX];
+    uint32_t z[ACCEL_FILTER_MEDIAN_MAX];
+    uint8_t next;
+
+    // The IIR's output, Q1, and the Q14 remainder its last step dropped, per
+    // axis; valid once primed
+    int16_t state[ACCEL_RING_AXES];
+    uint16_t carry[ACCEL_RING_AXES];
+    bool primed;
+} AccelFilter;
+
+// Sets the filter up with the given configuration, empty
+void AccelFilter_init(AccelFilter* filter, const AccelFilterConfig* config);
+
+// Forgets the samples so far. The next sample fills the median's history
+// and the IIR's state, so the output starts out at it.
+void AccelFilter_reset(AccelFilter* filter);
+
+// Filters one sample
+AccelSample AccelFilter_run(AccelFilter* filter, AccelSample in);
+
+// The same, a lane at a time and with a sort for the median
+AccelSample AccelFilter_runReference(AccelFilter* filter, AccelSample in);
+
+#endif /* HAL_ACCELFILTER_H_ */
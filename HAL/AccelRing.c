@@ -0,0 +1,155 @@
+/*
+ * AccelRing.c
+ *
+ *  Created on: Nov 29, 2024
+ */
+
+#include <HAL/AccelRing.h>
+#include <HAL/Timer.h>
+#include <HAL/LcdDriver/HAL_MSP_EXP432P401R_Crystalfontz128x128_ST7735.h>
+
+#if !LCD_USE_DMA
+#error "AccelRing uses the uDMA control table the LCD driver sets up"
+#endif
+
+#define ACLK_HZ 32768
+
+AccelRingStats g_accelRingStats;
+
+static AccelBlock ring[ACCEL_RING_BLOCKS];
+
+// Blocks completed since AccelRing_start(), and read by AccelRing_read().
+// The uDMA is filling block `written` and has block `written` + 1 armed, so
+// the reader may lag by up to ACCEL_RING_BLOCKS - 2.
+static volatile uint32_t written;
+static uint32_t readCount;
+
+static uint32_t periodCycles;
+
+// Points one control structure at the ring slot of block n
+static void AccelRing_arm(uint32_t structure, uint32_t n)
+{
+    DMA_setChannelTransfer(structure | ACCEL_RING_DMA_CHANNEL,
+                           UDMA_MODE_PINGPONG, (void *) &ADC14->MEM[0],
+                           ring[n % ACCEL_RING_BLOCKS].samples,
+                           ACCEL_RING_MEMS);
+}
+
+void AccelRing_init(void)
+{
+    const uint32_t control = UDMA_SIZE_16 | UDMA_SRC_INC_32 | UDMA_DST_INC_16
+            | UDMA_ARB_32;
+
+    DMA_assignChannel(ACCEL_RING_DMA_CHANNEL);
+    DMA_disableChannelAttribute(ACCEL_RING_DMA_CHANNEL,
+                                UDMA_ATTR_ALTSELECT | UDMA_ATTR_USEBURST |
+                                UDMA_ATTR_HIGH_PRIORITY | UDMA_ATTR_REQMASK);
+
+    // Each request moves the whole sequence: the low half of each 32-bit
+    // conversion memory into the next AccelSample field
+    DMA_setChannelControl(UDMA_PRI_SELECT | ACCEL_RING_DMA_CHANNEL, control);
+    DMA_setChannelControl(UDMA_ALT_SELECT | ACCEL_RING_DMA_CHANNEL, control);
+
+    DMA_assignInterrupt(ACCEL_RING_DMA_INT, ACCEL_RING_DMA_CHANNEL_NUM);
+    DMA_clearInterruptFlag(ACCEL_RING_DMA_CHANNEL_NUM);
+    Interrupt_enableInterrupt(ACCEL_RING_DMA_INT_NUM);
+}
+
+void AccelRing_start(uint32_t periodAclk)
+{
+    AccelRing_stop();
+
+    written = 0;
+    readCount = 0;
+    periodCycles = (uint32_t) ((uint64_t) periodAclk * SYSTEM_CLOCK / ACLK_HZ);
+
+    // Primary first, then alternate, then primary again...
+    DMA_disableChannelAttribute(ACCEL_RING_DMA_CHANNEL, UDMA_ATTR_ALTSELECT);
+    AccelRing_arm(UDMA_PRI_SELECT, 0);
+    AccelRing_arm(UDMA_ALT_SELECT, 1);
+    DMA_clearInterruptFlag(ACCEL_RING_DMA_CHANNEL_NUM);
+    DMA_enableChannel(ACCEL_RING_DMA_CHANNEL_NUM);
+}
+
+void AccelRing_stop(void)
+{
+    DMA_disableChannel(ACCEL_RING_DMA_CHANNEL_NUM);
+}
+
+void AccelRing_pause(void)
+{
+    DMA_disableChannel(ACCEL_RING_DMA_CHANNEL_NUM);
+}
+
+// The structure for block `written` is still armed and selected, and the
+// other for the one after, so the channel carries on where it stopped. The
+// ADC asks for the uDMA once as each sequence ends, so none that ended
+// while paused is copied, and the next is copied whole.
+void AccelRing_resume(void)
+{
+    DMA_enableChannel(ACCEL_RING_DMA_CHANNEL_NUM);
+}
+
+bool AccelRing_read(AccelBlock* block)
+{
+    for (;;)
+    {
+        uint32_t available = written - readCount;
+
+        if (!available)
+        {
+            return false;
+        }
+        if (available > ACCEL_RING_BLOCKS - 2)
+        {
+            g_accelRingStats.dropped += available - (ACCEL_RING_BLOCKS - 2);
+            readCount = written - (ACCEL_RING_BLOCKS - 2);
+        }
+
+        *block = ring[readCount % ACCEL_RING_BLOCKS];
+
+        // The copy is only good if the uDMA did not come round to it
+        // meanwhile
+        if (written - readCount <= ACCEL_RING_BLOCKS - 2)
+        {
+            readCount++;
+            return true;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// uDMA completion interrupt for the ADC channel: a control structure has
+// filled its block, and the other has taken over. The finished one is
+// stamped and pointed two blocks on. If the interrupt was held off long
+// enough for both to finish, the flag was only raised once, so the finished
+// structures are found by their mode rather than counted.
+//
+//*****************************************************************************
+void DMA_INT2_IRQHandler(void)
+{
+    uint32_t n = written;
+
+    DMA_clearInterruptFlag(ACCEL_RING_DMA_CHANNEL_NUM);
+
+    for (;;)
+    {
+        uint32_t structure = (n % 2) ? UDMA_ALT_SELECT : UDMA_PRI_SELECT;
+        AccelBlock* block = &ring[n % ACCEL_RING_BLOCKS];
+
+        if (DMA_getChannelMode(structure | ACCEL_RING_DMA_CHANNEL)
+                != UDMA_MODE_STOP)
+        {
+            break;
+        }
+
+        block->endCycles = Clock_now();
+        block->periodCycles = periodCycles;
+        block->sequence = n;
+
+        AccelRing_arm(structure, n + 2);
+        written = ++n;
+        g_accelRingStats.blocks++;
+    }
+}
@@ -0,0 +1,96 @@
+/*
+ * AccelRing.h
+ *
+ *  Created on: Nov 29, 2024
+ *
+ * Accelerometer capture.  The ADC's sequence holds ACCEL_RING_BLOCK samples
+ * of X, Y and Z, in MEM0..MEM(ACCEL_RING_MEMS - 1), and the uDMA copies the
+ * whole sequence into a ring of blocks when it ends.  The uDMA runs in
+ * ping-pong mode: while one control structure fills a block, the other is
+ * set up for the next, so no sample is missed between blocks and the CPU
+ * only takes one interrupt a block.  The interrupt stamps the block with
+ * Clock_now() and points the structure that finished two blocks on.
+ *
+ * AccelRing_read() hands the main loop whole blocks, oldest first.  A block
+ * is never written while it is being read; if the main loop falls so far
+ * behind that the uDMA comes round to blocks it has not read, those are
+ * dropped and counted.
+ *
+ * The Sampler starts and stops the capture with the sampling.  While the
+ * round is quiet the game pauses it and sleeps through the samples, the
+ * ADC's window comparators watching them instead (see main.c).
+ */
+
+#ifndef HAL_ACCELRING_H_
+#define HAL_ACCELRING_H_
+
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+
+#define ACCEL_RING_AXES         3   // X, Y, Z
+#define ACCEL_RING_BLOCK        8   // samples per ADC sequence and uDMA block
+#define ACCEL_RING_BLOCKS       8   // blocks in the ring
+#define ACCEL_RING_MEMS         (ACCEL_RING_AXES * ACCEL_RING_BLOCK)
+
+#if ACCEL_RING_MEMS > 32
+#error "A block must fit in the ADC's 32 conversion memories"
+#endif
+
+// The ADC's uDMA trigger, on channel 7, and the completion interrupt
+#define ACCEL_RING_DMA_CHANNEL      DMA_CH7_ADC14
+#define ACCEL_RING_DMA_CHANNEL_NUM  7
+#define ACCEL_RING_DMA_INT          DMA_INT2
+#define ACCEL_RING_DMA_INT_NUM      INT_DMA_INT2
+
+// One sample, as the uDMA lays it down: the low halves of three conversion
+// memories
+typedef struct
+{
+    uint16_t x;
+    uint16_t y;
+    uint16_t z;
+} AccelSample;
+
+typedef struct
+{
+    AccelSample samples[ACCEL_RING_BLOCK];
+
+    // Clock_now() when the block's last sample was copied, and the clock
+    // cycles between samples: sample i was taken about
+    // endCycles - (ACCEL_RING_BLOCK - 1 - i) * periodCycles
+    uint64_t endCycles;
+    uint32_t periodCycles;
+
+    // Blocks captured before this one since AccelRing_start()
+    uint32_t sequence;
+} AccelBlock;
+
+typedef struct
+{
+    uint32_t blocks;        // captured
+    uint32_t dropped;       // overwritten before they were read
+} AccelRingStats;
+
+extern AccelRingStats g_accelRingStats;
+
+// Sets up the uDMA channel and its interrupt. The uDMA itself, and its
+// control table, must already be set up by the LCD driver.
+void AccelRing_init(void);
+
+// Empties the ring and arms both control structures, for samples
+// periodAclk ACLK cycles apart. The ADC's sequence must start from MEM0.
+void AccelRing_start(uint32_t periodAclk);
+
+// Disables the channel. The block being filled is lost.
+void AccelRing_stop(void);
+
+// Pauses and resumes the capture, keeping the ring and its count: the
+// sequences that end while it is paused are not copied, and the first block
+// after AccelRing_resume() is the next sequence to end.  Its endCycles shows
+// the gap. Both are safe to call from an ISR.
+void AccelRing_pause(void);
+void AccelRing_resume(void);
+
+// Copies out the oldest block not yet read. Returns false if there is none.
+bool AccelRing_read(AccelBlock* block);
+
+#endif /* HAL_ACCELRING_H_ */
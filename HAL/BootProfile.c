@@ -0,0 +1,33 @@
+/*
+ * BootProfile.c
+ *
+ *  Created on: Nov 24, 2024
+ */
+
+#include <HAL/BootProfile.h>
+
+BootProfile g_bootProfile;
+
+// Cycle count at the start of the current phase
+static uint32_t phaseStart;
+
+void BootProfile_start(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    phaseStart = 0;
+}
+
+void BootProfile_mark(BootPhase phase)
+{
+    uint32_t now = DWT->CYCCNT;
+    uint32_t cyclesPerUs = MAP_CS_getMCLK() / 1000000;
+
+    g_bootProfile.cycles[phase] = now - phaseStart;
+    g_bootProfile.microseconds[phase] = (now - phaseStart) / cyclesPerUs;
+    g_bootProfile.totalMicroseconds += g_bootProfile.microseconds[phase];
+
+    phaseStart = now;
+}
@@ -0,0 +1,53 @@
+/*
+ * BootProfile.h
+ *
+ *  Created on: Nov 24, 2024
+ *
+ * Boot timing report.  Each phase of start-up is timed on the DWT cycle
+ * counter, from BootProfile_start() to the first title screen.  The results
+ * are kept in g_bootProfile; read them from the debugger (add g_bootProfile
+ * to the Expressions view) after the title screen appears.
+ */
+
+#ifndef HAL_BOOTPROFILE_H_
+#define HAL_BOOTPROFILE_H_
+
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+
+typedef enum
+{
+    BOOT_CLOCKS,        // core voltage, flash wait states, clock system
+    BOOT_LCD_START,     // LCD port, SPI and uDMA; power-up sequence started
+    BOOT_ADC,           // accelerometer pins and ADC
+    BOOT_TIMERS,        // Timer32, TimerWheel tick
+    BOOT_BUTTONS,       // button GPIO
+    BOOT_LCD_WAIT,      // waiting out what is left of the LCD power-up
+    BOOT_GRAPHICS,      // orientation, framebuffer, graphics context, fonts
+    BOOT_HAL,           // HAL_construct()
+    BOOT_TITLE,         // first title screen drawn and flushed
+    BOOT_PHASES
+} BootPhase;
+
+typedef struct
+{
+    // Length of each phase, in cycles and in microseconds at the clock the
+    // phase ended with
+    uint32_t cycles[BOOT_PHASES];
+    uint32_t microseconds[BOOT_PHASES];
+
+    // From BootProfile_start() to the end of the last phase marked
+    uint32_t totalMicroseconds;
+
+    // Calls to Crystalfontz128x128_PollInit() during BOOT_LCD_WAIT
+    uint32_t lcdPolls;
+} BootProfile;
+
+extern BootProfile g_bootProfile;
+
+// Starts the cycle counter and the first phase
+void BootProfile_start(void);
+
+// Ends the given phase; the next one starts now
+void BootProfile_mark(BootPhase phase);
+
+#endif /* HAL_BOOTPROFILE_H_ */
@@ -11,21 +11,86 @@
 
 #include "HAL/LED.h"
 #include "HAL/Timer.h"
-
-// A boolean variable that is true when a high-to-low transition is sensed on
-// JSB For a global variable, the keyword static limits the scope of the
-// variable to this function only. This means functions in other files of the
-// project cannot access this variable
-volatile static bool JSBmodified;
-volatile static bool BB1modified;
-volatile static bool BB2modified;
-
-volatile static bool LB1modified;
-volatile static bool LB2modified;
+#include "HAL/Idle.h"
 
 // 500 ms debouncing wait
 #define DEBOUNCE_WAIT 500
 
+// The debouncing state of a button whose taps are sensed by a high-to-low
+// interrupt. The port ISR reports a tap on the first transition and then
+// ignores the button until the window timer runs out, so no one has to poll
+// a timer to leave the debouncing state.
+typedef struct {
+    // True when a tap has been sensed that the XXtapped() function has not
+    // returned yet
+    volatile bool tapped;
+
+    // True while the extra transitions are being ignored
+    volatile bool debouncing;
+
+    // Ends the debouncing state DEBOUNCE_WAIT ms after the tap
+    TimerWheel_Timer window;
+} Debouncer;
+
+// For a global variable, the keyword static limits the scope of the variable
+// to this file only. This means functions in other files of the project
+// cannot access these variables
+static Debouncer JSBdebouncer;
+static Debouncer BB1debouncer;
+static Debouncer BB2debouncer;
+
+static Debouncer LB1debouncer;
+static Debouncer LB2debouncer;
+
+// Window timer callback, run from the TimerWheel ISR: the wait is over, so
+// the next transition is a new tap
+static void endDebounce(void *context)
+{
+    Debouncer *debouncer = context;
+    debouncer->debouncing = false;
+}
+
+static void initDebouncer(Debouncer *debouncer)
+{
+    TimerWheel_cancel(&debouncer->window);
+    debouncer->tapped = false;
+    debouncer->debouncing = false;
+    debouncer->window = TimerWheel_construct(endDebounce, debouncer);
+}
+
+// Called by the port ISRs on a high-to-low transition
+static void debounceTransition(Debouncer *debouncer)
+{
+    if (!debouncer->debouncing)
+    {
+        // We are not in debouncing and the first transition is detected
+        debouncer->tapped = true;
+
+        // Let's enter debouncing state until the window timer fires
+        debouncer->debouncing = true;
+        TimerWheel_start(&debouncer->window,
+                         TimerWheel_msToTicks(DEBOUNCE_WAIT), 0);
+    }
+}
+
+// Returns whether a tap has been sensed since the last call. This is a very
+// critical step similar to clearing interrupt flag: the tap is consumed, so
+// next time we enter this function we don't think a new one has happened.
+// Interrupts are masked so that a tap sensed between the read and the clear
+// is not lost.
+static bool takeTap(Debouncer *debouncer)
+{
+    bool wasMasked = Interrupt_disableMaster();
+    bool tapped = debouncer->tapped;
+
+    debouncer->tapped = false;
+    if (!wasMasked)
+    {
+        Interrupt_enableMaster();
+    }
+    return tapped;
+}
+
 // An internal function that initializes a button and enables the high-to-low
 // transition
 void initButton(uint_fast8_t selectedPort, uint_fast16_t selectedPins)
@@ -61,12 +126,12 @@ void initButtons()
     Interrupt_enableInterrupt(INT_PORT3);
 
     // This allows us to start from a clean slate
-    JSBmodified = false;
-    BB1modified = false;
-    BB2modified = false;
+    initDebouncer(&JSBdebouncer);
+    initDebouncer(&BB1debouncer);
+    initDebouncer(&BB2debouncer);
 
-    LB1modified = false;
-    LB2modified = false;
+    initDebouncer(&LB1debouncer);
+    initDebouncer(&LB2debouncer);
 
 }
 
@@ -75,7 +140,7 @@ void PORT4_IRQHandler()
     // We check to see if the port4 interrupt came from JSB
     if (GPIO_getInterruptStatus(GPIO_PORT_P4, GPIO_PIN1))
     {
-        JSBmodified = true;
+        debounceTransition(&JSBdebouncer);
 
         // A very critical step: If we don't clear the interrupt, the ISR will be
         // called again and again.
@@ -88,7 +153,7 @@ void PORT3_IRQHandler()
     // We check to see if the port4 interrupt came from BB2
     if (GPIO_getInterruptStatus(GPIO_PORT_P3, GPIO_PIN5))
     {
-        BB2modified = true;
+        debounceTransition(&BB2debouncer);
 
         // A very critical step: If we don't clear the interrupt, the ISR will be
         // called again and again.
@@ -101,7 +166,7 @@ void PORT5_IRQHandler()
     // We check to see if the port4 interrupt came from BB1
     if (GPIO_getInterruptStatus(GPIO_PORT_P5, GPIO_PIN1))
     {
-        BB1modified = true;
+        debounceTransition(&BB1debouncer);
 
         // A very critical step: If we don't clear the interrupt, the ISR will be
         // called again and again.
@@ -114,7 +179,7 @@ void PORT1_IRQHandler()
     // We check to see if the port4 interrupt came from LB1
     if (GPIO_getInterruptStatus(GPIO_PORT_P1, GPIO_PIN1))
     {
-        LB1modified = true;
+        debounceTransition(&LB1debouncer);
 
         // A very critical step: If we don't clear the interrupt, the ISR will be
         // called again and again.
@@ -123,7 +188,7 @@ void PORT1_IRQHandler()
     // We check to see if the port4 interrupt came from LB2
     else if (GPIO_getInterruptStatus(GPIO_PORT_P1, GPIO_PIN4))
     {
-        LB2modified = true;
+        debounceTransition(&LB2debouncer);
 
         // A very critical step: If we don't clear the interrupt, the ISR will be
         // called again and again.
@@ -133,205 +198,27 @@ void PORT1_IRQHandler()
 
 bool JSBtapped()
 {
-    // This variable is true if we are in debouncing state (we are ignoring the
-    // extra transitions) This variable has to be static so that it "remembers"
-    static bool debouncing = false;
-
-    // The SW timer used for debouncing. It has to be static, otherwise it won't
-    // work.
-    static SWTimer debounceTimer;
-
-    // the single output of the FMS
-    bool tapped = false;
-
-    // If we are in debouncing state and the debouncing timer is expired, in other
-    // words, if wait time is over, we should leave the debouncing state.
-    if (debouncing && SWTimer_expired(&debounceTimer))
-        debouncing = false;
-
-    // if we are not in the debouncing state and a transition is detected
-    if (!debouncing && JSBmodified)
-    {
-        // We are not in debouncing and the first transition is detected
-        tapped = true;
-
-        // Let's enter debouncing state
-        debouncing = true;
-
-        // We should setup a timer for how much to wait
-        debounceTimer = SWTimer_construct(DEBOUNCE_WAIT);
-        SWTimer_start(&debounceTimer);
-    }
-
-    // This is a very critical step similar to clearing interrupt flag.
-    // If we don't refresh this variable, next time we enter this function, we
-    // think a new transition has happened.
-    JSBmodified = false;
-
-    return tapped;
+    return takeTap(&JSBdebouncer);
 }
 
-
 bool BB1tapped()
 {
-    // This variable is true if we are in debouncing state (we are ignoring the
-    // extra transitions) This variable has to be static so that it "remembers"
-    static bool debouncing = false;
-
-    // The SW timer used for debouncing. It has to be static, otherwise it won't
-    // work.
-    static SWTimer debounceTimer;
-
-    // the single output of the FMS
-    bool tapped = false;
-
-    // If we are in debouncing state and the debouncing timer is expired, in other
-    // words, if wait time is over, we should leave the debouncing state.
-    if (debouncing && SWTimer_expired(&debounceTimer))
-        debouncing = false;
-
-    // if we are not in the debouncing state and a transition is detected
-    if (!debouncing && BB1modified)
-    {
-        // We are not in debouncing and the first transition is detected
-        tapped = true;
-
-        // Let's enter debouncing state
-        debouncing = true;
-
-        // We should setup a timer for how much to wait
-        debounceTimer = SWTimer_construct(DEBOUNCE_WAIT);
-        SWTimer_start(&debounceTimer);
-    }
-
-    // This is a very critical step similar to clearing interrupt flag.
-    // If we don't refresh this variable, next time we enter this function, we
-    // think a new transition has happened.
-    BB1modified = false;
-
-    return tapped;
+    return takeTap(&BB1debouncer);
 }
 
 bool BB2tapped()
 {
-    // This variable is true if we are in debouncing state (we are ignoring the
-    // extra transitions) This variable has to be static so that it "remembers"
-    static bool debouncing = false;
-
-    // The SW timer used for debouncing. It has to be static, otherwise it won't
-    // work.
-    static SWTimer debounceTimer;
-
-    // the single output of the FMS
-    bool tapped = false;
-
-bool b2mod = BB2modified;
-bool timerExpired = SWTimer_expired(&debounceTimer);
-    // If we are in debouncing state and the debouncing timer is expired, in other
-    // words, if wait time is over, we should leave the debouncing state.
-    if (debouncing && timerExpired)
-        debouncing = false;
-
-    // if we are not in the debouncing state and a transition is detected
-    if (!debouncing && BB2modified)
-    {
-        // We are not in debouncing and the first transition is detected
-        tapped = true;
-
-        // Let's enter debouncing state
-        debouncing = true;
-
-        // We should setup a timer for how much to wait
-        debounceTimer = SWTimer_construct(DEBOUNCE_WAIT);
-        SWTimer_start(&debounceTimer);
-    }
-
-    // This is a very critical step similar to clearing interrupt flag.
-    // If we don't refresh this variable, next time we enter this function, we
-    // think a new transition has happened.
-    BB2modified = false;
-
-    return tapped;
+    return takeTap(&BB2debouncer);
 }
 
 bool LB1tapped()
 {
-    // This variable is true if we are in debouncing state (we are ignoring the
-    // extra transitions) This variable has to be static so that it "remembers"
-    static bool debouncing = false;
-
-    // The SW timer used for debouncing. It has to be static, otherwise it won't
-    // work.
-    static SWTimer debounceTimer;
-
-    // the single output of the FMS
-    bool tapped = false;
-
-    // If we are in debouncing state and the debouncing timer is expired, in other
-    // words, if wait time is over, we should leave the debouncing state.
-    if (debouncing && SWTimer_expired(&debounceTimer))
-        debouncing = false;
-
-    // if we are not in the debouncing state and a transition is detected
-    if (!debouncing && LB1modified)
-    {
-        // We are not in debouncing and the first transition is detected
-        tapped = true;
-
-        // Let's enter debouncing state
-        debouncing = true;
-
-        // We should setup a timer for how much to wait
-        debounceTimer = SWTimer_construct(DEBOUNCE_WAIT);
-        SWTimer_start(&debounceTimer);
-    }
-
-    // This is a very critical step similar to clearing interrupt flag.
-    // If we don't refresh this variable, next time we enter this function, we
-    // think a new transition has happened.
-    LB1modified = false;
-
-    return tapped;
+    return takeTap(&LB1debouncer);
 }
 
 bool LB2tapped()
 {
-    // This variable is true if we are in debouncing state (we are ignoring the
-    // extra transitions) This variable has to be static so that it "remembers"
-    static bool debouncing = false;
-
-    // The SW timer used for debouncing. It has to be static, otherwise it won't
-    // work.
-    static SWTimer debounceTimer;
-
-    // the single output of the FMS
-    bool tapped = false;
-
-    // If we are in debouncing state and the debouncing timer is expired, in other
-    // words, if wait time is over, we should leave the debouncing state.
-    if (debouncing && SWTimer_expired(&debounceTimer))
-        debouncing = false;
-
-    // if we are not in the debouncing state and a transition is detected
-    if (!debouncing && LB2modified)
-    {
-        // We are not in debouncing and the first transition is detected
-        tapped = true;
-
-        // Let's enter debouncing state
-        debouncing = true;
-
-        // We should setup a timer for how much to wait
-        debounceTimer = SWTimer_construct(DEBOUNCE_WAIT);
-        SWTimer_start(&debounceTimer);
-    }
-
-    // This is a very critical step similar to clearing interrupt flag.
-    // If we don't refresh this variable, next time we enter this function, we
-    // think a new transition has happened.
-    LB2modified = false;
-
-    return tapped;
+    return takeTap(&LB2debouncer);
 }
 
 // This function calls all the functions that check button status and stores
@@ -352,6 +239,31 @@ buttons_t updateButtons()
     return (buttons);
 }
 
+// The Buttons whose FSM is in a transition state, waiting on its SWTimer.
+// Timer32 stops in LPM3, so while any is the CPU is held out of it.
+static uint8_t buttonsTiming;
+
+// Starts the button's timer and enters a transition state
+static void Button_startTransition(Button *button, DebounceState state)
+{
+    SWTimer_start(&button->timer);
+    button->debounceState = state;
+    if (buttonsTiming++ == 0)
+    {
+        Idle_hold(IDLE_HOLD_CLOCK);
+    }
+}
+
+// Leaves a transition state for a stable one
+static void Button_endTransition(Button *button, DebounceState state)
+{
+    button->debounceState = state;
+    if (--buttonsTiming == 0)
+    {
+        Idle_release(IDLE_HOLD_CLOCK);
+    }
+}
+
 /**
  * Constructs a button as a GPIO pushbutton, given a proper port and pin.
  * Initializes the debouncing and output FSMs.
@@ -443,8 +355,7 @@ void Button_refresh(Button *button)
     case StableR:
         if (rawButtonStatus == PRESSED)
         {
-            SWTimer_start(&button->timer);
-            button->debounceState = TransitionRP;
+            Button_startTransition(button, TransitionRP);
         }
         newPushState = RELEASED;
         break;
@@ -453,8 +364,7 @@ void Button_refresh(Button *button)
     case StableP:
         if (rawButtonStatus == RELEASED)
         {
-            SWTimer_start(&button->timer);
-            button->debounceState = TransitionPR;
+            Button_startTransition(button, TransitionPR);
         }
         newPushState = PRESSED;
         break;
@@ -465,11 +375,11 @@ void Button_refresh(Button *button)
     case TransitionRP:
         if (rawButtonStatus == RELEASED)
         {
-            button->debounceState = StableR;
+            Button_endTransition(button, StableR);
         }
         else if (SWTimer_expired(&button->timer))
         {
-            button->debounceState = StableP;
+            Button_endTransition(button, StableP);
         }
         newPushState = RELEASED;
         break;
@@ -480,11 +390,11 @@ void Button_refresh(Button *button)
     case TransitionPR:
         if (rawButtonStatus == PRESSED)
         {
-            button->debounceState = StableP;
+            Button_endTransition(button, StableP);
         }
         else if (SWTimer_expired(&button->timer))
         {
-            button->debounceState = StableR;
+            Button_endTransition(button, StableR);
         }
         newPushState = PRESSED;
     }
@@ -0,0 +1,399 @@
+/*
+ * FontAtlas.c
+ *
+ *  Created on: Nov 22, 2024
+ */
+
+#include <HAL/FontAtlas.h>
+#include <HAL/LcdDriver/Crystalfontz128x128_ST7735.h>
+#include <string.h>
+
+// grlib fonts hold glyphs for the printable ASCII range; anything else is
+// drawn as a space
+#define FONT_ATLAS_FIRST        32
+#define FONT_ATLAS_LAST         126
+#define FONT_ATLAS_GLYPHS       (FONT_ATLAS_LAST - FONT_ATLAS_FIRST + 1)
+#define FONT_ATLAS_ABSENT       ' '
+
+// Bytes per row of the line bitmap: one bit per screen column
+#define FONT_ATLAS_LINE_STRIDE  (LCD_HORIZONTAL_MAX / 8)
+
+typedef struct
+{
+    const Graphics_Font *font;
+
+    // Bytes per decoded glyph row, enough for font->maxWidth pixels
+    uint8_t stride;
+
+    // Pool offset of each decoded glyph plus one; 0 until first used
+    uint16_t slot[FONT_ATLAS_GLYPHS];
+} FontAtlas_Entry;
+
+static FontAtlas_Entry atlasFonts[FONT_ATLAS_FONTS];
+static uint8_t atlasPool[FONT_ATLAS_POOL_SIZE];
+static uint16_t atlasPoolUsed;
+
+// Glyph decoded outside the pool once it is full
+static uint8_t atlasScratch[FONT_ATLAS_MAX_HEIGHT * FONT_ATLAS_MAX_WIDTH / 8];
+
+// String being composed, one row per font row, bit per screen column
+static uint8_t atlasLine[FONT_ATLAS_MAX_HEIGHT][FONT_ATLAS_LINE_STRIDE];
+
+/**
+ * Returns the atlas entry for font, claiming a free one the first time the
+ * font is seen.  Returns NULL for fonts the atlas cannot hold.
+ */
+static FontAtlas_Entry *FontAtlas_find(const Graphics_Font *font)
+{
+    int i;
+
+    if ((font->format != FONT_FMT_UNCOMPRESSED &&
+         font->format != FONT_FMT_PIXEL_RLE) ||
+        font->height > FONT_ATLAS_MAX_HEIGHT ||
+        font->maxWidth > FONT_ATLAS_MAX_WIDTH)
+    {
+        return NULL;
+    }
+
+    for (i = 0; i < FONT_ATLAS_FONTS; i++)
+    {
+        if (atlasFonts[i].font == font)
+        {
+            return &atlasFonts[i];
+        }
+        if (atlasFonts[i].font == NULL)
+        {
+            atlasFonts[i].font = font;
+            atlasFonts[i].stride = (font->maxWidth + 7) / 8;
+            return &atlasFonts[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Returns the glyph index of c within the font, substituting the absent
+ * character for anything outside the printable range.
+ */
+static uint8_t FontAtlas_glyphIndex(char c)
+{
+    uint8_t index = (uint8_t) c;
+
+    if ((index < FONT_ATLAS_FIRST) || (index > FONT_ATLAS_LAST))
+    {
+        index = FONT_ATLAS_ABSENT;
+    }
+
+    return index - FONT_ATLAS_FIRST;
+}
+
+/**
+ * Returns the grlib glyph record for c: data[0] is its size in bytes, data[1]
+ * its width in pixels, and the encoded image starts at data[2].
+ */
+static const uint8_t *FontAtlas_glyphData(const Graphics_Font *font, char c)
+{
+    return font->data + font->offset[FontAtlas_glyphIndex(c)];
+}
+
+/**
+ * Decodes one glyph into glyph, stride bytes per row and font->height rows,
+ * set bits being foreground.  Follows the walk Graphics_drawString() makes
+ * over the same data, so the pixels come out identical.
+ */
+static void FontAtlas_decode(const Graphics_Font *font, const uint8_t *data,
+                             uint8_t *glyph, uint8_t stride)
+{
+    uint16_t idx = 2, off, on;
+    uint8_t bit = 0, width = data[1];
+    int16_t x = 0, y = 0;
+
+    memset(glyph, 0, stride * font->height);
+
+    if (width == 0)
+    {
+        return;
+    }
+
+    while ((idx < data[0]) && (y < font->height))
+    {
+        if (font->format == FONT_FMT_UNCOMPRESSED)
+        {
+            // A plain bit stream, width bits per row with no row padding
+            for (off = 0; idx < data[0]; off++)
+            {
+                if ((data[idx] >> (7 - bit)) & 1)
+                {
+                    break;
+                }
+                if (++bit == 8)
+                {
+                    bit = 0;
+                    idx++;
+                }
+            }
+            for (on = 0; idx < data[0]; on++)
+            {
+                if (!((data[idx] >> (7 - bit)) & 1))
+                {
+                    break;
+                }
+                if (++bit == 8)
+                {
+                    bit = 0;
+                    idx++;
+                }
+            }
+        }
+        else if (data[idx])
+        {
+            // Off count in the upper nibble, on count in the lower one
+            off = data[idx] >> 4;
+            on = data[idx] & 15;
+            idx++;
+        }
+        else if (data[idx + 1] & 0x80)
+        {
+            // Escape: a long run of on pixels, in units of 8
+            off = 0;
+            on = (data[idx + 1] & 0x7f) * 8;
+            idx += 2;
+        }
+        else
+        {
+            // Escape: a long run of off pixels, in units of 8
+            off = data[idx + 1] * 8;
+            on = 0;
+            idx += 2;
+        }
+
+        x += off;
+        while (x >= width)
+        {
+            x -= width;
+            y++;
+        }
+
+        while (on-- && (y < font->height))
+        {
+            if (x < stride * 8)
+            {
+                glyph[y * stride + (x >> 3)] |= 0x80 >> (x & 7);
+            }
+            if (++x == width)
+            {
+                x = 0;
+                y++;
+            }
+        }
+    }
+}
+
+/**
+ * Returns the decoded image of c, decoding it into the pool on first use.
+ * width receives the glyph's advance in pixels.
+ */
+static const uint8_t *FontAtlas_glyph(FontAtlas_Entry *entry, char c,
+                                      uint8_t *width)
+{
+    const Graphics_Font *font = entry->font;
+    const uint8_t *data = FontAtlas_glyphData(font, c);
+    uint16_t size = entry->stride * font->height;
+    uint8_t index = FontAtlas_glyphIndex(c);
+
+    *width = data[1];
+
+    if (entry->slot[index])
+    {
+        return &atlasPool[entry->slot[index] - 1];
+    }
+
+    if (atlasPoolUsed + size > FONT_ATLAS_POOL_SIZE)
+    {
+        FontAtlas_decode(font, data, atlasScratch, entry->stride);
+        return atlasScratch;
+    }
+
+    FontAtlas_decode(font, data, &atlasPool[atlasPoolUsed], entry->stride);
+    entry->slot[index] = atlasPoolUsed + 1;
+    atlasPoolUsed += size;
+
+    return &atlasPool[entry->slot[index] - 1];
+}
+
+/**
+ * ORs a glyph row into a bitmap row of the given number of columns, with the
+ * glyph's first pixel at column x.  Bits outside the row are dropped.
+ */
+static void FontAtlas_orRow(uint8_t *line, int32_t columns, int32_t x,
+                            const uint8_t *bits, uint8_t width)
+{
+    int32_t i, bytes = (columns + 7) / 8;
+
+    if (x >= 0)
+    {
+        uint8_t shift = x & 7;
+        int32_t column = x >> 3;
+
+        for (i = 0; (i < (width + 7) / 8) && (column < bytes); i++, column++)
+        {
+            line[column] |= bits[i] >> shift;
+            if (shift && (column + 1 < bytes))
+            {
+                line[column + 1] |= bits[i] << (8 - shift);
+            }
+        }
+        return;
+    }
+
+    // Partly off the left edge: bit by bit
+    for (i = -x; (i < width) && (x + i < columns); i++)
+    {
+        if ((bits[i >> 3] >> (7 - (i & 7))) & 1)
+        {
+            line[(x + i) >> 3] |= 0x80 >> ((x + i) & 7);
+        }
+    }
+}
+
+bool FontAtlas_render(const Graphics_Font *font, const char *string,
+                      int32_t x, uint8_t firstRow, uint8_t rows,
+                      uint8_t *bits, uint16_t stride, int32_t columns)
+{
+    FontAtlas_Entry *entry = FontAtlas_find(font);
+    uint8_t row, width;
+
+    if (entry == NULL)
+    {
+        return false;
+    }
+
+    memset(bits, 0, stride * rows);
+
+    for (; *string && (x < columns); string++)
+    {
+        const uint8_t *glyph = FontAtlas_glyph(entry, *string, &width);
+
+        if (x + width > 0)
+        {
+            for (row = 0; row < rows; row++)
+            {
+                FontAtlas_orRow(&bits[row * stride], columns, x,
+                                &glyph[(firstRow + row) * entry->stride],
+                                width);
+            }
+        }
+        x += width;
+    }
+
+    return true;
+}
+
+bool FontAtlas_getWindow(const Graphics_Context *context, const char *string,
+                         int32_t x, int32_t y, int32_t xMin, int32_t xMax,
+                         Graphics_Rectangle *window)
+{
+    int32_t x0, y0, x1, y1;
+
+    // The window covers the field and the string, clipped
+    x0 = x < xMin ? x : xMin;
+    x1 = x + FontAtlas_getStringWidth(context->font, string) - 1;
+    if (x1 < xMax)
+    {
+        x1 = xMax;
+    }
+    y0 = y;
+    y1 = y + context->font->height - 1;
+
+    if (x0 < context->clipRegion.xMin) x0 = context->clipRegion.xMin;
+    if (x1 > context->clipRegion.xMax) x1 = context->clipRegion.xMax;
+    if (y0 < context->clipRegion.yMin) y0 = context->clipRegion.yMin;
+    if (y1 > context->clipRegion.yMax) y1 = context->clipRegion.yMax;
+
+    window->xMin = x0;
+    window->yMin = y0;
+    window->xMax = x1;
+    window->yMax = y1;
+
+    return (x0 <= x1) && (y0 <= y1);
+}
+
+void FontAtlas_drawStringField(const Graphics_Context *context,
+                               const char *string, int32_t x, int32_t y,
+                               int32_t xMin, int32_t xMax)
+{
+    const Graphics_Font *font = context->font;
+    Graphics_Rectangle window;
+
+    if (FontAtlas_find(font) == NULL)
+    {
+        // Paint the field, then let grlib draw the string
+        if (xMin <= xMax)
+        {
+            Graphics_Context field = *context;
+            Graphics_Rectangle rect = { xMin, y, xMax, y + font->height - 1 };
+            field.foreground = context->background;
+            Graphics_fillRectangle(&field, &rect);
+        }
+        Graphics_drawString((Graphics_Context *) context, (int8_t *) string,
+                            AUTO_STRING_LENGTH, x, y, OPAQUE_TEXT);
+        return;
+    }
+
+    if (!FontAtlas_getWindow(context, string, x, y, xMin, xMax, &window))
+    {
+        return;
+    }
+
+    FontAtlas_render(font, string, x - window.xMin, window.yMin - y,
+                     window.yMax - window.yMin + 1, &atlasLine[0][0],
+                     FONT_ATLAS_LINE_STRIDE, window.xMax - window.xMin + 1);
+
+    Crystalfontz128x128_BlitMono(window.xMin, window.yMin,
+                                 window.xMax, window.yMax,
+                                 &atlasLine[0][0], FONT_ATLAS_LINE_STRIDE,
+                                 context->foreground, context->background);
+}
+
+void FontAtlas_drawString(const Graphics_Context *context, const char *string,
+                          int32_t x, int32_t y)
+{
+    FontAtlas_drawStringField(context, string, x, y, x, x - 1);
+}
+
+void FontAtlas_drawStringCentered(const Graphics_Context *context,
+                                  const char *string, int32_t x, int32_t y)
+{
+    FontAtlas_drawString(context, string,
+                         x - FontAtlas_getStringWidth(context->font, string) / 2,
+                         y - context->font->baseline / 2);
+}
+
+int32_t FontAtlas_getStringWidth(const Graphics_Font *font, const char *string)
+{
+    int32_t width = 0;
+
+    for (; *string; string++)
+    {
+        width += FontAtlas_glyphData(font, *string)[1];
+    }
+
+    return width;
+}
+
+void FontAtlas_preload(const Graphics_Font *font, const char *string)
+{
+    FontAtlas_Entry *entry = FontAtlas_find(font);
+    uint8_t width;
+
+    if (entry == NULL)
+    {
+        return;
+    }
+
+    for (; *string; string++)
+    {
+        FontAtlas_glyph(entry, *string, &width);
+    }
+}
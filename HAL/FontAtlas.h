@@ -0,0 +1,73 @@
+/*
+ * FontAtlas.h
+ *
+ *  Created on: Nov 22, 2024
+ *
+ * Opaque text renderer for the Crystalfontz128x128 display.  Glyphs of a grlib
+ * font are decoded once into a 1bpp atlas in SRAM, the first time they are
+ * needed, and a whole string is then composed into a line bitmap and sent as
+ * a single window (one RAMWR, or one framebuffer write while buffered).
+ *
+ * The output matches Graphics_drawString(..., OPAQUE_TEXT) for the same
+ * context: same glyph cells, colours, clipping and centring.  The one
+ * difference is that grlib paints the padding bits at the end of an
+ * uncompressed glyph into the row below the cell; the atlas stops at the
+ * font height.
+ */
+
+#ifndef HAL_FONTATLAS_H_
+#define HAL_FONTATLAS_H_
+
+#include <ti/grlib/grlib.h>
+
+// Bytes of SRAM shared by the decoded glyphs of all fonts.  Once full, new
+// glyphs are decoded on every draw instead of being kept.
+#define FONT_ATLAS_POOL_SIZE    6144
+
+// Number of different fonts the atlas keeps glyphs for
+#define FONT_ATLAS_FONTS        4
+
+// Largest font the atlas handles; bigger or extended (FONT_EX_MARKER) fonts
+// are passed on to Graphics_drawString()
+#define FONT_ATLAS_MAX_HEIGHT   32
+#define FONT_ATLAS_MAX_WIDTH    32
+
+// Draws string with its top-left corner at (x, y), like Graphics_drawString()
+// with OPAQUE_TEXT
+void FontAtlas_drawString(const Graphics_Context *context, const char *string,
+                          int32_t x, int32_t y);
+
+// Draws string centred on (x, y), like Graphics_drawStringCentered() with
+// OPAQUE_TEXT
+void FontAtlas_drawStringCentered(const Graphics_Context *context,
+                                  const char *string, int32_t x, int32_t y);
+
+// Draws string at (x, y) and paints the background over columns xMin..xMax
+// of the text rows in the same window, so the previous contents of a field
+// are cleared without a separate blank-string draw
+void FontAtlas_drawStringField(const Graphics_Context *context,
+                               const char *string, int32_t x, int32_t y,
+                               int32_t xMin, int32_t xMax);
+
+// Composes rows firstRow..firstRow + rows - 1 of string into a 1bpp bitmap
+// of the given number of columns, stride bytes per row, most significant bit
+// first, with the string's left edge at column x (which may be negative).
+// Returns false for fonts the atlas cannot hold.
+bool FontAtlas_render(const Graphics_Font *font, const char *string,
+                      int32_t x, uint8_t firstRow, uint8_t rows,
+                      uint8_t *bits, uint16_t stride, int32_t columns);
+
+// Computes the window FontAtlas_drawStringField() would send for the same
+// arguments, clipped to the context.  Returns false if nothing is visible.
+bool FontAtlas_getWindow(const Graphics_Context *context, const char *string,
+                         int32_t x, int32_t y, int32_t xMin, int32_t xMax,
+                         Graphics_Rectangle *window);
+
+// Returns the width of string in pixels, like Graphics_getStringWidth()
+int32_t FontAtlas_getStringWidth(const Graphics_Font *font, const char *string);
+
+// Decodes the glyphs of string ahead of time so the first draw that uses them
+// does not pay for it
+void FontAtlas_preload(const Graphics_Font *font, const char *string);
+
+#endif /* HAL_FONTATLAS_H_ */
@@ -8,36 +8,27 @@
 #include <HAL/Graphics.h>
 //#include <HAL/LcdDriver/Crystalfontz128x128_ST7735.h>
 
+Graphics_Context g_sContext;
+
+// Binds GFX to the shared context.  The display itself is brought up by
+// initialize() in main.c before the HAL is constructed.
 void InitGraphics(GFX *GFX)
 {
-
-    Graphics_initContext(&GFX->context, &g_sCrystalfontz128x128,
-                         &g_sCrystalfontz128x128_funcs);
-    Graphics_setForegroundColor(&GFX->context, GRAPHICS_COLOR_BLACK);
-    Graphics_setBackgroundColor(&GFX->context, GRAPHICS_COLOR_WHITE);
-    Graphics_setFont(&GFX->context, &g_sFontCm12);
-
-    Crystalfontz128x128_Init();
-      Crystalfontz128x128_SetOrientation(LCD_ORIENTATION_UP);
-
-    Graphics_clearDisplay(&GFX->context);
+    GFX->context = &g_sContext;
+    GFX->defaultForeground = FG_COLOR;
+    GFX->defaultBackground = BG_COLOR;
+    GFX->foreground = g_sContext.foreground;
+    GFX->background = g_sContext.background;
 }
 
 GFX GFX_construct(uint32_t defaultForeground, uint32_t defaultBackground)
 {
     GFX gfx;
 
+    gfx.context = &g_sContext;
     gfx.defaultForeground = defaultForeground;
     gfx.defaultBackground = defaultBackground;
 
-    // initializing the display
-    Crystalfontz128x128_Init();
-    Crystalfontz128x128_SetOrientation(LCD_ORIENTATION_UP);
-
-    // setting up the graphics
-    Graphics_initContext(&gfx.context, &g_sCrystalfontz128x128, &g_sCrystalfontz128x128_funcs);
-    Graphics_setFont(&gfx.context, &g_sFontFixed6x8);
-
     GFX_resetColors(&gfx);
     GFX_clear(&gfx);
 
@@ -49,43 +40,43 @@ void GFX_resetColors(GFX* gfx_p)
     gfx_p->foreground = gfx_p->defaultForeground;
     gfx_p->background = gfx_p->defaultBackground;
 
-    Graphics_setForegroundColor(&gfx_p->context, gfx_p->defaultForeground);
-    Graphics_setBackgroundColor(&gfx_p->context, gfx_p->defaultBackground);
+    Graphics_setForegroundColor(gfx_p->context, gfx_p->defaultForeground);
+    Graphics_setBackgroundColor(gfx_p->context, gfx_p->defaultBackground);
 }
 
 void GFX_clear(GFX* gfx_p)
 {
-    Graphics_clearDisplay(&gfx_p->context);
+    Graphics_clearDisplay(gfx_p->context);
 }
 
 void GFX_print(GFX* gfx_p, char* string, int row, int col)
 {
-    int yPosition = row * Graphics_getFontHeight(gfx_p->context.font);
-    int xPosition = col * Graphics_getFontMaxWidth(gfx_p->context.font);
+    int yPosition = row * Graphics_getFontHeight(gfx_p->context->font);
+    int xPosition = col * Graphics_getFontMaxWidth(gfx_p->context->font);
 
-    Graphics_drawString(&gfx_p->context, (int8_t*) string, -1, xPosition, yPosition, OPAQUE_TEXT);
+    Graphics_drawString(gfx_p->context, (int8_t*) string, -1, xPosition, yPosition, OPAQUE_TEXT);
 }
 
 void GFX_setForeground(GFX* gfx_p, uint32_t foreground)
 {
     gfx_p->foreground = foreground;
-    Graphics_setForegroundColor(&gfx_p->context, foreground);
+    Graphics_setForegroundColor(gfx_p->context, foreground);
 }
 
 void GFX_setBackground(GFX* gfx_p, uint32_t background)
 {
     gfx_p->background = background;
-    Graphics_setBackgroundColor(&gfx_p->context, background);
+    Graphics_setBackgroundColor(gfx_p->context, background);
 }
 
 void GFX_drawSolidCircle(GFX* gfx_p, int x, int y, int radius)
 {
-    Graphics_fillCircle(&gfx_p->context, x, y, radius);
+    Graphics_fillCircle(gfx_p->context, x, y, radius);
 }
 
 void GFX_drawHollowCircle(GFX* gfx_p, int x, int y, int radius)
 {
-    Graphics_drawCircle(&gfx_p->context, x, y, radius);
+    Graphics_drawCircle(gfx_p->context, x, y, radius);
 }
 
 void GFX_removeSolidCircle(GFX* gfx_p, int x, int y, int radius)
@@ -16,9 +16,13 @@
 #define FG_COLOR GRAPHICS_COLOR_WHITE
 #define BG_COLOR GRAPHICS_COLOR_BLACK
 
+// The one graphics context for the display.  The application draws through it
+// directly and every GFX object points at it, so the LCD is set up once.
+extern Graphics_Context g_sContext;
+
 struct _GFX
 {
-    Graphics_Context context;
+    Graphics_Context *context;
     uint32_t foreground;
     uint32_t background;
     uint32_t defaultForeground;
@@ -16,8 +16,9 @@
  */
 HAL* HAL_construct()
 {
-    // The API object which will be returned at the end of construction
-    HAL hal;
+    // The API object which will be returned at the end of construction. It is
+    // static so the pointer stays valid after this function returns.
+    static HAL hal;
 
     // Initialize all LEDs by calling their constructors with correctly-defined
     // arguments.
@@ -13,6 +13,14 @@
 #include <HAL/LED.h>
 #include <HAL/Timer.h>
 #include <HAL/Graphics.h>
+#include <HAL/FontAtlas.h>
+#include <HAL/WordCache.h>
+#include <HAL/BootProfile.h>
+#include <HAL/Idle.h>
+#include <HAL/Sampler.h>
+#include <HAL/AccelRing.h>
+#include <HAL/AccelFilter.h>
+#include <HAL/Trace.h>
 //#include <HAL/LcdDriver/Crystalfontz128x128_ST7735.h>
 
 //#include <HAL/LcdDriver>
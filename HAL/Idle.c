@@ -0,0 +1,118 @@
+/*
+ * Idle.c
+ *
+ *  Created on: Nov 27, 2024
+ */
+
+#include <HAL/Idle.h>
+#include <HAL/TimerWheel.h>
+#include <HAL/LcdDriver/HAL_MSP_EXP432P401R_Crystalfontz128x128_ST7735.h>
+
+IdleStats g_idleStats;
+
+static volatile uint8_t holdBits;
+
+// Counter reading at the last wake (or at Idle_init()). Spans are 16-bit
+// counter differences: a sleep is at most TIMER_WHEEL_MAX_SLEEP ticks, well
+// inside the counter's 2 s wrap, and so is a pass of the main loop.
+static uint16_t awakeSince;
+
+static uint16_t Idle_aclk(void)
+{
+    return Timer_A_getCounterValue(TIMER_WHEEL_BASE);
+}
+
+void Idle_init(void)
+{
+    IdleStats cleared = { 0 };
+
+    g_idleStats = cleared;
+    awakeSince = Idle_aclk();
+}
+
+void Idle_hold(uint8_t holds)
+{
+    bool wasMasked = Interrupt_disableMaster();
+    holdBits |= holds;
+    if (!wasMasked)
+    {
+        Interrupt_enableMaster();
+    }
+}
+
+void Idle_release(uint8_t holds)
+{
+    bool wasMasked = Interrupt_disableMaster();
+    holdBits &= ~holds;
+    if (!wasMasked)
+    {
+        Interrupt_enableMaster();
+    }
+}
+
+// Picks the mode for this sleep. Interrupts must be masked, so that nothing
+// changes between the choice and the sleep.
+static IdleMode Idle_chooseMode(void)
+{
+    uint32_t ticks;
+
+    if (holdBits)
+    {
+        g_idleStats.heldSleeps++;
+        return IDLE_LPM0;
+    }
+    if (HAL_LCD_isBusy())
+    {
+        g_idleStats.lcdSleeps++;
+        return IDLE_LPM0;
+    }
+    if (TimerWheel_nextDeadline(&ticks) && (ticks < IDLE_LPM3_MIN_TICKS))
+    {
+        g_idleStats.soonSleeps++;
+        return IDLE_LPM0;
+    }
+    return IDLE_LPM3;
+}
+
+void Idle_sleep(void)
+{
+    bool wasMasked = Interrupt_disableMaster();
+    uint32_t interrupts = TimerWheel_interruptCount();
+    uint16_t asleepSince = Idle_aclk();
+    IdleMode mode = Idle_chooseMode();
+
+    g_idleStats.awakeAclk += (uint16_t) (asleepSince - awakeSince);
+
+    // With interrupts masked, a pending interrupt still ends the sleep - one
+    // that came since the choice was made ends it at once - but its ISR only
+    // runs once they are unmasked below, after the wake is counted
+    if ((mode == IDLE_LPM3) && !PCM_gotoLPM3())
+    {
+        mode = IDLE_LPM0;
+    }
+    if (mode == IDLE_LPM0)
+    {
+        PCM_gotoLPM0();
+    }
+
+    awakeSince = Idle_aclk();
+    g_idleStats.asleepAclk += (uint16_t) (awakeSince - asleepSince);
+    g_idleStats.sleeps[mode]++;
+    g_idleStats.wakes++;
+
+    if (!wasMasked)
+    {
+        Interrupt_enableMaster();
+    }
+    if (TimerWheel_interruptCount() != interrupts)
+    {
+        g_idleStats.timerWakes++;
+    }
+}
+
+uint32_t Idle_activePermille(void)
+{
+    uint64_t total = g_idleStats.asleepAclk + g_idleStats.awakeAclk;
+
+    return total ? (uint32_t) (g_idleStats.awakeAclk * 1000 / total) : 0;
+}
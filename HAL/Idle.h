@@ -0,0 +1,83 @@
+/*
+ * Idle.h
+ *
+ *  Created on: Nov 27, 2024
+ *
+ * The idle manager.  The main loop calls Idle_sleep() when it has nothing to
+ * do; that picks the deepest low-power mode what is running allows and
+ * sleeps in it until the next interrupt.  The TimerWheel has its compare set
+ * for the next timer to expire (at most a second away), so that is the
+ * latest the CPU wakes; the buttons and the ADC wake it sooner.
+ *
+ * LPM3 stops MCLK, SMCLK and every module running from them, keeping only
+ * ACLK: the TimerWheel and the port interrupts still work, but the ADC, the
+ * LCD's SPI and uDMA, the trace UART and Timer32 do not.  So the CPU only
+ * goes down to LPM3 when none of those is needed:
+ *   - no hold is set.  Code with one of them running sets a hold bit with
+ *     Idle_hold() and clears it with Idle_release().
+ *   - no LCD transfer is in flight.
+ *   - the next timer is at least IDLE_LPM3_MIN_TICKS away; for anything
+ *     sooner, LPM3's slower wake costs more than it saves.
+ * Otherwise it sleeps in LPM0.
+ *
+ * Each sleep and wake is counted in g_idleStats, with the time spent asleep
+ * and awake measured on the TimerWheel's ACLK counter.  Read it from the
+ * debugger (add g_idleStats to the Expressions view).
+ */
+
+#ifndef HAL_IDLE_H_
+#define HAL_IDLE_H_
+
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+
+typedef enum
+{
+    IDLE_LPM0,
+    IDLE_LPM3,
+    IDLE_MODES
+} IdleMode;
+
+// Hold bits, each keeping the CPU out of LPM3 while it is set
+#define IDLE_HOLD_ADC       0x01    // ADC14 converting
+#define IDLE_HOLD_CLOCK     0x02    // An SWTimer timing a span that may
+                                    // include a sleep (a Button debouncing)
+#define IDLE_HOLD_UART      0x04    // Trace bytes still going out
+
+#define IDLE_LPM3_MIN_TICKS 2
+
+typedef struct
+{
+    // Sleeps in each mode, and why LPM0 was chosen over LPM3
+    uint32_t sleeps[IDLE_MODES];
+    uint32_t heldSleeps;        // a hold bit was set
+    uint32_t lcdSleeps;         // an LCD transfer was in flight
+    uint32_t soonSleeps;        // the next timer was too close
+
+    // Wakes, and those on which the TimerWheel's compare interrupt was taken.
+    // The rest were buttons, the ADC or the LCD's uDMA.
+    uint32_t wakes;
+    uint32_t timerWakes;
+
+    // ACLK cycles spent asleep and awake since Idle_init()
+    uint64_t asleepAclk;
+    uint64_t awakeAclk;
+} IdleStats;
+
+extern IdleStats g_idleStats;
+
+// Clears the statistics. Call after TimerWheel_init().
+void Idle_init(void);
+
+// Sets and clears hold bits
+void Idle_hold(uint8_t holds);
+void Idle_release(uint8_t holds);
+
+// Sleeps until the next interrupt, in the deepest mode allowed. Its ISR has
+// run by the time this returns.
+void Idle_sleep(void);
+
+// The share of the time since Idle_init() the CPU was awake, in tenths of a
+// percent
+uint32_t Idle_activePermille(void);
+
+#endif /* HAL_IDLE_H_ */
@@ -47,112 +47,606 @@ uint16_t Lcd_ScreenWidth, Lcd_ScreenHeigth;
 uint8_t Lcd_PenSolid, Lcd_FontSolid, Lcd_FlagRead;
 uint16_t Lcd_TouchTrim;
 
+// MADCTL value of each orientation, and where screen (0, 0) sits in the
+// controller's 132x132 GRAM once it is applied.  Every orientation shows the
+// same 128x128 pixels of the panel, each a quarter turn from the one before.
+static const struct
+{
+    uint8_t madctl;
+    uint8_t xOffset, yOffset;
+} Lcd_Orientations[4] =
+{
+    [LCD_ORIENTATION_UP]    = { CM_MADCTL_MX | CM_MADCTL_MY | CM_MADCTL_BGR, 2, 3 },
+    [LCD_ORIENTATION_LEFT]  = { CM_MADCTL_MY | CM_MADCTL_MV | CM_MADCTL_BGR, 3, 2 },
+    [LCD_ORIENTATION_DOWN]  = { CM_MADCTL_BGR,                               2, 1 },
+    [LCD_ORIENTATION_RIGHT] = { CM_MADCTL_MX | CM_MADCTL_MV | CM_MADCTL_BGR, 1, 2 },
+};
+
+// Column/row window last sent with CASET/RASET, in panel coordinates
+static uint16_t Lcd_WindowX0, Lcd_WindowX1, Lcd_WindowY0, Lcd_WindowY1;
+static bool Lcd_WindowValid = false;
+
+// Next pixel address of an open PixelDraw RAMWR run, in screen coordinates
+static int16_t Lcd_PixelRunX, Lcd_PixelRunY;
+static bool Lcd_PixelRunOpen = false;
+
+// Pixel format the controller was (or will be) set to, as a COLMOD value
+static uint8_t Lcd_ColorMode = LCD_COLOR_MODE;
+
+// Screen rows shown while the controller is in partial mode.  Outside the
+// band the panel is not driven, so a buffered flush leaves those rows dirty
+// until normal mode is back.
+static bool Lcd_Partial = false;
+static uint16_t Lcd_PartialY0, Lcd_PartialY1;
+
+static bool Crystalfontz128x128_SendPartialArea(void);
+
+// Staging buffer of the span currently being built, and its fill level
+static uint8_t *Lcd_SpanBuffer;
+static uint16_t Lcd_SpanLength;
+
+// RGB444 only: low nibble of an unpaired pixel, shifted up, waiting for the
+// next pixel to complete its byte
+static uint8_t Lcd_SpanNibble;
+static bool Lcd_SpanHalf;
+
+#if LCD_FRAMEBUFFER
+// Off-screen copy of the panel in display-native colours, indexed [y][x].
+// While Lcd_Buffered is set, primitives draw here and only mark the tiles
+// they touch; Crystalfontz128x128_Flush() sends the dirty tiles to the panel.
+static uint16_t Lcd_FrameBuffer[LCD_VERTICAL_MAX][LCD_HORIZONTAL_MAX];
+static uint16_t Lcd_DirtyTiles[LCD_TILE_ROWS];
+static bool Lcd_Buffered = false;
+
+// Framebuffer position the current span writes to (NULL: span goes to the bus)
+static uint16_t *Lcd_SpanTarget;
+#endif
+
+//*****************************************************************************
+//
+// Sends a command byte.  Anything but RAMWR ends an open PixelDraw run, since
+// the controller takes the data that follows as the new command's parameters.
+//
+//*****************************************************************************
+static inline void Crystalfontz128x128_Command(uint8_t command)
+{
+    if (command != CM_RAMWR)
+    {
+        Lcd_PixelRunOpen = false;
+    }
+    HAL_LCD_writeCommand(command);
+}
+
+//*****************************************************************************
+//
+// Span helpers.  Pixels are packed into a staging buffer and handed to the
+// transfer engine one LCD_DMA_BUFFER_SIZE block at a time, instead of being
+// written to the bus one byte per call.  In RGB444 two pixels take three
+// bytes, the middle one holding the low nibble of the first and the high
+// nibble of the second.
+//
+//*****************************************************************************
+static void Crystalfontz128x128_SpanBegin(void)
+{
+    Lcd_SpanBuffer = HAL_LCD_getStagingBuffer();
+    Lcd_SpanLength = 0;
+    Lcd_SpanHalf = false;
+#if LCD_FRAMEBUFFER
+    Lcd_SpanTarget = 0;
+#endif
+}
+
+static inline void Crystalfontz128x128_SpanPut(uint16_t ulValue)
+{
+#if LCD_FRAMEBUFFER
+    if (Lcd_SpanTarget)
+    {
+        *Lcd_SpanTarget++ = ulValue;
+        return;
+    }
+#endif
+
+    if (Lcd_ColorMode == LCD_COLOR_MODE_RGB444)
+    {
+        if (Lcd_SpanHalf)
+        {
+            Lcd_SpanBuffer[Lcd_SpanLength++] = Lcd_SpanNibble |
+                                               ((ulValue >> 8) & 0x0F);
+            Lcd_SpanBuffer[Lcd_SpanLength++] = ulValue;
+        }
+        else
+        {
+            Lcd_SpanBuffer[Lcd_SpanLength++] = ulValue >> 4;
+            Lcd_SpanNibble = ulValue << 4;
+        }
+        Lcd_SpanHalf = !Lcd_SpanHalf;
+    }
+    else
+    {
+        Lcd_SpanBuffer[Lcd_SpanLength++] = ulValue >> 8;
+        Lcd_SpanBuffer[Lcd_SpanLength++] = ulValue;
+    }
+
+    // Hand the block over while there is still room for a pixel's two bytes;
+    // a pending nibble carries over into the next block
+    if (Lcd_SpanLength > LCD_DMA_BUFFER_SIZE - 2)
+    {
+        HAL_LCD_writeDataBlock(Lcd_SpanBuffer, Lcd_SpanLength);
+        Lcd_SpanBuffer = HAL_LCD_getStagingBuffer();
+        Lcd_SpanLength = 0;
+    }
+}
+
+static void Crystalfontz128x128_SpanEnd(void)
+{
+#if LCD_FRAMEBUFFER
+    if (Lcd_SpanTarget)
+    {
+        Lcd_SpanTarget = 0;
+        return;
+    }
+#endif
+
+    // An odd RGB444 span ends with its last pixel's low nibble, padded
+    if (Lcd_SpanHalf)
+    {
+        Lcd_SpanBuffer[Lcd_SpanLength++] = Lcd_SpanNibble;
+        Lcd_SpanHalf = false;
+    }
+
+    HAL_LCD_writeDataBlock(Lcd_SpanBuffer, Lcd_SpanLength);
+    Lcd_SpanLength = 0;
+}
+
+//*****************************************************************************
+//
+// Sends one colour for the given number of pixels of the current RAMWR
+// window, in the current colour mode.
+//
+//*****************************************************************************
+static void Crystalfontz128x128_Fill(uint16_t ulValue, uint32_t pixels)
+{
+    if (Lcd_ColorMode == LCD_COLOR_MODE_RGB444)
+    {
+        const uint8_t pair[3] = {
+            ulValue >> 4, (ulValue << 4) | ((ulValue >> 8) & 0x0F), ulValue
+        };
+
+        HAL_LCD_fillPattern(pair, 3, pixels / 2);
+        if (pixels & 1)
+        {
+            HAL_LCD_writeData(ulValue >> 4);
+            HAL_LCD_writeData(ulValue << 4);
+        }
+        return;
+    }
+
+    HAL_LCD_fillData(ulValue >> 8, ulValue, pixels);
+}
+
+#if LCD_FRAMEBUFFER
+//*****************************************************************************
+//
+// Framebuffer helpers.  Coordinates are inclusive and already clipped by the
+// graphics library.
+//
+//*****************************************************************************
+static void Crystalfontz128x128_MarkDirty(int16_t x0, int16_t y0,
+                                          int16_t x1, int16_t y1)
+{
+    int16_t ty;
+    uint16_t run = (uint16_t)((0xFFFFu >> (LCD_TILE_COLUMNS - 1 - x1 / LCD_TILE_SIZE)) &
+                              (0xFFFFu << (x0 / LCD_TILE_SIZE)));
+
+    for (ty = y0 / LCD_TILE_SIZE; ty <= y1 / LCD_TILE_SIZE; ty++)
+    {
+        Lcd_DirtyTiles[ty] |= run;
+    }
+}
+
+// Turns screen coordinates a quarter turn at a time.  Once
+// Crystalfontz128x128_SetOrientation() has turned the display by turns,
+// screen (x, y) sits on the panel pixel the turned (x, y) was on before.
+// last is the largest coordinate, so tiles turn as well as pixels.
+static inline void Crystalfontz128x128_Turn(int16_t *x, int16_t *y,
+                                            int16_t last, uint8_t turns)
+{
+    int16_t t;
+
+    while (turns--)
+    {
+        t = *x;
+        *x = last - *y;
+        *y = t;
+    }
+}
+
+// True if every pixel of tile (tx, ty) is already on the panel after the
+// display turned: the tile it now sits on was flushed, and held the same
+// colours
+static bool Crystalfontz128x128_TileTurnsClean(int16_t tx, int16_t ty,
+                                               uint8_t turns,
+                                               const uint16_t *wasDirty)
+{
+    int16_t ox = tx, oy = ty, x, y;
+
+    Crystalfontz128x128_Turn(&ox, &oy, LCD_TILE_COLUMNS - 1, turns);
+    if (wasDirty[oy] & (1u << ox))
+    {
+        return false;
+    }
+
+    for (y = ty * LCD_TILE_SIZE; y < (ty + 1) * LCD_TILE_SIZE; y++)
+    {
+        for (x = tx * LCD_TILE_SIZE; x < (tx + 1) * LCD_TILE_SIZE; x++)
+        {
+            int16_t px = x, py = y;
+
+            Crystalfontz128x128_Turn(&px, &py, LCD_HORIZONTAL_MAX - 1, turns);
+            if (Lcd_FrameBuffer[y][x] != Lcd_FrameBuffer[py][px])
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// A MADCTL write only changes how later writes are addressed: the panel goes
+// on showing its GRAM, now the old picture turned.  Marks dirty the tiles
+// that show something other than the framebuffer, which for blank or
+// symmetric parts of the screen is none of them.
+static void Crystalfontz128x128_MarkTurned(uint8_t turns)
+{
+    uint16_t wasDirty[LCD_TILE_ROWS];
+    int16_t tx, ty;
+
+    if (!turns)
+    {
+        return;
+    }
+
+    for (ty = 0; ty < LCD_TILE_ROWS; ty++)
+    {
+        wasDirty[ty] = Lcd_DirtyTiles[ty];
+        Lcd_DirtyTiles[ty] = 0;
+    }
+    for (ty = 0; ty < LCD_TILE_ROWS; ty++)
+    {
+        for (tx = 0; tx < LCD_TILE_COLUMNS; tx++)
+        {
+            if (!Crystalfontz128x128_TileTurnsClean(tx, ty, turns, wasDirty))
+            {
+                Lcd_DirtyTiles[ty] |= 1u << tx;
+            }
+        }
+    }
+}
+
+static void Crystalfontz128x128_BufferFill(int16_t x0, int16_t y0,
+                                           int16_t x1, int16_t y1,
+                                           uint16_t ulValue)
+{
+    int16_t x, y;
+
+    for (y = y0; y <= y1; y++)
+    {
+        uint16_t *pixel = &Lcd_FrameBuffer[y][x0];
+        for (x = x0; x <= x1; x++)
+        {
+            *pixel++ = ulValue;
+        }
+    }
+
+    Crystalfontz128x128_MarkDirty(x0, y0, x1, y1);
+}
+
+// Sends one rectangle of the framebuffer to the panel
+static void Crystalfontz128x128_BufferSend(int16_t x0, int16_t y0,
+                                           int16_t x1, int16_t y1)
+{
+    int16_t x, y;
+
+    Crystalfontz128x128_SetDrawFrame(x0, y0, x1, y1);
+    Crystalfontz128x128_Command(CM_RAMWR);
+    Crystalfontz128x128_SpanBegin();
+
+    for (y = y0; y <= y1; y++)
+    {
+        const uint16_t *pixel = &Lcd_FrameBuffer[y][x0];
+        for (x = x0; x <= x1; x++)
+        {
+            Crystalfontz128x128_SpanPut(*pixel++);
+        }
+    }
+
+    Crystalfontz128x128_SpanEnd();
+}
+#endif
+
+//*****************************************************************************
+//
+// Power-up sequence for the ST7735, run one step at a time by
+// Crystalfontz128x128_PollInit().  Each step drives the reset line or sends a
+// command with up to two data bytes, then leaves the controller alone for
+// the given number of microseconds (counted from the end of any data the
+// step queued).  LCD_STEP_COLMOD sends COLMOD with the mode picked by
+// Crystalfontz128x128_SetColorMode(); LCD_STEP_CLEAR fills the panel white.
+//
+//*****************************************************************************
+#define LCD_STEP_RESET_LOW     0xF0
+#define LCD_STEP_RESET_HIGH    0xF1
+#define LCD_STEP_CLEAR         0xF2
+#define LCD_STEP_COLMOD        0xF3
+
+typedef struct
+{
+    uint8_t command;
+    uint8_t length;
+    uint8_t data[2];
+    uint16_t delay;
+} Lcd_InitStep;
+
+static const Lcd_InitStep Lcd_InitSequence[] =
+{
+    { LCD_STEP_RESET_LOW,  0, { 0x00, 0x00 },   50 },
+    { LCD_STEP_RESET_HIGH, 0, { 0x00, 0x00 },  120 },
+    { CM_SLPOUT,           0, { 0x00, 0x00 },  200 },
+    { CM_GAMSET,           1, { 0x04, 0x00 },    0 },
+    { CM_SETPWCTR,         2, { 0x0A, 0x14 },    0 },
+    { CM_SETSTBA,          2, { 0x0A, 0x00 },    0 },
+    { LCD_STEP_COLMOD,     0, { 0x00, 0x00 },   10 },
+    { CM_MADCTL,           1, { CM_MADCTL_BGR }, 0 },
+    { CM_NORON,            0, { 0x00, 0x00 },    0 },
+    { LCD_STEP_CLEAR,      0, { 0x00, 0x00 },   10 },
+    { CM_DISPON,           0, { 0x00, 0x00 },    0 },
+};
+
+#define LCD_INIT_STEPS (sizeof(Lcd_InitSequence) / sizeof(Lcd_InitSequence[0]))
+
+// Next step to run, and whether the previous step's delay is still waiting
+// for its data to leave the bus before it starts
+static uint8_t Lcd_InitStepIndex = LCD_INIT_STEPS;
+static bool Lcd_InitDelayPending = false;
+
+// Set once Crystalfontz128x128_StartInit() has brought up the SPI
+static bool Lcd_InitStarted = false;
+
 //*****************************************************************************
 //
 //! Initializes the display driver.
 //!
 //! This function initializes the ST7735 display controller on the panel,
-//! preparing it to display data.
+//! preparing it to display data.  It blocks until the whole power-up sequence
+//! has run; see Crystalfontz128x128_StartInit() for a version that does not.
 //!
 //! \return None.
 //
 //*****************************************************************************
 void Crystalfontz128x128_Init(void)
+{
+    Crystalfontz128x128_StartInit();
+    while (!Crystalfontz128x128_PollInit());
+}
+
+
+//*****************************************************************************
+//
+//! Starts initializing the display driver.
+//!
+//! Sets up the port, SPI and uDMA and starts the controller power-up sequence,
+//! then returns right away.  Crystalfontz128x128_PollInit() must be called
+//! until it returns true before anything is drawn; in between, the caller is
+//! free to set up other peripherals while the controller's reset and wake-up
+//! delays run out.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void Crystalfontz128x128_StartInit(void)
 {
     HAL_LCD_PortInit();
     HAL_LCD_SpiInit();
+    HAL_LCD_DmaInit();
+    Crystalfontz128x128_InvalidateWindow();
 
-    GPIO_setOutputLowOnPin(LCD_RST_PORT, LCD_RST_PIN);
-    HAL_LCD_delay(50);
-    GPIO_setOutputHighOnPin(LCD_RST_PORT, LCD_RST_PIN);
-    HAL_LCD_delay(120);
+    Lcd_ScreenWidth  = LCD_VERTICAL_MAX;
+    Lcd_ScreenHeigth = LCD_HORIZONTAL_MAX;
+    Lcd_PenSolid  = 0;
+    Lcd_FontSolid = 1;
+    Lcd_FlagRead  = 0;
+    Lcd_TouchTrim = 0;
+
+    Lcd_Partial = false;
+    Lcd_InitStepIndex = 0;
+    Lcd_InitDelayPending = false;
+    Lcd_InitStarted = true;
+    HAL_LCD_startTimeout(0);
+}
 
-    HAL_LCD_writeCommand(CM_SLPOUT);
-    HAL_LCD_delay(200);
 
-    HAL_LCD_writeCommand(CM_GAMSET);
-    HAL_LCD_writeData(0x04);
+//*****************************************************************************
+//
+//! Advances the power-up sequence started by Crystalfontz128x128_StartInit().
+//!
+//! Runs every step whose delay has run out and returns without waiting for
+//! the next one.  The white fill of the panel is handed to the uDMA, so it
+//! too proceeds in the background.
+//!
+//! \return true once the display is initialized.
+//
+//*****************************************************************************
+bool Crystalfontz128x128_PollInit(void)
+{
+    const Lcd_InitStep *step;
+    uint8_t i;
+
+    while (Lcd_InitStepIndex < LCD_INIT_STEPS)
+    {
+        if (Lcd_InitDelayPending)
+        {
+            if (HAL_LCD_isBusy())
+            {
+                return false;
+            }
+            HAL_LCD_startTimeout(Lcd_InitSequence[Lcd_InitStepIndex - 1].delay);
+            Lcd_InitDelayPending = false;
+        }
 
-    HAL_LCD_writeCommand(CM_SETPWCTR);
-    HAL_LCD_writeData(0x0A);
-    HAL_LCD_writeData(0x14);
+        if (!HAL_LCD_isTimedOut())
+        {
+            return false;
+        }
 
-    HAL_LCD_writeCommand(CM_SETSTBA);
-    HAL_LCD_writeData(0x0A);
-    HAL_LCD_writeData(0x00);
+        step = &Lcd_InitSequence[Lcd_InitStepIndex++];
+        switch (step->command)
+        {
+            case LCD_STEP_RESET_LOW:
+                GPIO_setOutputLowOnPin(LCD_RST_PORT, LCD_RST_PIN);
+                break;
+            case LCD_STEP_RESET_HIGH:
+                GPIO_setOutputHighOnPin(LCD_RST_PORT, LCD_RST_PIN);
+                break;
+            case LCD_STEP_COLMOD:
+                Crystalfontz128x128_Command(CM_COLMOD);
+                HAL_LCD_writeData(Lcd_ColorMode);
+                break;
+            case LCD_STEP_CLEAR:
+                // All ones is white in either colour mode
+                Crystalfontz128x128_SetDrawFrame(0, 0, 127, 127);
+                Crystalfontz128x128_Command(CM_RAMWR);
+                Crystalfontz128x128_Fill(0xFFFF, 16384);
+                break;
+            default:
+                Crystalfontz128x128_Command(step->command);
+                for (i = 0; i < step->length; i++)
+                {
+                    HAL_LCD_writeData(step->data[i]);
+                }
+                break;
+        }
+        Lcd_InitDelayPending = true;
+    }
 
-    HAL_LCD_writeCommand(CM_COLMOD);
-    HAL_LCD_writeData(0x05);
-    HAL_LCD_delay(10);
+    if (Lcd_InitDelayPending)
+    {
+        if (HAL_LCD_isBusy())
+        {
+            return false;
+        }
+        Lcd_InitDelayPending = false;
+    }
 
-    HAL_LCD_writeCommand(CM_MADCTL);
-    HAL_LCD_writeData(CM_MADCTL_BGR);
+    return true;
+}
 
-    HAL_LCD_writeCommand(CM_NORON);
 
-    Lcd_ScreenWidth  = LCD_VERTICAL_MAX;
-    Lcd_ScreenHeigth = LCD_HORIZONTAL_MAX;
-    Lcd_PenSolid  = 0;
-    Lcd_FontSolid = 1;
-    Lcd_FlagRead  = 0;
-    Lcd_TouchTrim = 0;
+//*****************************************************************************
+//
+//! Selects the pixel format sent to the controller.
+//!
+//! \param mode is the COLMOD value to use.  Valid values are:
+//!           - \b LCD_COLOR_MODE_RGB565, two bytes per pixel,
+//!           - \b LCD_COLOR_MODE_RGB444, three bytes per two pixels.
+//!
+//! Best called before Crystalfontz128x128_Init() or
+//! Crystalfontz128x128_StartInit(), which then program it as part of the
+//! power-up sequence; called later it sends COLMOD right away.  Colours are
+//! translated for the mode current at the time, so contexts whose colours
+//! were set before a change have to set them again, and a buffered screen
+//! has to be redrawn.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void Crystalfontz128x128_SetColorMode(uint8_t mode)
+{
+    Lcd_ColorMode = mode;
 
-    Crystalfontz128x128_SetDrawFrame(0, 0, 127, 127);
-    HAL_LCD_writeCommand(CM_RAMWR);
-    int i;
-    for (i = 0; i < 16384; i++)
+    if (Lcd_InitStarted && (Lcd_InitStepIndex == LCD_INIT_STEPS))
     {
-        HAL_LCD_writeData(0xFF);
-        HAL_LCD_writeData(0xFF);
+        Crystalfontz128x128_Command(CM_COLMOD);
+        HAL_LCD_writeData(mode);
     }
+}
+
+
+//*****************************************************************************
+//
+//! Returns the pixel format set by Crystalfontz128x128_SetColorMode().
+//
+//*****************************************************************************
+uint8_t Crystalfontz128x128_GetColorMode(void)
+{
+    return Lcd_ColorMode;
+}
 
-    HAL_LCD_delay(10);
-    HAL_LCD_writeCommand(CM_DISPON);
+
+//*****************************************************************************
+//
+//! Forgets the cached draw window.
+//!
+//! The next Crystalfontz128x128_SetDrawFrame() call sends both CASET and
+//! RASET, and any open PixelDraw run is closed.  Must be called whenever the
+//! controller's window may have changed behind the driver's back, e.g. after
+//! a reset or a MADCTL write.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void Crystalfontz128x128_InvalidateWindow(void)
+{
+    Lcd_WindowValid = false;
+    Lcd_PixelRunOpen = false;
 }
 
 
+//*****************************************************************************
+//
+//! Sets the column and row window for the next RAMWR.
+//!
+//! \param x0, y0, x1, y1 are the inclusive window corners in screen
+//! coordinates.
+//!
+//! The window last sent to the controller is cached, and CASET or RASET is
+//! only sent when its range actually changes.  Any open PixelDraw run is
+//! closed, since the caller is about to start a new RAMWR.
+//!
+//! \return None.
+//
+//*****************************************************************************
 void Crystalfontz128x128_SetDrawFrame(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
 {
-    switch (Lcd_Orientation) {
-        case 0:
-            x0 += 2;
-            y0 += 3;
-            x1 += 2;
-            y1 += 3;
-            break;
-        case 1:
-            x0 += 3;
-            y0 += 2;
-            x1 += 3;
-            y1 += 2;
-            break;
-        case 2:
-            x0 += 2;
-            y0 += 1;
-            x1 += 2;
-            y1 += 1;
-            break;
-        case 3:
-            x0 += 1;
-            y0 += 2;
-            x1 += 1;
-            y1 += 2;
-            break;
-        default:
-            break;
+    Lcd_PixelRunOpen = false;
+
+    x0 += Lcd_Orientations[Lcd_Orientation].xOffset;
+    y0 += Lcd_Orientations[Lcd_Orientation].yOffset;
+    x1 += Lcd_Orientations[Lcd_Orientation].xOffset;
+    y1 += Lcd_Orientations[Lcd_Orientation].yOffset;
+
+    if (!Lcd_WindowValid || (x0 != Lcd_WindowX0) || (x1 != Lcd_WindowX1))
+    {
+        Crystalfontz128x128_Command(CM_CASET);
+        HAL_LCD_writeData((uint8_t)(x0 >> 8));
+        HAL_LCD_writeData((uint8_t)(x0));
+        HAL_LCD_writeData((uint8_t)(x1 >> 8));
+        HAL_LCD_writeData((uint8_t)(x1));
+        Lcd_WindowX0 = x0;
+        Lcd_WindowX1 = x1;
     }
 
-    HAL_LCD_writeCommand(CM_CASET);
-    HAL_LCD_writeData((uint8_t)(x0 >> 8));
-    HAL_LCD_writeData((uint8_t)(x0));
-    HAL_LCD_writeData((uint8_t)(x1 >> 8));
-    HAL_LCD_writeData((uint8_t)(x1));
+    if (!Lcd_WindowValid || (y0 != Lcd_WindowY0) || (y1 != Lcd_WindowY1))
+    {
+        Crystalfontz128x128_Command(CM_RASET);
+        HAL_LCD_writeData((uint8_t)(y0 >> 8));
+        HAL_LCD_writeData((uint8_t)(y0));
+        HAL_LCD_writeData((uint8_t)(y1 >> 8));
+        HAL_LCD_writeData((uint8_t)(y1));
+        Lcd_WindowY0 = y0;
+        Lcd_WindowY1 = y1;
+    }
 
-    HAL_LCD_writeCommand(CM_RASET);
-    HAL_LCD_writeData((uint8_t)(y0 >> 8));
-    HAL_LCD_writeData((uint8_t)(y0));
-    HAL_LCD_writeData((uint8_t)(y1 >> 8));
-    HAL_LCD_writeData((uint8_t)(y1));
+    Lcd_WindowValid = true;
 }
 
 
@@ -166,29 +660,273 @@ void Crystalfontz128x128_SetDrawFrame(uint16_t x0, uint16_t y0, uint16_t x1, uin
 //!           - \b LCD_ORIENTATION_DOWN,
 //!           - \b LCD_ORIENTATION_RIGHT,
 //!
-//! This function sets the orientation of the LCD
+//! This function sets the orientation of the LCD with a single MADCTL write.
+//! The controller does not move what is already in its GRAM, so the panel
+//! shows the old picture turned until it is redrawn.  While buffered, only
+//! the tiles whose pixels now sit on something different are marked dirty,
+//! and the next Graphics_flushBuffer() sends those; a blank or symmetric
+//! screen costs nothing more.  Otherwise the caller redraws the screen.  In
+//! partial mode, the band follows the new orientation, or the display goes
+//! back to normal mode if it is turned sideways.
 //!
 //! \return None.
 //
 //*****************************************************************************
 void Crystalfontz128x128_SetOrientation(uint8_t orientation)
 {
+    uint8_t turns = (orientation - Lcd_Orientation) & 3;
+
+    if (orientation > LCD_ORIENTATION_RIGHT)
+    {
+        return;
+    }
+
+    Crystalfontz128x128_InvalidateWindow();
     Lcd_Orientation = orientation;
-    HAL_LCD_writeCommand(CM_MADCTL);
+    Crystalfontz128x128_Command(CM_MADCTL);
+    HAL_LCD_writeData(Lcd_Orientations[Lcd_Orientation].madctl);
+
+#if LCD_FRAMEBUFFER
+    if (Lcd_Buffered)
+    {
+        Crystalfontz128x128_MarkTurned(turns);
+    }
+#endif
+
+    // The band is in screen rows, which land on other panel rows now
+    if (Lcd_Partial && !Crystalfontz128x128_SendPartialArea())
+    {
+        Crystalfontz128x128_SetNormalMode();
+    }
+}
+
+
+//*****************************************************************************
+//
+//! Enables or disables off-screen rendering.
+//!
+//! \param buffered selects whether drawing primitives render into the RAM
+//! framebuffer (true) or go straight to the panel (false).
+//!
+//! While buffered, nothing reaches the panel until Graphics_flushBuffer() is
+//! called, which sends only the tiles touched since the previous flush.
+//! Enabling marks the whole screen dirty, since the panel contents are not
+//! known; disabling flushes any pending drawing first.  Without
+//! LCD_FRAMEBUFFER this function does nothing.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void Crystalfontz128x128_SetBuffered(bool buffered)
+{
+#if LCD_FRAMEBUFFER
+    if (buffered == Lcd_Buffered)
+    {
+        return;
+    }
+
+    if (buffered)
+    {
+        Crystalfontz128x128_MarkDirty(0, 0, LCD_HORIZONTAL_MAX - 1,
+                                      LCD_VERTICAL_MAX - 1);
+    }
+    else
+    {
+        g_sCrystalfontz128x128_funcs.pfnFlush(&g_sCrystalfontz128x128);
+    }
+    Lcd_Buffered = buffered;
+#endif
+}
+
+
+//*****************************************************************************
+//
+//! Returns true while drawing goes to the RAM framebuffer.
+//
+//*****************************************************************************
+bool Crystalfontz128x128_IsBuffered(void)
+{
+#if LCD_FRAMEBUFFER
+    return Lcd_Buffered;
+#else
+    return false;
+#endif
+}
+
+
+//*****************************************************************************
+//
+// Sends PTLAR for the band in Lcd_PartialY0..Lcd_PartialY1.  Partial mode
+// selects panel scan lines, which are screen rows only while the display is
+// upright or upside down; with rows and columns exchanged the band would be
+// a column strip, and false is returned without sending anything.
+//
+//*****************************************************************************
+static bool Crystalfontz128x128_SendPartialArea(void)
+{
+    uint16_t start, end;
+
     switch (Lcd_Orientation) {
         case LCD_ORIENTATION_UP:
-            HAL_LCD_writeData(CM_MADCTL_MX | CM_MADCTL_MY | CM_MADCTL_BGR);
-            break;
-        case LCD_ORIENTATION_LEFT:
-            HAL_LCD_writeData(CM_MADCTL_MY | CM_MADCTL_MV | CM_MADCTL_BGR);
+            // RASET row y + 3, mirrored by MY
+            start = LCD_VERTICAL_MAX - Lcd_PartialY1;
+            end = LCD_VERTICAL_MAX - Lcd_PartialY0;
             break;
         case LCD_ORIENTATION_DOWN:
-            HAL_LCD_writeData(CM_MADCTL_BGR);
-            break;
-        case LCD_ORIENTATION_RIGHT:
-            HAL_LCD_writeData(CM_MADCTL_MX | CM_MADCTL_MV | CM_MADCTL_BGR);
+            start = Lcd_PartialY0 + 1;
+            end = Lcd_PartialY1 + 1;
             break;
+        default:
+            return false;
+    }
+
+    Crystalfontz128x128_Command(CM_PTLAR);
+    HAL_LCD_writeData((uint8_t)(start >> 8));
+    HAL_LCD_writeData((uint8_t)(start));
+    HAL_LCD_writeData((uint8_t)(end >> 8));
+    HAL_LCD_writeData((uint8_t)(end));
+    return true;
+}
+
+
+//*****************************************************************************
+//
+//! Limits the panel to a band of screen rows.
+//!
+//! \param y0, y1 are the first and last screen rows of the band.
+//!
+//! Puts the controller in partial mode: only the band is scanned, and the
+//! rest of the panel is left undriven, which shows as the panel's blank
+//! colour and saves the power of driving those rows.  While buffered,
+//! Graphics_flushBuffer() only sends the tiles that overlap the band; the
+//! others stay dirty and are sent by Crystalfontz128x128_SetNormalMode().
+//! Only available with LCD_ORIENTATION_UP or LCD_ORIENTATION_DOWN, since
+//! the controller's partial area is a range of scan lines.  Changing the
+//! band while partial just moves it.
+//!
+//! \return true if the band is in effect, false if the orientation does not
+//! allow one, in which case the display stays as it was.
+//
+//*****************************************************************************
+bool Crystalfontz128x128_SetPartialArea(uint16_t y0, uint16_t y1)
+{
+    uint16_t oldY0 = Lcd_PartialY0, oldY1 = Lcd_PartialY1;
+
+    Lcd_PartialY0 = y0;
+    Lcd_PartialY1 = y1;
+    if (!Crystalfontz128x128_SendPartialArea())
+    {
+        Lcd_PartialY0 = oldY0;
+        Lcd_PartialY1 = oldY1;
+        return false;
+    }
+
+    if (!Lcd_Partial)
+    {
+        Crystalfontz128x128_Command(CM_PTLON);
+        Lcd_Partial = true;
+    }
+    return true;
+}
+
+
+//*****************************************************************************
+//
+//! Leaves partial mode.
+//!
+//! When buffered, the tiles left dirty outside the band are sent first, so
+//! the rows that come back on show what was drawn while they were off.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void Crystalfontz128x128_SetNormalMode(void)
+{
+    if (!Lcd_Partial)
+    {
+        return;
     }
+
+    Lcd_Partial = false;
+    g_sCrystalfontz128x128_funcs.pfnFlush(&g_sCrystalfontz128x128);
+    Crystalfontz128x128_Command(CM_NORON);
+}
+
+
+//*****************************************************************************
+//
+//! Returns true while the panel is limited to a band of rows.
+//
+//*****************************************************************************
+bool Crystalfontz128x128_IsPartial(void)
+{
+    return Lcd_Partial;
+}
+
+
+//*****************************************************************************
+//
+//! Draws a two-colour bitmap into one window.
+//!
+//! \param x0, y0, x1, y1 are the inclusive window corners in screen
+//! coordinates, already clipped to the display.
+//! \param pucBits points to the 1bpp bitmap row for line y0.  Each row starts
+//! at column x0, most significant bit first: column x0 + i is bit
+//! (7 - i % 8) of pucBits[i / 8].
+//! \param usStride is the number of bytes between bitmap rows.
+//! \param ulForeground, ulBackground are the display-native colours used for
+//! set and clear bits.
+//!
+//! The whole window is sent with a single RAMWR, or written into the
+//! framebuffer while buffered.  Used by the text blitter so a string costs
+//! one window instead of a line or pixel primitive per run of each glyph.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void Crystalfontz128x128_BlitMono(int16_t x0, int16_t y0,
+                                  int16_t x1, int16_t y1,
+                                  const uint8_t *pucBits, uint16_t usStride,
+                                  uint16_t ulForeground, uint16_t ulBackground)
+{
+    int16_t i, y, width = x1 - x0 + 1;
+
+    if ((x0 > x1) || (y0 > y1))
+    {
+        return;
+    }
+
+#if LCD_FRAMEBUFFER
+    if (Lcd_Buffered)
+    {
+        Crystalfontz128x128_MarkDirty(x0, y0, x1, y1);
+        for (y = y0; y <= y1; y++, pucBits += usStride)
+        {
+            uint16_t *pixel = &Lcd_FrameBuffer[y][x0];
+            for (i = 0; i < width; i++)
+            {
+                *pixel++ = ((pucBits[i >> 3] >> (7 - (i & 7))) & 1) ?
+                           ulForeground : ulBackground;
+            }
+        }
+        return;
+    }
+#endif
+
+    Crystalfontz128x128_SetDrawFrame(x0, y0, x1, y1);
+    Crystalfontz128x128_Command(CM_RAMWR);
+    Crystalfontz128x128_SpanBegin();
+
+    for (y = y0; y <= y1; y++, pucBits += usStride)
+    {
+        for (i = 0; i < width; i++)
+        {
+            Crystalfontz128x128_SpanPut(((pucBits[i >> 3] >> (7 - (i & 7))) & 1) ?
+                                        ulForeground : ulBackground);
+        }
+    }
+
+    Crystalfontz128x128_SpanEnd();
 }
 
 
@@ -205,6 +943,12 @@ void Crystalfontz128x128_SetOrientation(uint8_t orientation)
 //! This function sets the given pixel to a particular color.  The coordinates
 //! of the pixel are assumed to be within the extents of the display.
 //!
+//! The window is opened from the pixel to the right edge of the screen, so a
+//! following PixelDraw on the next address only needs its two data bytes:
+//! glyph rendering draws long left-to-right runs of single pixels.  In RGB444
+//! a lone pixel is padded to two bytes, so a run cannot be continued and each
+//! pixel sets its own window.
+//!
 //! \return None.
 //
 //*****************************************************************************
@@ -213,15 +957,38 @@ static void Crystalfontz128x128_PixelDraw(const Graphics_Display *pDisplay,
                                           int16_t lY,
                                           uint16_t ulValue)
 {
+#if LCD_FRAMEBUFFER
+    if (Lcd_Buffered)
+    {
+        Lcd_FrameBuffer[lY][lX] = ulValue;
+        Lcd_DirtyTiles[lY / LCD_TILE_SIZE] |= 1 << (lX / LCD_TILE_SIZE);
+        return;
+    }
+#endif
 
-    Crystalfontz128x128_SetDrawFrame(lX,lY,lX,lY);
+    if (!Lcd_PixelRunOpen || (lX != Lcd_PixelRunX) || (lY != Lcd_PixelRunY))
+    {
+        Crystalfontz128x128_SetDrawFrame(lX, lY, LCD_HORIZONTAL_MAX - 1, lY);
+        Crystalfontz128x128_Command(CM_RAMWR);
+    }
 
     //
     // Write the pixel value.
     //
-    HAL_LCD_writeCommand(CM_RAMWR);
+    if (Lcd_ColorMode == LCD_COLOR_MODE_RGB444)
+    {
+        HAL_LCD_writeData(ulValue>>4);
+        HAL_LCD_writeData(ulValue<<4);
+        Lcd_PixelRunOpen = false;
+        return;
+    }
+
     HAL_LCD_writeData(ulValue>>8);
     HAL_LCD_writeData(ulValue);
+
+    Lcd_PixelRunX = lX + 1;
+    Lcd_PixelRunY = lY;
+    Lcd_PixelRunOpen = (Lcd_PixelRunX < LCD_HORIZONTAL_MAX);
 }
 
 
@@ -264,8 +1031,20 @@ static void Crystalfontz128x128_PixelDrawMultiple(const Graphics_Display *pDispl
     //
     // Set the cursor increment to left to right, followed by top to bottom.
     //
-    Crystalfontz128x128_SetDrawFrame(lX,lY,lX+lCount,127);
-    HAL_LCD_writeCommand(CM_RAMWR);
+#if LCD_FRAMEBUFFER
+    if (Lcd_Buffered)
+    {
+        Crystalfontz128x128_MarkDirty(lX, lY, lX + lCount - 1, lY);
+        Crystalfontz128x128_SpanBegin();
+        Lcd_SpanTarget = &Lcd_FrameBuffer[lY][lX];
+    }
+    else
+#endif
+    {
+        Crystalfontz128x128_SetDrawFrame(lX,lY,lX+lCount,127);
+        Crystalfontz128x128_Command(CM_RAMWR);
+        Crystalfontz128x128_SpanBegin();
+    }
 
     //
     // Determine how to interpret the pixel data based on the number of bits
@@ -286,9 +1065,7 @@ static void Crystalfontz128x128_PixelDrawMultiple(const Graphics_Display *pDispl
                 for(; (lX0 < 8) && lCount; lX0++, lCount--)
                 {
                     // Draw this pixel in the appropriate color
-                    HAL_LCD_writeData((((uint32_t *)pucPalette)[(Data >>
-                                                             (7 - lX0)) & 1])>>8);
-                    HAL_LCD_writeData(((uint32_t *)pucPalette)[(Data >>
+                    Crystalfontz128x128_SpanPut(((uint32_t *)pucPalette)[(Data >>
                                                              (7 - lX0)) & 1]);
                 }
 
@@ -321,8 +1098,7 @@ static void Crystalfontz128x128_PixelDrawMultiple(const Graphics_Display *pDispl
                         Data = (*pucData >> 4);
                         Data = (*(uint16_t *)(pucPalette + Data));
                         // Write to LCD screen
-                        HAL_LCD_writeData(Data>>8);
-                        HAL_LCD_writeData(Data);
+                        Crystalfontz128x128_SpanPut(Data);
 
                         // Decrement the count of pixels to draw
                         lCount--;
@@ -337,8 +1113,7 @@ static void Crystalfontz128x128_PixelDrawMultiple(const Graphics_Display *pDispl
                             Data = (*pucData++ & 15);
                             Data = (*(uint16_t *)(pucPalette + Data));
                             // Write to LCD screen
-                            HAL_LCD_writeData(Data>>8);
-                            HAL_LCD_writeData(Data);
+                            Crystalfontz128x128_SpanPut(Data);
 
                             // Decrement the count of pixels to draw
                             lCount--;
@@ -361,8 +1136,7 @@ static void Crystalfontz128x128_PixelDrawMultiple(const Graphics_Display *pDispl
                 Data = *pucData++;
                 Data = (*(uint16_t *)(pucPalette + Data));
                 // Write to LCD screen
-                HAL_LCD_writeData(Data>>8);
-                HAL_LCD_writeData(Data);
+                Crystalfontz128x128_SpanPut(Data);
             }
             // The image data has been drawn
             break;
@@ -388,11 +1162,12 @@ static void Crystalfontz128x128_PixelDrawMultiple(const Graphics_Display *pDispl
                 pucData += 2;
 
                 // Translate this palette entry and write it to the screen
-                HAL_LCD_writeData(usData>>8);
-                HAL_LCD_writeData(usData);
+                Crystalfontz128x128_SpanPut(usData);
             }
         }
     }
+
+    Crystalfontz128x128_SpanEnd();
 }
 
 
@@ -419,20 +1194,21 @@ static void Crystalfontz128x128_LineDrawH(const Graphics_Display *pDisplay,
                                           int16_t lY,
                                           uint16_t ulValue)
 {
-
+#if LCD_FRAMEBUFFER
+    if (Lcd_Buffered)
+    {
+        Crystalfontz128x128_BufferFill(lX1, lY, lX2, lY, ulValue);
+        return;
+    }
+#endif
 
     Crystalfontz128x128_SetDrawFrame(lX1, lY, lX2, lY);
 
     //
     // Write the pixel value.
     //
-    int16_t i;
-    HAL_LCD_writeCommand(CM_RAMWR);
-    for (i = lX1; i <= lX2; i++)
-    {
-        HAL_LCD_writeData(ulValue>>8);
-        HAL_LCD_writeData(ulValue);
-    }
+    Crystalfontz128x128_Command(CM_RAMWR);
+    Crystalfontz128x128_Fill(ulValue, lX2 - lX1 + 1);
 }
 
 
@@ -459,18 +1235,21 @@ static void Crystalfontz128x128_LineDrawV(const Graphics_Display *pDisplay,
                                           int16_t lY2,
                                           uint16_t ulValue)
 {
+#if LCD_FRAMEBUFFER
+    if (Lcd_Buffered)
+    {
+        Crystalfontz128x128_BufferFill(lX, lY1, lX, lY2, ulValue);
+        return;
+    }
+#endif
+
     Crystalfontz128x128_SetDrawFrame(lX, lY1, lX, lY2);
 
     //
     // Write the pixel value.
     //
-    int16_t i;
-    HAL_LCD_writeCommand(CM_RAMWR);
-    for (i = lY1; i <= lY2; i++)
-    {
-        HAL_LCD_writeData(ulValue>>8);
-        HAL_LCD_writeData(ulValue);
-    }
+    Crystalfontz128x128_Command(CM_RAMWR);
+    Crystalfontz128x128_Fill(ulValue, lY2 - lY1 + 1);
 }
 
 
@@ -500,19 +1279,22 @@ static void Crystalfontz128x128_RectFill(const Graphics_Display *pDisplay,
     int16_t y0 = pRect->sYMin;
     int16_t y1 = pRect->sYMax;
 
+#if LCD_FRAMEBUFFER
+    if (Lcd_Buffered)
+    {
+        Crystalfontz128x128_BufferFill(x0, y0, x1, y1, ulValue);
+        return;
+    }
+#endif
+
     Crystalfontz128x128_SetDrawFrame(x0, y0, x1, y1);
 
     //
-    // Write the pixel value.
+    // Write the pixel value.  The window holds exactly this many pixels.
     //
-    int16_t i;
-    int16_t pixels = (x1 - x0 + 1) * (y1 - y0 + 1);
-    HAL_LCD_writeCommand(CM_RAMWR);
-    for (i = 0; i <= pixels; i++)
-    {
-        HAL_LCD_writeData(ulValue>>8);
-        HAL_LCD_writeData(ulValue);
-    }
+    uint32_t pixels = (uint32_t)(x1 - x0 + 1) * (y1 - y0 + 1);
+    Crystalfontz128x128_Command(CM_RAMWR);
+    Crystalfontz128x128_Fill(ulValue, pixels);
 }
 
 //*****************************************************************************
@@ -535,6 +1317,16 @@ static void Crystalfontz128x128_RectFill(const Graphics_Display *pDisplay,
 static uint32_t Crystalfontz128x128_ColorTranslate(const Graphics_Display *pDisplay,
                                                    uint32_t ulValue)
 {
+    //
+    // Translate from a 24-bit RGB color to a 4-4-4 RGB color.
+    //
+    if (Lcd_ColorMode == LCD_COLOR_MODE_RGB444)
+    {
+        return(((((ulValue) & 0x00f00000) >> 12) |
+                (((ulValue) & 0x0000f000) >> 8) |
+                (((ulValue) & 0x000000f0) >> 4)));
+    }
+
     //
     // Translate from a 24-bit RGB color to a 5-6-5 RGB color.
     //
@@ -551,10 +1343,13 @@ static uint32_t Crystalfontz128x128_ColorTranslate(const Graphics_Display *pDisp
 //! \param pDisplay is a pointer to the driver-specific data for this
 //! display driver.
 //!
-//! This functions flushes any cached drawing operations to the display.  This
-//! is useful when a local frame buffer is used for drawing operations, and the
-//! flush would copy the local frame buffer to the display.  For the SSD2119
-//! driver, the flush is a no operation.
+//! This functions flushes any cached drawing operations to the display.  When
+//! the driver is buffered (see Crystalfontz128x128_SetBuffered()), the dirty
+//! tiles are merged into rectangles - runs of adjacent tiles in a row,
+//! extended downwards while the rows below are dirty over the same run - and
+//! each rectangle is sent with a single RAMWR.  In partial mode only the
+//! tile rows overlapping the band are sent.  Otherwise there is nothing to
+//! be done.
 //!
 //! \return None.
 //
@@ -562,9 +1357,57 @@ static uint32_t Crystalfontz128x128_ColorTranslate(const Graphics_Display *pDisp
 static void
 Crystalfontz128x128_Flush(const Graphics_Display *pDisplay)
 {
-    //
-    // There is nothing to be done.
-    //
+#if LCD_FRAMEBUFFER
+    int16_t t, ty, tyFirst, tyLast, tyEnd, first, last;
+    uint16_t run;
+
+    if (!Lcd_Buffered)
+    {
+        return;
+    }
+
+    // Rows the panel is not scanning are left for later
+    tyFirst = Lcd_Partial ? Lcd_PartialY0 / LCD_TILE_SIZE : 0;
+    tyLast = Lcd_Partial ? Lcd_PartialY1 / LCD_TILE_SIZE : LCD_TILE_ROWS - 1;
+
+    for (ty = tyFirst; ty <= tyLast; ty++)
+    {
+        while (Lcd_DirtyTiles[ty])
+        {
+            // Find the first run of dirty tiles in this row
+            first = 0;
+            while (!(Lcd_DirtyTiles[ty] & (1 << first)))
+            {
+                first++;
+            }
+            last = first;
+            while ((last + 1 < LCD_TILE_COLUMNS) &&
+                   (Lcd_DirtyTiles[ty] & (1 << (last + 1))))
+            {
+                last++;
+            }
+            run = (uint16_t)((0xFFFFu >> (LCD_TILE_COLUMNS - 1 - last)) & (0xFFFFu << first));
+
+            // Grow it downwards while the same run is dirty
+            tyEnd = ty;
+            while ((tyEnd < tyLast) &&
+                   ((Lcd_DirtyTiles[tyEnd + 1] & run) == run))
+            {
+                tyEnd++;
+            }
+
+            Crystalfontz128x128_BufferSend(first * LCD_TILE_SIZE,
+                                           ty * LCD_TILE_SIZE,
+                                           (last + 1) * LCD_TILE_SIZE - 1,
+                                           (tyEnd + 1) * LCD_TILE_SIZE - 1);
+
+            for (t = ty; t <= tyEnd; t++)
+            {
+                Lcd_DirtyTiles[t] &= ~run;
+            }
+        }
+    }
+#endif
 }
 
 
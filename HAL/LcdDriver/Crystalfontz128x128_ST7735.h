@@ -48,6 +48,27 @@
 #define LCD_VERTICAL_MAX                   128
 #define LCD_HORIZONTAL_MAX                 128
 
+// Set to 1 to compile in the off-screen framebuffer (32 KB of SRAM) used by
+// Crystalfontz128x128_SetBuffered()
+#ifndef LCD_FRAMEBUFFER
+#define LCD_FRAMEBUFFER                    1
+#endif
+
+// Dirty regions are tracked in square tiles of this many pixels
+#define LCD_TILE_SIZE                      8
+#define LCD_TILE_COLUMNS                   (LCD_HORIZONTAL_MAX / LCD_TILE_SIZE)
+#define LCD_TILE_ROWS                      (LCD_VERTICAL_MAX / LCD_TILE_SIZE)
+
+// Pixel formats for Crystalfontz128x128_SetColorMode(), as COLMOD values.
+// RGB444 sends 25% fewer bytes per pixel than RGB565.
+#define LCD_COLOR_MODE_RGB444              0x03
+#define LCD_COLOR_MODE_RGB565              0x05
+
+// Pixel format used until Crystalfontz128x128_SetColorMode() is called
+#ifndef LCD_COLOR_MODE
+#define LCD_COLOR_MODE                     LCD_COLOR_MODE_RGB565
+#endif
+
 #define LCD_ORIENTATION_UP    0
 #define LCD_ORIENTATION_LEFT  1
 #define LCD_ORIENTATION_DOWN  2
@@ -103,10 +124,35 @@ extern const Graphics_Display_Functions g_sCrystalfontz128x128_funcs;
 
 extern void Crystalfontz128x128_Init(void);
 
+extern void Crystalfontz128x128_StartInit(void);
+
+extern bool Crystalfontz128x128_PollInit(void);
+
+extern void Crystalfontz128x128_SetColorMode(uint8_t mode);
+
+extern uint8_t Crystalfontz128x128_GetColorMode(void);
+
 extern void Crystalfontz128x128_SetDrawFrame(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
 
+extern void Crystalfontz128x128_InvalidateWindow(void);
+
 extern void Crystalfontz128x128_SetOrientation(uint8_t orientation);
 
+extern void Crystalfontz128x128_SetBuffered(bool buffered);
+
+extern bool Crystalfontz128x128_IsBuffered(void);
+
+extern bool Crystalfontz128x128_SetPartialArea(uint16_t y0, uint16_t y1);
+
+extern void Crystalfontz128x128_SetNormalMode(void);
+
+extern bool Crystalfontz128x128_IsPartial(void);
+
+extern void Crystalfontz128x128_BlitMono(int16_t x0, int16_t y0,
+                                         int16_t x1, int16_t y1,
+                                         const uint8_t *pucBits, uint16_t usStride,
+                                         uint16_t ulForeground, uint16_t ulBackground);
+
 
 
 #endif /* __CRYSTALFONTZLCD_H__ */
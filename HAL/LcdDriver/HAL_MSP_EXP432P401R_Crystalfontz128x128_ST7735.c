@@ -41,6 +41,46 @@
 #include <ti/grlib/grlib.h>
 #include <ti/devices/msp432p4xx/driverlib/driverlib.h>
 #include <stdint.h>
+#include <string.h>
+
+//*****************************************************************************
+//
+// Transfer engine state.  The uDMA control table has to be aligned to 1024
+// bytes.  Two staging buffers let the driver build the next span while the
+// previous one is still being shifted out; the fill buffer holds the repeated
+// pattern used for solid fills, as many whole copies as fit.
+//
+//*****************************************************************************
+#if LCD_USE_DMA
+#if defined( __TI_ARM__ )
+#pragma DATA_ALIGN(Lcd_DmaControlTable, 1024)
+uint8_t Lcd_DmaControlTable[1024];
+#elif defined( __IAR_SYSTEMS_ICC__ )
+#pragma data_alignment=1024
+uint8_t Lcd_DmaControlTable[1024];
+#else
+uint8_t Lcd_DmaControlTable[1024] __attribute__ ((aligned (1024)));
+#endif
+
+static uint8_t Lcd_FillBuffer[LCD_DMA_BUFFER_SIZE];
+static uint8_t Lcd_FillPattern[LCD_FILL_PATTERN_MAX];
+static uint8_t Lcd_FillPatternSize = 0;
+
+// Bytes of Lcd_FillBuffer holding whole copies of the pattern
+static uint16_t Lcd_FillChunk;
+#endif
+
+static uint8_t Lcd_StagingBuffer[2][LCD_DMA_BUFFER_SIZE];
+static uint8_t Lcd_StagingIndex = 0;
+
+// Set while a uDMA transfer (or a chain of fill transfers) is in flight
+static volatile bool Lcd_DmaBusy = false;
+
+// Bytes of the current fill which still have to be handed to the uDMA
+static volatile uint32_t Lcd_FillRemaining = 0;
+
+// DWT cycle count at which the current HAL_LCD_startTimeout() period ends
+static uint32_t Lcd_TimeoutEnd;
 
 void HAL_LCD_PortInit(void)
 {
@@ -76,6 +116,331 @@ void HAL_LCD_SpiInit(void)
     GPIO_setOutputHighOnPin(LCD_DC_PORT, LCD_DC_PIN);
 }
 
+//*****************************************************************************
+//
+// Configures the uDMA channel wired to EUSCI_B0 TX.  Every transfer moves
+// bytes from memory into UCB0TXBUF, paced by UCTXIFG, and raises LCD_DMA_INT
+// on completion.
+//
+//*****************************************************************************
+void HAL_LCD_DmaInit(void)
+{
+#if LCD_USE_DMA
+    DMA_enableModule();
+    DMA_setControlBase(Lcd_DmaControlTable);
+
+    DMA_assignChannel(LCD_DMA_CHANNEL);
+    DMA_disableChannelAttribute(LCD_DMA_CHANNEL,
+                                UDMA_ATTR_ALTSELECT | UDMA_ATTR_USEBURST |
+                                UDMA_ATTR_HIGH_PRIORITY | UDMA_ATTR_REQMASK);
+    DMA_setChannelControl(UDMA_PRI_SELECT | LCD_DMA_CHANNEL,
+                          UDMA_SIZE_8 | UDMA_SRC_INC_8 | UDMA_DST_INC_NONE |
+                          UDMA_ARB_1);
+
+    DMA_assignInterrupt(LCD_DMA_INT, LCD_DMA_CHANNEL_NUM);
+    DMA_clearInterruptFlag(LCD_DMA_CHANNEL_NUM);
+    Interrupt_enableInterrupt(LCD_DMA_INT_NUM);
+#endif
+    Lcd_DmaBusy = false;
+    Lcd_FillRemaining = 0;
+}
+
+
+#if LCD_USE_DMA
+//*****************************************************************************
+//
+// Starts one uDMA transfer.  The first byte is written by the CPU: the eUSCI
+// only requests a transfer on a rising edge of UCTXIFG, which happens when
+// that byte moves into the shift register.  With the shift register idle
+// that is a cycle or two after the write, so the channel is armed first.
+//
+//*****************************************************************************
+static void HAL_LCD_startTransfer(const uint8_t *data, uint16_t length)
+{
+    while (!(UCB0IFG & UCTXIFG));
+
+    if (length == 1)
+    {
+        UCB0TXBUF = data[0];
+
+        // Nothing left for the uDMA, so the transfer is complete already
+        if (Lcd_FillRemaining == 0)
+        {
+            Lcd_DmaBusy = false;
+        }
+        return;
+    }
+
+    DMA_setChannelTransfer(UDMA_PRI_SELECT | LCD_DMA_CHANNEL,
+                           UDMA_MODE_BASIC, (void *) (data + 1),
+                           (void *) SPI_getTransmitBufferAddressForDMA(LCD_EUSCI_BASE),
+                           length - 1);
+    DMA_enableChannel(LCD_DMA_CHANNEL_NUM);
+    UCB0TXBUF = data[0];
+}
+
+
+//*****************************************************************************
+//
+// Hands the next chunk of a fill to the uDMA.  Called from the caller's
+// context for the first chunk and from DMA_INT1_IRQHandler() for the rest.
+//
+//*****************************************************************************
+static void HAL_LCD_continueFill(void)
+{
+    uint16_t length = Lcd_FillChunk;
+
+    if (Lcd_FillRemaining < length)
+    {
+        length = (uint16_t) Lcd_FillRemaining;
+    }
+    Lcd_FillRemaining -= length;
+
+    HAL_LCD_startTransfer(Lcd_FillBuffer, length);
+}
+
+
+//*****************************************************************************
+//
+// uDMA completion interrupt for the LCD channel.  Chains the next chunk of a
+// fill, or marks the transfer engine idle.
+//
+//*****************************************************************************
+void DMA_INT1_IRQHandler(void)
+{
+    DMA_clearInterruptFlag(LCD_DMA_CHANNEL_NUM);
+
+    if (Lcd_FillRemaining)
+    {
+        HAL_LCD_continueFill();
+    }
+    else
+    {
+        Lcd_DmaBusy = false;
+    }
+}
+#endif
+
+
+//*****************************************************************************
+//
+// Boot runs with interrupts masked, so the uDMA completion interrupt cannot
+// do its job then.  A finished transfer is spotted instead by its BASIC mode
+// channel having disabled itself, and the handler is run from the caller's
+// context.
+//
+//*****************************************************************************
+static void HAL_LCD_serviceDma(void)
+{
+#if LCD_USE_DMA
+    if (Lcd_DmaBusy && __get_PRIMASK() &&
+        !DMA_isChannelEnabled(LCD_DMA_CHANNEL_NUM))
+    {
+        Interrupt_unpendInterrupt(LCD_DMA_INT_NUM);
+        DMA_INT1_IRQHandler();
+    }
+#endif
+}
+
+
+//*****************************************************************************
+//
+// Waits for the uDMA to go idle.
+//
+//*****************************************************************************
+static void HAL_LCD_waitForDma(void)
+{
+    while (Lcd_DmaBusy)
+    {
+        HAL_LCD_serviceDma();
+    }
+}
+
+
+//*****************************************************************************
+//
+// Returns true while a span handed to HAL_LCD_writeDataBlock() or
+// HAL_LCD_fillData() is still being transmitted.
+//
+//*****************************************************************************
+bool HAL_LCD_isBusy(void)
+{
+    HAL_LCD_serviceDma();
+    return Lcd_DmaBusy || (UCB0STATW & UCBUSY);
+}
+
+
+//*****************************************************************************
+//
+// Blocks until every queued byte has left the shift register.  Anything that
+// toggles the DC line has to call this first.
+//
+//*****************************************************************************
+void HAL_LCD_waitForTransfer(void)
+{
+    HAL_LCD_waitForDma();
+    while (UCB0STATW & UCBUSY);
+}
+
+
+//*****************************************************************************
+//
+// Returns a staging buffer of LCD_DMA_BUFFER_SIZE bytes which is not owned by
+// the transfer engine.  Buffers alternate, so the next span can be built
+// while the previous one is still being sent.
+//
+//*****************************************************************************
+uint8_t *HAL_LCD_getStagingBuffer(void)
+{
+    Lcd_StagingIndex ^= 1;
+    return Lcd_StagingBuffer[Lcd_StagingIndex];
+}
+
+
+//*****************************************************************************
+//
+// Streams a block of data bytes with the CPU.  TXBUF is reloaded as soon as
+// UCTXIFG reports it empty, so bytes go out back to back; the shift register
+// is only waited on once, after the last byte.
+//
+//*****************************************************************************
+void HAL_LCD_streamData(const uint8_t *data, uint32_t length)
+{
+    // Pending span? //
+    HAL_LCD_waitForDma();
+
+    while (length--)
+    {
+        while (!(UCB0IFG & UCTXIFG));
+        UCB0TXBUF = *data++;
+    }
+
+    // USCI_B0 Busy? //
+    while (UCB0STATW & UCBUSY);
+}
+
+
+//*****************************************************************************
+//
+// Streams a pattern of size bytes count times with the CPU, keeping TXBUF fed
+// the same way as HAL_LCD_streamData().
+//
+//*****************************************************************************
+void HAL_LCD_streamPattern(const uint8_t *pattern, uint8_t size, uint32_t count)
+{
+    uint8_t i;
+
+    // Pending span? //
+    HAL_LCD_waitForDma();
+
+    while (count--)
+    {
+        for (i = 0; i < size; i++)
+        {
+            while (!(UCB0IFG & UCTXIFG));
+            UCB0TXBUF = pattern[i];
+        }
+    }
+
+    // USCI_B0 Busy? //
+    while (UCB0STATW & UCBUSY);
+}
+
+
+//*****************************************************************************
+//
+// Streams the 16-bit pattern (high, low) count times with the CPU.
+//
+//*****************************************************************************
+void HAL_LCD_streamFill(uint8_t high, uint8_t low, uint32_t count)
+{
+    const uint8_t pattern[2] = { high, low };
+
+    HAL_LCD_streamPattern(pattern, 2, count);
+}
+
+
+//*****************************************************************************
+//
+// Sends a block of data bytes.  With LCD_USE_DMA the call returns as soon as
+// the transfer has started, so the data must stay untouched until the engine
+// is idle again.  Buffers from HAL_LCD_getStagingBuffer() satisfy this.
+//
+//*****************************************************************************
+void HAL_LCD_writeDataBlock(const uint8_t *data, uint16_t length)
+{
+    if (length == 0)
+    {
+        return;
+    }
+
+#if LCD_USE_DMA
+    if (length >= LCD_DMA_MIN_LENGTH)
+    {
+        HAL_LCD_waitForDma();
+        Lcd_DmaBusy = true;
+        HAL_LCD_startTransfer(data, length);
+        return;
+    }
+#endif
+    HAL_LCD_streamData(data, length);
+}
+
+
+//*****************************************************************************
+//
+// Sends a pattern of size bytes (at most LCD_FILL_PATTERN_MAX) count times,
+// e.g. one colour for every pixel of a rectangle: two bytes per pixel in
+// RGB565, three bytes per pixel pair in RGB444.  With LCD_USE_DMA the pattern
+// is replicated once into the fill buffer, which the uDMA interrupt then
+// re-sends chunk by chunk.
+//
+//*****************************************************************************
+void HAL_LCD_fillPattern(const uint8_t *pattern, uint8_t size, uint32_t count)
+{
+#if LCD_USE_DMA
+    if (count * size < LCD_DMA_MIN_LENGTH)
+    {
+        HAL_LCD_streamPattern(pattern, size, count);
+        return;
+    }
+
+    HAL_LCD_waitForDma();
+
+    if ((size != Lcd_FillPatternSize) ||
+        (memcmp(pattern, Lcd_FillPattern, size) != 0))
+    {
+        uint16_t i;
+        Lcd_FillChunk = LCD_DMA_BUFFER_SIZE - LCD_DMA_BUFFER_SIZE % size;
+        for (i = 0; i < Lcd_FillChunk; i++)
+        {
+            Lcd_FillBuffer[i] = pattern[i % size];
+        }
+        memcpy(Lcd_FillPattern, pattern, size);
+        Lcd_FillPatternSize = size;
+    }
+
+    Lcd_DmaBusy = true;
+    Lcd_FillRemaining = count * size;
+    HAL_LCD_continueFill();
+#else
+    HAL_LCD_streamPattern(pattern, size, count);
+#endif
+}
+
+
+//*****************************************************************************
+//
+// Sends the 16-bit pattern (high, low) count times.
+//
+//*****************************************************************************
+void HAL_LCD_fillData(uint8_t high, uint8_t low, uint32_t count)
+{
+    const uint8_t pattern[2] = { high, low };
+
+    HAL_LCD_fillPattern(pattern, 2, count);
+}
+
 
 //*****************************************************************************
 //
@@ -85,6 +450,9 @@ void HAL_LCD_SpiInit(void)
 //*****************************************************************************
 void HAL_LCD_writeCommand(uint8_t command)
 {
+    // Let any pending span finish before the DC line changes
+    HAL_LCD_waitForTransfer();
+
     // Set to command mode
     GPIO_setOutputLowOnPin(LCD_DC_PORT, LCD_DC_PIN);
 
@@ -110,14 +478,42 @@ void HAL_LCD_writeCommand(uint8_t command)
 //*****************************************************************************
 void HAL_LCD_writeData(uint8_t data)
 {
-    // USCI_B0 Busy? //
-    while (UCB0STATW & UCBUSY);
+    // Pending span? //
+    HAL_LCD_waitForDma();
 
-    // Transmit data
+    // TXBUF empty? //
+    while (!(UCB0IFG & UCTXIFG));
+
+    // Transmit data.  HAL_LCD_writeCommand() waits for the shift register
+    // before it changes DC, so there is no need to wait here.
     UCB0TXBUF = data;
+}
 
-    // USCI_B0 Busy? //
-    while (UCB0STATW & UCBUSY);
+//*****************************************************************************
+//
+// Starts a timeout of the given number of microseconds, measured on the DWT
+// cycle counter, so that controller delays can be waited out without
+// spinning.  Poll HAL_LCD_isTimedOut() to see when it has passed.
+//
+//*****************************************************************************
+void HAL_LCD_startTimeout(uint32_t microseconds)
+{
+    // The counter free-runs once enabled; enabling it again is harmless
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    Lcd_TimeoutEnd = DWT->CYCCNT + microseconds * LCD_CYCLES_PER_US;
+}
+
+
+//*****************************************************************************
+//
+// Returns true once the period started by HAL_LCD_startTimeout() has passed.
+//
+//*****************************************************************************
+bool HAL_LCD_isTimedOut(void)
+{
+    return (int32_t) (DWT->CYCCNT - Lcd_TimeoutEnd) >= 0;
 }
 
 //*****************************************************************************
@@ -154,7 +550,7 @@ SysCtlDelay(uint32_t ui32Count)
           "    bx      lr");
 }
 #endif
-#if defined(codered) || defined( __GNUC__ ) || defined(sourcerygxx)
+#if (defined(codered) || defined( __GNUC__ ) || defined(sourcerygxx)) && defined(__arm__)
 void __attribute__((naked))
 SysCtlDelay(uint32_t ui32Count)
 {
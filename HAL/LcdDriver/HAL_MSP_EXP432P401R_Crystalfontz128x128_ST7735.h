@@ -53,6 +53,8 @@
 #define LCD_SYSTEM_CLOCK_SPEED                 48000000
 // SPI clock speed (in Hz)
 #define LCD_SPI_CLOCK_SPEED                    16000000
+// System clock cycles per microsecond, for timeouts on the DWT cycle counter
+#define LCD_CYCLES_PER_US                      (LCD_SYSTEM_CLOCK_SPEED / 1000000)
 
 // Ports from MSP432 connected to LCD
 #define LCD_SCK_PORT          GPIO_PORT_P1
@@ -73,6 +75,28 @@
 // Definition of USCI base address to be used for SPI communication
 #define LCD_EUSCI_BASE        EUSCI_B0_BASE
 
+// Set to 1 to hand pixel spans to the uDMA engine, 0 for CPU writes only
+#ifndef LCD_USE_DMA
+#define LCD_USE_DMA           1
+#endif
+
+// uDMA channel, completion interrupt and channel number for EUSCI_B0 TX
+#define LCD_DMA_CHANNEL       DMA_CH0_EUSCIB0TX0
+#define LCD_DMA_CHANNEL_NUM   0
+#define LCD_DMA_INT           DMA_INT1
+#define LCD_DMA_INT_NUM       INT_DMA_INT1
+
+// Size (in bytes) of each staging buffer and of each chained uDMA transfer.
+// Must be even and no larger than 1024, the uDMA transfer size limit.
+#define LCD_DMA_BUFFER_SIZE   256
+
+// Spans shorter than this (in bytes) are streamed by the CPU, since setting
+// up a uDMA transfer costs more than it saves
+#define LCD_DMA_MIN_LENGTH    16
+
+// Longest repeated pattern HAL_LCD_fillPattern() takes: one RGB444 pixel pair
+#define LCD_FILL_PATTERN_MAX  3
+
 //*****************************************************************************
 //
 // Prototypes for the globals exported by this driver.
@@ -82,6 +106,18 @@ extern void HAL_LCD_writeCommand(uint8_t command);
 extern void HAL_LCD_writeData(uint8_t data);
 extern void HAL_LCD_PortInit(void);
 extern void HAL_LCD_SpiInit(void);
+extern void HAL_LCD_DmaInit(void);
+extern uint8_t *HAL_LCD_getStagingBuffer(void);
+extern void HAL_LCD_writeDataBlock(const uint8_t *data, uint16_t length);
+extern void HAL_LCD_fillData(uint8_t high, uint8_t low, uint32_t count);
+extern void HAL_LCD_fillPattern(const uint8_t *pattern, uint8_t size, uint32_t count);
+extern void HAL_LCD_streamData(const uint8_t *data, uint32_t length);
+extern void HAL_LCD_streamFill(uint8_t high, uint8_t low, uint32_t count);
+extern void HAL_LCD_streamPattern(const uint8_t *pattern, uint8_t size, uint32_t count);
+extern bool HAL_LCD_isBusy(void);
+extern void HAL_LCD_waitForTransfer(void);
+extern void HAL_LCD_startTimeout(uint32_t microseconds);
+extern bool HAL_LCD_isTimedOut(void);
 
 // Custom __delay_cycles() for non CCS Compiler
 #if !defined( __TI_ARM__ )
@@ -0,0 +1,96 @@
+/*
+ * Sampler.c
+ *
+ *  Created on: Nov 28, 2024
+ */
+
+#include <HAL/Sampler.h>
+#include <HAL/Idle.h>
+#include <HAL/AccelRing.h>
+
+static uint32_t sequenceFirst, sequenceLast, sampleLength;
+static uint32_t rate;
+
+// Stops the timer, then the ADC. Setting CONSEQ to single-channel with ENC
+// clear is the only way to stop a repeat sequence at once, rather than at the
+// end of a sequence that no more triggers would finish.
+static void Sampler_stop(void)
+{
+    MAP_Timer_A_stopTimer(SAMPLER_TIMER_BASE);
+    MAP_ADC14_disableConversion();
+    MAP_ADC14_configureSingleSampleMode(sequenceFirst, false);
+    AccelRing_stop();
+}
+
+void Sampler_init(uint32_t firstMem, uint32_t lastMem,
+                  uint32_t conversionsPerSample)
+{
+    sequenceFirst = firstMem;
+    sequenceLast = lastMem;
+    sampleLength = conversionsPerSample;
+    rate = 0;
+
+    Sampler_stop();
+    MAP_ADC14_setSampleHoldTrigger(SAMPLER_TRIGGER, false);
+    MAP_ADC14_enableSampleTimer(ADC_MANUAL_ITERATION);
+}
+
+// Starts the capture, the sequence from its first memory and the timer at one
+// edge per conversion, rounded to the nearest ACLK cycle
+static void Sampler_start(uint32_t hz)
+{
+    uint32_t triggerHz = hz * sampleLength;
+    uint_fast16_t period = (SAMPLER_ACLK_HZ + triggerHz / 2) / triggerHz;
+    const Timer_A_UpModeConfig upConfig = {
+            TIMER_A_CLOCKSOURCE_ACLK,
+            TIMER_A_CLOCKSOURCE_DIVIDER_1,
+            period - 1,
+            TIMER_A_TAIE_INTERRUPT_DISABLE,
+            TIMER_A_CCIE_CCR0_INTERRUPT_DISABLE,
+            TIMER_A_DO_CLEAR };
+    const Timer_A_CompareModeConfig triggerConfig = {
+            TIMER_A_CAPTURECOMPARE_REGISTER_1,
+            TIMER_A_CAPTURECOMPARE_INTERRUPT_DISABLE,
+            TIMER_A_OUTPUTMODE_SET_RESET,
+            period / 2 };
+
+    AccelRing_start(period * sampleLength);
+    MAP_ADC14_configureMultiSequenceMode(sequenceFirst, sequenceLast, true);
+    MAP_ADC14_enableConversion();
+
+    MAP_Timer_A_configureUpMode(SAMPLER_TIMER_BASE, &upConfig);
+    MAP_Timer_A_initCompare(SAMPLER_TIMER_BASE, &triggerConfig);
+    MAP_Timer_A_startCounter(SAMPLER_TIMER_BASE, TIMER_A_UP_MODE);
+}
+
+void Sampler_setRate(uint32_t hz)
+{
+    if (hz > SAMPLER_MAX_HZ)
+    {
+        hz = SAMPLER_MAX_HZ;
+    }
+    if (hz == rate)
+    {
+        return;
+    }
+
+    if (rate)
+    {
+        Sampler_stop();
+    }
+    if (hz)
+    {
+        Idle_hold(IDLE_HOLD_ADC);
+        Sampler_start(hz);
+    }
+    else
+    {
+        Idle_release(IDLE_HOLD_ADC);
+    }
+    rate = hz;
+}
+
+uint32_t Sampler_rate(void)
+{
+    return rate;
+}
@@ -0,0 +1,47 @@
+/*
+ * Sampler.h
+ *
+ *  Created on: Nov 28, 2024
+ *
+ * The accelerometer sampling scheduler.  ADC14 converts its sequence of
+ * conversion memories on a trigger from TIMER_A0 rather than back to back,
+ * so samples come at a set rate, and not at all while the rate is 0.
+ *
+ * The ADC is in repeat-sequence mode with manual iteration: each rising edge
+ * of TA0.1 converts the next memory of the sequence.  TIMER_A0 counts ACLK
+ * in up mode, with CCR1 setting the output partway through each period and
+ * CCR0 resetting it, so it gives one edge per period.  A sample is a few
+ * conversions (one per axis), so it takes that many periods, and the
+ * sequence holds a block of samples, which AccelRing captures.
+ *
+ * While the rate is not 0 the ADC needs its clock and the CPU's, so it holds
+ * the CPU out of LPM3 (IDLE_HOLD_ADC).
+ */
+
+#ifndef HAL_SAMPLER_H_
+#define HAL_SAMPLER_H_
+
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+
+#define SAMPLER_TIMER_BASE      TIMER_A0_BASE
+#define SAMPLER_TRIGGER         ADC_TRIGGER_SOURCE1     // TA0_C1
+#define SAMPLER_ACLK_HZ         32768
+
+// A conversion takes about 20 ADC clocks of ADCOSC/64/8 (410 us), so a
+// sample of three takes over 1.2 ms. This leaves it room.
+#define SAMPLER_MAX_HZ          400
+
+// Sets up the timer and the ADC's trigger for the sequence of memories
+// firstMem..lastMem, which must already be configured, in samples of
+// conversionsPerSample memories each. Sampling is off.
+void Sampler_init(uint32_t firstMem, uint32_t lastMem,
+                  uint32_t conversionsPerSample);
+
+// Takes hz samples a second (at most SAMPLER_MAX_HZ), or none if hz is 0,
+// capturing them into AccelRing. Does nothing if the rate is hz already.
+void Sampler_setRate(uint32_t hz);
+
+// The rate last set
+uint32_t Sampler_rate(void);
+
+#endif /* HAL_SAMPLER_H_ */
@@ -10,35 +10,86 @@
 
 /** The reference counter which tracks how many rollovers have occurred. Used in
  * timing SWTimers. */
-static volatile uint64_t hwTimerRollovers;
+static volatile uint32_t hwTimerRollovers;
 volatile bool gameOver = false;
 
-/**
- * The ISR used to increment the total number of rollovers which have passed.
- * When the TIMER32_0_BASE timer expires, this ISR is automatically called. DO
- * NOT DIRECTLY INVOKE THIS FUNCTION FROM YOUR CODE, or you WILL destroy the
- * accuracy of ALL software timers in your code.
- */
+/** Seconds left in the round, published by the countdown tick, and whether a
+ * tick has happened since countdownTicked() last looked. */
+static volatile int secondsRemaining;
+static volatile bool secondTicked = false;
+
+/** The countdown's one-second tick on the TimerWheel */
+static TimerWheel_Timer countdownTimer;
+
 bool executeCode(void)
 {
     return(hwTimerRollovers % 1000 == 0);
 }
 
-void T32_INT1_IRQHandler(void) {
-    // Clear the interrupt flag
-    MAP_Timer32_clearInterruptFlag(TIMER32_0_BASE);
+/**
+ * The ISR used to increment the total number of rollovers which have passed.
+ * When the SWTIMER_CLOCK_BASE timer expires, this ISR is automatically called.
+ * DO NOT DIRECTLY INVOKE THIS FUNCTION FROM YOUR CODE, or you WILL destroy the
+ * accuracy of ALL software timers in your code.
+ */
+void T32_INT2_IRQHandler(void) {
+    MAP_Timer32_clearInterruptFlag(SWTIMER_CLOCK_BASE);
     hwTimerRollovers++;
+}
 
-    // Logic to handle when the timer expires
-    int remaining_time = get_remaining_time();
-    if (remaining_time <= 0) {
+/**
+ * The round countdown tick, run from the TimerWheel ISR once a second while
+ * the countdown is going.
+ */
+static void countdownTick(void* context) {
+    // One second of the round has gone
+    if (secondsRemaining > 0) {
+        secondsRemaining--;
+    }
+    secondTicked = true;
+
+    if (secondsRemaining == 0) {
         gameOver = true;
-        // Reset the timer for the next round
-        MAP_Timer32_haltTimer(TIMER32_0_BASE);
-        MAP_Timer32_setCount(TIMER32_0_BASE, TIMER_COUNT_VALUE);
-        MAP_Timer32_startTimer(TIMER32_0_BASE, true);
+        // Stop ticking until the next round starts the countdown
+        TimerWheel_cancel(&countdownTimer);
+    }
+}
+
+/**
+ * Starts the round countdown from the given number of seconds, restarting
+ * it if it is already going. The TimerWheel must have been initialized.
+ */
+void startCountdown(int seconds)
+{
+    uint32_t tickTicks = TimerWheel_msToTicks(COUNTDOWN_TICK_MS);
+
+    TimerWheel_cancel(&countdownTimer);
+    secondsRemaining = seconds;
+    secondTicked = true;
+    countdownTimer = TimerWheel_construct(countdownTick, NULL);
+    TimerWheel_start(&countdownTimer, tickTicks, tickTicks);
+}
+
+/**
+ * Returns the seconds left in the round, as of the last tick.
+ */
+int get_remaining_time()
+{
+    return secondsRemaining;
+}
+
+/**
+ * Returns true once after each countdown tick (and after the countdown
+ * starts), so the time shown only has to be redrawn when it has changed.
+ */
+bool countdownTicked()
+{
+    if (secondTicked)
+    {
+        secondTicked = false;
+        return true;
     }
-    //sleep();
+    return false;
 }
 
 void resetgameOver()
@@ -100,33 +151,69 @@ void InitSystemTiming() {
   CS_initClockSignal(CS_SMCLK, CS_DCOCLK_SELECT, CS_CLOCK_DIVIDER_1);
   CS_initClockSignal(CS_ACLK, CS_REFOCLK_SELECT, CS_CLOCK_DIVIDER_1);
 
-  // Initialize the main hardware timer under which all other software timers
-  // are based. This should be a periodic timer with the maximum load value
-  // supported and a prescaler of 1 in order to minimize the frequency of
-  // interrupts while keeping a high timer resolution.
-  Timer32_initModule(TIMER32_0_BASE, TIMER32_PRESCALER_1, TIMER32_32BIT,
+  initSWTimerClock();
+
+  // Enable interrupts again, after all system timing has been set up properly
+  Interrupt_enableMaster();
+}
+
+/**
+ * Starts the main hardware timer under which all other software timers are
+ * based. It has a Timer32 of its own, so nothing else reloads it: the round
+ * countdown runs on TIMER32_0. Interrupts are left masked or unmasked as they
+ * were, so this can run during a masked boot.
+ */
+void initSWTimerClock() {
+  hwTimerRollovers = 0;
+
+  // This should be a periodic timer with the maximum load value supported and
+  // a prescaler of 1 in order to minimize the frequency of interrupts while
+  // keeping a high timer resolution.
+  Timer32_initModule(SWTIMER_CLOCK_BASE, TIMER32_PRESCALER_1, TIMER32_32BIT,
                      TIMER32_PERIODIC_MODE);
-  Timer32_setCount(TIMER32_0_BASE, LOADVALUE);
+  Timer32_setCount(SWTIMER_CLOCK_BASE, LOADVALUE);
 
   // Clear the interrupt flag and enable it. Clearing it gaurantees that we
   // don't get a "leftover" interrupt
-  Timer32_clearInterruptFlag(TIMER32_0_BASE);
-  Interrupt_enableInterrupt(INT_T32_INT1);
+  Timer32_clearInterruptFlag(SWTIMER_CLOCK_BASE);
+  Timer32_enableInterrupt(SWTIMER_CLOCK_BASE);
+  Interrupt_enableInterrupt(SWTIMER_CLOCK_INT);
 
-  // Enable interrupts again, after all system timing has been set up properly
-  Interrupt_enableMaster();
+  // Starts the main reference hardware timer, whose interrupt counts
+  // rollovers
+  Timer32_startTimer(SWTIMER_CLOCK_BASE, false);
+}
 
-  // Starts the main reference hardware timer and enables an interrupt which
-  // counts rollovers
-  Timer32_startTimer(TIMER32_0_BASE, false);
+/**
+ * Reads the monotonic clock. Only T32_INT2_IRQHandler() writes the rollover
+ * count, so a count that reads the same before and after the counter means
+ * the two belong together. If the counter has wrapped but its interrupt is
+ * still pending - because interrupts are masked, or the caller is an ISR that
+ * outranks it - the rollover is added here; a counter still in the top half
+ * of its range was read after that wrap.
+ *
+ * @return the number of cycles since initSWTimerClock()
+ */
+uint64_t Clock_now() {
+  uint32_t rollovers, counter, pending;
 
-  hwTimerRollovers = 0;
+  do {
+    rollovers = hwTimerRollovers;
+    counter = Timer32_getValue(SWTIMER_CLOCK_BASE);
+    pending = Timer32_getInterruptStatus(SWTIMER_CLOCK_BASE);
+  } while (hwTimerRollovers != rollovers);
+
+  if (pending && counter > LOADVALUE / 2) {
+    rollovers++;
+  }
+
+  return ((uint64_t)rollovers << 32) | (LOADVALUE - counter);
 }
 
 /**
  * Constructs a new Software Timer, using a wait time in milliseconds. The timer
  * uses the hwTimerRollovers variable to keep track of its reference time, and
- * is based off of time passing under the TIMER32_0_BASE. When first
+ * is based off of time passing under the SWTIMER_CLOCK_BASE. When first
  * constructed, this timer is NOT conditioned to start. Before any calls to
  * SWTimer_expired(), SWTimer_elapsedTimeUS(), or SWTimer_percentElapsed(), you
  * MUST FIRST CALL the SWTimer_start() method.
@@ -137,8 +224,7 @@ void InitSystemTiming() {
 SWTimer SWTimer_construct(uint64_t waitTime_ms) {
   SWTimer timer;
 
-  timer.startCounter = 0;
-  timer.startRollovers = 0;
+  timer.startCycles = 0;
 
   uint64_t counterClock = SYSTEM_CLOCK / PRESCALER;
   uint64_t cyclesPerMillisecond = counterClock / MS_DIVISION_FACTOR;
@@ -148,14 +234,12 @@ SWTimer SWTimer_construct(uint64_t waitTime_ms) {
 }
 
 /**
- * Starts a constructed timer by reading the current number of rollovers and
- * current load value in TIMER32_0_BASE.
+ * Starts a constructed timer by reading the monotonic clock.
  *
  * @param timer_p:    The SWTimer to start
  */
 void SWTimer_start(SWTimer* timer_p) {
-  timer_p->startCounter = Timer32_getValue(TIMER32_0_BASE);
-  timer_p->startRollovers = hwTimerRollovers;
+  timer_p->startCycles = Clock_now();
 }
 
 /**
@@ -171,13 +255,7 @@ void SWTimer_start(SWTimer* timer_p) {
  * @return the number of cycles elapsed since the timer started.
  */
 uint64_t SWTimer_elapsedCycles(SWTimer* timer_p) {
-  uint64_t rollovers = hwTimerRollovers - timer_p->startRollovers;
-  uint64_t startCounter = timer_p->startCounter;
-  uint64_t currentCounter = Timer32_getValue(TIMER32_0_BASE);
-  uint64_t elapsedCycles =
-      (rollovers * (LOADVALUE + 1)) + startCounter - currentCounter;
-
-  return elapsedCycles;
+  return Clock_now() - timer_p->startCycles;
 }
 
 /**
@@ -9,10 +9,15 @@
 #define HAL_TIMER_H_
 
 #include <ti/devices/msp432p4xx/driverlib/driverlib.h>
-#define TIMER_COUNT_VALUE 2880000000
-//#define TIMER_COUNT_VALUE 19200000
+#include <HAL/TimerWheel.h>
 
+// The round countdown ticks once a second on the TimerWheel, and the game is
+// over when it reaches zero.
+#define COUNTDOWN_TICK_MS 1000
+
+void startCountdown(int seconds);
 int get_remaining_time();
+bool countdownTicked();
 bool gameIsOver();
 void resetgameOver();
 void sleep();
@@ -32,6 +37,67 @@ bool executeCode(void);
 #define LOADVALUE 0xFFFFFFFF
 #define PRESCALER 1
 
+// The free-running Timer32 the software timers count on, and its interrupt
+#define SWTIMER_CLOCK_BASE TIMER32_1_BASE
+#define SWTIMER_CLOCK_INT INT_T32_INT2
+
+/**=================================================================================================
+ * The monotonic clock: cycles of SWTIMER_CLOCK_BASE (SYSTEM_CLOCK / PRESCALER
+ * per second) since initSWTimerClock(). Every software timer, debouncer and
+ * latency measurement reads time from here.
+ *
+ * Clock_now() is safe to call from the main loop and from any ISR, masked or
+ * not, without locking: the rollover count is read on both sides of the
+ * counter and the read is retried if it changed, and a rollover whose
+ * interrupt has not been taken yet is counted.
+ *
+ * Clock_now32() is the fast path: the low 32 bits of Clock_now() are the
+ * counter alone, since the timer rolls over every 2^32 cycles. The difference
+ * of two readings is exact for intervals up to 2^32 cycles (89 s).
+ *
+ * Timer32 runs from MCLK, which stops in LPM3. Hold IDLE_HOLD_CLOCK (see
+ * HAL/Idle.h) while timing anything that may span a sleep.
+ *
+ * The conversions multiply by a precomputed reciprocal instead of dividing,
+ * which the M4 does in one UMULL; they are exact for any 32-bit count.
+ * =================================================================================================
+ */
+uint64_t Clock_now();
+
+static inline uint32_t Clock_now32()
+{
+  return LOADVALUE - Timer32_getValue(SWTIMER_CLOCK_BASE);
+}
+
+#if (SYSTEM_CLOCK / PRESCALER) != 48000000
+#error "Clock_cyclesToUs/Ms reciprocals assume a 48 MHz clock"
+#endif
+
+// floor(x / 48) == (x * ceil(2^37 / 48)) >> 37 for every 32-bit x
+static inline uint32_t Clock_cyclesToUs(uint32_t cycles)
+{
+  return (uint32_t)(((uint64_t)cycles * 0xAAAAAAABu) >> 37);
+}
+
+// floor(x / 48) for a 64-bit x, as 2^32 == 48 * 89478485 + 16: the high word
+// is scaled by the quotient and its remainder carried into the low word's.
+// Exact below 2^60 cycles (760 years).
+static inline uint64_t Clock_cyclesToUs64(uint64_t cycles)
+{
+  uint32_t high = (uint32_t)(cycles >> 32);
+  uint32_t low = Clock_cyclesToUs((uint32_t)cycles);
+  uint32_t rest = (uint32_t)cycles - low * 48u;
+
+  return (uint64_t)high * 89478485u + low
+         + Clock_cyclesToUs(high * 16u + rest);
+}
+
+// floor(x / 48000) == (x * ceil(2^42 / 48000)) >> 42 for every 32-bit x
+static inline uint32_t Clock_cyclesToMs(uint32_t cycles)
+{
+  return (uint32_t)(((uint64_t)cycles * 91625969u) >> 42);
+}
+
 /**=================================================================================================
  * A Software timer object, implemented in the C object-oriented style. Use the
  * constructor [SWTimer_construct()] to create a software timer. The only method
@@ -52,13 +118,8 @@ struct _SWTimer {
   // expires
   uint64_t cyclesToWait;
 
-  // The starting counter value of the hardware timer, set when the timer is
-  // started
-  uint32_t startCounter;
-
-  // The starting rollover value of the hardware timer, set when the timer is
-  // started
-  uint32_t startRollovers;
+  // The monotonic clock's reading when the timer was started
+  uint64_t startCycles;
 };
 typedef struct _SWTimer SWTimer;
 
@@ -81,8 +142,9 @@ bool SWTimer_expired(SWTimer* timer_p);
 // timer under which all of the software timers are based.
 void InitSystemTiming();
 
-// Initializes and starts a hardware timer (the second available Timer32)
-void startHWTimer(uint32_t waitTime_ms);
-bool HWTimerExpired();
+// Starts the hardware timer under which all of the software timers are based
+// (TIMER32_1, free-running), without touching the clock system.
+void initSWTimerClock();
+
 
 #endif /* HAL_TIMER_H_ */
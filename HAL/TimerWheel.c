@@ -0,0 +1,504 @@
+/*
+ * TimerWheel.c
+ *
+ *  Created on: Nov 26, 2024
+ *
+ * Callback timers on one hardware timer. See TimerWheel.h.
+ */
+
+#include <stddef.h>
+#include <HAL/TimerWheel.h>
+
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+
+// Ticks spanned by one slot of the given level
+#define LEVEL_SHIFT(level) ((level) * TIMER_WHEEL_SLOT_BITS)
+
+// Ticks spanned by the whole wheel; timers further out are parked
+#define WHEEL_REACH (1u << LEVEL_SHIFT(TIMER_WHEEL_LEVELS))
+
+#if TIMER_WHEEL_ACLK_HZ % TIMER_WHEEL_TICK_HZ != 0
+#error "The tick must be a whole number of ACLK cycles"
+#endif
+
+/** The tick the wheel has got to, and the counter reading that tick started
+ * on. They move together, in the compare ISR. The counter runs on between
+ * interrupts, so the real time is the wheel's plus the whole ticks the
+ * counter has gone past wheelTickCount. */
+static volatile uint32_t wheelTicks;
+static volatile uint16_t wheelTickCount;
+
+/** The tick the compare is set for. It is never more than
+ * TIMER_WHEEL_MAX_SLEEP ticks past wheelTicks. */
+static uint32_t armedTick;
+
+/** Compare interrupts taken, for the idle statistics */
+static volatile uint32_t interrupts;
+
+/** The slot list heads, and a bit per slot that is set while its list is not
+ * empty, so that the next deadline is found without walking the slots. */
+static TimerWheel_Timer* slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+static uint64_t occupied[TIMER_WHEEL_LEVELS];
+
+/**
+ * Masks interrupts around a change to the slot lists, which the compare ISR
+ * and the main loop both make.
+ *
+ * @return whether interrupts were masked already, for TimerWheel_unlock()
+ */
+static bool TimerWheel_lock() {
+  return Interrupt_disableMaster();
+}
+
+static void TimerWheel_unlock(bool wasMasked) {
+  if (!wasMasked) {
+    Interrupt_enableMaster();
+  }
+}
+
+/**
+ * Files a timer in the slot its expiry tick falls in: level 0 if it expires
+ * within a turn of level 0, else the lowest level that reaches it. Timers
+ * beyond the top level wait in its last slot. Interrupts must be masked.
+ *
+ * @param timer_p:  The idle timer to file
+ */
+static void TimerWheel_link(TimerWheel_Timer* timer_p) {
+  uint32_t delta = timer_p->expires - wheelTicks;
+  unsigned level, slot;
+
+  for (level = 0; level < TIMER_WHEEL_LEVELS - 1; level++) {
+    if (delta < (1u << LEVEL_SHIFT(level + 1))) {
+      break;
+    }
+  }
+
+  if (delta < WHEEL_REACH) {
+    slot = (timer_p->expires >> LEVEL_SHIFT(level)) & SLOT_MASK;
+  } else {
+    slot = ((wheelTicks >> LEVEL_SHIFT(level)) + SLOT_MASK) & SLOT_MASK;
+  }
+
+  timer_p->next = slots[level][slot];
+  if (timer_p->next) {
+    timer_p->next->pprev = &timer_p->next;
+  }
+  timer_p->pprev = &slots[level][slot];
+  slots[level][slot] = timer_p;
+  occupied[level] |= (uint64_t)1 << slot;
+}
+
+/**
+ * Takes a pending timer out of its slot list. Interrupts must be masked.
+ * The slot's bit is cleared when the list empties; finding which slot that
+ * is only takes a look at the head pointer the timer links back to.
+ *
+ * @param timer_p:  The pending timer to unlink
+ */
+static void TimerWheel_unlink(TimerWheel_Timer* timer_p) {
+  TimerWheel_Timer** head = timer_p->pprev;
+
+  *head = timer_p->next;
+  if (timer_p->next) {
+    timer_p->next->pprev = head;
+  }
+  timer_p->next = NULL;
+  timer_p->pprev = NULL;
+
+  if (!*head && head >= &slots[0][0] &&
+      head < &slots[0][0] + TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS) {
+    unsigned index = head - &slots[0][0];
+    occupied[index / TIMER_WHEEL_SLOTS] &=
+        ~((uint64_t)1 << (index % TIMER_WHEEL_SLOTS));
+  }
+}
+
+/**
+ * Moves every timer of one slot of an upper level down to the levels below,
+ * now that the wheel has come round to it. Interrupts must be masked.
+ */
+static void TimerWheel_cascade(unsigned level, unsigned slot) {
+  TimerWheel_Timer* timer_p = slots[level][slot];
+
+  slots[level][slot] = NULL;
+  occupied[level] &= ~((uint64_t)1 << slot);
+
+  while (timer_p) {
+    TimerWheel_Timer* next = timer_p->next;
+    TimerWheel_link(timer_p);
+    timer_p = next;
+  }
+}
+
+/**
+ * Finds the first occupied slot of a level at or after a given slot, going
+ * round. The lowest set bit of the rotated bitmap is located with a de
+ * Bruijn multiply instead of a loop over the slots.
+ *
+ * @return how many slots after from it is, or TIMER_WHEEL_SLOTS if the
+ * level is empty
+ */
+static unsigned TimerWheel_firstOccupied(unsigned level, unsigned from) {
+  static const uint8_t deBruijnIndex[64] = {
+      0,  1,  48, 2,  57, 49, 28, 3,  61, 58, 50, 42, 38, 29, 17, 4,
+      62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+      63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+      46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9,  13, 8,  7,  6};
+  uint64_t bits = occupied[level];
+
+  if (!bits) {
+    return TIMER_WHEEL_SLOTS;
+  }
+  if (from) {
+    bits = (bits >> from) | (bits << (TIMER_WHEEL_SLOTS - from));
+  }
+
+  return deBruijnIndex[((bits & (0 - bits)) * 0x03F79D71B4CB0A89ull) >> 58];
+}
+
+/**
+ * Works out the next tick on which the wheel has work: a level 0 slot with
+ * timers in it, or an upper level slot with timers to cascade. Each level's
+ * first occupied slot after the current one gives a candidate; the earliest
+ * of them is the answer. A slot of an upper level is cascaded on the tick
+ * its span starts. Interrupts must be masked.
+ *
+ * @param ticks_p:  Set to the number of ticks from wheelTicks to that tick
+ * @return true if any timer is pending
+ */
+static bool TimerWheel_nextWork(uint32_t* ticks_p) {
+  uint32_t now = wheelTicks;
+  uint32_t best = 0;
+  bool found = false;
+  unsigned level;
+
+  for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+    uint32_t span = now >> LEVEL_SHIFT(level);
+    unsigned offset = TimerWheel_firstOccupied(level, (span + 1) & SLOT_MASK);
+    uint32_t ticks;
+
+    if (offset == TIMER_WHEEL_SLOTS) {
+      continue;
+    }
+
+    ticks = ((span + offset + 1) << LEVEL_SHIFT(level)) - now;
+    if (!found || ticks < best) {
+      best = ticks;
+      found = true;
+    }
+  }
+
+  if (found) {
+    *ticks_p = best;
+  }
+  return found;
+}
+
+/**
+ * Finds the earliest tick a pending timer expires on. The slots of a level
+ * are in order of their spans, so only its first occupied slot's list has to
+ * be walked - unless that slot holds nothing but timers parked beyond the
+ * top level, when the next one is walked too. Cascades are not counted: the
+ * compare ISR does them on its way to the expiry. Interrupts must be masked.
+ *
+ * @param tick_p:  Set to the tick
+ * @return true if any timer is pending
+ */
+static bool TimerWheel_nextExpiry(uint32_t* tick_p) {
+  uint32_t now = wheelTicks;
+  uint32_t best = 0;
+  bool found = false;
+  unsigned level;
+
+  for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+    unsigned first = ((now >> LEVEL_SHIFT(level)) + 1) & SLOT_MASK;
+    unsigned skipped = 0;
+
+    while (skipped < TIMER_WHEEL_SLOTS) {
+      unsigned offset =
+          TimerWheel_firstOccupied(level, (first + skipped) & SLOT_MASK);
+      TimerWheel_Timer* timer_p;
+      bool inReach = false;
+
+      if (skipped + offset >= TIMER_WHEEL_SLOTS) {
+        break;
+      }
+
+      timer_p = slots[level][(first + skipped + offset) & SLOT_MASK];
+      for (; timer_p; timer_p = timer_p->next) {
+        uint32_t ticks = timer_p->expires - now;
+
+        inReach |= ticks < WHEEL_REACH;
+        if (!found || ticks < best) {
+          best = ticks;
+          found = true;
+        }
+      }
+      if (inReach) {
+        break;
+      }
+      skipped += offset + 1;
+    }
+  }
+
+  if (found) {
+    *tick_p = now + best;
+  }
+  return found;
+}
+
+/**
+ * @return the current tick: the wheel's, plus the whole ticks the counter
+ * has gone past it
+ */
+static uint32_t TimerWheel_counterTicks() {
+  uint16_t counted = Timer_A_getCounterValue(TIMER_WHEEL_BASE) - wheelTickCount;
+  return wheelTicks + counted / TIMER_WHEEL_ACLK_PER_TICK;
+}
+
+/**
+ * Sets the compare for a tick no more than TIMER_WHEEL_MAX_SLEEP ticks past
+ * the wheel's. The compare only fires when the counter reaches it exactly,
+ * so a tick that is already here - the wheel ran late - is pended by hand.
+ * Interrupts must be masked.
+ */
+static void TimerWheel_armAt(uint32_t tick) {
+  armedTick = tick;
+  Timer_A_setCompareValue(
+      TIMER_WHEEL_BASE, TIMER_A_CAPTURECOMPARE_REGISTER_0,
+      wheelTickCount + (tick - wheelTicks) * TIMER_WHEEL_ACLK_PER_TICK);
+
+  if ((int32_t)(TimerWheel_counterTicks() - tick) >= 0) {
+    Interrupt_pendInterrupt(TIMER_WHEEL_INT);
+  }
+}
+
+/**
+ * Advances the wheel a tick. Upper levels are cascaded first, top down, so
+ * that timers due on this tick are in level 0 before its slot is run. Each
+ * timer is unlinked - and a periodic one re-filed a period on - before its
+ * callback is called with interrupts unmasked, so the callback is free to
+ * start or cancel it.
+ */
+static void TimerWheel_tick() {
+  bool wasMasked = TimerWheel_lock();
+  uint32_t now = wheelTicks + 1;
+  unsigned level, slot = now & SLOT_MASK;
+
+  wheelTicks = now;
+  wheelTickCount += TIMER_WHEEL_ACLK_PER_TICK;
+  for (level = TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+    if ((now & ((1u << LEVEL_SHIFT(level)) - 1)) == 0) {
+      TimerWheel_cascade(level, (now >> LEVEL_SHIFT(level)) & SLOT_MASK);
+    }
+  }
+  TimerWheel_unlock(wasMasked);
+
+  for (;;) {
+    TimerWheel_Timer* timer_p;
+
+    wasMasked = TimerWheel_lock();
+    timer_p = slots[0][slot];
+    if (!timer_p) {
+      TimerWheel_unlock(wasMasked);
+      break;
+    }
+
+    TimerWheel_unlink(timer_p);
+    if (timer_p->period) {
+      timer_p->expires += timer_p->period;
+      TimerWheel_link(timer_p);
+    }
+    TimerWheel_unlock(wasMasked);
+
+    timer_p->callback(timer_p->context);
+  }
+}
+
+/**
+ * Advances the wheel to the counter, running what falls due on the way. The
+ * quiet stretches between ticks with work are skipped in one step rather
+ * than a tick at a time. The counter is read again after each tick with
+ * work, so time spent in callbacks is caught up too.
+ */
+static void TimerWheel_catchUp() {
+  for (;;) {
+    bool wasMasked = TimerWheel_lock();
+    uint32_t behind = TimerWheel_counterTicks() - wheelTicks;
+    uint32_t work;
+
+    if (!TimerWheel_nextWork(&work) || work > behind) {
+      wheelTicks += behind;
+      wheelTickCount += behind * TIMER_WHEEL_ACLK_PER_TICK;
+      TimerWheel_unlock(wasMasked);
+      return;
+    }
+    wheelTicks += work - 1;
+    wheelTickCount += (work - 1) * TIMER_WHEEL_ACLK_PER_TICK;
+    TimerWheel_unlock(wasMasked);
+
+    TimerWheel_tick();
+  }
+}
+
+/**
+ * Starts TIMER_A1 counting ACLK continuously, with a compare interrupt on
+ * CCR0. ACLK must already be sourced from REFO. Any timers still pending are
+ * dropped.
+ */
+void TimerWheel_init() {
+  const Timer_A_ContinuousModeConfig counterConfig = {
+      TIMER_A_CLOCKSOURCE_ACLK,
+      TIMER_A_CLOCKSOURCE_DIVIDER_1,
+      TIMER_A_TAIE_INTERRUPT_DISABLE,
+      TIMER_A_DO_CLEAR};
+  const Timer_A_CompareModeConfig compareConfig = {
+      TIMER_A_CAPTURECOMPARE_REGISTER_0,
+      TIMER_A_CAPTURECOMPARE_INTERRUPT_ENABLE,
+      TIMER_A_OUTPUTMODE_OUTBITVALUE,
+      TIMER_WHEEL_MAX_SLEEP * TIMER_WHEEL_ACLK_PER_TICK};
+  unsigned level, slot;
+
+  wheelTicks = 0;
+  wheelTickCount = 0;
+  armedTick = TIMER_WHEEL_MAX_SLEEP;
+  interrupts = 0;
+  for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+    for (slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+      slots[level][slot] = NULL;
+    }
+    occupied[level] = 0;
+  }
+
+  Timer_A_configureContinuousMode(TIMER_WHEEL_BASE, &counterConfig);
+  Timer_A_initCompare(TIMER_WHEEL_BASE, &compareConfig);
+  Interrupt_enableInterrupt(TIMER_WHEEL_INT);
+  Timer_A_startCounter(TIMER_WHEEL_BASE, TIMER_A_CONTINUOUS_MODE);
+}
+
+/**
+ * The compare interrupt: runs everything due up to the counter, then sets
+ * the compare for the next expiry, or for TIMER_WHEEL_MAX_SLEEP ticks on if
+ * that is sooner, so that the counter never gets far enough ahead of the
+ * wheel to wrap. DO NOT DIRECTLY INVOKE THIS FUNCTION FROM YOUR CODE.
+ */
+void TA1_0_IRQHandler(void) {
+  bool wasMasked;
+  uint32_t tick;
+
+  Timer_A_clearCaptureCompareInterrupt(TIMER_WHEEL_BASE,
+                                       TIMER_A_CAPTURECOMPARE_REGISTER_0);
+  interrupts++;
+
+  TimerWheel_catchUp();
+
+  wasMasked = TimerWheel_lock();
+  if (!TimerWheel_nextExpiry(&tick) ||
+      tick - wheelTicks > TIMER_WHEEL_MAX_SLEEP) {
+    tick = wheelTicks + TIMER_WHEEL_MAX_SLEEP;
+  }
+  TimerWheel_armAt(tick);
+  TimerWheel_unlock(wasMasked);
+}
+
+/**
+ * Constructs an idle timer. Nothing is scheduled until TimerWheel_start().
+ *
+ * @param callback:  Called from the compare ISR each time the timer expires
+ * @param context:   Passed to callback
+ * @return a TimerWheel_Timer object
+ */
+TimerWheel_Timer TimerWheel_construct(TimerWheel_Callback callback,
+                                      void* context) {
+  TimerWheel_Timer timer;
+
+  timer.next = NULL;
+  timer.pprev = NULL;
+  timer.expires = 0;
+  timer.period = 0;
+  timer.callback = callback;
+  timer.context = context;
+
+  return timer;
+}
+
+/**
+ * Arms a timer, re-arming it if it is pending already. The delay counts from
+ * the counter's tick, however far behind it the wheel is. The compare is
+ * only moved if this timer expires before the tick it is set for.
+ *
+ * @param timer_p:      The constructed timer to arm
+ * @param delayTicks:   Ticks until the first expiry; 0 is taken as 1
+ * @param periodTicks:  Ticks between later expiries, or 0 to expire once
+ */
+void TimerWheel_start(TimerWheel_Timer* timer_p, uint32_t delayTicks,
+                      uint32_t periodTicks) {
+  bool wasMasked = TimerWheel_lock();
+
+  if (timer_p->pprev) {
+    TimerWheel_unlink(timer_p);
+  }
+  timer_p->expires = TimerWheel_counterTicks() + (delayTicks ? delayTicks : 1);
+  timer_p->period = periodTicks;
+  TimerWheel_link(timer_p);
+
+  if ((int32_t)(timer_p->expires - armedTick) < 0) {
+    TimerWheel_armAt(timer_p->expires);
+  }
+
+  TimerWheel_unlock(wasMasked);
+}
+
+/**
+ * Disarms a timer. Cancelling a periodic timer from its own callback stops
+ * it. The compare is left alone: if it was set for this timer, the ISR finds
+ * nothing due and sets it again.
+ *
+ * @param timer_p:  The timer to disarm
+ */
+void TimerWheel_cancel(TimerWheel_Timer* timer_p) {
+  bool wasMasked = TimerWheel_lock();
+
+  if (timer_p->pprev) {
+    TimerWheel_unlink(timer_p);
+  }
+
+  TimerWheel_unlock(wasMasked);
+}
+
+bool TimerWheel_isPending(const TimerWheel_Timer* timer_p) {
+  return timer_p->pprev != NULL;
+}
+
+uint32_t TimerWheel_now() {
+  bool wasMasked = TimerWheel_lock();
+  uint32_t now = TimerWheel_counterTicks();
+
+  TimerWheel_unlock(wasMasked);
+  return now;
+}
+
+uint32_t TimerWheel_interruptCount() {
+  return interrupts;
+}
+
+/**
+ * Gives the ticks until the next timer expires.
+ *
+ * @param ticks_p:  Set to the number of ticks from now to that tick, or 0
+ *                  if it is already due and its interrupt pending
+ * @return true if any timer is pending
+ */
+bool TimerWheel_nextDeadline(uint32_t* ticks_p) {
+  bool wasMasked = TimerWheel_lock();
+  uint32_t tick;
+  bool found = TimerWheel_nextExpiry(&tick);
+
+  if (found) {
+    int32_t ticks = (int32_t)(tick - TimerWheel_counterTicks());
+    *ticks_p = ticks > 0 ? (uint32_t)ticks : 0;
+  }
+
+  TimerWheel_unlock(wasMasked);
+  return found;
+}
@@ -0,0 +1,109 @@
+/*
+ * TimerWheel.h
+ *
+ *  Created on: Nov 26, 2024
+ *
+ * Callback timers on one hardware timer.  Time is counted in ticks of
+ * 1/TIMER_WHEEL_TICK_HZ s on TIMER_A1, which counts ACLK (REFO, 32768 Hz)
+ * and keeps counting in LPM3.  The timer is tickless: its compare is set to
+ * the tick the next timer expires on, so it only interrupts then - or after
+ * TIMER_WHEEL_MAX_SLEEP ticks with nothing due - and the ISR catches the
+ * wheel up to the counter and runs the callbacks of the timers that have
+ * expired.  Any number of timers share that one hardware timer, and nothing
+ * has to be polled.
+ *
+ * Pending timers sit in a hierarchical wheel of TIMER_WHEEL_LEVELS levels of
+ * TIMER_WHEEL_SLOTS slots.  Level 0 has a slot per tick; each level above
+ * has a slot per whole turn of the level below, and its slots are moved down
+ * ("cascaded") as the level below comes round to them.  A timer is a node of
+ * its slot's doubly linked list, so starting and cancelling one are O(1)
+ * whatever else is pending, and no memory is allocated.  The top level spans
+ * 2^18 ticks (256 s); a timer further out than that waits in the top level's
+ * last slot and is re-filed each time it comes round.
+ *
+ * Callbacks run in the compare ISR with interrupts enabled.  They may start
+ * and cancel timers, their own included, but should be short: everything
+ * else due on the same tick waits for them.
+ */
+
+#ifndef HAL_TIMERWHEEL_H_
+#define HAL_TIMERWHEEL_H_
+
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+
+// The tick, and the hardware timer that counts it: 32 ACLK cycles
+#define TIMER_WHEEL_TICK_HZ     1024
+#define TIMER_WHEEL_ACLK_HZ     32768
+#define TIMER_WHEEL_ACLK_PER_TICK (TIMER_WHEEL_ACLK_HZ / TIMER_WHEEL_TICK_HZ)
+#define TIMER_WHEEL_BASE        TIMER_A1_BASE
+#define TIMER_WHEEL_INT         INT_TA1_0
+
+// Longest the compare is set ahead, in ticks. The 16-bit counter wraps every
+// 2048 ticks, so this leaves a second for the ISR to be late in.
+#define TIMER_WHEEL_MAX_SLEEP   1024
+
+#define TIMER_WHEEL_LEVELS      3
+#define TIMER_WHEEL_SLOT_BITS   6
+#define TIMER_WHEEL_SLOTS       (1 << TIMER_WHEEL_SLOT_BITS)
+
+typedef void (*TimerWheel_Callback)(void *context);
+
+/**=============================================================================
+ * A timer on the wheel. Use [TimerWheel_construct()] to create one, then
+ * [TimerWheel_start()] to arm it. Treat all members as PRIVATE, and do not
+ * copy or overwrite a timer while it is pending: the wheel holds pointers
+ * into it.
+ * =============================================================================
+ */
+struct _TimerWheel_Timer {
+  // Slot list links. pprev points at whatever points at this timer - the
+  // slot head or the previous timer's next - and is NULL while idle.
+  struct _TimerWheel_Timer* next;
+  struct _TimerWheel_Timer** pprev;
+
+  uint32_t expires;  // tick on which the callback runs
+  uint32_t period;   // ticks between runs, or 0 to run once
+
+  TimerWheel_Callback callback;
+  void* context;
+};
+typedef struct _TimerWheel_Timer TimerWheel_Timer;
+
+// Rounds up, so a window is never shorter than asked for. 1 s is exactly
+// 1024 ticks.
+static inline uint32_t TimerWheel_msToTicks(uint32_t ms)
+{
+  return (uint32_t)(((uint64_t)ms * TIMER_WHEEL_TICK_HZ + 999) / 1000);
+}
+
+// Starts the counter. Interrupts are left masked or unmasked as they were.
+void TimerWheel_init();
+
+// Constructs an idle timer that calls callback(context) when it expires
+TimerWheel_Timer TimerWheel_construct(TimerWheel_Callback callback,
+                                      void* context);
+
+// Arms a timer to expire delayTicks from now (at least one tick), then every
+// periodTicks after that if periodTicks is not 0. A pending timer is
+// re-armed.
+void TimerWheel_start(TimerWheel_Timer* timer_p, uint32_t delayTicks,
+                      uint32_t periodTicks);
+
+// Disarms a timer. Does nothing if it is idle.
+void TimerWheel_cancel(TimerWheel_Timer* timer_p);
+
+// True from TimerWheel_start() until the timer is cancelled or, if it runs
+// once, until its callback is called
+bool TimerWheel_isPending(const TimerWheel_Timer* timer_p);
+
+// Ticks since TimerWheel_init(), wrapping after 48 days
+uint32_t TimerWheel_now();
+
+// Gives the number of ticks until the next timer expires, 0 if it is due
+// already. Returns false, leaving ticks_p alone, if no timer is pending.
+bool TimerWheel_nextDeadline(uint32_t* ticks_p);
+
+// Compare interrupts taken since TimerWheel_init()
+uint32_t TimerWheel_interruptCount();
+
+#endif /* HAL_TIMERWHEEL_H_ */
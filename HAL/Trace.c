@@ -0,0 +1,351 @@
+/*
+ * Trace.c
+ *
+ *  Created on: Nov 30, 2024
+ */
+
+#include <HAL/Trace.h>
+#include <HAL/Timer.h>
+#include <HAL/Idle.h>
+
+TraceStats g_traceStats;
+
+// 115200 baud from the 48 MHz SMCLK, oversampled
+static const eUSCI_UART_ConfigV1 uartConfig =
+{
+    EUSCI_A_UART_CLOCKSOURCE_SMCLK,
+    26,                                         // clockPrescalar
+    0,                                          // firstModReg
+    111,                                        // secondModReg
+    EUSCI_A_UART_NO_PARITY,
+    EUSCI_A_UART_LSB_FIRST,
+    EUSCI_A_UART_ONE_STOP_BIT,
+    EUSCI_A_UART_MODE,
+    EUSCI_A_UART_OVERSAMPLING_BAUDRATE_GENERATION,
+    EUSCI_A_UART_8_BIT_LEN
+};
+
+static uint8_t ring[TRACE_RING_BYTES];
+
+// Bytes written to the ring by the main loop, and sent by the UART
+// interrupt. The interrupt is enabled while `sending`.
+static volatile uint32_t head;
+static volatile uint32_t tail;
+static volatile bool sending;
+
+static bool enabled;
+
+// The next record is a SYNC, with a LOST if `lost` is not 0, and the next
+// sample is written whole
+static bool resync;
+static uint32_t lost;
+static bool wholeNext;
+
+// The sample last recorded, the time of the next one, and the period last
+// recorded, in microseconds. The next sample gets a TIME record if
+// !timeRecorded, and a PERIOD record if the block's period is not
+// periodUs. While followsOn, a block's samples are taken to follow the last.
+static AccelSample last;
+static uint64_t nextUs;
+static bool timeRecorded, followsOn;
+static uint32_t periodUs, blockPeriodUs;
+
+// Sample periods the capture skipped before the next sample, for a GAP
+static uint32_t gap;
+
+// Writes v's low `bytes` bytes to p, most significant first
+static inline uint8_t *Trace_pack(uint8_t *p, uint64_t v, int bytes)
+{
+    while (bytes--)
+    {
+        *p++ = (uint8_t) (v >> (8 * bytes));
+    }
+    return p;
+}
+
+static inline bool Trace_fits(int32_t d, int bits)
+{
+    return d >= -(1 << (bits - 1)) && d < (1 << (bits - 1));
+}
+
+// Turns the UART's transmit interrupt on if it is not, which sends the
+// first byte as soon as the ISR runs
+static void Trace_kick(void)
+{
+    bool wasMasked = Interrupt_disableMaster();
+
+    if (!sending)
+    {
+        sending = true;
+        Idle_hold(IDLE_HOLD_UART);
+        UART_enableInterrupt(TRACE_UART_BASE, EUSCI_A_UART_TRANSMIT_INTERRUPT);
+    }
+    if (!wasMasked)
+    {
+        Interrupt_enableMaster();
+    }
+}
+
+// Copies a record into the ring, whole or not at all
+static bool Trace_put(const uint8_t *record, uint32_t length)
+{
+    uint32_t h = head, i;
+
+    if (TRACE_RING_BYTES - (h - tail) < length)
+    {
+        lost++;
+        g_traceStats.lost++;
+        resync = true;
+        wholeNext = true;
+        return false;
+    }
+
+    for (i = 0; i < length; i++)
+    {
+        ring[(h + i) & (TRACE_RING_BYTES - 1)] = record[i];
+    }
+    head = h + length;
+    g_traceStats.bytes += length;
+    Trace_kick();
+    return true;
+}
+
+// Writes what has to come before the next record: SYNC and LOST after
+// records were dropped, the time and period if they are not known from the
+// stream, and GAP if samples were not captured
+static uint8_t *Trace_prefix(uint8_t *p)
+{
+    if (resync)
+    {
+        p = Trace_pack(p, (TRACE_TAG_EVENT | TRACE_SYNC) << 8 | TRACE_SYNC_MAGIC,
+                       TRACE_EVENT_BYTES);
+        timeRecorded = false;
+        periodUs = 0;
+    }
+    if (!timeRecorded)
+    {
+        p = Trace_pack(p, (uint64_t) TRACE_TAG_TIME << 32
+                       | (nextUs & 0xFFFFFFFFFull), TRACE_TIME_BYTES);
+    }
+    if (resync && lost)
+    {
+        // At the time the gap ended
+        p = Trace_pack(p, (TRACE_TAG_EVENT | TRACE_LOST) << 8
+                       | (lost > 255 ? 255 : lost), TRACE_EVENT_BYTES);
+    }
+    if (gap)
+    {
+        p = Trace_pack(p, (TRACE_TAG_EVENT | TRACE_GAP) << 8
+                       | (gap > 255 ? 255 : gap), TRACE_EVENT_BYTES);
+    }
+    if (periodUs != blockPeriodUs)
+    {
+        p = Trace_pack(p, (uint32_t) TRACE_TAG_PERIOD << 16
+                       | (blockPeriodUs & 0xFFFFF), TRACE_PERIOD_BYTES);
+    }
+    return p;
+}
+
+// After a record and its prefix went into the ring
+static void Trace_committed(void)
+{
+    resync = false;
+    lost = 0;
+    gap = 0;
+    timeRecorded = true;
+    periodUs = blockPeriodUs;
+}
+
+void Trace_init(void)
+{
+    GPIO_setAsPeripheralModuleFunctionInputPin(
+            GPIO_PORT_P1, GPIO_PIN2 | GPIO_PIN3, GPIO_PRIMARY_MODULE_FUNCTION);
+    UART_initModule(TRACE_UART_BASE, &uartConfig);
+    UART_enableModule(TRACE_UART_BASE);
+    Interrupt_enableInterrupt(TRACE_UART_INT);
+
+    head = 0;
+    tail = 0;
+    sending = false;
+    Trace_setEnabled(true);
+}
+
+void Trace_setEnabled(bool enable)
+{
+    if (enable && !enabled)
+    {
+        resync = true;
+        wholeNext = true;
+        lost = 0;
+        gap = 0;
+        followsOn = false;
+    }
+    enabled = enable;
+}
+
+void Trace_startBlock(const AccelBlock *block)
+{
+    uint64_t endUs = Clock_cyclesToUs64(block->endCycles);
+    uint64_t startUs;
+    int64_t off;
+
+    blockPeriodUs = Clock_cyclesToUs(block->periodCycles);
+    startUs = endUs - (uint64_t) blockPeriodUs * (ACCEL_RING_BLOCK - 1);
+
+    // Blocks follow on while the ring keeps up, so the samples' times are
+    // known from the last; a gap, or the clock wandering off by half a
+    // period, takes a TIME record.  Samples missing from a gap (the ring
+    // paused or dropping blocks) were not seen by the round either, and a
+    // GAP event says how many
+    off = (int64_t) (startUs - nextUs);
+    if (!followsOn || off > blockPeriodUs / 2 || -off > blockPeriodUs / 2)
+    {
+        gap = !followsOn || off < (int64_t) blockPeriodUs ? 0
+              : off < (int64_t) blockPeriodUs * 255
+              ? ((uint32_t) off + blockPeriodUs / 2) / blockPeriodUs : 255;
+        nextUs = startUs;
+        timeRecorded = false;
+    }
+    followsOn = true;
+}
+
+void Trace_sample(AccelSample sample)
+{
+    uint8_t record[TRACE_RECORD_MAX], *p;
+    int32_t dx, dy, dz;
+    uint32_t start, cycles;
+
+    if (!enabled)
+    {
+        return;
+    }
+
+    start = Clock_now32();
+    dx = (int32_t) sample.x - last.x;
+    dy = (int32_t) sample.y - last.y;
+    dz = (int32_t) sample.z - last.z;
+
+    p = Trace_prefix(record);
+    if (!wholeNext && Trace_fits(dx, 5) && Trace_fits(dy, 5)
+        && Trace_fits(dz, 5))
+    {
+        p = Trace_pack(p, TRACE_TAG_SMALL << 8 | (dx & 0x1F) << 10
+                       | (dy & 0x1F) << 5 | (dz & 0x1F), TRACE_SMALL_BYTES);
+    }
+    else if (!wholeNext && Trace_fits(dx, 7) && Trace_fits(dy, 7)
+             && Trace_fits(dz, 7))
+    {
+        p = Trace_pack(p, (uint32_t) TRACE_TAG_MEDIUM << 16 | (dx & 0x7F) << 15
+                       | (dy & 0x7F) << 8 | (dz & 0x7F) << 1,
+                       TRACE_MEDIUM_BYTES);
+    }
+    else
+    {
+        p = Trace_pack(p, (uint64_t) TRACE_TAG_FULL << 40
+                       | (uint64_t) (sample.x & 0x3FFF) << 28
+                       | (uint32_t) (sample.y & 0x3FFF) << 14
+                       | (sample.z & 0x3FFF), TRACE_FULL_BYTES);
+    }
+
+    if (Trace_put(record, p - record))
+    {
+        Trace_committed();
+        wholeNext = false;
+        last = sample;
+        g_traceStats.samples++;
+    }
+    nextUs += blockPeriodUs;
+
+    cycles = Clock_now32() - start;
+    g_traceStats.totalCycles += cycles;
+    if (cycles > g_traceStats.maxCycles)
+    {
+        g_traceStats.maxCycles = cycles;
+    }
+}
+
+void Trace_event(TraceEvent event, uint8_t argument)
+{
+    uint8_t record[TRACE_EVENT_RECORD_MAX], *p;
+
+    if (!enabled)
+    {
+        return;
+    }
+
+    // After a gap, the event goes after a SYNC, at the time the next sample
+    // would have had
+    p = Trace_prefix(record);
+    p = Trace_pack(p, (TRACE_TAG_EVENT | event) << 8 | argument,
+                   TRACE_EVENT_BYTES);
+    if (Trace_put(record, p - record))
+    {
+        Trace_committed();
+        g_traceStats.events++;
+    }
+}
+
+void Trace_eventNow(TraceEvent event, uint8_t argument)
+{
+    // These mark rounds, so they start with a SYNC: a decoder attached
+    // partway through picks up the stream from the next round
+    resync = true;
+    wholeNext = true;
+    nextUs = Clock_cyclesToUs64(Clock_now());
+    timeRecorded = false;
+    Trace_event(event, argument);
+
+    // The next block starts a TIME of its own
+    followsOn = false;
+}
+
+//*****************************************************************************
+//
+// EUSCI_A0 interrupt: sends the next byte of the ring each time the transmit
+// buffer empties. Once the ring is empty, it waits for the last byte to
+// leave the shift register before letting the CPU back into LPM3.
+//
+//*****************************************************************************
+void EUSCIA0_IRQHandler(void)
+{
+    uint32_t status = UART_getEnabledInterruptStatus(TRACE_UART_BASE);
+
+    if (status & EUSCI_A_UART_TRANSMIT_INTERRUPT_FLAG)
+    {
+        if (tail != head)
+        {
+            UART_transmitData(TRACE_UART_BASE,
+                              ring[tail & (TRACE_RING_BYTES - 1)]);
+            tail = tail + 1;
+        }
+        else
+        {
+            UART_disableInterrupt(TRACE_UART_BASE,
+                                  EUSCI_A_UART_TRANSMIT_INTERRUPT);
+            UART_clearInterruptFlag(TRACE_UART_BASE,
+                                    EUSCI_A_UART_TRANSMIT_COMPLETE_INTERRUPT);
+            UART_enableInterrupt(TRACE_UART_BASE,
+                                 EUSCI_A_UART_TRANSMIT_COMPLETE_INTERRUPT);
+            status |= UART_queryStatusFlags(TRACE_UART_BASE, EUSCI_A_UART_BUSY)
+                    ? 0 : EUSCI_A_UART_TRANSMIT_COMPLETE_INTERRUPT_FLAG;
+        }
+    }
+
+    if (status & EUSCI_A_UART_TRANSMIT_COMPLETE_INTERRUPT_FLAG)
+    {
+        UART_clearInterruptFlag(TRACE_UART_BASE,
+                                EUSCI_A_UART_TRANSMIT_COMPLETE_INTERRUPT);
+        UART_disableInterrupt(TRACE_UART_BASE,
+                              EUSCI_A_UART_TRANSMIT_COMPLETE_INTERRUPT);
+        if (tail != head)
+        {
+            UART_enableInterrupt(TRACE_UART_BASE,
+                                 EUSCI_A_UART_TRANSMIT_INTERRUPT);
+        }
+        else
+        {
+            sending = false;
+            Idle_release(IDLE_HOLD_UART);
+        }
+    }
+}
@@ -0,0 +1,138 @@
+/*
+ * Trace.h
+ *
+ *  Created on: Nov 30, 2024
+ *
+ * Accelerometer trace recorder.  Every raw sample the round sees, with its
+ * time, and the game's events are packed into a ring of bytes in SRAM, which the
+ * EUSCI_A0 UART (the LaunchPad's backchannel, 115200 8N1) sends to the PC
+ * from its transmit interrupt, a byte at a time.  Nothing waits on the UART:
+ * if the ring is full, records are dropped and counted, and the gap is
+ * marked in the stream.  While bytes are going out the UART needs SMCLK, so
+ * it holds the CPU out of LPM3 (IDLE_HOLD_UART).
+ *
+ * A sample is recorded as its difference from the one before, in 2 bytes if
+ * every axis moved by less than 16 counts and 3 if by less than 64, or
+ * whole in 6.  Sample times are not recorded: each comes a period after the
+ * last, and a TIME record is only written when the capture does not follow
+ * on from the previous block.  Where the capture skipped samples (the ring
+ * paused while the tilt window is armed, or dropping blocks), a GAP event
+ * after the TIME record says how many.  The cost of each Trace_sample() call is
+ * measured on the clock and kept in g_traceStats; it writes at most
+ * TRACE_RECORD_MAX bytes and does not loop, so it is bounded.
+ *
+ * The stream, records back to back, multi-byte fields most significant
+ * byte first:
+ *   0ddddd dddddddddd (2 bytes)  SAMPLE_SMALL   dx, dy, dz: 5 bits each,
+ *                                               signed
+ *   10dddd ... d0 (3 bytes)      SAMPLE_MEDIUM  dx, dy, dz: 7 bits each,
+ *                                               then a 0 bit
+ *   110000 xx ... (6 bytes)      SAMPLE_FULL    x, y, z: 14 bits each
+ *   1101 tttt ... (5 bytes)      TIME           the next sample's time, 36
+ *                                               bits of microseconds
+ *   1110 pppp ... (3 bytes)      PERIOD         microseconds between
+ *                                               samples, 20 bits
+ *   1111 eeee aaaaaaaa           EVENT          event e, argument a
+ * A sample is at the time in the TIME record before it, or a PERIOD after
+ * the sample before it; an event is at the time of the sample before it, or
+ * of the TIME record if it comes straight after one.
+ *
+ * The first record of a capture, of each Trace_eventNow() (round start and
+ * end) and after records were dropped is a SYNC event (argument
+ * TRACE_SYNC_MAGIC), followed by TIME, a LOST event if any were dropped,
+ * and PERIOD and a full sample before the next samples, so a decoder can
+ * pick up the stream from there.  host/trace_decode turns the stream into
+ * CSV.
+ */
+
+#ifndef HAL_TRACE_H_
+#define HAL_TRACE_H_
+
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+#include <HAL/AccelRing.h>
+
+// Bytes in the ring: about 15 s of samples at 100 Hz
+#define TRACE_RING_BYTES        4096
+
+#if TRACE_RING_BYTES & (TRACE_RING_BYTES - 1)
+#error "TRACE_RING_BYTES must be a power of 2"
+#endif
+
+#define TRACE_UART_BASE         EUSCI_A0_BASE
+#define TRACE_UART_INT          INT_EUSCIA0
+
+// Record tags, and the masks that pick them out of a record's first byte
+#define TRACE_TAG_SMALL         0x00
+#define TRACE_MASK_SMALL        0x80
+#define TRACE_TAG_MEDIUM        0x80
+#define TRACE_MASK_MEDIUM       0xC0
+#define TRACE_TAG_FULL          0xC0
+#define TRACE_TAG_TIME          0xD0
+#define TRACE_TAG_PERIOD        0xE0
+#define TRACE_TAG_EVENT         0xF0
+#define TRACE_MASK_TAG          0xF0
+
+#define TRACE_SMALL_BYTES       2
+#define TRACE_MEDIUM_BYTES      3
+#define TRACE_FULL_BYTES        6
+#define TRACE_TIME_BYTES        5
+#define TRACE_PERIOD_BYTES      3
+#define TRACE_EVENT_BYTES       2
+
+// The most one Trace_sample() call writes: SYNC, TIME, LOST, GAP, PERIOD
+// and a full sample
+#define TRACE_RECORD_MAX        (3 * TRACE_EVENT_BYTES + TRACE_TIME_BYTES + \
+                                 TRACE_PERIOD_BYTES + TRACE_FULL_BYTES)
+
+// The most one Trace_event() call writes: SYNC, TIME, LOST, GAP, PERIOD and
+// the event
+#define TRACE_EVENT_RECORD_MAX  (4 * TRACE_EVENT_BYTES + TRACE_TIME_BYTES + \
+                                 TRACE_PERIOD_BYTES)
+
+#define TRACE_SYNC_MAGIC        0xA5
+
+typedef enum
+{
+    TRACE_ROUND_START,      // argument 0
+    TRACE_WORD_SHOWN,       // the word's index
+    TRACE_SCORED,           // the score, up to 255
+    TRACE_SKIPPED,          // argument 0
+    TRACE_ROUND_END,        // the score, up to 255
+    TRACE_LOST,             // samples and events dropped, up to 255
+    TRACE_GAP,              // sample periods not captured, up to 255
+    TRACE_SYNC = 15         // TRACE_SYNC_MAGIC
+} TraceEvent;
+
+typedef struct
+{
+    uint32_t samples;       // recorded
+    uint32_t events;
+    uint32_t lost;          // samples and events dropped with the ring full
+    uint32_t bytes;         // written to the ring
+
+    // Cycles spent in Trace_sample(), the most in one call and in all
+    uint32_t maxCycles;
+    uint64_t totalCycles;
+} TraceStats;
+
+extern TraceStats g_traceStats;
+
+// Sets up the UART and its pins, empties the ring and starts recording
+void Trace_init(void);
+
+// Stops or restarts recording; what is in the ring still goes out
+void Trace_setEnabled(bool enabled);
+
+// Takes the time of the samples of a block about to be recorded
+void Trace_startBlock(const AccelBlock* block);
+
+// Records the next sample of the block
+void Trace_sample(AccelSample sample);
+
+// Records an event at the time of the last sample
+void Trace_event(TraceEvent event, uint8_t argument);
+
+// Records an event at the time now, for events outside the samples
+void Trace_eventNow(TraceEvent event, uint8_t argument);
+
+#endif /* HAL_TRACE_H_ */
@@ -0,0 +1,157 @@
+/*
+ * WordCache.c
+ *
+ *  Created on: Nov 23, 2024
+ */
+
+#include <HAL/WordCache.h>
+#include <HAL/LcdDriver/Crystalfontz128x128_ST7735.h>
+#include <string.h>
+
+typedef struct
+{
+    // Key: the text, the font and where it was asked to go
+    char word[WORD_CACHE_MAX_LENGTH + 1];
+    const Graphics_Font *font;
+    int32_t x, y, xMin, xMax;
+
+    // The window the bitmap covers, already clipped
+    Graphics_Rectangle window;
+    uint8_t stride;
+
+    // Draw count at the last use; 0 marks an empty slot
+    uint32_t lastUse;
+} WordCache_Slot;
+
+static WordCache_Slot cacheSlots[WORD_CACHE_SLOTS];
+static uint8_t cacheBitmaps[WORD_CACHE_SLOTS][WORD_CACHE_SLOT_SIZE];
+static uint32_t cacheClock;
+static WordCache_Stats cacheStats;
+
+/**
+ * Returns the slot holding this word at this place, or NULL.
+ */
+static WordCache_Slot *WordCache_lookup(const Graphics_Font *font,
+                                        const char *word, int32_t x, int32_t y,
+                                        int32_t xMin, int32_t xMax)
+{
+    int i;
+
+    for (i = 0; i < WORD_CACHE_SLOTS; i++)
+    {
+        WordCache_Slot *slot = &cacheSlots[i];
+
+        if (slot->lastUse && (slot->font == font) && (slot->x == x) &&
+            (slot->y == y) && (slot->xMin == xMin) && (slot->xMax == xMax) &&
+            (strcmp(slot->word, word) == 0))
+        {
+            return slot;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Returns an empty slot, or the least recently used one if all are taken.
+ */
+static WordCache_Slot *WordCache_victim(void)
+{
+    WordCache_Slot *victim = &cacheSlots[0];
+    int i;
+
+    for (i = 0; i < WORD_CACHE_SLOTS; i++)
+    {
+        if (cacheSlots[i].lastUse < victim->lastUse)
+        {
+            victim = &cacheSlots[i];
+        }
+    }
+
+    if (victim->lastUse)
+    {
+        cacheStats.evictions++;
+    }
+
+    return victim;
+}
+
+void WordCache_drawString(const Graphics_Context *context, const char *word,
+                          int32_t x, int32_t y, int32_t xMin, int32_t xMax)
+{
+    const Graphics_Font *font = context->font;
+    WordCache_Slot *slot;
+    Graphics_Rectangle window;
+
+    slot = WordCache_lookup(font, word, x, y, xMin, xMax);
+
+    // Clip regions are not part of the key, so a hit is only good while the
+    // window still fits inside the context's
+    if (slot && (slot->window.xMin >= context->clipRegion.xMin) &&
+        (slot->window.xMax <= context->clipRegion.xMax) &&
+        (slot->window.yMin >= context->clipRegion.yMin) &&
+        (slot->window.yMax <= context->clipRegion.yMax))
+    {
+        cacheStats.hits++;
+    }
+    else
+    {
+        if ((strlen(word) > WORD_CACHE_MAX_LENGTH) ||
+            !FontAtlas_getWindow(context, word, x, y, xMin, xMax, &window))
+        {
+            FontAtlas_drawStringField(context, word, x, y, xMin, xMax);
+            return;
+        }
+
+        if (slot == NULL)
+        {
+            slot = WordCache_victim();
+        }
+
+        slot->stride = (window.xMax - window.xMin + 8) / 8;
+        if (!FontAtlas_render(font, word, x - window.xMin,
+                              window.yMin - y, window.yMax - window.yMin + 1,
+                              cacheBitmaps[slot - cacheSlots], slot->stride,
+                              window.xMax - window.xMin + 1))
+        {
+            // Not an atlas font: nothing to cache
+            slot->lastUse = 0;
+            FontAtlas_drawStringField(context, word, x, y, xMin, xMax);
+            return;
+        }
+
+        strcpy(slot->word, word);
+        slot->font = font;
+        slot->x = x;
+        slot->y = y;
+        slot->xMin = xMin;
+        slot->xMax = xMax;
+        slot->window = window;
+        cacheStats.misses++;
+    }
+
+    slot->lastUse = ++cacheClock;
+
+    Crystalfontz128x128_BlitMono(slot->window.xMin, slot->window.yMin,
+                                 slot->window.xMax, slot->window.yMax,
+                                 cacheBitmaps[slot - cacheSlots], slot->stride,
+                                 context->foreground, context->background);
+}
+
+void WordCache_drawCentered(const Graphics_Context *context, const char *word,
+                            int32_t x, int32_t y, int32_t xMin, int32_t xMax)
+{
+    WordCache_drawString(context, word,
+                         x - FontAtlas_getStringWidth(context->font, word) / 2,
+                         y - context->font->baseline / 2, xMin, xMax);
+}
+
+void WordCache_clear(void)
+{
+    memset(cacheSlots, 0, sizeof(cacheSlots));
+}
+
+WordCache_Stats WordCache_getStats(void)
+{
+    return cacheStats;
+}
@@ -0,0 +1,57 @@
+/*
+ * WordCache.h
+ *
+ *  Created on: Nov 23, 2024
+ *
+ * Cache of pre-rendered words.  The first time a word is drawn at a given
+ * place it is rasterized, through the FontAtlas, into a 1bpp bitmap of its
+ * whole window (field included) and kept in one of a fixed number of slots.
+ * Drawing it again is a single Crystalfontz128x128_BlitMono() of that bitmap
+ * in the context's current colours, with no glyph work and no measuring.
+ *
+ * Memory use is fixed at WORD_CACHE_SLOTS * WORD_CACHE_SLOT_SIZE bytes no
+ * matter how long the word list is; when every slot is taken the least
+ * recently drawn word is evicted.
+ */
+
+#ifndef HAL_WORDCACHE_H_
+#define HAL_WORDCACHE_H_
+
+#include <ti/grlib/grlib.h>
+#include <HAL/FontAtlas.h>
+#include <HAL/LcdDriver/Crystalfontz128x128_ST7735.h>
+
+// Number of words kept at once
+#define WORD_CACHE_SLOTS        8
+
+// Bitmap bytes per slot: a full-width line of the tallest atlas font
+#define WORD_CACHE_SLOT_SIZE    (LCD_HORIZONTAL_MAX / 8 * FONT_ATLAS_MAX_HEIGHT)
+
+// Longest word that is cached; longer ones are drawn through the FontAtlas
+#define WORD_CACHE_MAX_LENGTH   23
+
+typedef struct
+{
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+} WordCache_Stats;
+
+// Draws word with its top-left corner at (x, y), like Graphics_drawString()
+// with OPAQUE_TEXT, and paints the background over columns xMin..xMax of the
+// text rows in the same window (see FontAtlas_drawStringField())
+void WordCache_drawString(const Graphics_Context *context, const char *word,
+                          int32_t x, int32_t y, int32_t xMin, int32_t xMax);
+
+// Same as WordCache_drawString(), but centred on (x, y) like
+// Graphics_drawStringCentered()
+void WordCache_drawCentered(const Graphics_Context *context, const char *word,
+                            int32_t x, int32_t y, int32_t xMin, int32_t xMax);
+
+// Forgets every cached word, e.g. after the fonts or the word list change
+void WordCache_clear(void);
+
+// Returns the hit, miss and eviction counts since boot
+WordCache_Stats WordCache_getStats(void);
+
+#endif /* HAL_WORDCACHE_H_ */
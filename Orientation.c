@@ -0,0 +1,376 @@
+/*
+ * Orientation.c
+ *
+ * The board's orientation and gestures.  See Orientation.h.
+ */
+
+#include "Orientation.h"
+
+#define CORDIC_STEPS 16
+
+/* atan(2^-i) with a turn as 2^32 */
+static const int32_t cordicAtan[CORDIC_STEPS] = {
+    536870912, 316933406, 167458907, 85004756, 42667331, 21354465,
+    10679838, 5340245, 2670163, 1335087, 667544, 333772,
+    166886, 83443, 41722, 20861,
+};
+
+/* CORDIC's gain after 16 steps, Q14, its inverse, Q14, and the inverse of
+ * its square, Q16 */
+#define CORDIC_GAIN_Q14         26981
+#define CORDIC_GAIN_INV_Q14     9949
+#define CORDIC_GAIN2_INV_Q16    24167
+
+/* Counts are scaled up this much going in, for the fine steps' sake */
+#define CORDIC_SCALE_BITS       12
+
+/* Jolts are counted in 1/256ths so the decay has something to take off */
+#define SHAKE_JOLT              256
+
+/* A quarter turn, as an angle */
+#define QUARTER                 0x4000
+
+OrientationConfig Orientation_defaultConfig(uint32_t sampleHz)
+{
+    /* The tilt thresholds are the angles of the Z band the game first
+     * classified on (7000, 7500, 10000 and 10500 counts).  Flat is past the
+     * deepest a tilt is held by hand, so a long "got it" is not dropped as
+     * the board being put down */
+    OrientationConfig config = {
+        .zeroG = 8192,
+        .oneG = 3277,
+        .tilt = {
+            .downEnter = ORIENTATION_DEG(-21),
+            .downExit = ORIENTATION_DEG(-12),
+            .upExit = ORIENTATION_DEG(33),
+            .upEnter = ORIENTATION_DEG(45),
+        },
+        .flatAngle = ORIENTATION_DEG(80),
+        .shakeJolts = 4,
+        .turnMargin = ORIENTATION_DEG(15),
+    };
+
+    config.tilt.dwellSamples = Tilt_samplesIn(50, sampleHz);
+    config.flatDwell = Tilt_samplesIn(1500, sampleHz);
+    /* The filter shaves a shake's peaks, so a gentle one never gets 0.5 g
+     * off 1 g, and tips the pitch through the thresholds as a tilt would */
+    config.shakeG = config.oneG * 3 / 10;
+    config.shakeWindow = Tilt_samplesIn(250, sampleHz);
+    config.turnDwell = Tilt_samplesIn(500, sampleHz);
+    return config;
+}
+
+void Orientation_init(Orientation *orientation,
+                      const OrientationConfig *config)
+{
+    orientation->config = *config;
+    Tilt_init(&orientation->tilt, &config->tilt);
+    Orientation_reset(orientation);
+}
+
+void Orientation_reset(Orientation *orientation)
+{
+    Tilt_reset(&orientation->tilt);
+    orientation->angles.pitch = 0;
+    orientation->angles.roll = 0;
+    orientation->angles.magnitude = orientation->config.oneG;
+    orientation->shakeLevel = 0;
+    orientation->shaking = false;
+    orientation->flatCount = 0;
+    orientation->flat = false;
+    orientation->settling = false;
+    orientation->settleCount = 0;
+    orientation->facing = ORIENTATION_FACING_UP;
+    orientation->turnToward = ORIENTATION_FACING_UP;
+    orientation->turnCount = 0;
+}
+
+int16_t Orientation_atan2(int32_t y, int32_t x, int32_t *magnitude_p)
+{
+    uint32_t angle = 0;
+    int i;
+
+    /* Into the right half-plane, where the steps converge */
+    if (x < 0)
+    {
+        x = -x;
+        y = -y;
+        angle = 0x80000000u;
+    }
+
+    /* Turn (x, y) onto the x axis, adding up the angles turned through */
+    for (i = 0; i < CORDIC_STEPS; i++)
+    {
+        int32_t dx = y >> i;
+        int32_t dy = x >> i;
+
+        if (y > 0)
+        {
+            x += dx;
+            y -= dy;
+            angle += cordicAtan[i];
+        }
+        else
+        {
+            x -= dx;
+            y += dy;
+            angle -= cordicAtan[i];
+        }
+    }
+
+    if (magnitude_p)
+    {
+        *magnitude_p = x;
+    }
+    /* To 16 bits, rounded */
+    return (int16_t) ((angle + 0x8000u) >> 16);
+}
+
+/* length * sin(angle), rounded, for an angle up to a quarter turn either
+ * way: CORDIC in rotation mode, turning (length, 0) through the angle with
+ * the gain taken off going in.  length is at most 2^16. */
+static int32_t Orientation_sin(int16_t angle, int32_t length)
+{
+    int32_t x = length * CORDIC_GAIN_INV_Q14 >> (14 - CORDIC_SCALE_BITS);
+    int32_t y = 0;
+    int32_t left = (int32_t) angle * 65536;
+    int i;
+
+    for (i = 0; i < CORDIC_STEPS; i++)
+    {
+        int32_t dx = y >> i;
+        int32_t dy = x >> i;
+
+        if (left > 0)
+        {
+            x -= dx;
+            y += dy;
+            left -= cordicAtan[i];
+        }
+        else
+        {
+            x += dx;
+            y -= dy;
+            left += cordicAtan[i];
+        }
+    }
+    return (y + (1 << (CORDIC_SCALE_BITS - 1))) >> CORDIC_SCALE_BITS;
+}
+
+/* Counts a jolt if the magnitude is shakeG off 1 g; returns true when the
+ * recent ones make a new shake */
+static bool Orientation_shook(Orientation *orientation)
+{
+    const OrientationConfig *config = &orientation->config;
+    int32_t off = (int32_t) orientation->angles.magnitude - config->oneG;
+
+    orientation->shakeLevel -= orientation->shakeLevel / config->shakeWindow;
+    if (off > config->shakeG || -off > config->shakeG)
+    {
+        orientation->shakeLevel += SHAKE_JOLT;
+    }
+
+    if (orientation->shaking)
+    {
+        orientation->shaking = orientation->shakeLevel >= SHAKE_JOLT;
+        return false;
+    }
+    orientation->shaking =
+            orientation->shakeLevel >= (uint32_t) config->shakeJolts * SHAKE_JOLT;
+    return orientation->shaking;
+}
+
+/* Returns FLAT or FLAT_END as the pitch goes past flatAngle for flatDwell
+ * samples, or comes back */
+static uint8_t Orientation_lies(Orientation *orientation)
+{
+    const OrientationConfig *config = &orientation->config;
+    int16_t pitch = orientation->angles.pitch;
+    bool beyond = pitch > config->flatAngle || pitch < -config->flatAngle;
+
+    if (!orientation->flat)
+    {
+        orientation->flatCount = beyond ? orientation->flatCount + 1 : 0;
+        if (orientation->flatCount < config->flatDwell)
+        {
+            return 0;
+        }
+        orientation->flat = true;
+        return ORIENTATION_FLAT;
+    }
+    if (beyond)
+    {
+        return 0;
+    }
+    orientation->flat = false;
+    orientation->flatCount = 0;
+    return ORIENTATION_FLAT_END;
+}
+
+/* Returns true once the pitch has stayed inside the level band for the tilt
+ * dwell after a shake or lying flat, when tilts can be classified again.
+ * The shake's tail counts: the board is often still well before the jolts
+ * have decayed, and a tilt started then is the player's next gesture */
+static bool Orientation_settled(Orientation *orientation)
+{
+    const TiltConfig *tilt = &orientation->config.tilt;
+    int16_t pitch = orientation->angles.pitch;
+
+    if (!orientation->settling)
+    {
+        return true;
+    }
+    if (orientation->flat || pitch <= tilt->downExit
+        || pitch >= tilt->upExit)
+    {
+        orientation->settleCount = 0;
+        return false;
+    }
+    if (++orientation->settleCount < orientation->tilt.config.dwellSamples)
+    {
+        return false;
+    }
+    orientation->settling = false;
+    orientation->settleCount = 0;
+    Tilt_reset(&orientation->tilt);
+    return true;
+}
+
+/* Returns true when the roll has stayed well inside another quarter for
+ * turnDwell samples, and moves the facing there */
+static bool Orientation_turned(Orientation *orientation)
+{
+    const OrientationConfig *config = &orientation->config;
+    int16_t pitch = orientation->angles.pitch;
+    uint16_t roll = (uint16_t) orientation->angles.roll;
+    uint8_t quarter = (uint16_t) (roll + QUARTER / 2) >> 14;
+    int16_t off = (int16_t) (roll - quarter * QUARTER);
+
+    /* Near flat the roll is noise, and while shaking it is the shake */
+    if (orientation->shaking || pitch > config->flatAngle
+        || pitch < -config->flatAngle || quarter == orientation->facing
+        || off > QUARTER / 2 - config->turnMargin
+        || off < config->turnMargin - QUARTER / 2)
+    {
+        orientation->turnCount = 0;
+        return false;
+    }
+
+    if (quarter != orientation->turnToward)
+    {
+        orientation->turnToward = quarter;
+        orientation->turnCount = 0;
+    }
+    if (++orientation->turnCount < config->turnDwell)
+    {
+        return false;
+    }
+    orientation->facing = quarter;
+    orientation->turnCount = 0;
+    return true;
+}
+
+uint8_t Orientation_update(Orientation *orientation, AccelSample sample)
+{
+    const OrientationConfig *config = &orientation->config;
+    int32_t x = ((int32_t) sample.x - config->zeroG) * (1 << CORDIC_SCALE_BITS);
+    int32_t y = ((int32_t) sample.y - config->zeroG) * (1 << CORDIC_SCALE_BITS);
+    int32_t z = ((int32_t) sample.z - config->zeroG) * CORDIC_GAIN_Q14
+            >> (14 - CORDIC_SCALE_BITS);
+    int32_t planar, total;
+    uint8_t events = 0;
+
+    /* Roll and the X/Y part's size, which comes out with CORDIC's gain, so
+     * Z gets the same gain going in; pitch and the whole size, with the
+     * gain twice over */
+    orientation->angles.roll = Orientation_atan2(x, y, &planar);
+    orientation->angles.pitch = Orientation_atan2(z, planar, &total);
+    orientation->angles.magnitude = (uint16_t)
+            (((total >> CORDIC_SCALE_BITS) * CORDIC_GAIN2_INV_Q16) >> 16);
+
+    if (Orientation_shook(orientation))
+    {
+        events |= ORIENTATION_SHAKE;
+    }
+    events |= Orientation_lies(orientation);
+    if (events & (ORIENTATION_SHAKE | ORIENTATION_FLAT))
+    {
+        Tilt_reset(&orientation->tilt);
+        orientation->settling = true;
+    }
+
+    if (Orientation_turned(orientation))
+    {
+        events |= ORIENTATION_TURN;
+    }
+
+    if (Orientation_settled(orientation) && !orientation->shaking
+        && !orientation->flat)
+    {
+        switch (Tilt_update(&orientation->tilt, orientation->angles.pitch))
+        {
+        case TILT_ENTER_DOWN:
+            events |= ORIENTATION_DOWN;
+            break;
+        case TILT_ENTER_UP:
+            events |= ORIENTATION_UP;
+            break;
+        case TILT_LEAVE_DOWN:
+            events |= ORIENTATION_DOWN_END;
+            break;
+        case TILT_LEAVE_UP:
+            events |= ORIENTATION_UP_END;
+            break;
+        default:
+            break;
+        }
+    }
+    return events;
+}
+
+bool Orientation_quiet(const Orientation *orientation)
+{
+    const OrientationConfig *config = &orientation->config;
+    int16_t pitch = orientation->angles.pitch;
+    int16_t off = (int16_t) (orientation->angles.roll
+            - orientation->facing * QUARTER);
+
+    return !orientation->settling && !orientation->shaking
+            && !orientation->flat && orientation->flatCount == 0
+            && orientation->shakeLevel < SHAKE_JOLT
+            && orientation->turnCount == 0
+            && Tilt_state(&orientation->tilt) == TILT_LEVEL
+            && orientation->tilt.dwell == 0
+            && pitch > config->tilt.downExit && pitch < config->tilt.upExit
+            && off < QUARTER / 2 - config->turnMargin
+            && off > config->turnMargin - QUARTER / 2;
+}
+
+void Orientation_quietBand(const Orientation *orientation, AccelSample *low,
+                           AccelSample *high)
+{
+    const OrientationConfig *config = &orientation->config;
+    int32_t across = Orientation_sin(QUARTER / 2 - config->turnMargin,
+                                     config->oneG);
+
+    low->x = low->y = 0;
+    high->x = high->y = UINT16_MAX;
+    low->z = config->zeroG
+            + Orientation_sin(config->tilt.downExit, config->oneG);
+    high->z = config->zeroG
+            + Orientation_sin(config->tilt.upExit, config->oneG);
+
+    /* Gravity's X/Y part is along Y facing up or down, and along X turned
+     * sideways; the other axis is the one a turn moves first */
+    if (orientation->facing == ORIENTATION_FACING_UP
+        || orientation->facing == ORIENTATION_FACING_DOWN)
+    {
+        low->x = config->zeroG - across;
+        high->x = config->zeroG + across;
+    }
+    else
+    {
+        low->y = config->zeroG - across;
+        high->y = config->zeroG + across;
+    }
+}
@@ -0,0 +1,183 @@
+/*
+ * Orientation.h
+ *
+ * The board's orientation from all three accelerometer axes, and the
+ * gestures the game plays on.
+ *
+ * Each sample, gravity's direction is found in two angles:
+ *   pitch  how far the screen faces the floor (negative) or the ceiling
+ *          (positive), from -90 to 90 degrees: the angle between gravity and
+ *          the screen's plane.  It does not depend on how the board is
+ *          turned in that plane, so holding it at an angle does not move
+ *          the tilt thresholds.
+ *   roll   which way the board is turned in the screen's plane: the
+ *          direction of gravity's X/Y part, 0 with it along +Y.
+ * and its magnitude, which is 1 g when the board is still.
+ *
+ * The angles are worked out with CORDIC in vectoring mode, shifts and adds
+ * only: once on (Y, X) for roll and the X/Y magnitude, once on that and Z for
+ * pitch and the total.  No floating point and no libm; two 16-step passes
+ * are a few hundred cycles, a few microseconds at 48 MHz.
+ *
+ * Angles are binary: a turn is 65536, so they wrap like an int16_t, and
+ * ORIENTATION_DEG() converts from degrees.
+ *
+ * The gestures:
+ *   DOWN, UP       the pitch crossing the tilt thresholds, through a Tilt
+ *                  classifier (hysteresis and dwell); DOWN_END and UP_END
+ *                  when it comes back
+ *   SHAKE          the magnitude straying from 1 g by more than shakeG on
+ *                  enough recent samples.  As with FLAT, a tilt under way
+ *                  is dropped, and none is classified until it settles.
+ *   FLAT, FLAT_END the pitch beyond flatAngle either way for flatDwell
+ *                  samples: the board put down on its back or its face.
+ *                  flatAngle is kept past the deepest tilt held by hand, so
+ *                  only a board lying there goes flat; a tilt under way
+ *                  when it does is dropped without an end, and tilts are
+ *                  not classified while it is flat.
+ * After a shake or FLAT_END, tilts are only classified again once the pitch
+ * has been back inside the level band (downExit to upExit) for the tilt
+ * dwell, so picking the board up, which swings the pitch back through the
+ * thresholds, neither scores nor passes.
+ *   TURN           the board turned a quarter or a half round in the screen's
+ *                  plane and held there: the roll well inside another
+ *                  quarter (turnMargin past its edge) for turnDwell samples,
+ *                  with the board neither shaking nor near flat, where the
+ *                  roll means nothing.  Orientation_facing() says which
+ *                  quarter, for the display to follow.
+ * There is no hardware behind it, so it runs off-target as well.
+ */
+
+#ifndef ORIENTATION_H_
+#define ORIENTATION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <HAL/AccelRing.h>
+#include "Tilt.h"
+
+#define ORIENTATION_DEG(degrees) ((int16_t) ((degrees) * 65536L / 360))
+
+// Events of one sample, or'd together
+#define ORIENTATION_DOWN        0x01
+#define ORIENTATION_DOWN_END    0x02
+#define ORIENTATION_UP          0x04
+#define ORIENTATION_UP_END      0x08
+#define ORIENTATION_SHAKE       0x10
+#define ORIENTATION_FLAT        0x20
+#define ORIENTATION_FLAT_END    0x40
+#define ORIENTATION_TURN        0x80
+
+// Which way the board is turned in the screen's plane, in quarter turns
+// from upright: the quarter of the roll gravity's X/Y part is in
+#define ORIENTATION_FACING_UP       0   // along +Y
+#define ORIENTATION_FACING_PLUS_X   1
+#define ORIENTATION_FACING_DOWN     2   // along -Y
+#define ORIENTATION_FACING_MINUS_X  3
+
+typedef struct
+{
+    // ADC counts at 0 g and for 1 g, the same on every axis
+    int16_t zeroG;
+    int16_t oneG;
+
+    // Pitch thresholds (angles) and dwell for tilting down and up
+    TiltConfig tilt;
+
+    // Pitch beyond which, either way, the board is lying flat, and the
+    // samples it must stay there
+    int16_t flatAngle;
+    uint16_t flatDwell;
+
+    // Distance of the magnitude from 1 g, in counts, that makes a sample a
+    // jolt, and the jolts in about the last shakeWindow samples that make a
+    // shake
+    uint16_t shakeG;
+    uint16_t shakeJolts;
+    uint16_t shakeWindow;
+
+    // Angle the roll must be past the edge of another quarter, and the
+    // samples it must stay there, to turn the facing
+    int16_t turnMargin;
+    uint16_t turnDwell;
+} OrientationConfig;
+
+typedef struct
+{
+    int16_t pitch;
+    int16_t roll;
+    uint16_t magnitude;     // ADC counts
+} OrientationAngles;
+
+typedef struct
+{
+    OrientationConfig config;
+    Tilt tilt;
+    OrientationAngles angles;
+
+    // Recent jolts, decaying by a shakeWindow'th a sample, in 1/256ths
+    uint32_t shakeLevel;
+    bool shaking;
+
+    uint16_t flatCount;
+    bool flat;
+
+    // After a shake or lying flat, tilts are not classified again until the
+    // pitch has been back inside the level band for the tilt dwell
+    bool settling;
+    uint16_t settleCount;
+
+    uint8_t facing;
+    uint8_t turnToward;     // the quarter turnCount samples have been in
+    uint16_t turnCount;
+} Orientation;
+
+// The BoosterPack's accelerometer (ratiometric, on AVCC: 0 g mid-scale and
+// about 660 mV/g of 3.3 V), the game's tilt thresholds with a 50 ms dwell,
+// flat past 80 degrees for 1.5 s, a shake of 4 jolts of 0.3 g in 250 ms,
+// and a turn 15 degrees into another quarter for 0.5 s, at the given sample
+// rate
+OrientationConfig Orientation_defaultConfig(uint32_t sampleHz);
+
+void Orientation_init(Orientation* orientation,
+                      const OrientationConfig* config);
+
+// Upright, still, not flat and facing up
+void Orientation_reset(Orientation* orientation);
+
+// Takes the next sample; returns its events
+uint8_t Orientation_update(Orientation* orientation, AccelSample sample);
+
+// The angles of the last sample
+static inline OrientationAngles Orientation_angles(
+        const Orientation* orientation)
+{
+    return orientation->angles;
+}
+
+// The quarter the board was last turned to, ORIENTATION_FACING_*
+static inline uint8_t Orientation_facing(const Orientation* orientation)
+{
+    return orientation->facing;
+}
+
+// True when no gesture is under way or counting towards one: level (the
+// pitch inside downExit to upExit and the roll turnMargin inside its
+// quarter), not settling, shaking or flat, with no dwell counting and less
+// than a jolt of shake left.  Until a sample leaves Orientation_quietBand(),
+// the samples can be skipped: none of them would start a gesture.
+bool Orientation_quiet(const Orientation* orientation);
+
+// The raw readings, each axis between low and high, that keep a still board
+// quiet: Z with the pitch inside the level band, and the axis across
+// gravity's X/Y part with the roll turnMargin inside its quarter, both at
+// 1 g.  The axis gravity is along is not limited (0 to UINT16_MAX).
+void Orientation_quietBand(const Orientation* orientation, AccelSample* low,
+                           AccelSample* high);
+
+// atan2(y, x) as a binary angle, and CORDIC's magnitude: sqrt(x^2 + y^2)
+// times its gain, 1.6468, in magnitude_p if it is not NULL. y and x are at
+// most 2^28 in size.
+int16_t Orientation_atan2(int32_t y, int32_t x, int32_t* magnitude_p);
+
+#endif /* ORIENTATION_H_ */
@@ -0,0 +1,54 @@
+/*
+ * Round.c
+ *
+ * The round's play.  See Round.h.
+ */
+
+#include "Round.h"
+
+RoundConfig Round_defaultConfig(uint32_t sampleHz)
+{
+    RoundConfig config = {
+        .filter = {
+            .alpha = ACCEL_FILTER_ALPHA_ONE * 3 / 10,
+            .medianTaps = 5,
+        },
+    };
+
+    config.orientation = Orientation_defaultConfig(sampleHz);
+    return config;
+}
+
+void Round_init(Round *round, const RoundConfig *config)
+{
+    AccelFilter_init(&round->filter, &config->filter);
+    Orientation_init(&round->orientation, &config->orientation);
+}
+
+void Round_reset(Round *round)
+{
+    AccelFilter_reset(&round->filter);
+    Orientation_reset(&round->orientation);
+}
+
+uint8_t Round_sample(Round *round, AccelSample sample)
+{
+    uint8_t events = Orientation_update(&round->orientation,
+                                        AccelFilter_run(&round->filter,
+                                                        sample));
+    uint8_t did = 0;
+
+    if (events & ORIENTATION_DOWN_END)
+    {
+        did |= ROUND_SCORED;
+    }
+    if (events & ORIENTATION_UP_END)
+    {
+        did |= ROUND_PASSED;
+    }
+    if (events & ORIENTATION_TURN)
+    {
+        did |= ROUND_TURNED;
+    }
+    return did;
+}
@@ -0,0 +1,80 @@
+/*
+ * Round.h
+ *
+ * The round's play, from the raw accelerometer samples to what the game does
+ * with them.  Each sample goes through the AccelFilter and on into the
+ * Orientation engine, and of its gestures:
+ *   SCORED     back from face down: the word was got
+ *   PASSED     back from face up: the word was passed
+ *   TURNED     the board turned to face another way
+ * Shakes and setting the board down do none of these.
+ *
+ * drawAccelData() feeds it the AccelRing's blocks and draws what it says;
+ * it touches no hardware, so host/tilt_replay runs the same code on recorded
+ * and synthetic traces.  While nothing is under way (Round_quiet()), the
+ * firmware can sleep through the samples until the ADC's window comparators
+ * see one leave Round_quietBand().
+ */
+
+#ifndef ROUND_H_
+#define ROUND_H_
+
+#include <stdint.h>
+#include <HAL/AccelFilter.h>
+#include "Orientation.h"
+
+// What one sample did, or'd together
+#define ROUND_SCORED    0x01
+#define ROUND_PASSED    0x02
+#define ROUND_TURNED    0x04
+
+typedef struct
+{
+    AccelFilterConfig filter;
+    OrientationConfig orientation;
+} RoundConfig;
+
+typedef struct
+{
+    AccelFilter filter;
+    Orientation orientation;
+} Round;
+
+// A median of 5 to drop spikes then a low-pass at about 5 Hz at 100 Hz, and
+// the Orientation engine's defaults, at the given sample rate
+RoundConfig Round_defaultConfig(uint32_t sampleHz);
+
+void Round_init(Round* round, const RoundConfig* config);
+
+// Forgets the samples so far, upright and facing up, for a new round
+void Round_reset(Round* round);
+
+// Takes the next raw sample; returns what it did, ROUND_*
+uint8_t Round_sample(Round* round, AccelSample sample);
+
+// The quarter the board was last turned to, ORIENTATION_FACING_*
+static inline uint8_t Round_facing(const Round* round)
+{
+    return Orientation_facing(&round->orientation);
+}
+
+// True when nothing is under way (Orientation_quiet()) and the board faces
+// up or down, so that X is the axis a turn moves first: the firmware's
+// window comparators watch Z and X only, not Y
+static inline bool Round_quiet(const Round* round)
+{
+    uint8_t facing = Round_facing(round);
+
+    return Orientation_quiet(&round->orientation)
+            && (facing == ORIENTATION_FACING_UP
+                || facing == ORIENTATION_FACING_DOWN);
+}
+
+// The raw readings that keep the round quiet (Orientation_quietBand())
+static inline void Round_quietBand(const Round* round, AccelSample* low,
+                                   AccelSample* high)
+{
+    Orientation_quietBand(&round->orientation, low, high);
+}
+
+#endif /* ROUND_H_ */
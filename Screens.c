@@ -0,0 +1,156 @@
+/*
+ * Screens.c
+ *
+ * Everything the game draws, one routine per screen or field.  Nothing here
+ * touches the hardware beyond the graphics context, so the same file builds
+ * into the host benchmark (host/screen_bench.c).
+ */
+
+#include "Screens.h"
+#include <HAL/FontAtlas.h>
+#include <stdio.h>
+#include <string.h>
+#include "Words.h"
+
+/* The time field: two character cells of the 6-pixel fixed font */
+#define TIME_X          64
+#define TIME_Y          110
+#define TIME_DIGITS     2
+#define TIME_CELL       6
+
+/* Characters the time field shows, one per cell; NUL where the cell is not
+ * known to hold anything, so it is drawn next time */
+static char shownTime[TIME_DIGITS];
+
+void drawTitle()
+{
+    Graphics_clearDisplay(&g_sContext);
+    Graphics_drawStringCentered(&g_sContext, (int8_t*) "Welcome to Charades:",
+    AUTO_STRING_LENGTH,
+                                64, 30, OPAQUE_TEXT);
+    Graphics_drawStringCentered(&g_sContext, (int8_t*) "Press BB1 to proceed.",
+    AUTO_STRING_LENGTH,
+                                64, 60, OPAQUE_TEXT);
+    Graphics_drawStringCentered(&g_sContext, (int8_t*) "Press BB2 for instr.",
+    AUTO_STRING_LENGTH,
+                                64, 90, OPAQUE_TEXT);
+}
+
+void drawInstructions()
+{
+    GrContextFontSet(&g_sContext, &g_sFontCmss12i);
+
+    Graphics_clearDisplay(&g_sContext);
+    Graphics_drawStringCentered(&g_sContext, (int8_t*) "Instructions:",
+    AUTO_STRING_LENGTH,
+                                64, 10, OPAQUE_TEXT);
+    Graphics_drawStringCentered(&g_sContext, (int8_t*) "Look up:'",
+    AUTO_STRING_LENGTH,
+                                64, 25, OPAQUE_TEXT);
+    Graphics_drawStringCentered(&g_sContext, (int8_t*) "'Charades Heads Up!'",
+    AUTO_STRING_LENGTH,
+                                64, 40, OPAQUE_TEXT);
+    Graphics_drawStringCentered(&g_sContext,
+                                (int8_t*) "Follow the instructions",
+                                AUTO_STRING_LENGTH,
+                                64, 55, OPAQUE_TEXT);
+    Graphics_drawStringCentered(&g_sContext, (int8_t*) "keeping the LCD",
+    AUTO_STRING_LENGTH,
+                                64, 70, OPAQUE_TEXT);
+    Graphics_drawStringCentered(&g_sContext, (int8_t*) "perpendicular",
+    AUTO_STRING_LENGTH,
+                                64, 85, OPAQUE_TEXT);
+    Graphics_drawStringCentered(&g_sContext, (int8_t*) "to the ground",
+    AUTO_STRING_LENGTH,
+                                64, 100, OPAQUE_TEXT);
+    GrContextFontSet(&g_sContext, &g_sFontFixed6x8);
+
+}
+
+void drawSettings()
+{
+    Graphics_clearDisplay(&g_sContext);
+    Graphics_drawStringCentered(&g_sContext, (int8_t*) "Settings:",
+    AUTO_STRING_LENGTH,
+                                64, 30, OPAQUE_TEXT);
+    Graphics_drawStringCentered(&g_sContext, (int8_t*) "Press bb1 for animals",
+        AUTO_STRING_LENGTH,
+                                    64, 60, OPAQUE_TEXT);
+    Graphics_drawStringCentered(&g_sContext, (int8_t*) "Press bb2 for objects",
+            AUTO_STRING_LENGTH,
+                                        64, 90, OPAQUE_TEXT);
+}
+
+void drawGame()
+{
+    Graphics_clearDisplay(&g_sContext);
+    Graphics_drawStringCentered(&g_sContext, (int8_t*) "Charades:",
+    AUTO_STRING_LENGTH,
+                                64, 30, OPAQUE_TEXT);
+    Graphics_drawString(&g_sContext, (int8_t*) "Time:   s",
+       AUTO_STRING_LENGTH,
+                                   30, 110, OPAQUE_TEXT);
+    /* The label's blanks covered the time field */
+    memset(shownTime, 0, sizeof(shownTime));
+    Graphics_drawString(&g_sContext, (int8_t*) "Score: ",
+       AUTO_STRING_LENGTH,
+                                   40, 90, OPAQUE_TEXT);
+   /* Graphics_drawString(&g_sContext, "Word: ",
+       AUTO_STRING_LENGTH,
+                                   10, 50, OPAQUE_TEXT);*/
+}
+
+void displayWord(int word_index)
+{
+    /* Placement and font come from the layout table; the old word is cleared
+     * in the same window, and words already seen come from the cache */
+    Words_draw(&g_sContext, word_index);
+}
+
+void displayScore(int score)
+{
+    char scoreStr[10];
+    sprintf(scoreStr, " %d", score);
+    /* Clears the 8-character score field in the same window */
+    FontAtlas_drawStringField(&g_sContext, scoreStr, 75, 90, 75, 75 + 8 * 6 - 1);
+}
+
+void end_game(int score)
+{
+    char final_score[30];
+    Graphics_clearDisplay(&g_sContext);
+    sprintf(final_score, "Your final score: %d ", score);
+    Graphics_drawStringCentered(&g_sContext, (int8_t*) final_score,
+    AUTO_STRING_LENGTH,
+                                64, 50, OPAQUE_TEXT);
+    Graphics_drawStringCentered(&g_sContext, (int8_t*) "Press JSB to return.",
+     AUTO_STRING_LENGTH,
+                                 64, 90, OPAQUE_TEXT);
+
+}
+
+void displayTimeRemaining(int remaining_time)
+{
+    char timeStr[TIME_DIGITS + 2];
+    char cell[2] = { 0, 0 };
+    int i, x;
+
+    /* Left-aligned, blank-padded to the field width */
+    snprintf(timeStr, sizeof(timeStr), "%-*d", TIME_DIGITS, remaining_time);
+
+    /* Only the cells whose character changed are drawn: from 59 to 58 that is
+     * one digit, and each is cleared with its glyph, so going from 10 to 9
+     * leaves no stale digit behind */
+    for (i = 0; i < TIME_DIGITS; i++)
+    {
+        if (timeStr[i] == shownTime[i])
+        {
+            continue;
+        }
+        x = TIME_X + i * TIME_CELL;
+        cell[0] = timeStr[i];
+        FontAtlas_drawStringField(&g_sContext, cell, x, TIME_Y, x,
+                                  x + TIME_CELL - 1);
+        shownTime[i] = timeStr[i];
+    }
+}
@@ -0,0 +1,32 @@
+/*
+ * Screens.h
+ *
+ * The game's screens and fields, drawn through g_sContext.  Values shown on
+ * screen are passed in, so the routines can also run off-target.
+ */
+
+#ifndef SCREENS_H_
+#define SCREENS_H_
+
+#include <ti/grlib/grlib.h>
+#include <HAL/Graphics.h>
+
+/* Full screens; each clears the display first */
+void drawTitle(void);
+void drawInstructions(void);
+void drawSettings(void);
+void drawGame(void);
+void end_game(int score);
+
+/* Rows of the game screen with anything on them, from the heading down to
+ * the time line; the rest stays background.  Tile-aligned, so a flush in
+ * partial mode sends whole tiles. */
+#define GAME_BAND_TOP       24
+#define GAME_BAND_BOTTOM    119
+
+/* Fields of the game screen, drawn over what is there */
+void displayWord(int word_index);
+void displayScore(int score);
+void displayTimeRemaining(int remaining_time);
+
+#endif /* SCREENS_H_ */
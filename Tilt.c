@@ -0,0 +1,92 @@
+/*
+ * Tilt.c
+ *
+ * The round's tilt classifier.  See Tilt.h.
+ */
+
+#include "Tilt.h"
+
+uint16_t Tilt_samplesIn(uint32_t ms, uint32_t sampleHz)
+{
+    uint32_t samples = (ms * sampleHz + 999) / 1000;
+
+    return samples ? samples : 1;
+}
+
+void Tilt_init(Tilt *tilt, const TiltConfig *config)
+{
+    tilt->config = *config;
+    if (!tilt->config.dwellSamples)
+    {
+        tilt->config.dwellSamples = 1;
+    }
+    Tilt_reset(tilt);
+}
+
+void Tilt_reset(Tilt *tilt)
+{
+    tilt->state = TILT_LEVEL;
+    tilt->toward = TILT_LEVEL;
+    tilt->dwell = 0;
+}
+
+TiltEvent Tilt_update(Tilt *tilt, int16_t reading)
+{
+    const TiltConfig *config = &tilt->config;
+    TiltState toward = tilt->state;
+    TiltEvent event = TILT_NONE;
+
+    /* Where this reading alone would take the state */
+    switch (tilt->state)
+    {
+    case TILT_LEVEL:
+        if (reading < config->downEnter)
+        {
+            toward = TILT_DOWN;
+        }
+        else if (reading > config->upEnter)
+        {
+            toward = TILT_UP;
+        }
+        break;
+    case TILT_DOWN:
+        if (reading > config->downExit)
+        {
+            toward = TILT_LEVEL;
+        }
+        break;
+    case TILT_UP:
+        if (reading < config->upExit)
+        {
+            toward = TILT_LEVEL;
+        }
+        break;
+    }
+
+    /* It only goes there after dwellSamples of them in a row */
+    if (toward == tilt->state || toward != tilt->toward)
+    {
+        tilt->dwell = 0;
+    }
+    tilt->toward = toward;
+    if (toward == tilt->state || ++tilt->dwell < config->dwellSamples)
+    {
+        return TILT_NONE;
+    }
+
+    switch (toward)
+    {
+    case TILT_DOWN:
+        event = TILT_ENTER_DOWN;
+        break;
+    case TILT_UP:
+        event = TILT_ENTER_UP;
+        break;
+    case TILT_LEVEL:
+        event = (tilt->state == TILT_DOWN) ? TILT_LEAVE_DOWN : TILT_LEAVE_UP;
+        break;
+    }
+    tilt->state = toward;
+    tilt->dwell = 0;
+    return event;
+}
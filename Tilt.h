@@ -0,0 +1,77 @@
+/*
+ * Tilt.h
+ *
+ * The round's tilt classifier.  It is fed a reading a sample at a time -
+ * the board's pitch from Orientation, or a raw axis - and tells the game
+ * when the player tips the board face down (got the word) or face up
+ * (passed), and when they bring it back.  Face down is the low end.
+ *
+ * Each way out of the level band has an enter threshold and an exit
+ * threshold inside it, so a reading hovering at one edge does not flicker
+ * between states (hysteresis), and a state only changes once the reading
+ * has stayed past the threshold for dwellSamples samples in a row, so a
+ * knock that gets through the filter does not count as a tilt.
+ *
+ * There is no hardware behind it, so it runs off-target as well.
+ */
+
+#ifndef TILT_H_
+#define TILT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum
+{
+    TILT_LEVEL,
+    TILT_DOWN,
+    TILT_UP
+} TiltState;
+
+typedef enum
+{
+    TILT_NONE,
+    TILT_ENTER_DOWN,
+    TILT_ENTER_UP,
+    TILT_LEAVE_DOWN,    // back to level from face down: the word was got
+    TILT_LEAVE_UP       // back to level from face up: the word was passed
+} TiltEvent;
+
+typedef struct
+{
+    // Readings a tilt starts beyond and ends back inside.
+    // downEnter < downExit < upExit < upEnter.
+    int16_t downEnter;
+    int16_t downExit;
+    int16_t upExit;
+    int16_t upEnter;
+
+    // Samples in a row past a threshold before the state changes; at least 1
+    uint16_t dwellSamples;
+} TiltConfig;
+
+typedef struct
+{
+    TiltConfig config;
+    TiltState state;
+    uint16_t dwell;     // samples in a row past the current state's threshold
+    TiltState toward;   // the state those samples point to
+} Tilt;
+
+// Samples in ms at sampleHz, rounded up, and at least 1: for dwellSamples
+uint16_t Tilt_samplesIn(uint32_t ms, uint32_t sampleHz);
+
+// Starts level
+void Tilt_init(Tilt* tilt, const TiltConfig* config);
+void Tilt_reset(Tilt* tilt);
+
+// Classifies the next reading; returns the state change it completed, if
+// any
+TiltEvent Tilt_update(Tilt* tilt, int16_t reading);
+
+static inline TiltState Tilt_state(const Tilt* tilt)
+{
+    return tilt->state;
+}
+
+#endif /* TILT_H_ */
@@ -0,0 +1,67 @@
+/*
+ * Words.c
+ *
+ * The charades word list and its layout table.  See Words.h.
+ */
+
+#include "Words.h"
+#include <HAL/FontAtlas.h>
+#include <HAL/WordCache.h>
+
+#define WORD_TEXT(text) text,
+#define WORD_LENGTH(text) sizeof(text) - 1,
+
+const char *const Words_text[WORD_COUNT] = { WORD_LIST(WORD_TEXT) };
+const uint8_t Words_length[WORD_COUNT] = { WORD_LIST(WORD_LENGTH) };
+
+const Graphics_Font *const Words_fonts[WORD_FONTS] = {
+    &g_sFontCmss24b,
+    &g_sFontCmss18b,
+};
+
+uint16_t Words_width[WORD_FONTS][WORD_COUNT];
+uint8_t Words_font[WORD_COUNT];
+int16_t Words_left[WORD_COUNT];
+int16_t Words_top[WORD_COUNT];
+
+void Words_initLayout(void)
+{
+    int i, f;
+
+    for (i = 0; i < WORD_COUNT; i++)
+    {
+        for (f = 0; f < WORD_FONTS; f++)
+        {
+            Words_width[f][i] = FontAtlas_getStringWidth(Words_fonts[f],
+                                                         Words_text[i]);
+        }
+
+        /* The largest font whose centred placement stays inside the field;
+         * the smallest one if none does */
+        for (f = 0; f < WORD_FONTS - 1; f++)
+        {
+            int left = WORD_CENTER_X - Words_width[f][i] / 2;
+            if (left >= WORD_FIELD_MIN &&
+                left + Words_width[f][i] - 1 <= WORD_FIELD_MAX)
+            {
+                break;
+            }
+        }
+
+        Words_font[i] = f;
+        Words_left[i] = WORD_CENTER_X - Words_width[f][i] / 2;
+        Words_top[i] = WORD_CENTER_Y - Words_fonts[f]->baseline / 2;
+
+        FontAtlas_preload(Words_fonts[f], Words_text[i]);
+    }
+}
+
+void Words_draw(Graphics_Context *context, int i)
+{
+    const Graphics_Font *font = context->font;
+
+    GrContextFontSet(context, Words_fonts[Words_font[i]]);
+    WordCache_drawString(context, Words_text[i], Words_left[i], Words_top[i],
+                         WORD_FIELD_MIN, WORD_FIELD_MAX);
+    GrContextFontSet(context, font);
+}
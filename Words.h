@@ -0,0 +1,61 @@
+/*
+ * Words.h
+ *
+ * The charades word list and its layout table.
+ *
+ * The list is written once, as an X-macro, so the count and the byte lengths
+ * are compile-time constants.  Pixel metrics depend on the grlib font data,
+ * which lives in the SDK library rather than in this project, so they are
+ * filled in once at boot by Words_initLayout() and are plain lookups after.
+ */
+
+#ifndef WORDS_H_
+#define WORDS_H_
+
+#include <ti/grlib/grlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define WORD_LIST(X) \
+    X("elephant")  X("airplane")  X("guitar")    X("Swimming")  X("Balloon")  \
+    X("Whisper")   X("Robot")     X("Spider")    X("Dancing")   X("Pirate")   \
+    X("Fireworks") X("Chef")      X("Lion")      X("Sleeping")  X("Rainbow")  \
+    X("Doctor")    X("Superhero") X("Fishing")   X("Laughing")  X("Astronaut")\
+    X("Washer")    X("Dinosaur")  X("Painting")  X("Surfing")   X("Clapping") \
+    X("Ghost")     X("Bowling")   X("Magician")  X("Juggling")  X("Campfire")
+
+#define WORD_ONE(text) + 1
+enum { WORD_COUNT = 0 WORD_LIST(WORD_ONE) };
+#undef WORD_ONE
+
+/* Fonts a word can be drawn in, preferred first */
+#define WORD_FONTS          2
+#define WORD_FONT_LARGE     0
+#define WORD_FONT_SMALL     1
+
+/* Where words go: centred on (WORD_CENTER_X, WORD_CENTER_Y), clearing the
+ * field WORD_FIELD_MIN..WORD_FIELD_MAX */
+#define WORD_CENTER_X       65
+#define WORD_CENTER_Y       65
+#define WORD_FIELD_MIN      0
+#define WORD_FIELD_MAX      127
+
+/* Compile-time part of the table, in flash */
+extern const char *const Words_text[WORD_COUNT];
+extern const uint8_t Words_length[WORD_COUNT];
+extern const Graphics_Font *const Words_fonts[WORD_FONTS];
+
+/* Filled in by Words_initLayout() */
+extern uint16_t Words_width[WORD_FONTS][WORD_COUNT];
+extern uint8_t Words_font[WORD_COUNT];
+extern int16_t Words_left[WORD_COUNT];
+extern int16_t Words_top[WORD_COUNT];
+
+/* Measures every word in every font, picks the largest font in which each
+ * word fits the field, and warms the glyph atlas for it */
+void Words_initLayout(void);
+
+/* Draws word i at its precomputed place, clearing the field */
+void Words_draw(Graphics_Context *context, int i);
+
+#endif /* WORDS_H_ */
@@ -0,0 +1,155 @@
+/*
+ * HostFonts.c
+ *
+ * Synthetic grlib fonts for the host tools.  See HostFonts.h.
+ */
+
+#include "HostFonts.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+Graphics_Font g_sFontFixed6x8;
+Graphics_Font g_sFontCmss12i;
+Graphics_Font g_sFontCmss18b;
+Graphics_Font g_sFontCmss24b;
+
+static uint8_t fixed6x8Data[HOSTFONTS_DATA_SIZE];
+static uint8_t cmss12iData[HOSTFONTS_DATA_SIZE];
+static uint8_t cmss18bData[HOSTFONTS_DATA_SIZE];
+static uint8_t cmss24bData[HOSTFONTS_DATA_SIZE];
+
+static bool HostFonts_pixel(int c, int row, int column, int width)
+{
+    if (row < 3)
+    {
+        return false;
+    }
+    if (row == 6 || (row > 15 && c == 'W'))
+    {
+        return true;
+    }
+    return (((c * 7 + row * 3 + column * 5) ^ (row * column)) % 3) == 0 &&
+           (column < width - 1);
+}
+
+static uint8_t *HostFonts_rlePut(uint8_t *out, int off, int on)
+{
+    int k;
+
+    while (off > 15)
+    {
+        k = off / 8 > 127 ? 127 : off / 8;
+        *out++ = 0;
+        *out++ = k;
+        off -= 8 * k;
+    }
+    if (on > 15)
+    {
+        if (off)
+        {
+            *out++ = off << 4;
+        }
+        off = 0;
+        while (on > 15)
+        {
+            k = on / 8 > 127 ? 127 : on / 8;
+            *out++ = 0;
+            *out++ = 0x80 | k;
+            on -= 8 * k;
+        }
+    }
+    if (off || on)
+    {
+        *out++ = (off << 4) | on;
+    }
+    return out;
+}
+
+void HostFonts_build(Graphics_Font *font, uint8_t *data, uint8_t format,
+                     uint8_t maxWidth, uint8_t height, uint8_t baseline,
+                     bool fixed)
+{
+    uint8_t *out = data;
+    int c, i;
+
+    font->format = format;
+    font->maxWidth = maxWidth;
+    font->height = height;
+    font->baseline = baseline;
+    font->data = data;
+
+    for (c = 32; c <= 126; c++)
+    {
+        // grlib draws the padding bits at the end of an uncompressed glyph
+        // below its cell, which the atlas does not copy; even widths keep
+        // the bit stream byte aligned so both paths agree
+        int width = fixed ? maxWidth : (maxWidth & ~1) - 2 * (4 - c % 5);
+        int pixels, off = 0, on = 0;
+        uint8_t *start = out;
+
+        if (width < 2)
+        {
+            width = 2;
+        }
+        pixels = width * height;
+
+        font->offset[c - 32] = out - data;
+        out += 2;
+
+        if (format == FONT_FMT_UNCOMPRESSED)
+        {
+            memset(out, 0, (pixels + 7) / 8);
+            for (i = 0; i < pixels; i++)
+            {
+                if (HostFonts_pixel(c, i / width, i % width, width))
+                {
+                    out[i / 8] |= 0x80 >> (i % 8);
+                }
+            }
+            out += (pixels + 7) / 8;
+        }
+        else
+        {
+            for (i = 0; i < pixels; i++)
+            {
+                if (HostFonts_pixel(c, i / width, i % width, width))
+                {
+                    on++;
+                }
+                else
+                {
+                    if (on)
+                    {
+                        out = HostFonts_rlePut(out, off, on);
+                        off = on = 0;
+                    }
+                    off++;
+                }
+            }
+            out = HostFonts_rlePut(out, off, on);
+        }
+
+        // The glyph size is a byte in grlib's format
+        if ((out - start > 255) || (out - data > HOSTFONTS_DATA_SIZE - 256))
+        {
+            fprintf(stderr, "HostFonts: glyph '%c' does not fit\n", c);
+            exit(2);
+        }
+        start[0] = out - start;
+        start[1] = width;
+    }
+}
+
+void HostFonts_init(void)
+{
+    HostFonts_build(&g_sFontFixed6x8, fixed6x8Data, FONT_FMT_UNCOMPRESSED,
+                    6, 8, 7, true);
+    HostFonts_build(&g_sFontCmss12i, cmss12iData, FONT_FMT_PIXEL_RLE,
+                    12, 12, 9, false);
+    HostFonts_build(&g_sFontCmss18b, cmss18bData, FONT_FMT_PIXEL_RLE,
+                    18, 18, 14, false);
+    HostFonts_build(&g_sFontCmss24b, cmss24bData, FONT_FMT_PIXEL_RLE,
+                    24, 24, 18, false);
+}
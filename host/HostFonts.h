@@ -0,0 +1,31 @@
+/*
+ * HostFonts.h
+ *
+ * Synthetic grlib fonts for the host tools.  The SDK fonts are prebuilt in
+ * the grlib library, so the host builds stand-ins at startup: every printable
+ * character gets a glyph of its own width whose rows of off and on pixels
+ * are long enough to exercise the run-length escapes, encoded the way grlib
+ * expects.
+ */
+
+#ifndef HOST_HOSTFONTS_H_
+#define HOST_HOSTFONTS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <ti/grlib/grlib.h>
+
+// Bytes of glyph data a built font may need
+#define HOSTFONTS_DATA_SIZE     (96 * 256)
+
+// Fills font and data (HOSTFONTS_DATA_SIZE bytes) with a synthetic font in
+// the given format.  Proportional glyphs are maxWidth wide or up to eight
+// pixels narrower, in steps of two; fixed ones are all maxWidth wide.
+void HostFonts_build(Graphics_Font *font, uint8_t *data, uint8_t format,
+                     uint8_t maxWidth, uint8_t height, uint8_t baseline,
+                     bool fixed);
+
+// Builds g_sFontFixed6x8, g_sFontCmss12i, g_sFontCmss18b and g_sFontCmss24b
+void HostFonts_init(void);
+
+#endif /* HOST_HOSTFONTS_H_ */
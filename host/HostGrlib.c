@@ -0,0 +1,257 @@
+/*
+ * HostGrlib.c
+ *
+ * Host versions of the grlib calls the firmware makes outside the display
+ * driver.  Graphics_drawString() walks glyph data the way grlib 3.x does and
+ * emits the same line and pixel primitives, so its bus traffic can be
+ * compared with the FontAtlas blitter.  Like grlib, every call goes through
+ * the function table given to Graphics_initContext(); a display that was
+ * never bound to one uses the Crystalfontz128x128 driver's.
+ */
+
+#include <ti/grlib/grlib.h>
+#include <HAL/LcdDriver/Crystalfontz128x128_ST7735.h>
+
+static const Graphics_Display_Functions *HostGrlib_fxns(
+        const Graphics_Context *context)
+{
+    return context->display->pFxns ? context->display->pFxns :
+                                     &g_sCrystalfontz128x128_funcs;
+}
+
+void Graphics_initContext(Graphics_Context *context, Graphics_Display *display,
+                          const Graphics_Display_Functions *pFxns)
+{
+    display->pFxns = pFxns;
+    context->size = sizeof(Graphics_Context);
+    context->display = display;
+    context->clipRegion.xMin = 0;
+    context->clipRegion.yMin = 0;
+    context->clipRegion.xMax = display->width - 1;
+    context->clipRegion.yMax = display->heigth - 1;
+    context->foreground = 0;
+    context->background = 0;
+    context->font = 0;
+}
+
+void Graphics_setForegroundColor(Graphics_Context *context, int32_t value)
+{
+    context->foreground = HostGrlib_fxns(context)->pfnColorTranslate(
+            context->display, value);
+}
+
+void Graphics_setBackgroundColor(Graphics_Context *context, int32_t value)
+{
+    context->background = HostGrlib_fxns(context)->pfnColorTranslate(
+            context->display, value);
+}
+
+void Graphics_setFont(Graphics_Context *context, const Graphics_Font *font)
+{
+    context->font = font;
+}
+
+void Graphics_clearDisplay(const Graphics_Context *context)
+{
+    HostGrlib_fxns(context)->pfnClearDisplay(context->display,
+                                             context->background);
+}
+
+void Graphics_flushBuffer(const Graphics_Context *context)
+{
+    HostGrlib_fxns(context)->pfnFlush(context->display);
+}
+
+static void HostGrlib_lineH(const Graphics_Context *context, int32_t x1,
+                            int32_t x2, int32_t y, uint32_t value)
+{
+    if ((y < context->clipRegion.yMin) || (y > context->clipRegion.yMax))
+    {
+        return;
+    }
+    if (x1 < context->clipRegion.xMin)
+    {
+        x1 = context->clipRegion.xMin;
+    }
+    if (x2 > context->clipRegion.xMax)
+    {
+        x2 = context->clipRegion.xMax;
+    }
+    if (x1 > x2)
+    {
+        return;
+    }
+
+    if (x1 == x2)
+    {
+        HostGrlib_fxns(context)->pfnPixelDraw(context->display, x1, y, value);
+    }
+    else
+    {
+        HostGrlib_fxns(context)->pfnLineDrawH(context->display, x1, x2, y,
+                                              value);
+    }
+}
+
+void Graphics_fillRectangle(const Graphics_Context *context,
+                            const Graphics_Rectangle *rect)
+{
+    Graphics_Rectangle clipped = *rect;
+
+    if (clipped.xMin < context->clipRegion.xMin)
+        clipped.xMin = context->clipRegion.xMin;
+    if (clipped.yMin < context->clipRegion.yMin)
+        clipped.yMin = context->clipRegion.yMin;
+    if (clipped.xMax > context->clipRegion.xMax)
+        clipped.xMax = context->clipRegion.xMax;
+    if (clipped.yMax > context->clipRegion.yMax)
+        clipped.yMax = context->clipRegion.yMax;
+
+    if ((clipped.xMin <= clipped.xMax) && (clipped.yMin <= clipped.yMax))
+    {
+        HostGrlib_fxns(context)->pfnRectFill(context->display, &clipped,
+                                             context->foreground);
+    }
+}
+
+void Graphics_drawString(const Graphics_Context *context, int8_t *string,
+                         int32_t length, int32_t x, int32_t y, bool opaque)
+{
+    const Graphics_Font *font = context->font;
+    int32_t idx, x0, y0, count, off, on, bit;
+    const uint8_t *data;
+
+    while (*string && length--)
+    {
+        if (x > context->clipRegion.xMax)
+        {
+            break;
+        }
+
+        if ((*string >= 32) && (*string <= 126))
+        {
+            data = font->data + font->offset[*string - 32];
+        }
+        else
+        {
+            data = font->data + font->offset[0];
+        }
+        string++;
+
+        if ((x + data[1]) < context->clipRegion.xMin)
+        {
+            x += data[1];
+            continue;
+        }
+
+        for (idx = 2, x0 = 0, bit = 0, y0 = 0; idx < data[0];)
+        {
+            if ((y + y0) > context->clipRegion.yMax)
+            {
+                break;
+            }
+
+            if (font->format == FONT_FMT_UNCOMPRESSED)
+            {
+                for (off = 0; idx < data[0]; off++)
+                {
+                    if ((data[idx] >> (7 - bit)) & 1)
+                        break;
+                    if (++bit == 8)
+                    {
+                        bit = 0;
+                        idx++;
+                    }
+                }
+                for (on = 0; idx < data[0]; on++)
+                {
+                    if (!((data[idx] >> (7 - bit)) & 1))
+                        break;
+                    if (++bit == 8)
+                    {
+                        bit = 0;
+                        idx++;
+                    }
+                }
+            }
+            else if (data[idx])
+            {
+                off = (data[idx] >> 4) & 15;
+                on = data[idx] & 15;
+                idx++;
+            }
+            else if (data[idx + 1] & 0x80)
+            {
+                off = 0;
+                on = (data[idx + 1] & 0x7f) * 8;
+                idx += 2;
+            }
+            else
+            {
+                off = data[idx + 1] * 8;
+                on = 0;
+                idx += 2;
+            }
+
+            while (off)
+            {
+                count = data[1] - x0;
+                if (off < count)
+                    count = off;
+                if (opaque)
+                    HostGrlib_lineH(context, x + x0, x + x0 + count - 1,
+                                    y + y0, context->background);
+                off -= count;
+                x0 += count;
+                if (x0 == data[1])
+                {
+                    y0++;
+                    x0 = 0;
+                }
+            }
+
+            while (on)
+            {
+                count = data[1] - x0;
+                if (on < count)
+                    count = on;
+                HostGrlib_lineH(context, x + x0, x + x0 + count - 1, y + y0,
+                                context->foreground);
+                on -= count;
+                x0 += count;
+                if (x0 == data[1])
+                {
+                    y0++;
+                    x0 = 0;
+                }
+            }
+        }
+
+        x += data[1];
+    }
+}
+
+int32_t Graphics_getStringWidth(const Graphics_Context *context,
+                                const int8_t *string, int32_t length)
+{
+    const Graphics_Font *font = context->font;
+    int32_t width = 0;
+
+    while (*string && length--)
+    {
+        int32_t c = ((*string >= 32) && (*string <= 126)) ? *string - 32 : 0;
+        width += font->data[font->offset[c] + 1];
+        string++;
+    }
+
+    return width;
+}
+
+void Graphics_drawStringCentered(const Graphics_Context *context,
+                                 int8_t *string, int32_t length, int32_t x,
+                                 int32_t y, bool opaque)
+{
+    Graphics_drawString(context, string, length,
+                        x - Graphics_getStringWidth(context, string, length) / 2,
+                        y - context->font->baseline / 2, opaque);
+}
@@ -0,0 +1,354 @@
+/*
+ * HostLcd.c
+ *
+ * Host-side stand-in for the EUSCI_B0 / GPIO / uDMA registers behind the
+ * Crystalfontz128x128 LCD.  See HostLcd.h.
+ */
+
+#include "HostLcd.h"
+
+#include <stdlib.h>
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+#include <HAL/LcdDriver/HAL_MSP_EXP432P401R_Crystalfontz128x128_ST7735.h>
+
+// TXBUF holds this value while no byte is queued
+#define TXBUF_EMPTY 0xFFFF
+
+// CPU cycles (at 48 MHz) to shift one byte out at 16 MHz, and charged for
+// each read of the cycle counter, i.e. for one pass of a polling loop
+#define CYCLES_PER_BYTE 24
+#define CYCLES_PER_POLL 16
+
+volatile uint16_t HostLcd_TXBUF = TXBUF_EMPTY;
+
+static bool dcIsData = true;
+static HostLcd_Stats stats;
+static HostLcd_Byte *byteLog;
+static uint32_t logLength, logCapacity;
+static void (*byteSink)(uint8_t value, bool isData);
+static void (*resetHook)(void);
+
+// uDMA channel state (only the LCD channel is modelled)
+static const uint8_t *dmaSource;
+static uint32_t dmaSize;
+static bool dmaArmed;
+static bool dmaInterruptAssigned;
+static bool dmaInterruptPending;
+
+// PRIMASK, as set by Interrupt_disableMaster()
+static bool interruptsMasked;
+
+static DWT_Type dwt;
+CoreDebug_Type HostLcd_CoreDebug;
+
+// Provided by the LCD HAL when it is built with LCD_USE_DMA
+extern void DMA_INT1_IRQHandler(void) __attribute__((weak));
+
+static void HostLcd_record(uint8_t value, bool viaDma)
+{
+    if (logLength == logCapacity)
+    {
+        logCapacity = logCapacity ? logCapacity * 2 : 4096;
+        byteLog = realloc(byteLog, logCapacity * sizeof(HostLcd_Byte));
+        if (!byteLog)
+        {
+            abort();
+        }
+    }
+
+    byteLog[logLength].value = value;
+    byteLog[logLength].isData = dcIsData;
+    byteLog[logLength].viaDma = viaDma;
+    logLength++;
+    dwt.CYCCNT += CYCLES_PER_BYTE;
+
+    if (dcIsData)
+    {
+        stats.dataBytes++;
+    }
+    else
+    {
+        stats.commandBytes++;
+    }
+    if (viaDma)
+    {
+        stats.dmaBytes++;
+    }
+
+    if (byteSink)
+    {
+        byteSink(value, dcIsData);
+    }
+}
+
+static void HostLcd_runDma(void);
+
+// Shifts out the byte queued in TXBUF, if any.  UCTXIFG rises as the byte
+// moves into the shift register, which is the request an armed channel
+// waits for; its completion interrupt may queue the next chunk's first byte.
+static void HostLcd_shift(void)
+{
+    while (HostLcd_TXBUF != TXBUF_EMPTY)
+    {
+        HostLcd_record((uint8_t) HostLcd_TXBUF, false);
+        HostLcd_TXBUF = TXBUF_EMPTY;
+        if (dmaArmed)
+        {
+            HostLcd_runDma();
+        }
+    }
+}
+
+void HostLcd_reset(void)
+{
+    HostLcd_shift();
+    stats = (HostLcd_Stats) {0};
+    logLength = 0;
+}
+
+HostLcd_Stats HostLcd_getStats(void)
+{
+    HostLcd_shift();
+    return stats;
+}
+
+const HostLcd_Byte *HostLcd_getLog(uint32_t *length)
+{
+    HostLcd_shift();
+    *length = logLength;
+    return byteLog;
+}
+
+void HostLcd_setSink(void (*sink)(uint8_t value, bool isData))
+{
+    byteSink = sink;
+}
+
+void HostLcd_setResetHook(void (*hook)(void))
+{
+    resetHook = hook;
+}
+
+uint16_t HostLcd_readSTATW(void)
+{
+    HostLcd_shift();
+    return 0;
+}
+
+uint16_t HostLcd_readIFG(void)
+{
+    HostLcd_shift();
+    return UCTXIFG;
+}
+
+void SysCtlDelay(uint32_t count)
+{
+    stats.delayCycles += count;
+    dwt.CYCCNT += count;
+}
+
+DWT_Type *HostLcd_readDWT(void)
+{
+    if (dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk)
+    {
+        dwt.CYCCNT += CYCLES_PER_POLL;
+    }
+    return &dwt;
+}
+
+//*****************************************************************************
+//
+// GPIO: only the DC and reset lines are modelled
+//
+//*****************************************************************************
+static void HostLcd_setPins(uint_fast8_t port, uint_fast16_t pins, bool high)
+{
+    if ((port == LCD_RST_PORT) && (pins & LCD_RST_PIN) && !high)
+    {
+        HostLcd_shift();
+        if (resetHook)
+        {
+            resetHook();
+        }
+    }
+
+    if ((port == LCD_DC_PORT) && (pins & LCD_DC_PIN))
+    {
+        // The DC line is sampled with the last bit of each byte
+        HostLcd_shift();
+        if (dcIsData != high)
+        {
+            stats.dcToggles++;
+        }
+        dcIsData = high;
+    }
+}
+
+void GPIO_setOutputHighOnPin(uint_fast8_t port, uint_fast16_t pins)
+{
+    HostLcd_setPins(port, pins, true);
+}
+
+void GPIO_setOutputLowOnPin(uint_fast8_t port, uint_fast16_t pins)
+{
+    HostLcd_setPins(port, pins, false);
+}
+
+void GPIO_setAsOutputPin(uint_fast8_t port, uint_fast16_t pins)
+{
+}
+
+void GPIO_setAsPeripheralModuleFunctionOutputPin(uint_fast8_t port,
+                                                 uint_fast16_t pins,
+                                                 uint_fast8_t mode)
+{
+}
+
+//*****************************************************************************
+//
+// EUSCI_B0
+//
+//*****************************************************************************
+bool SPI_initMaster(uint32_t moduleInstance,
+                    const eUSCI_SPI_MasterConfig *config)
+{
+    return true;
+}
+
+void SPI_enableModule(uint32_t moduleInstance)
+{
+}
+
+uintptr_t SPI_getTransmitBufferAddressForDMA(uint32_t moduleInstance)
+{
+    return moduleInstance + 0x0E;
+}
+
+//*****************************************************************************
+//
+// uDMA: an enabled channel waits for the rising edge of UCTXIFG that comes
+// when the CPU's first byte moves into the shift register, then completes at
+// once, and the completion interrupt runs right away unless interrupts are
+// masked.  A channel enabled after that byte was written has missed its
+// edge; on the board it would never run.
+//
+//*****************************************************************************
+void DMA_enableModule(void)
+{
+}
+
+void DMA_setControlBase(void *controlTable)
+{
+}
+
+void DMA_assignChannel(uint32_t mapping)
+{
+}
+
+void DMA_disableChannelAttribute(uint32_t channelNum, uint32_t attr)
+{
+}
+
+void DMA_setChannelControl(uint32_t channelStructIndex, uint32_t control)
+{
+}
+
+void DMA_setChannelTransfer(uint32_t channelStructIndex, uint32_t mode,
+                            void *srcAddr, void *dstAddr,
+                            uint32_t transferSize)
+{
+    dmaSource = srcAddr;
+    dmaSize = transferSize;
+}
+
+static void HostLcd_runDma(void)
+{
+    uint32_t i;
+
+    dmaArmed = false;
+    for (i = 0; i < dmaSize; i++)
+    {
+        HostLcd_record(dmaSource[i], true);
+    }
+    stats.dmaTransfers++;
+    dmaSize = 0;
+
+    if (dmaInterruptAssigned && DMA_INT1_IRQHandler)
+    {
+        if (interruptsMasked)
+        {
+            // Stays pending until unmasked or cleared by the driver
+            dmaInterruptPending = true;
+        }
+        else
+        {
+            stats.dmaInterrupts++;
+            DMA_INT1_IRQHandler();
+        }
+    }
+}
+
+void DMA_enableChannel(uint32_t channelNum)
+{
+    if (HostLcd_TXBUF != TXBUF_EMPTY)
+    {
+        stats.dmaMissedRequests++;
+    }
+    dmaArmed = true;
+}
+
+bool DMA_isChannelEnabled(uint32_t channelNum)
+{
+    HostLcd_shift();
+    return dmaArmed;
+}
+
+void DMA_assignInterrupt(uint32_t interruptNumber, uint32_t channel)
+{
+    dmaInterruptAssigned = (interruptNumber == DMA_INT1);
+}
+
+void DMA_clearInterruptFlag(uint32_t intChannel)
+{
+}
+
+void Interrupt_enableInterrupt(uint32_t interruptNumber)
+{
+}
+
+void Interrupt_unpendInterrupt(uint32_t interruptNumber)
+{
+    if ((interruptNumber == INT_DMA_INT1) && dmaInterruptPending)
+    {
+        dmaInterruptPending = false;
+        stats.dmaPolled++;
+    }
+}
+
+bool Interrupt_disableMaster(void)
+{
+    bool wasMasked = interruptsMasked;
+    interruptsMasked = true;
+    return wasMasked;
+}
+
+bool Interrupt_enableMaster(void)
+{
+    bool wasMasked = interruptsMasked;
+    interruptsMasked = false;
+    if (dmaInterruptPending)
+    {
+        dmaInterruptPending = false;
+        stats.dmaInterrupts++;
+        DMA_INT1_IRQHandler();
+    }
+    return wasMasked;
+}
+
+// The driver spins on this while it waits for the uDMA, so time passes: the
+// byte queued in TXBUF goes out, and with it the request of an armed channel
+uint32_t __get_PRIMASK(void)
+{
+    HostLcd_shift();
+    return interruptsMasked;
+}
@@ -0,0 +1,56 @@
+/*
+ * HostLcd.h
+ *
+ * Host-side stand-in for the EUSCI_B0 / GPIO / uDMA registers behind the
+ * Crystalfontz128x128 LCD.  Every byte the driver puts on the SPI bus is
+ * recorded in order, tagged with the DC line (command or data) and with the
+ * path it took (CPU write or uDMA).  A sink, such as St7735Emu, can follow
+ * the bytes as they go out.
+ */
+
+#ifndef HOST_HOSTLCD_H_
+#define HOST_HOSTLCD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// One byte seen on the bus
+typedef struct
+{
+    uint8_t value;
+    bool isData;    // state of the DC line while the byte was shifted out
+    bool viaDma;    // moved by the uDMA rather than written by the CPU
+} HostLcd_Byte;
+
+// Running totals since the last HostLcd_reset()
+typedef struct
+{
+    uint32_t commandBytes;
+    uint32_t dataBytes;
+    uint32_t dmaBytes;
+    uint32_t dmaTransfers;
+    uint32_t dmaInterrupts;
+    uint32_t dmaPolled;     // completions handled with interrupts masked
+    // Channels enabled after their first byte was written, which missed
+    // the eUSCI's request and would never run on the board
+    uint32_t dmaMissedRequests;
+    uint32_t dcToggles;
+    uint64_t delayCycles;
+} HostLcd_Stats;
+
+// Clears the statistics and the byte log
+void HostLcd_reset(void);
+
+// Returns the statistics gathered since the last reset
+HostLcd_Stats HostLcd_getStats(void);
+
+// Returns the byte log; length receives the number of entries
+const HostLcd_Byte *HostLcd_getLog(uint32_t *length);
+
+// Installs a callback invoked for every byte as it is shifted out
+void HostLcd_setSink(void (*sink)(uint8_t value, bool isData));
+
+// Installs a callback invoked when the driver pulls the LCD reset line low
+void HostLcd_setResetHook(void (*hook)(void));
+
+#endif /* HOST_HOSTLCD_H_ */
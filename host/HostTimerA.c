@@ -0,0 +1,171 @@
+/*
+ * HostTimerA.c
+ *
+ * Host-side stand-in for TIMER_A1 and the NVIC behind the TimerWheel.  See
+ * HostTimerA.h.
+ */
+
+#include "HostTimerA.h"
+
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+
+extern void TA1_0_IRQHandler(void);
+
+static uint64_t aclk;
+static uint64_t counterStart;   // ACLK cycle the counter was last cleared on
+static uint16_t compare;
+static bool compareEnabled;
+static bool counting;
+
+// PRIMASK, the compare interrupt's pending bit, and whether its handler is
+// running (it does not preempt itself)
+static bool interruptsMasked;
+static bool pending;
+static bool inHandler;
+
+static uint16_t HostTimerA_counter(void)
+{
+    return (uint16_t) (aclk - counterStart);
+}
+
+// Takes the compare interrupt, and any that it pends, if nothing holds it off
+static void HostTimerA_deliver(void)
+{
+    while (pending && !interruptsMasked && !inHandler)
+    {
+        pending = false;
+        inHandler = true;
+        TA1_0_IRQHandler();
+        inHandler = false;
+    }
+}
+
+void HostTimerA_reset(void)
+{
+    aclk = 0;
+    counterStart = 0;
+    compare = 0;
+    compareEnabled = false;
+    counting = false;
+    interruptsMasked = false;
+    pending = false;
+    inHandler = false;
+}
+
+uint64_t HostTimerA_now(void)
+{
+    return aclk;
+}
+
+uint64_t HostTimerA_nextCompare(void)
+{
+    if (pending)
+    {
+        return aclk;
+    }
+    // The flag is set when the counter counts up to CCR0, not while it sits
+    // there, so a match now is a whole wrap away
+    return aclk + (uint16_t) (compare - HostTimerA_counter() - 1) + 1;
+}
+
+void HostTimerA_advanceTo(uint64_t target)
+{
+    while (aclk < target)
+    {
+        uint64_t match = HostTimerA_nextCompare();
+
+        if (!counting || !compareEnabled || pending || (match > target))
+        {
+            aclk = target;
+            break;
+        }
+        aclk = match;
+        pending = true;
+        HostTimerA_deliver();
+    }
+    HostTimerA_deliver();
+}
+
+//*****************************************************************************
+//
+// driverlib
+//
+//*****************************************************************************
+void Timer_A_configureContinuousMode(uint32_t timer,
+        const Timer_A_ContinuousModeConfig *config)
+{
+    if (config->timerClear == TIMER_A_DO_CLEAR)
+    {
+        counterStart = aclk;
+    }
+}
+
+void Timer_A_initCompare(uint32_t timer,
+                         const Timer_A_CompareModeConfig *config)
+{
+    compare = config->compareValue;
+    compareEnabled = (config->compareInterruptEnable
+            == TIMER_A_CAPTURECOMPARE_INTERRUPT_ENABLE);
+}
+
+void Timer_A_setCompareValue(uint32_t timer, uint_fast16_t compareRegister,
+                             uint_fast16_t compareValue)
+{
+    compare = compareValue;
+}
+
+uint16_t Timer_A_getCounterValue(uint32_t timer)
+{
+    return HostTimerA_counter();
+}
+
+void Timer_A_startCounter(uint32_t timer, uint_fast16_t timerMode)
+{
+    counting = (timerMode == TIMER_A_CONTINUOUS_MODE);
+}
+
+void Timer_A_clearCaptureCompareInterrupt(uint32_t timer,
+                                          uint_fast16_t captureCompareRegister)
+{
+}
+
+void Interrupt_enableInterrupt(uint32_t interruptNumber)
+{
+}
+
+void Interrupt_pendInterrupt(uint32_t interruptNumber)
+{
+    if (interruptNumber == INT_TA1_0)
+    {
+        pending = true;
+        HostTimerA_deliver();
+    }
+}
+
+void Interrupt_unpendInterrupt(uint32_t interruptNumber)
+{
+    if (interruptNumber == INT_TA1_0)
+    {
+        pending = false;
+    }
+}
+
+bool Interrupt_disableMaster(void)
+{
+    bool wasMasked = interruptsMasked;
+    interruptsMasked = true;
+    return wasMasked;
+}
+
+bool Interrupt_enableMaster(void)
+{
+    bool wasMasked = interruptsMasked;
+    interruptsMasked = false;
+    HostTimerA_deliver();
+    return wasMasked;
+}
+
+uint32_t __get_PRIMASK(void)
+{
+    return interruptsMasked;
+}
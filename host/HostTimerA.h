@@ -0,0 +1,32 @@
+/*
+ * HostTimerA.h
+ *
+ * Host-side stand-in for TIMER_A1 and the NVIC behind the TimerWheel.  ACLK
+ * is simulated time: it only moves when HostTimerA_advanceTo() moves it, and
+ * the compare interrupt is taken at the ACLK cycle the 16-bit counter reaches
+ * CCR0, or as soon as interrupts are unmasked if it came while they were
+ * masked.  It provides the Interrupt_* functions too, so it is not linked
+ * with HostLcd.c.
+ */
+
+#ifndef HOST_HOSTTIMERA_H_
+#define HOST_HOSTTIMERA_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Rewinds ACLK to 0, unmasks interrupts and drops any pending interrupt
+void HostTimerA_reset(void);
+
+// ACLK cycles since the last reset
+uint64_t HostTimerA_now(void);
+
+// Runs ACLK on to the given cycle, taking each compare interrupt that falls
+// on the way
+void HostTimerA_advanceTo(uint64_t aclk);
+
+// The ACLK cycle of the next compare match, or now if the interrupt is
+// pending already
+uint64_t HostTimerA_nextCompare(void);
+
+#endif /* HOST_HOSTTIMERA_H_ */
@@ -0,0 +1,476 @@
+/*
+ * St7735Emu.c
+ *
+ * Model of the ST7735 controller on the Crystalfontz128x128 panel.  See
+ * St7735Emu.h.
+ */
+
+#include "St7735Emu.h"
+#include "HostLcd.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <HAL/LcdDriver/Crystalfontz128x128_ST7735.h>
+
+#define GRAM_LAST (ST7735EMU_GRAM_SIZE - 1)
+
+// Bus pixel formats (COLMOD IFPF)
+#define COLMOD_RGB444   0x03
+#define COLMOD_RGB565   0x05
+#define COLMOD_RGB666   0x06
+
+static uint32_t gram[ST7735EMU_GRAM_SIZE][ST7735EMU_GRAM_SIZE];
+static St7735Emu_Stats stats;
+
+// Controller registers
+static bool sleeping, displayOn, partial, inverted;
+static uint8_t madctl, colmod;
+static uint16_t colStart, colEnd, rowStart, rowEnd;
+static uint16_t partialStart, partialEnd;
+
+// Command being executed, and how many of its data bytes have arrived
+static uint8_t command;
+static uint32_t dataCount;
+static uint8_t param[4];
+
+// RAMWR address counter, pixels written so far and bytes of the pixel
+// being assembled
+static uint16_t col, row;
+static uint32_t written;
+static uint8_t pixelBytes[3];
+
+static bool lastWasData = true;
+
+//*****************************************************************************
+//
+// Power-on / hardware reset state
+//
+//*****************************************************************************
+static void St7735Emu_reset(void)
+{
+    sleeping = true;
+    displayOn = false;
+    partial = false;
+    inverted = false;
+    madctl = 0;
+    colmod = COLMOD_RGB666;
+    colStart = 0;
+    colEnd = GRAM_LAST;
+    rowStart = 0;
+    rowEnd = GRAM_LAST;
+    partialStart = 0;
+    partialEnd = GRAM_LAST;
+    command = CM_NOP;
+    dataCount = 0;
+}
+
+//*****************************************************************************
+//
+// Packs widened channels into 0xRRGGBB.  The panel is wired BGR, so with the
+// MADCTL BGR bit set the first field on the bus is shown as red.
+//
+//*****************************************************************************
+static uint32_t St7735Emu_rgb(uint32_t first, uint32_t second, uint32_t third)
+{
+    if (!(madctl & CM_MADCTL_BGR))
+    {
+        uint32_t swap = first;
+        first = third;
+        third = swap;
+    }
+
+    return (first << 16) | (second << 8) | third;
+}
+
+// Widens a 4-4-4 pixel by nibble replication
+static uint32_t St7735Emu_rgb444(uint16_t value)
+{
+    return St7735Emu_rgb(((value >> 8) & 0x0F) * 0x11, ((value >> 4) & 0x0F) * 0x11,
+                         (value & 0x0F) * 0x11);
+}
+
+// Stores one pixel at the address counter and advances it
+static void St7735Emu_store(uint32_t rgb)
+{
+    uint16_t c = col, r = row, t;
+
+    if (written++ >= (uint32_t) (colEnd - colStart + 1) * (rowEnd - rowStart + 1))
+    {
+        stats.windowOverruns++;
+    }
+
+    // Row/column exchange first, then the mirrors act on GRAM axes
+    if (madctl & CM_MADCTL_MV)
+    {
+        t = c;
+        c = r;
+        r = t;
+    }
+    if (madctl & CM_MADCTL_MX)
+    {
+        c = GRAM_LAST - c;
+    }
+    if (madctl & CM_MADCTL_MY)
+    {
+        r = GRAM_LAST - r;
+    }
+    if ((c <= GRAM_LAST) && (r <= GRAM_LAST))
+    {
+        gram[r][c] = rgb;
+    }
+    stats.pixels++;
+
+    if (++col > colEnd)
+    {
+        col = colStart;
+        if (++row > rowEnd)
+        {
+            row = rowStart;
+        }
+    }
+}
+
+// Takes one RAMWR data byte
+static void St7735Emu_pixelByte(uint8_t value)
+{
+    uint32_t r, g, b;
+
+    if (colmod == COLMOD_RGB444)
+    {
+        // Three bytes per two pixels: RG BR GB
+        switch (dataCount % 3)
+        {
+            case 0:
+                pixelBytes[0] = value;
+                break;
+            case 1:
+                St7735Emu_store(St7735Emu_rgb444((pixelBytes[0] << 4) | (value >> 4)));
+                pixelBytes[0] = value & 0x0F;
+                break;
+            default:
+                St7735Emu_store(St7735Emu_rgb444((pixelBytes[0] << 8) | value));
+                break;
+        }
+        return;
+    }
+
+    if (colmod == COLMOD_RGB666)
+    {
+        // Three bytes per pixel, six bits in the top of each
+        pixelBytes[dataCount % 3] = value;
+        if (dataCount % 3 == 2)
+        {
+            r = (pixelBytes[0] & 0xFC) | (pixelBytes[0] >> 6);
+            g = (pixelBytes[1] & 0xFC) | (pixelBytes[1] >> 6);
+            b = (pixelBytes[2] & 0xFC) | (pixelBytes[2] >> 6);
+            St7735Emu_store(St7735Emu_rgb(r, g, b));
+        }
+        return;
+    }
+
+    pixelBytes[dataCount & 1] = value;
+    if (dataCount & 1)
+    {
+        r = pixelBytes[0] >> 3;
+        g = ((pixelBytes[0] & 0x07) << 3) | (pixelBytes[1] >> 5);
+        b = pixelBytes[1] & 0x1F;
+        St7735Emu_store(St7735Emu_rgb((r << 3) | (r >> 2), (g << 2) | (g >> 4),
+                                      (b << 3) | (b >> 2)));
+    }
+}
+
+// Checks how the previous command's data ended
+static void St7735Emu_finishCommand(void)
+{
+    if ((command == CM_RAMWR) && dataCount)
+    {
+        // An odd RGB444 span may end after the first two bytes of a pair
+        uint32_t phase = dataCount % ((colmod == COLMOD_RGB565) ? 2 : 3);
+        if ((phase != 0) && !((colmod == COLMOD_RGB444) && (phase == 2)))
+        {
+            stats.partialPixels++;
+        }
+    }
+}
+
+// Applies a CASET or RASET once its four parameters are in
+static void St7735Emu_setWindow(uint16_t *start, uint16_t *end)
+{
+    uint16_t first = (param[0] << 8) | param[1];
+    uint16_t last = (param[2] << 8) | param[3];
+
+    if ((first > last) || (last > GRAM_LAST))
+    {
+        stats.badWindows++;
+    }
+    *start = first;
+    *end = last;
+}
+
+static void St7735Emu_command(uint8_t value)
+{
+    St7735Emu_finishCommand();
+
+    command = value;
+    dataCount = 0;
+    stats.commands++;
+
+    switch (value)
+    {
+        case CM_NOP:
+            break;
+        case CM_SWRESET:
+            St7735Emu_reset();
+            command = CM_SWRESET;
+            break;
+        case CM_SLPIN:
+            sleeping = true;
+            break;
+        case CM_SLPOUT:
+            sleeping = false;
+            break;
+        case CM_PTLON:
+            partial = true;
+            break;
+        case CM_NORON:
+            partial = false;
+            break;
+        case CM_INVOFF:
+            inverted = false;
+            break;
+        case CM_INVON:
+            inverted = true;
+            break;
+        case CM_DISPOFF:
+            displayOn = false;
+            break;
+        case CM_DISPON:
+            displayOn = true;
+            break;
+        case CM_CASET:
+            stats.caset++;
+            break;
+        case CM_RASET:
+            stats.raset++;
+            break;
+        case CM_RAMWR:
+            stats.ramwr++;
+            col = colStart;
+            row = rowStart;
+            written = 0;
+            break;
+        case CM_PTLAR:
+        case CM_MADCTL:
+        case CM_COLMOD:
+        case CM_GAMSET:
+        case CM_SETPWCTR:
+        case CM_SETSTBA:
+            break;
+        default:
+            stats.unknownCommands++;
+            break;
+    }
+}
+
+static void St7735Emu_data(uint8_t value)
+{
+    stats.dataBytes++;
+
+    switch (command)
+    {
+        case CM_CASET:
+        case CM_RASET:
+        case CM_PTLAR:
+            if (dataCount < 4)
+            {
+                param[dataCount] = value;
+            }
+            if (dataCount == 3)
+            {
+                if (command == CM_CASET)
+                {
+                    St7735Emu_setWindow(&colStart, &colEnd);
+                }
+                else if (command == CM_RASET)
+                {
+                    St7735Emu_setWindow(&rowStart, &rowEnd);
+                }
+                else
+                {
+                    partialStart = (param[0] << 8) | param[1];
+                    partialEnd = (param[2] << 8) | param[3];
+                }
+            }
+            break;
+        case CM_MADCTL:
+            madctl = value;
+            break;
+        case CM_COLMOD:
+            colmod = value & 0x07;
+            break;
+        case CM_RAMWR:
+            St7735Emu_pixelByte(value);
+            break;
+        default:
+            break;
+    }
+
+    dataCount++;
+}
+
+static void St7735Emu_byte(uint8_t value, bool isData)
+{
+    if (isData != lastWasData)
+    {
+        stats.dcToggles++;
+        lastWasData = isData;
+    }
+
+    if (isData)
+    {
+        St7735Emu_data(value);
+    }
+    else
+    {
+        St7735Emu_command(value);
+    }
+}
+
+static void St7735Emu_hardReset(void)
+{
+    St7735Emu_finishCommand();
+    St7735Emu_reset();
+}
+
+void St7735Emu_attach(void)
+{
+    St7735Emu_reset();
+    memset(gram, 0, sizeof(gram));
+    memset(&stats, 0, sizeof(stats));
+    lastWasData = true;
+    HostLcd_setSink(St7735Emu_byte);
+    HostLcd_setResetHook(St7735Emu_hardReset);
+}
+
+void St7735Emu_detach(void)
+{
+    HostLcd_setSink(NULL);
+    HostLcd_setResetHook(NULL);
+}
+
+St7735Emu_Stats St7735Emu_endFrame(void)
+{
+    St7735Emu_Stats frame;
+
+    HostLcd_getStats();     // shifts out any byte still in TXBUF
+    frame = stats;
+    memset(&stats, 0, sizeof(stats));
+    return frame;
+}
+
+St7735Emu_Stats St7735Emu_getStats(void)
+{
+    HostLcd_getStats();
+    return stats;
+}
+
+// True if GRAM row r is scanned: always in normal mode, and in partial mode
+// when it lies in the partial area, which wraps past the last row if it
+// ends before it starts
+static bool St7735Emu_isScanned(uint16_t r)
+{
+    if (!partial)
+    {
+        return true;
+    }
+    if (partialStart <= partialEnd)
+    {
+        return (r >= partialStart) && (r <= partialEnd);
+    }
+    return (r >= partialStart) || (r <= partialEnd);
+}
+
+uint32_t St7735Emu_getPixel(int x, int y)
+{
+    // Seen with the BoosterPack upright, GRAM's first row and column are at
+    // the bottom right
+    uint16_t r = ST7735EMU_VISIBLE_ROW + ST7735EMU_HEIGHT - 1 - y;
+    uint32_t rgb;
+
+    HostLcd_getStats();
+    if (!St7735Emu_isScanned(r))
+    {
+        return ST7735EMU_BLANK;
+    }
+    rgb = gram[r][ST7735EMU_VISIBLE_COL + ST7735EMU_WIDTH - 1 - x];
+    return inverted ? (rgb ^ 0xFFFFFF) : rgb;
+}
+
+void St7735Emu_getScreen(uint32_t screen[ST7735EMU_HEIGHT][ST7735EMU_WIDTH])
+{
+    int x, y;
+
+    for (y = 0; y < ST7735EMU_HEIGHT; y++)
+    {
+        for (x = 0; x < ST7735EMU_WIDTH; x++)
+        {
+            screen[y][x] = St7735Emu_getPixel(x, y);
+        }
+    }
+}
+
+bool St7735Emu_writePpm(const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    int x, y;
+
+    if (!file)
+    {
+        return false;
+    }
+
+    fprintf(file, "P6\n%d %d\n255\n", ST7735EMU_WIDTH, ST7735EMU_HEIGHT);
+    for (y = 0; y < ST7735EMU_HEIGHT; y++)
+    {
+        for (x = 0; x < ST7735EMU_WIDTH; x++)
+        {
+            uint32_t rgb = St7735Emu_getPixel(x, y);
+            fputc(rgb >> 16, file);
+            fputc((rgb >> 8) & 0xFF, file);
+            fputc(rgb & 0xFF, file);
+        }
+    }
+
+    return fclose(file) == 0;
+}
+
+bool St7735Emu_isSleeping(void)
+{
+    return sleeping;
+}
+
+bool St7735Emu_isDisplayOn(void)
+{
+    return displayOn;
+}
+
+bool St7735Emu_isPartial(void)
+{
+    return partial;
+}
+
+void St7735Emu_getPartialArea(uint16_t *start, uint16_t *end)
+{
+    *start = partialStart;
+    *end = partialEnd;
+}
+
+uint8_t St7735Emu_getColorMode(void)
+{
+    return colmod;
+}
+
+uint8_t St7735Emu_getMadctl(void)
+{
+    return madctl;
+}
@@ -0,0 +1,82 @@
+/*
+ * St7735Emu.h
+ *
+ * Model of the ST7735 controller on the Crystalfontz128x128 panel, fed with
+ * the bytes HostLcd sees on the SPI bus.  It interprets the commands the
+ * driver uses (reset, sleep, display and partial modes, CASET/RASET/RAMWR,
+ * MADCTL and COLMOD) into the controller's 132x132 GRAM, from which the
+ * 128x128 visible area can be read back or written out as a PPM image.
+ *
+ * Bus traffic is counted per frame: St7735Emu_endFrame() returns the counts
+ * since the previous call.  Protocol errors the panel would silently absorb
+ * are counted too, most usefully pixels written past the end of a RAMWR
+ * window, which the controller wraps back onto the window's first pixel.
+ */
+
+#ifndef HOST_ST7735EMU_H_
+#define HOST_ST7735EMU_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Visible area, and where it sits in GRAM
+#define ST7735EMU_WIDTH         128
+#define ST7735EMU_HEIGHT        128
+#define ST7735EMU_GRAM_SIZE     132
+#define ST7735EMU_VISIBLE_COL   2
+#define ST7735EMU_VISIBLE_ROW   1
+
+// What a row outside the partial area shows: the panel is normally white
+#define ST7735EMU_BLANK         0xFFFFFF
+
+typedef struct
+{
+    uint32_t commands;          // command bytes
+    uint32_t dataBytes;         // data bytes, parameters included
+    uint32_t dcToggles;         // changes of the DC line between bytes
+    uint32_t pixels;            // pixels written to GRAM
+    uint32_t caset;
+    uint32_t raset;
+    uint32_t ramwr;
+
+    // Protocol errors
+    uint32_t windowOverruns;    // pixels past the end of a RAMWR window
+    uint32_t partialPixels;     // RAMWR spans that ended mid-pixel
+    uint32_t badWindows;        // CASET/RASET start past end, or past GRAM
+    uint32_t unknownCommands;   // commands the model does not implement
+} St7735Emu_Stats;
+
+// Puts the model in its power-on state and hooks it to HostLcd's bus
+void St7735Emu_attach(void);
+
+// Unhooks the model; the GRAM is kept
+void St7735Emu_detach(void);
+
+// Returns the bus counts since the previous call and starts a new frame
+St7735Emu_Stats St7735Emu_endFrame(void);
+
+// Returns the counts of the current frame without ending it
+St7735Emu_Stats St7735Emu_getStats(void);
+
+// Returns the colour shown at (x, y) of the visible area, as seen with the
+// BoosterPack upright (so LCD_ORIENTATION_UP screen coordinates), as
+// 0xRRGGBB.  Channels are widened from the bus format by bit
+// replication.  In partial mode, rows outside the partial area show
+// ST7735EMU_BLANK whatever their GRAM holds.
+uint32_t St7735Emu_getPixel(int x, int y);
+
+// Copies the visible area into screen[y][x], as St7735Emu_getPixel() would
+void St7735Emu_getScreen(uint32_t screen[ST7735EMU_HEIGHT][ST7735EMU_WIDTH]);
+
+// Writes the visible area to path as a binary PPM.  Returns false on error.
+bool St7735Emu_writePpm(const char *path);
+
+// Controller state, for checks
+bool St7735Emu_isSleeping(void);
+bool St7735Emu_isDisplayOn(void);
+bool St7735Emu_isPartial(void);
+void St7735Emu_getPartialArea(uint16_t *start, uint16_t *end);    // GRAM rows
+uint8_t St7735Emu_getColorMode(void);
+uint8_t St7735Emu_getMadctl(void);
+
+#endif /* HOST_ST7735EMU_H_ */
@@ -0,0 +1,230 @@
+/*
+ * TraceDecoder.c
+ *
+ * Decoder for the trace recorder's stream.  See TraceDecoder.h.
+ */
+
+#include "TraceDecoder.h"
+
+#include <string.h>
+
+static const char *const eventNames[] = {
+    [TRACE_ROUND_START] = "round_start",
+    [TRACE_WORD_SHOWN] = "word_shown",
+    [TRACE_SCORED] = "scored",
+    [TRACE_SKIPPED] = "skipped",
+    [TRACE_ROUND_END] = "round_end",
+    [TRACE_LOST] = "lost",
+    [TRACE_GAP] = "gap",
+    [TRACE_SYNC] = "sync",
+};
+
+void TraceDecoder_init(TraceDecoder *decoder)
+{
+    memset(decoder, 0, sizeof(*decoder));
+}
+
+const char *TraceDecoder_eventName(uint8_t event)
+{
+    return event < sizeof(eventNames) / sizeof(eventNames[0])
+            ? eventNames[event] : NULL;
+}
+
+// Bytes in the record starting with byte, or 0 if no record starts so
+static int recordLength(uint8_t byte)
+{
+    if ((byte & TRACE_MASK_SMALL) == TRACE_TAG_SMALL)
+    {
+        return TRACE_SMALL_BYTES;
+    }
+    if ((byte & TRACE_MASK_MEDIUM) == TRACE_TAG_MEDIUM)
+    {
+        return TRACE_MEDIUM_BYTES;
+    }
+    switch (byte & TRACE_MASK_TAG)
+    {
+    case TRACE_TAG_FULL:
+        return (byte & 0x0C) ? 0 : TRACE_FULL_BYTES;
+    case TRACE_TAG_TIME:
+        return TRACE_TIME_BYTES;
+    case TRACE_TAG_PERIOD:
+        return TRACE_PERIOD_BYTES;
+    default:
+        return TRACE_EVENT_BYTES;
+    }
+}
+
+// The record's bytes as one number, most significant first
+static uint64_t recordValue(const TraceDecoder *decoder)
+{
+    uint64_t value = 0;
+    int i;
+
+    for (i = 0; i < decoder->length; i++)
+    {
+        value = value << 8 | decoder->record[i];
+    }
+    return value;
+}
+
+// The signed field of `bits` bits at `shift`
+static int32_t field(uint32_t value, int shift, int bits)
+{
+    int32_t f = (value >> shift) & ((1u << bits) - 1);
+
+    return f >= (1 << (bits - 1)) ? f - (1 << bits) : f;
+}
+
+static void lose(TraceDecoder *decoder)
+{
+    decoder->stats.errors++;
+    decoder->synced = false;
+    decoder->previous = 0;
+}
+
+static void resync(TraceDecoder *decoder)
+{
+    decoder->synced = true;
+    decoder->haveSample = false;
+    decoder->haveTime = false;
+    decoder->periodUs = 0;
+    decoder->length = 0;
+    decoder->stats.syncs++;
+}
+
+// Decodes a whole record; returns true if it is a sample or an event
+static bool decode(TraceDecoder *decoder, TraceDecoded *decoded)
+{
+    uint64_t value = recordValue(decoder);
+    uint8_t tag = decoder->record[0];
+    int32_t dx, dy, dz;
+
+    if ((tag & TRACE_MASK_TAG) == TRACE_TAG_TIME)
+    {
+        decoder->us = value & 0xFFFFFFFFFull;
+        decoder->haveTime = true;
+        decoder->timeFresh = true;
+        return false;
+    }
+    if ((tag & TRACE_MASK_TAG) == TRACE_TAG_PERIOD)
+    {
+        decoder->periodUs = value & 0xFFFFF;
+        return false;
+    }
+    if ((tag & TRACE_MASK_TAG) == TRACE_TAG_EVENT)
+    {
+        uint8_t event = tag & 0x0F;
+
+        if (event == TRACE_SYNC && decoder->record[1] == TRACE_SYNC_MAGIC)
+        {
+            resync(decoder);
+            return false;
+        }
+        if (!TraceDecoder_eventName(event) || event == TRACE_SYNC
+            || !decoder->haveTime)
+        {
+            lose(decoder);
+            return false;
+        }
+        decoded->kind = TRACE_DECODED_EVENT;
+        decoded->us = decoder->us;
+        decoded->event = event;
+        decoded->argument = decoder->record[1];
+        decoder->stats.events++;
+        return true;
+    }
+
+    // A sample
+    if ((tag & TRACE_MASK_TAG) == TRACE_TAG_FULL)
+    {
+        decoder->last.x = (value >> 28) & 0x3FFF;
+        decoder->last.y = (value >> 14) & 0x3FFF;
+        decoder->last.z = value & 0x3FFF;
+    }
+    else
+    {
+        if (!decoder->haveSample)
+        {
+            lose(decoder);
+            return false;
+        }
+        if ((tag & TRACE_MASK_SMALL) == TRACE_TAG_SMALL)
+        {
+            dx = field(value, 10, 5);
+            dy = field(value, 5, 5);
+            dz = field(value, 0, 5);
+        }
+        else
+        {
+            dx = field(value, 15, 7);
+            dy = field(value, 8, 7);
+            dz = field(value, 1, 7);
+        }
+        decoder->last.x += dx;
+        decoder->last.y += dy;
+        decoder->last.z += dz;
+    }
+    if (!decoder->haveTime || !decoder->periodUs)
+    {
+        lose(decoder);
+        return false;
+    }
+    decoder->haveSample = true;
+
+    // At the TIME just before, or a period on from the last sample
+    if (!decoder->timeFresh)
+    {
+        decoder->us += decoder->periodUs;
+    }
+    decoder->timeFresh = false;
+
+    decoded->kind = TRACE_DECODED_SAMPLE;
+    decoded->us = decoder->us;
+    decoded->sample = decoder->last;
+    decoder->stats.samples++;
+    return true;
+}
+
+bool TraceDecoder_put(TraceDecoder *decoder, uint8_t byte,
+                      TraceDecoded *decoded)
+{
+    bool found;
+
+    decoder->stats.bytes++;
+
+    if (!decoder->synced)
+    {
+        if (decoder->previous == (TRACE_TAG_EVENT | TRACE_SYNC)
+            && byte == TRACE_SYNC_MAGIC)
+        {
+            // The SYNC's first byte was counted as skipped
+            decoder->stats.skipped--;
+            resync(decoder);
+        }
+        else
+        {
+            decoder->stats.skipped++;
+            decoder->previous = byte;
+        }
+        return false;
+    }
+
+    if (decoder->length == 0)
+    {
+        decoder->expected = recordLength(byte);
+        if (!decoder->expected)
+        {
+            lose(decoder);
+            return false;
+        }
+    }
+    decoder->record[decoder->length++] = byte;
+    if (decoder->length < decoder->expected)
+    {
+        return false;
+    }
+
+    found = decode(decoder, decoded);
+    decoder->length = 0;
+    return found;
+}
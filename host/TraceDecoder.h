@@ -0,0 +1,73 @@
+/*
+ * TraceDecoder.h
+ *
+ * Decoder for the byte stream of the accelerometer trace recorder
+ * (HAL/Trace.h), fed a byte at a time as it comes off the UART.  It skips
+ * bytes until it sees a SYNC record, then turns each sample and event into
+ * a TraceDecoded with its time.  A record that cannot be right - a delta
+ * sample with no sample before it, a sample with no time, an unknown
+ * event - is counted as an error, and the decoder goes back to looking for
+ * a SYNC.
+ */
+
+#ifndef HOST_TRACEDECODER_H_
+#define HOST_TRACEDECODER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <HAL/Trace.h>
+
+typedef enum
+{
+    TRACE_DECODED_SAMPLE,
+    TRACE_DECODED_EVENT
+} TraceDecodedKind;
+
+typedef struct
+{
+    TraceDecodedKind kind;
+    uint64_t us;                // microseconds, as the board's clock had it
+    AccelSample sample;         // TRACE_DECODED_SAMPLE
+    uint8_t event;              // TRACE_DECODED_EVENT, a TraceEvent
+    uint8_t argument;
+} TraceDecoded;
+
+typedef struct
+{
+    uint32_t bytes;
+    uint32_t skipped;           // bytes passed over looking for a SYNC
+    uint32_t syncs;
+    uint32_t samples;
+    uint32_t events;
+    uint32_t errors;
+} TraceDecoderStats;
+
+typedef struct
+{
+    bool synced;
+    uint8_t previous;           // the byte before, while looking for a SYNC
+
+    // The record being put together
+    uint8_t record[8];
+    int length, expected;
+
+    // What the stream has said so far
+    bool haveSample, haveTime, timeFresh;
+    AccelSample last;
+    uint64_t us;
+    uint32_t periodUs;
+
+    TraceDecoderStats stats;
+} TraceDecoder;
+
+void TraceDecoder_init(TraceDecoder* decoder);
+
+// Takes the next byte; returns true, with decoded filled in, if it completed
+// a sample or an event
+bool TraceDecoder_put(TraceDecoder* decoder, uint8_t byte,
+                      TraceDecoded* decoded);
+
+// The name of an event, for CSV, or NULL if it has none
+const char *TraceDecoder_eventName(uint8_t event);
+
+#endif /* HOST_TRACEDECODER_H_ */
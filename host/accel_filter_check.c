@@ -0,0 +1,339 @@
+/*
+ * accel_filter_check.c
+ *
+ * Checks the accelerometer's filter stage (HAL/AccelFilter.c) and the tilt
+ * classifier (Tilt.c):
+ *   - AccelFilter_run(), the packed two-lane version, gives the same output
+ *     as AccelFilter_runReference() bit for bit, over random traces with
+ *     spikes and steps, for every median length and a range of alphas;
+ *   - a constant comes through unchanged, a single-sample spike does not
+ *     come through a median of 3 or more at all, and a step settles to
+ *     within a count;
+ *   - the classifier does not change state on a reading hovering at a
+ *     threshold or on a knock shorter than the dwell, and does on a tilt
+ *     that dwells, a dwell's worth of samples after it crosses;
+ *   - over a noisy round of tilts, the game's filter and a classifier on
+ *     its Z output with a 50 ms dwell count every tilt once, where
+ *     classifying the raw samples with no dwell also counts the knocks.
+ * Off-target, the packed version runs on the plain C lane arithmetic, not
+ * the DSP instructions.
+ *
+ * Usage: accel_filter_check
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <HAL/AccelFilter.h>
+#include <Tilt.h>
+
+#define SAMPLE_HZ       100
+#define RANDOM_SAMPLES  20000
+#define ADC_MAX         16383
+
+// A level board's Z, and a tilt down and up, in ADC counts
+#define Z_LEVEL         8800
+#define Z_FACE_DOWN     5600
+#define Z_FACE_UP       12000
+
+static int failures;
+
+// The Z band the game first classified on, with a 50 ms dwell
+static TiltConfig zTiltConfig(void)
+{
+    TiltConfig config = {
+        .downEnter = 7000,
+        .downExit = 7500,
+        .upExit = 10000,
+        .upEnter = 10500,
+        .dwellSamples = Tilt_samplesIn(50, SAMPLE_HZ),
+    };
+    return config;
+}
+
+static void check(bool ok, const char *name, const char *what)
+{
+    if (!ok)
+    {
+        printf("FAIL  %s: %s\n", name, what);
+        failures++;
+    }
+}
+
+// xorshift32, so runs can be diffed
+static uint32_t randomState = 2564;
+
+static uint32_t random32(void)
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+static uint16_t clampAdc(int32_t v)
+{
+    return (uint16_t) (v < 0 ? 0 : (v > ADC_MAX ? ADC_MAX : v));
+}
+
+static AccelSample sampleOf(int32_t x, int32_t y, int32_t z)
+{
+    AccelSample s = { clampAdc(x), clampAdc(y), clampAdc(z) };
+    return s;
+}
+
+static bool sameSample(AccelSample a, AccelSample b)
+{
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+//*****************************************************************************
+//
+// The filter
+//
+//*****************************************************************************
+
+// Random walk with noise, steps and full-scale spikes on every axis
+static AccelSample randomSample(int32_t level[ACCEL_RING_AXES])
+{
+    int32_t v[ACCEL_RING_AXES];
+    int axis;
+
+    for (axis = 0; axis < ACCEL_RING_AXES; axis++)
+    {
+        uint32_t r = random32();
+
+        if (r % 200 == 0)
+        {
+            level[axis] = (int32_t) (random32() % (ADC_MAX + 1));
+        }
+        v[axis] = level[axis] + (int32_t) (r >> 8) % 401 - 200;
+        if (r % 37 == 0)
+        {
+            v[axis] = (r & 0x100) ? ADC_MAX : 0;
+        }
+    }
+    return sampleOf(v[0], v[1], v[2]);
+}
+
+static void checkBitExact(void)
+{
+    static const uint16_t alphas[] = {
+        1, 100, 1638, 4915, 8192, 16000, ACCEL_FILTER_ALPHA_ONE
+    };
+    uint32_t taps, a, n, mismatches = 0, runs = 0;
+
+    for (taps = 1; taps <= ACCEL_FILTER_MEDIAN_MAX; taps += 2)
+    {
+        for (a = 0; a < sizeof(alphas) / sizeof(alphas[0]); a++)
+        {
+            AccelFilterConfig config = { alphas[a], (uint8_t) taps };
+            AccelFilter packed, reference;
+            int32_t level[ACCEL_RING_AXES] = { 8192, 8192, 8192 };
+
+            AccelFilter_init(&packed, &config);
+            AccelFilter_init(&reference, &config);
+            for (n = 0; n < RANDOM_SAMPLES; n++)
+            {
+                AccelSample in = randomSample(level);
+
+                if (n == RANDOM_SAMPLES / 2)
+                {
+                    AccelFilter_reset(&packed);
+                    AccelFilter_reset(&reference);
+                }
+                if (!sameSample(AccelFilter_run(&packed, in),
+                                AccelFilter_runReference(&reference, in)))
+                {
+                    mismatches++;
+                }
+            }
+            runs++;
+        }
+    }
+    check(!mismatches, "bit exact", "packed and reference outputs differ");
+    printf("bit exact     %u configurations, %u samples each, %u "
+           "mismatches\n", (unsigned) runs, (unsigned) RANDOM_SAMPLES,
+           (unsigned) mismatches);
+}
+
+static void checkResponse(void)
+{
+    AccelFilterConfig config = { ACCEL_FILTER_ALPHA_ONE, 3 };
+    AccelFilter filter;
+    AccelSample level = sampleOf(1000, 8000, 16000);
+    AccelSample out;
+    uint32_t n;
+    bool steady = true;
+
+    // A constant, and a one-sample spike on it with no smoothing
+    AccelFilter_init(&filter, &config);
+    for (n = 0; n < 20; n++)
+    {
+        out = AccelFilter_run(&filter, n == 10 ? sampleOf(0, ADC_MAX, 0)
+                                               : level);
+        steady &= sameSample(out, level);
+    }
+    check(steady, "response", "a constant or a spike came through");
+
+    // A step, through a slow low-pass
+    config.alpha = ACCEL_FILTER_ALPHA_ONE / 50;
+    config.medianTaps = 5;
+    AccelFilter_init(&filter, &config);
+    AccelFilter_run(&filter, sampleOf(0, 0, 0));
+    for (n = 0; n < 2000; n++)
+    {
+        out = AccelFilter_run(&filter, level);
+    }
+    check(abs(out.x - level.x) <= 1 && abs(out.y - level.y) <= 1
+          && abs(out.z - level.z) <= 1, "response", "a step did not settle");
+}
+
+//*****************************************************************************
+//
+// The classifier
+//
+//*****************************************************************************
+static void checkClassifier(void)
+{
+    TiltConfig config = zTiltConfig();
+    Tilt tilt;
+    uint32_t n, events = 0, at = 0;
+
+    check(config.dwellSamples == 5, "classifier", "50 ms is not 5 samples");
+    Tilt_init(&tilt, &config);
+
+    // Hovering either side of the down threshold, never dwelling
+    for (n = 0; n < 1000; n++)
+    {
+        uint16_t z = config.downEnter + ((n % 4 < 2) ? -20 : 20);
+
+        events += Tilt_update(&tilt, z) != TILT_NONE;
+    }
+    check(!events && Tilt_state(&tilt) == TILT_LEVEL, "classifier",
+          "a reading at the threshold changed state");
+
+    // A knock one sample short of the dwell, then a tilt that dwells
+    for (n = 0; n < config.dwellSamples - 1; n++)
+    {
+        events += Tilt_update(&tilt, Z_FACE_UP) != TILT_NONE;
+    }
+    events += Tilt_update(&tilt, Z_LEVEL) != TILT_NONE;
+    check(!events, "classifier", "a knock shorter than the dwell counted");
+
+    for (n = 1; n <= 3 * config.dwellSamples; n++)
+    {
+        if (Tilt_update(&tilt, Z_FACE_DOWN) == TILT_ENTER_DOWN)
+        {
+            at = n;
+            events++;
+        }
+    }
+    check(events == 1 && at == config.dwellSamples, "classifier",
+          "a tilt did not enter a dwell after it crossed");
+
+    // Back up inside the hysteresis band stays down, and past it leaves
+    for (n = 0; n < 100; n++)
+    {
+        events += Tilt_update(&tilt, config.downExit - 10) != TILT_NONE;
+    }
+    check(events == 1 && Tilt_state(&tilt) == TILT_DOWN, "classifier",
+          "left a tilt before its exit threshold");
+    for (n = 0; n < config.dwellSamples; n++)
+    {
+        if (Tilt_update(&tilt, Z_LEVEL) == TILT_LEAVE_DOWN)
+        {
+            events++;
+        }
+    }
+    check(events == 2 && Tilt_state(&tilt) == TILT_LEVEL, "classifier",
+          "did not leave a tilt");
+}
+
+//*****************************************************************************
+//
+// A noisy round: a tilt down or up every 3 s held for 600 ms, with sensor
+// noise, and a knock (a few samples of a large swing) every 700 ms
+//
+//*****************************************************************************
+#define ROUND_SAMPLES   (60 * SAMPLE_HZ)
+#define TILT_EVERY      (3 * SAMPLE_HZ)
+#define TILT_HOLD       (SAMPLE_HZ * 6 / 10)
+#define KNOCK_EVERY     (SAMPLE_HZ * 7 / 10)
+#define KNOCK_SAMPLES   2
+
+static AccelSample roundSample(uint32_t n)
+{
+    uint32_t intoTilt = n % TILT_EVERY;
+    int32_t z = Z_LEVEL;
+
+    if (n >= TILT_EVERY && intoTilt < TILT_HOLD)
+    {
+        z = ((n / TILT_EVERY) % 2) ? Z_FACE_DOWN : Z_FACE_UP;
+    }
+    z += (int32_t) (random32() % 601) - 300;
+    if (n % KNOCK_EVERY < KNOCK_SAMPLES)
+    {
+        z += (n / KNOCK_EVERY % 2) ? 2500 : -2500;
+    }
+    return sampleOf(4000, 8192, z);
+}
+
+static void checkRound(void)
+{
+    const AccelFilterConfig filterConfig = {
+        ACCEL_FILTER_ALPHA_ONE * 3 / 10, 5
+    };
+    TiltConfig config = zTiltConfig();
+    TiltConfig rawConfig = config;
+    AccelFilter filter;
+    Tilt tilt, raw;
+    uint32_t tilts = ROUND_SAMPLES / TILT_EVERY - 1;
+    uint32_t n, got = 0, passed = 0, rawEvents = 0;
+
+    rawConfig.dwellSamples = 1;
+    AccelFilter_init(&filter, &filterConfig);
+    Tilt_init(&tilt, &config);
+    Tilt_init(&raw, &rawConfig);
+    for (n = 0; n < ROUND_SAMPLES; n++)
+    {
+        AccelSample in = roundSample(n);
+        TiltEvent rawEvent = Tilt_update(&raw, in.z);
+
+        switch (Tilt_update(&tilt, AccelFilter_run(&filter, in).z))
+        {
+        case TILT_LEAVE_DOWN:
+            got++;
+            break;
+        case TILT_LEAVE_UP:
+            passed++;
+            break;
+        default:
+            break;
+        }
+        rawEvents += (rawEvent == TILT_LEAVE_DOWN)
+                || (rawEvent == TILT_LEAVE_UP);
+    }
+    check(got + passed == tilts && got == tilts / 2 + tilts % 2, "round",
+          "not every tilt counted once");
+    check(rawEvents > tilts, "round",
+          "the knocks did not trip the raw classifier");
+    printf("round         %u tilts: filtered %u got, %u passed; raw %u\n",
+           (unsigned) tilts, (unsigned) got, (unsigned) passed,
+           (unsigned) rawEvents);
+}
+
+int main(void)
+{
+    checkBitExact();
+    checkResponse();
+    checkClassifier();
+    checkRound();
+
+    if (failures)
+    {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
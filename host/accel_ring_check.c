@@ -0,0 +1,389 @@
+/*
+ * accel_ring_check.c
+ *
+ * Runs AccelRing (HAL/AccelRing.c) against a model of the ADC's conversion
+ * memories and of its uDMA channel in ping-pong mode, and checks that blocks
+ * come out of AccelRing_read() whole, in order and stamped with the clock
+ * reading of their completion interrupt: read as they arrive, read after the
+ * reader has fallen behind (the oldest are dropped and counted), with the
+ * completion interrupt held off over two blocks (one interrupt, both blocks),
+ * after a restart, and paused and resumed.  The uDMA copies the low half of
+ * each 32-bit memory, so the model fills the high halves with junk that must
+ * not show up.
+ *
+ * Usage: accel_ring_check
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <HAL/AccelRing.h>
+
+// 100 Hz: the Sampler's trigger period for three conversions a sample, and
+// the clock cycles between samples that gives
+#define CONVERSION_ACLK     109
+#define SAMPLE_ACLK         (CONVERSION_ACLK * ACCEL_RING_AXES)
+#define SAMPLE_CYCLES       ((uint32_t) ((uint64_t) SAMPLE_ACLK * 48000000 / 32768))
+
+static int failures;
+
+//*****************************************************************************
+//
+// The model.  A sequence ending is one uDMA request, which the active
+// control structure serves whole, then stops and hands over to the other.
+// If the other has not been re-armed, the channel stalls.
+//
+//*****************************************************************************
+ADC14_Type HostAdc14;
+
+typedef struct
+{
+    uint32_t mode;
+    const volatile uint32_t *src;
+    uint16_t *dst;
+    uint32_t size;
+} Structure;
+
+static Structure structures[2];
+static int active;
+static bool enabled, stalled;
+static bool interruptFlag, interruptHeld;
+static uint32_t interruptsTaken;
+
+static uint64_t now;
+
+extern void DMA_INT2_IRQHandler(void);
+
+uint64_t Clock_now()
+{
+    return now;
+}
+
+static Structure *structureOf(uint32_t channelStructIndex)
+{
+    return &structures[(channelStructIndex & UDMA_ALT_SELECT) ? 1 : 0];
+}
+
+void DMA_assignChannel(uint32_t mapping)
+{
+}
+
+void DMA_disableChannelAttribute(uint32_t channelNum, uint32_t attr)
+{
+    if (attr & UDMA_ATTR_ALTSELECT)
+    {
+        active = 0;
+    }
+}
+
+void DMA_setChannelControl(uint32_t channelStructIndex, uint32_t control)
+{
+}
+
+void DMA_setChannelTransfer(uint32_t channelStructIndex, uint32_t mode,
+                            void *srcAddr, void *dstAddr,
+                            uint32_t transferSize)
+{
+    Structure *structure = structureOf(channelStructIndex);
+
+    structure->mode = mode;
+    structure->src = srcAddr;
+    structure->dst = dstAddr;
+    structure->size = transferSize;
+}
+
+uint32_t DMA_getChannelMode(uint32_t channelStructIndex)
+{
+    return structureOf(channelStructIndex)->mode;
+}
+
+void DMA_enableChannel(uint32_t channelNum)
+{
+    enabled = true;
+    stalled = false;
+}
+
+void DMA_disableChannel(uint32_t channelNum)
+{
+    enabled = false;
+}
+
+void DMA_assignInterrupt(uint32_t interruptNumber, uint32_t channel)
+{
+}
+
+void DMA_clearInterruptFlag(uint32_t intChannel)
+{
+    interruptFlag = false;
+}
+
+void Interrupt_enableInterrupt(uint32_t interruptNumber)
+{
+}
+
+static void takeInterrupt(void)
+{
+    if (interruptFlag && !interruptHeld)
+    {
+        interruptsTaken++;
+        DMA_INT2_IRQHandler();
+    }
+}
+
+// The conversion of memory `mem` of the block'th sequence since the start
+static uint16_t conversion(uint32_t block, uint32_t mem)
+{
+    return (uint16_t) ((block * ACCEL_RING_MEMS + mem) & 0x3FFF);
+}
+
+// Converts a whole sequence into the memories, the clock running on by a
+// block's worth of samples, and ends it
+static void endSequence(uint32_t block)
+{
+    Structure *structure = &structures[active];
+    uint32_t i;
+
+    now += (uint64_t) ACCEL_RING_BLOCK * SAMPLE_CYCLES;
+    for (i = 0; i < ACCEL_RING_MEMS; i++)
+    {
+        ADC14->MEM[i] = 0xA5A50000u | conversion(block, i);
+    }
+    if (!enabled || stalled)
+    {
+        return;
+    }
+    if (structure->mode == UDMA_MODE_STOP)
+    {
+        stalled = true;
+        return;
+    }
+
+    for (i = 0; i < structure->size; i++)
+    {
+        structure->dst[i] = (uint16_t) structure->src[i];
+    }
+    structure->mode = UDMA_MODE_STOP;
+    active ^= 1;
+    interruptFlag = true;
+    takeInterrupt();
+}
+
+static void restart(void)
+{
+    now = 1000;
+    interruptsTaken = 0;
+    g_accelRingStats.blocks = g_accelRingStats.dropped = 0;
+    AccelRing_start(SAMPLE_ACLK);
+}
+
+//*****************************************************************************
+//
+// Checks
+//
+//*****************************************************************************
+static void check(bool ok, const char *name, const char *what)
+{
+    if (!ok)
+    {
+        printf("FAIL  %s: %s\n", name, what);
+        failures++;
+    }
+}
+
+// Reads the next block and checks it is the block'th captured, holding the
+// whole of the converted'th sequence since the start, and stamped no later
+// than the clock reads now
+static void expectConverted(uint32_t block, uint32_t converted,
+                            const char *name)
+{
+    AccelBlock out;
+    bool whole = true;
+    uint32_t i;
+
+    if (!AccelRing_read(&out))
+    {
+        check(false, name, "a block is missing");
+        return;
+    }
+    check(out.sequence == block, name, "blocks out of order");
+    check(out.periodCycles == SAMPLE_CYCLES, name, "wrong sample period");
+    check(out.endCycles <= now, name, "stamped in the future");
+    for (i = 0; i < ACCEL_RING_BLOCK; i++)
+    {
+        const AccelSample *sample = &out.samples[i];
+        uint32_t mem = i * ACCEL_RING_AXES;
+
+        whole &= (sample->x == conversion(converted, mem))
+                && (sample->y == conversion(converted, mem + 1))
+                && (sample->z == conversion(converted, mem + 2));
+    }
+    check(whole, name, "samples are not the block's");
+}
+
+static void expectBlock(uint32_t block, const char *name)
+{
+    expectConverted(block, block, name);
+}
+
+static void expectEmpty(const char *name)
+{
+    AccelBlock out;
+
+    check(!AccelRing_read(&out), name, "a block too many");
+}
+
+// Each block is read as soon as it is in, and stamped on its interrupt
+static void checkInOrder(void)
+{
+    const uint32_t blocks = 5 * ACCEL_RING_BLOCKS;
+    uint32_t n;
+
+    restart();
+    for (n = 0; n < blocks; n++)
+    {
+        AccelBlock out;
+
+        endSequence(n);
+        if (AccelRing_read(&out))
+        {
+            check(out.endCycles == now, "in order", "stamp is not the "
+                  "interrupt's");
+            check(out.sequence == n, "in order", "blocks out of order");
+        }
+        else
+        {
+            check(false, "in order", "a block is missing");
+        }
+    }
+    expectEmpty("in order");
+    check(interruptsTaken == blocks, "in order", "not one interrupt a block");
+    check(!stalled && !g_accelRingStats.dropped, "in order", "blocks lost");
+    printf("in order      %u blocks, %u interrupts, %u dropped\n",
+           (unsigned) g_accelRingStats.blocks, (unsigned) interruptsTaken,
+           (unsigned) g_accelRingStats.dropped);
+}
+
+// The reader falls behind by more than the ring holds: the oldest blocks are
+// dropped, and the rest come out whole
+static void checkBehind(void)
+{
+    const uint32_t blocks = 3 * ACCEL_RING_BLOCKS;
+    const uint32_t kept = ACCEL_RING_BLOCKS - 2;
+    uint32_t n;
+
+    restart();
+    for (n = 0; n < blocks; n++)
+    {
+        endSequence(n);
+    }
+    for (n = blocks - kept; n < blocks; n++)
+    {
+        expectBlock(n, "behind");
+    }
+    expectEmpty("behind");
+    check(g_accelRingStats.dropped == blocks - kept, "behind",
+          "dropped count is wrong");
+    check(!stalled, "behind", "the uDMA stalled");
+
+    // and it catches up
+    endSequence(blocks);
+    expectBlock(blocks, "behind");
+    printf("behind        %u blocks, %u read, %u dropped\n",
+           (unsigned) g_accelRingStats.blocks, (unsigned) kept + 1,
+           (unsigned) g_accelRingStats.dropped);
+}
+
+// The completion interrupt is held off while both structures finish: the
+// one interrupt has to re-arm both, or the channel stalls on the next block
+static void checkHeld(void)
+{
+    const uint32_t blocks = 2 * ACCEL_RING_BLOCKS;
+    uint32_t n;
+
+    restart();
+    endSequence(0);
+    interruptHeld = true;
+    endSequence(1);
+    endSequence(2);
+    interruptHeld = false;
+    takeInterrupt();
+    for (n = 0; n < 3; n++)
+    {
+        expectBlock(n, "held");
+    }
+    for (n = 3; n < blocks; n++)
+    {
+        endSequence(n);
+        expectBlock(n, "held");
+    }
+    expectEmpty("held");
+    check(!stalled, "held", "the uDMA stalled");
+    check(interruptsTaken == blocks - 1, "held", "interrupts miscounted");
+    printf("held          %u blocks, %u interrupts, %u dropped\n",
+           (unsigned) g_accelRingStats.blocks, (unsigned) interruptsTaken,
+           (unsigned) g_accelRingStats.dropped);
+}
+
+// Stopping loses nothing but the block being filled, and a restart starts
+// from an empty ring
+static void checkRestart(void)
+{
+    restart();
+    endSequence(0);
+    endSequence(1);
+    AccelRing_stop();
+    endSequence(2);
+    expectBlock(0, "restart");
+    expectBlock(1, "restart");
+    expectEmpty("restart");
+
+    endSequence(0);
+    restart();
+    expectEmpty("restart");
+    endSequence(0);
+    expectBlock(0, "restart");
+    check(!stalled, "restart", "the uDMA stalled");
+}
+
+// The sequences that end while paused are skipped, and the capture resumes
+// into the next block of the ring, with nothing to re-arm
+static void checkPause(void)
+{
+    restart();
+    endSequence(0);
+    endSequence(1);
+    AccelRing_pause();
+    endSequence(2);
+    endSequence(3);
+    AccelRing_resume();
+    endSequence(4);
+    endSequence(5);
+    expectBlock(0, "pause");
+    expectBlock(1, "pause");
+    expectConverted(2, 4, "pause");
+    expectConverted(3, 5, "pause");
+    expectEmpty("pause");
+    check(!stalled, "pause", "the uDMA stalled");
+    check(interruptsTaken == 4, "pause", "interrupts miscounted");
+    printf("pause         %u blocks, %u interrupts, %u dropped\n",
+           (unsigned) g_accelRingStats.blocks, (unsigned) interruptsTaken,
+           (unsigned) g_accelRingStats.dropped);
+}
+
+int main(void)
+{
+    AccelRing_init();
+
+    checkInOrder();
+    checkBehind();
+    checkHeld();
+    checkRestart();
+    checkPause();
+
+    if (failures)
+    {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,401 @@
+/*
+ * idle_sim.c
+ *
+ * Runs the idle manager (HAL/Idle.c) and the TimerWheel over a scripted
+ * session on a simulated TIMER_A1 (HostTimerA.c), and estimates how much of
+ * the time the CPU is awake.  The session is the title screen for 10 s, a
+ * 60 s round and the results screen for 10 s:
+ *   - a button is tapped at the end of each menu screen, starting its 500 ms
+ *     debounce timer on the wheel;
+ *   - every 3 s in the round the unit is tilted for 600 ms, the samples
+ *     leaving the quiet band, and the round is quiet again 200 ms after;
+ *   - the round's countdown runs on its 1 s wheel timer, and each second's
+ *     redraw keeps the LCD's uDMA busy for a few milliseconds;
+ *   - the ADC takes samples at the given rate while it is converting: the
+ *     Sampler's rate for the round, or ADCOSC's free-running rate.
+ * Every wake costs the given number of CPU cycles (interrupt entry and exit,
+ * and a pass of the main loop), the redraw more.
+ *
+ * The session is run under four policies:
+ *   idle        as the firmware runs it: the Sampler triggers the ADC during
+ *               the round only, and the uDMA interrupts once per AccelRing
+ *               block, which the main loop filters and classifies; while the
+ *               round is quiet, the capture is paused and the window
+ *               comparators wake the CPU on the sample a tilt leaves the band
+ *               on (TILT_WAKE_WINDOW); Idle_sleep() picks LPM0 or LPM3
+ *   blocks      the same, but every block interrupts (TILT_WAKE_WINDOW 0)
+ *   stream      the same, but every sample interrupts
+ *   adc-always  as before the idle manager: the ADC converts from boot and
+ *               every sample interrupts, so every sleep is in LPM0
+ *
+ * One CSV row per policy and screen goes to stdout, and a total per policy:
+ * wakes, wakes a second, how many of them were the wheel's, sleeps in each
+ * mode, and the percentage of the time awake as Idle measured it on the
+ * ACLK counter.  Nothing depends on the host's timing, so runs can be diffed.
+ *
+ * Usage: idle_sim [-s roundHz] [-a freeRunningHz] [-c cyclesPerWake]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <HAL/Idle.h>
+#include <HAL/AccelRing.h>
+#include <HAL/TimerWheel.h>
+#include <HAL/LcdDriver/HAL_MSP_EXP432P401R_Crystalfontz128x128_ST7735.h>
+
+#include "HostTimerA.h"
+
+#define MCLK_HZ             48000000u
+#define ACLK_HZ             TIMER_WHEEL_ACLK_HZ
+
+#define TILT_INTERVAL_S     3
+#define TILT_HOLD_MS        600
+#define QUIET_AFTER_MS      200     // the filter and the tilt's exit dwell
+#define DEBOUNCE_MS         500
+#define REDRAW_CYCLES       60000u      // the time digits, drawn and flushed
+#define REDRAW_LCD_ACLK     (3 * ACLK_HZ / 1000)   // their uDMA transfer
+
+typedef enum
+{
+    POLICY_IDLE,
+    POLICY_BLOCKS,
+    POLICY_STREAM,
+    POLICY_ADC_ALWAYS,
+    POLICIES
+} Policy;
+
+static const char *const policyNames[POLICIES] = {
+    "idle", "blocks", "stream", "adc-always"
+};
+
+typedef struct
+{
+    const char *name;
+    uint32_t seconds;
+    bool round;         // the countdown runs, the ADC samples and the unit
+                        // is tilted
+} Phase;
+
+static const Phase phases[] = {
+    { "title", 10, false },
+    { "game", 60, true },
+    { "results", 10, false },
+};
+enum { PHASES = sizeof(phases) / sizeof(phases[0]) };
+
+static uint32_t roundHz = 100;
+static uint32_t freeRunningHz = 800;
+static uint32_t adcHz;
+static uint32_t wakeCycles = 1500;
+
+// MCLK cycles charged but not yet a whole ACLK cycle
+static uint64_t cycleDebt;
+
+// Interrupt sources other than the wheel: the next ACLK cycle each fires on.
+// UINT64_MAX while one is off. The ADC interrupts on every sample, or the
+// uDMA once a block; with window wakes, the window comparator instead while
+// the round is quiet, on the sample that leaves the band.
+static bool adcRunning, windowWakes, watching;
+static uint32_t samplesPerWake;
+static uint64_t adcStart, adcWakes;
+static uint64_t nextAdc, nextCrossing, nextTap, lcdDone;
+
+// The round's tilts: where it started and ends, how many have begun, and
+// when the round is quiet after the last
+static uint64_t roundStart, roundEnd, quietAt;
+static uint32_t tilts;
+
+static TimerWheel_Timer countdownTimer, debounceTimer;
+static volatile bool countdownTicked;
+
+//*****************************************************************************
+//
+// Stand-ins for the PCM and the LCD HAL
+//
+//*****************************************************************************
+static uint64_t nextEvent(void)
+{
+    uint64_t next = HostTimerA_nextCompare();
+
+    if (!watching && (nextAdc < next))
+    {
+        next = nextAdc;
+    }
+    if (watching && (nextCrossing < next))
+    {
+        next = nextCrossing;
+    }
+    if (nextTap < next)
+    {
+        next = nextTap;
+    }
+    if (lcdDone < next)
+    {
+        next = lcdDone;
+    }
+    return next;
+}
+
+// Called with interrupts masked; sleeps until the next interrupt is pending.
+// If one is pending already, that is now.
+static void sleepUntilInterrupt(void)
+{
+    uint64_t next = nextEvent();
+
+    if (next > HostTimerA_now())
+    {
+        HostTimerA_advanceTo(next);
+    }
+}
+
+bool PCM_gotoLPM0(void)
+{
+    sleepUntilInterrupt();
+    return true;
+}
+
+bool PCM_gotoLPM3(void)
+{
+    sleepUntilInterrupt();
+    return true;
+}
+
+bool HAL_LCD_isBusy(void)
+{
+    return lcdDone != UINT64_MAX;
+}
+
+//*****************************************************************************
+//
+// The session
+//
+//*****************************************************************************
+
+// Runs the clock on by a number of CPU cycles, taking the wheel's interrupts
+// that fall in them
+static void charge(uint32_t cycles)
+{
+    cycleDebt += (uint64_t) cycles * ACLK_HZ;
+    HostTimerA_advanceTo(HostTimerA_now() + cycleDebt / MCLK_HZ);
+    cycleDebt %= MCLK_HZ;
+}
+
+static void startAdc(uint32_t hz)
+{
+    adcHz = hz;
+    adcRunning = true;
+    adcStart = HostTimerA_now();
+    adcWakes = 1;
+    nextAdc = adcStart + (uint64_t) samplesPerWake * ACLK_HZ / adcHz;
+    Idle_hold(IDLE_HOLD_ADC);
+}
+
+static void stopAdc(void)
+{
+    adcRunning = false;
+    nextAdc = UINT64_MAX;
+    Idle_release(IDLE_HOLD_ADC);
+}
+
+// The start of the next tilt, and the sample after it, which is the first
+// out of the band
+static void scheduleCrossing(void)
+{
+    uint64_t at = roundStart
+            + (uint64_t) (tilts + 1) * TILT_INTERVAL_S * ACLK_HZ;
+    uint64_t sample = (at - adcStart) * adcHz / ACLK_HZ + 1;
+
+    at = adcStart + sample * ACLK_HZ / adcHz;
+    nextCrossing = (at < roundEnd) ? at : UINT64_MAX;
+}
+
+static void countdownTick(void *context)
+{
+    countdownTicked = true;
+}
+
+static void endDebounce(void *context)
+{
+}
+
+// Handles whatever woke the CPU, as the ISRs and the main loop would
+static void handleWake(void)
+{
+    uint64_t now;
+    bool sampled = false;
+
+    charge(wakeCycles);
+    now = HostTimerA_now();
+
+    // Samples or blocks that finished while the CPU was busy leave one
+    // interrupt; while the window is watched, they leave none
+    while (nextAdc <= now)
+    {
+        sampled = !watching;
+        adcWakes++;
+        nextAdc = adcStart + adcWakes * samplesPerWake * ACLK_HZ / adcHz;
+    }
+    if (watching && (nextCrossing <= now))
+    {
+        // The comparator wakes the CPU and the capture resumes; the blocks
+        // wake it until the round is quiet after the tilt
+        watching = false;
+        quietAt = roundStart + (uint64_t) (tilts + 1) * TILT_INTERVAL_S
+                * ACLK_HZ + (uint64_t) (TILT_HOLD_MS + QUIET_AFTER_MS)
+                * ACLK_HZ / 1000;
+        tilts++;
+    }
+    else if (windowWakes && adcRunning && sampled && (now >= quietAt))
+    {
+        // A block left the round quiet: the window is armed
+        watching = true;
+        scheduleCrossing();
+    }
+    if (nextTap <= now)
+    {
+        TimerWheel_start(&debounceTimer, TimerWheel_msToTicks(DEBOUNCE_MS), 0);
+        nextTap = UINT64_MAX;
+    }
+    if (lcdDone <= now)
+    {
+        lcdDone = UINT64_MAX;
+    }
+    if (countdownTicked)
+    {
+        countdownTicked = false;
+        charge(REDRAW_CYCLES);
+        lcdDone = HostTimerA_now() + REDRAW_LCD_ACLK;
+    }
+}
+
+static void printRow(const char *policy, const char *phase,
+                     const IdleStats *before, const IdleStats *after)
+{
+    uint64_t asleep = after->asleepAclk - before->asleepAclk;
+    uint64_t awake = after->awakeAclk - before->awakeAclk;
+    double seconds = (double) (asleep + awake) / ACLK_HZ;
+    uint32_t wakes = after->wakes - before->wakes;
+
+    printf("%s,%s,%.1f,%u,%.1f,%u,%u,%u,%.3f\n", policy, phase, seconds,
+           (unsigned) wakes, wakes / seconds,
+           (unsigned) (after->timerWakes - before->timerWakes),
+           (unsigned) (after->sleeps[IDLE_LPM0] - before->sleeps[IDLE_LPM0]),
+           (unsigned) (after->sleeps[IDLE_LPM3] - before->sleeps[IDLE_LPM3]),
+           100.0 * awake / (asleep + awake));
+}
+
+static void runSession(Policy policy)
+{
+    IdleStats start;
+    int p;
+
+    HostTimerA_reset();
+    TimerWheel_init();
+    Idle_init();
+    cycleDebt = 0;
+    nextAdc = nextCrossing = nextTap = lcdDone = UINT64_MAX;
+    samplesPerWake = (policy == POLICY_IDLE || policy == POLICY_BLOCKS)
+            ? ACCEL_RING_BLOCK : 1;
+    windowWakes = (policy == POLICY_IDLE);
+    watching = false;
+    countdownTicked = false;
+    countdownTimer = TimerWheel_construct(countdownTick, NULL);
+    debounceTimer = TimerWheel_construct(endDebounce, NULL);
+
+    if (policy == POLICY_ADC_ALWAYS)
+    {
+        startAdc(freeRunningHz);
+    }
+    start = g_idleStats;
+
+    for (p = 0; p < PHASES; p++)
+    {
+        const Phase *phase = &phases[p];
+        uint64_t phaseStart = HostTimerA_now();
+        uint64_t end = phaseStart + (uint64_t) phase->seconds * ACLK_HZ;
+        IdleStats before = g_idleStats;
+
+        if (phase->round)
+        {
+            if (!adcRunning)
+            {
+                startAdc(roundHz);
+            }
+            TimerWheel_start(&countdownTimer, TimerWheel_msToTicks(1000),
+                             TimerWheel_msToTicks(1000));
+            roundStart = quietAt = phaseStart;
+            roundEnd = end;
+            tilts = 0;
+        }
+        else
+        {
+            nextTap = end - ACLK_HZ;
+        }
+
+        while (HostTimerA_now() < end)
+        {
+            Idle_sleep();
+            handleWake();
+        }
+
+        if (phase->round)
+        {
+            TimerWheel_cancel(&countdownTimer);
+            if (policy != POLICY_ADC_ALWAYS)
+            {
+                stopAdc();
+            }
+        }
+        watching = false;
+        nextCrossing = nextTap = UINT64_MAX;
+        printRow(policyNames[policy], phase->name, &before, &g_idleStats);
+    }
+
+    printRow(policyNames[policy], "total", &start, &g_idleStats);
+    if (adcRunning)
+    {
+        stopAdc();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int arg;
+    Policy policy;
+
+    for (arg = 1; arg < argc; arg++)
+    {
+        if ((strcmp(argv[arg], "-s") == 0) && (arg + 1 < argc))
+        {
+            roundHz = (uint32_t) strtoul(argv[++arg], NULL, 0);
+        }
+        else if ((strcmp(argv[arg], "-a") == 0) && (arg + 1 < argc))
+        {
+            freeRunningHz = (uint32_t) strtoul(argv[++arg], NULL, 0);
+        }
+        else if ((strcmp(argv[arg], "-c") == 0) && (arg + 1 < argc))
+        {
+            wakeCycles = (uint32_t) strtoul(argv[++arg], NULL, 0);
+        }
+        else
+        {
+            arg = argc;
+            roundHz = 0;
+        }
+    }
+    if (!roundHz || !freeRunningHz)
+    {
+        fprintf(stderr, "usage: %s [-s roundHz] [-a freeRunningHz] "
+                "[-c cyclesPerWake]\n", argv[0]);
+        return 2;
+    }
+
+    printf("policy,phase,seconds,wakes,wakes_per_s,timer_wakes,lpm0_sleeps,"
+           "lpm3_sleeps,active_pct\n");
+    for (policy = 0; policy < POLICIES; policy++)
+    {
+        runSession(policy);
+    }
+    return 0;
+}
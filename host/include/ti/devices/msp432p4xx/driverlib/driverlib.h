@@ -0,0 +1,310 @@
+/*
+ * driverlib.h (host stand-in)
+ *
+ * Register and driverlib stand-ins for building the LCD driver on a Linux
+ * host.  EUSCI_B0, the LCD GPIO lines and the uDMA channel are routed into
+ * HostLcd.c, which records every byte that would have gone out on the SPI
+ * bus together with the state of the DC line.  Timer_A and the NVIC's
+ * masking and pending for the TimerWheel and Idle tools are in HostTimerA.c.
+ * The ADC's conversion memories and its uDMA channel are modelled by
+ * accel_ring_check.c.
+ */
+
+#ifndef HOST_DRIVERLIB_H_
+#define HOST_DRIVERLIB_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//*****************************************************************************
+//
+// GPIO
+//
+//*****************************************************************************
+#define GPIO_PORT_P1                    1
+#define GPIO_PORT_P2                    2
+#define GPIO_PORT_P3                    3
+#define GPIO_PORT_P4                    4
+#define GPIO_PORT_P5                    5
+#define GPIO_PORT_P6                    6
+
+#define GPIO_PIN0                       (0x0001)
+#define GPIO_PIN1                       (0x0002)
+#define GPIO_PIN2                       (0x0004)
+#define GPIO_PIN3                       (0x0008)
+#define GPIO_PIN4                       (0x0010)
+#define GPIO_PIN5                       (0x0020)
+#define GPIO_PIN6                       (0x0040)
+#define GPIO_PIN7                       (0x0080)
+
+#define GPIO_PRIMARY_MODULE_FUNCTION    (0x01)
+#define GPIO_SECONDARY_MODULE_FUNCTION  (0x02)
+#define GPIO_TERTIARY_MODULE_FUNCTION   (0x03)
+
+extern void GPIO_setAsOutputPin(uint_fast8_t port, uint_fast16_t pins);
+extern void GPIO_setOutputHighOnPin(uint_fast8_t port, uint_fast16_t pins);
+extern void GPIO_setOutputLowOnPin(uint_fast8_t port, uint_fast16_t pins);
+extern void GPIO_setAsPeripheralModuleFunctionOutputPin(uint_fast8_t port,
+                                                        uint_fast16_t pins,
+                                                        uint_fast8_t mode);
+
+//*****************************************************************************
+//
+// EUSCI_B0 in SPI master mode
+//
+//*****************************************************************************
+#define EUSCI_B0_BASE                   (0x40002000)
+
+#define EUSCI_B_SPI_CLOCKSOURCE_SMCLK   (0x0080)
+#define EUSCI_B_SPI_MSB_FIRST           (0x2000)
+#define EUSCI_B_SPI_PHASE_DATA_CAPTURED_ONFIRST_CHANGED_ON_NEXT (0x8000)
+#define EUSCI_B_SPI_CLOCKPOLARITY_INACTIVITY_LOW (0x0000)
+#define EUSCI_B_SPI_3PIN                (0x0000)
+
+typedef struct _eUSCI_SPI_MasterConfig
+{
+    uint_fast8_t selectClockSource;
+    uint32_t clockSourceFrequency;
+    uint32_t desiredSpiClock;
+    uint_fast16_t msbFirst;
+    uint_fast16_t clockPhase;
+    uint_fast16_t clockPolarity;
+    uint_fast16_t spiMode;
+} eUSCI_SPI_MasterConfig;
+
+extern bool SPI_initMaster(uint32_t moduleInstance,
+                           const eUSCI_SPI_MasterConfig *config);
+extern void SPI_enableModule(uint32_t moduleInstance);
+extern uintptr_t SPI_getTransmitBufferAddressForDMA(uint32_t moduleInstance);
+
+// Writing UCB0TXBUF queues a byte; reading UCB0STATW or UCB0IFG shifts the
+// queued byte out, so the bus is never busy from the driver's point of view.
+extern volatile uint16_t HostLcd_TXBUF;
+extern uint16_t HostLcd_readSTATW(void);
+extern uint16_t HostLcd_readIFG(void);
+
+#define UCB0TXBUF                       HostLcd_TXBUF
+#define UCB0STATW                       (HostLcd_readSTATW())
+#define UCB0IFG                         (HostLcd_readIFG())
+#define UCBUSY                          (0x0001)
+#define UCTXIFG                         (0x0002)
+
+//*****************************************************************************
+//
+// uDMA
+//
+//*****************************************************************************
+#define DMA_CH0_EUSCIB0TX0              (0x01000000)
+#define DMA_CH7_ADC14                   (0x07000007)
+
+#define DMA_INT1                        (0x00000100)
+#define DMA_INT2                        (0x00000200)
+#define INT_DMA_INT1                    (49)
+#define INT_DMA_INT2                    (48)
+
+#define UDMA_PRI_SELECT                 (0x00000000)
+#define UDMA_ALT_SELECT                 (0x00000008)
+
+#define UDMA_ATTR_USEBURST              (0x00000001)
+#define UDMA_ATTR_ALTSELECT             (0x00000002)
+#define UDMA_ATTR_HIGH_PRIORITY         (0x00000004)
+#define UDMA_ATTR_REQMASK               (0x00000008)
+
+#define UDMA_SIZE_8                     (0x00000000)
+#define UDMA_SIZE_16                    (0x11000000)
+#define UDMA_SIZE_32                    (0x22000000)
+#define UDMA_SRC_INC_8                  (0x00000000)
+#define UDMA_SRC_INC_16                 (0x01000000)
+#define UDMA_SRC_INC_32                 (0x02000000)
+#define UDMA_SRC_INC_NONE               (0x03000000)
+#define UDMA_DST_INC_8                  (0x00000000)
+#define UDMA_DST_INC_16                 (0x10000000)
+#define UDMA_DST_INC_32                 (0x20000000)
+#define UDMA_DST_INC_NONE               (0x30000000)
+#define UDMA_ARB_1                      (0x00000000)
+#define UDMA_ARB_32                     (0x00014000)
+
+#define UDMA_MODE_STOP                  (0x00000000)
+#define UDMA_MODE_BASIC                 (0x00000001)
+#define UDMA_MODE_PINGPONG              (0x00000003)
+
+extern void DMA_enableModule(void);
+extern void DMA_setControlBase(void *controlTable);
+extern void DMA_assignChannel(uint32_t mapping);
+extern void DMA_disableChannelAttribute(uint32_t channelNum, uint32_t attr);
+extern void DMA_setChannelControl(uint32_t channelStructIndex,
+                                  uint32_t control);
+extern void DMA_setChannelTransfer(uint32_t channelStructIndex, uint32_t mode,
+                                   void *srcAddr, void *dstAddr,
+                                   uint32_t transferSize);
+extern void DMA_enableChannel(uint32_t channelNum);
+extern void DMA_disableChannel(uint32_t channelNum);
+extern uint32_t DMA_getChannelMode(uint32_t channelStructIndex);
+extern void DMA_assignInterrupt(uint32_t interruptNumber, uint32_t channel);
+extern void DMA_clearInterruptFlag(uint32_t intChannel);
+extern bool DMA_isChannelEnabled(uint32_t channelNum);
+
+//*****************************************************************************
+//
+// ADC14 conversion memories, which the uDMA reads
+//
+//*****************************************************************************
+typedef struct
+{
+    volatile uint32_t MEM[32];
+} ADC14_Type;
+
+extern ADC14_Type HostAdc14;
+
+#define ADC14                           (&HostAdc14)
+
+//*****************************************************************************
+//
+// Timer32, for the monotonic clock (HAL/Timer.h)
+//
+//*****************************************************************************
+#define TIMER32_1_BASE                  (0x4000C040)
+#define INT_T32_INT2                    (42)
+
+extern uint32_t Timer32_getValue(uint32_t timer);
+
+//*****************************************************************************
+//
+// Timer_A, for the TimerWheel's counter and compare
+//
+//*****************************************************************************
+#define TIMER_A1_BASE                   (0x40000400)
+#define INT_TA1_0                       (26)
+
+#define TIMER_A_CLOCKSOURCE_ACLK        (0x0100)
+#define TIMER_A_CLOCKSOURCE_DIVIDER_1   (0x01)
+#define TIMER_A_TAIE_INTERRUPT_DISABLE  (0x00)
+#define TIMER_A_DO_CLEAR                (0x0004)
+#define TIMER_A_CONTINUOUS_MODE         (0x0020)
+#define TIMER_A_CAPTURECOMPARE_REGISTER_0 (0x02)
+#define TIMER_A_CAPTURECOMPARE_INTERRUPT_ENABLE (0x0010)
+#define TIMER_A_OUTPUTMODE_OUTBITVALUE  (0x0000)
+
+typedef struct _Timer_A_ContinuousModeConfig
+{
+    uint_fast16_t clockSource;
+    uint_fast16_t clockSourceDivider;
+    uint_fast16_t timerInterruptEnable_TAIE;
+    uint_fast16_t timerClear;
+} Timer_A_ContinuousModeConfig;
+
+typedef struct _Timer_A_CompareModeConfig
+{
+    uint_fast16_t compareRegister;
+    uint_fast16_t compareInterruptEnable;
+    uint_fast16_t compareOutputMode;
+    uint_fast16_t compareValue;
+} Timer_A_CompareModeConfig;
+
+extern void Timer_A_configureContinuousMode(uint32_t timer,
+        const Timer_A_ContinuousModeConfig *config);
+extern void Timer_A_initCompare(uint32_t timer,
+                                const Timer_A_CompareModeConfig *config);
+extern void Timer_A_setCompareValue(uint32_t timer,
+                                    uint_fast16_t compareRegister,
+                                    uint_fast16_t compareValue);
+extern uint16_t Timer_A_getCounterValue(uint32_t timer);
+extern void Timer_A_startCounter(uint32_t timer, uint_fast16_t timerMode);
+extern void Timer_A_clearCaptureCompareInterrupt(uint32_t timer,
+                                                 uint_fast16_t captureCompareRegister);
+
+//*****************************************************************************
+//
+// EUSCI_A UART, for the trace recorder
+//
+//*****************************************************************************
+#define EUSCI_A0_BASE                   (0x40001000)
+#define INT_EUSCIA0                     (32)
+
+#define EUSCI_A_UART_CLOCKSOURCE_SMCLK  (0x0080)
+#define EUSCI_A_UART_NO_PARITY          (0x00)
+#define EUSCI_A_UART_LSB_FIRST          (0x00)
+#define EUSCI_A_UART_ONE_STOP_BIT       (0x00)
+#define EUSCI_A_UART_MODE               (0x00)
+#define EUSCI_A_UART_OVERSAMPLING_BAUDRATE_GENERATION (0x01)
+#define EUSCI_A_UART_8_BIT_LEN          (0x00)
+
+#define EUSCI_A_UART_TRANSMIT_INTERRUPT (0x0002)
+#define EUSCI_A_UART_TRANSMIT_COMPLETE_INTERRUPT (0x0008)
+#define EUSCI_A_UART_TRANSMIT_INTERRUPT_FLAG (0x0002)
+#define EUSCI_A_UART_TRANSMIT_COMPLETE_INTERRUPT_FLAG (0x0008)
+#define EUSCI_A_UART_BUSY               (0x0001)
+
+typedef struct _eUSCI_eUSCI_UART_ConfigV1
+{
+    uint_fast8_t selectClockSource;
+    uint_fast16_t clockPrescalar;
+    uint_fast8_t firstModReg;
+    uint_fast8_t secondModReg;
+    uint_fast8_t parity;
+    uint_fast16_t msborLsbFirst;
+    uint_fast16_t numberofStopBits;
+    uint_fast16_t uartMode;
+    uint_fast8_t overSampling;
+    uint_fast16_t dataLength;
+} eUSCI_UART_ConfigV1;
+
+extern void GPIO_setAsPeripheralModuleFunctionInputPin(uint_fast8_t port,
+        uint_fast16_t pins, uint_fast8_t mode);
+extern bool UART_initModule(uint32_t moduleInstance,
+                            const eUSCI_UART_ConfigV1 *config);
+extern void UART_enableModule(uint32_t moduleInstance);
+extern void UART_transmitData(uint32_t moduleInstance, uint_fast8_t transmitData);
+extern void UART_enableInterrupt(uint32_t moduleInstance, uint_fast8_t mask);
+extern void UART_disableInterrupt(uint32_t moduleInstance, uint_fast8_t mask);
+extern uint_fast8_t UART_getEnabledInterruptStatus(uint32_t moduleInstance);
+extern void UART_clearInterruptFlag(uint32_t moduleInstance, uint_fast8_t mask);
+extern uint_fast8_t UART_queryStatusFlags(uint32_t moduleInstance,
+                                          uint_fast8_t mask);
+
+//*****************************************************************************
+//
+// PCM low-power modes
+//
+//*****************************************************************************
+extern bool PCM_gotoLPM0(void);
+extern bool PCM_gotoLPM3(void);
+
+//*****************************************************************************
+//
+// NVIC
+//
+//*****************************************************************************
+extern void Interrupt_enableInterrupt(uint32_t interruptNumber);
+extern void Interrupt_pendInterrupt(uint32_t interruptNumber);
+extern void Interrupt_unpendInterrupt(uint32_t interruptNumber);
+extern bool Interrupt_disableMaster(void);
+extern bool Interrupt_enableMaster(void);
+extern uint32_t __get_PRIMASK(void);
+
+//*****************************************************************************
+//
+// DWT cycle counter.  Every read advances it a little, as a polling loop
+// would, and every byte on the bus advances it by its transmit time.
+//
+//*****************************************************************************
+typedef struct
+{
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+extern DWT_Type *HostLcd_readDWT(void);
+extern CoreDebug_Type HostLcd_CoreDebug;
+
+#define DWT                             (HostLcd_readDWT())
+#define CoreDebug                       (&HostLcd_CoreDebug)
+#define DWT_CTRL_CYCCNTENA_Msk          (0x00000001)
+#define CoreDebug_DEMCR_TRCENA_Msk      (0x01000000)
+
+#endif /* HOST_DRIVERLIB_H_ */
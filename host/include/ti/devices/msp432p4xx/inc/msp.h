@@ -0,0 +1,13 @@
+/*
+ * msp.h (host stand-in)
+ *
+ * Register definitions for host builds.  Everything lives in the driverlib
+ * stand-in; see include/ti/devices/msp432p4xx/driverlib/driverlib.h.
+ */
+
+#ifndef HOST_MSP_H_
+#define HOST_MSP_H_
+
+#include <ti/devices/msp432p4xx/driverlib/driverlib.h>
+
+#endif /* HOST_MSP_H_ */
@@ -0,0 +1,124 @@
+/*
+ * grlib.h (host stand-in)
+ *
+ * The subset of the MSP Graphics Library used by the display driver, the text
+ * renderer and the game's screens, laid out like grlib 3.x so driver tables
+ * and Screens.c compile unchanged on the host.  HostGrlib.c implements the
+ * calls, HostFonts.c the fonts.
+ */
+
+#ifndef HOST_GRLIB_H_
+#define HOST_GRLIB_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct Graphics_Rectangle
+{
+    int16_t xMin;
+    int16_t yMin;
+    int16_t xMax;
+    int16_t yMax;
+} Graphics_Rectangle;
+
+// Legacy member names still used by older drivers
+#define sXMin xMin
+#define sYMin yMin
+#define sXMax xMax
+#define sYMax yMax
+
+typedef struct Graphics_Display_Functions Graphics_Display_Functions;
+
+typedef struct Graphics_Display
+{
+    int32_t size;
+    void *displayData;
+    uint16_t width;
+    uint16_t heigth;
+    const Graphics_Display_Functions *pFxns;    // set by Graphics_initContext()
+} Graphics_Display;
+
+struct Graphics_Display_Functions
+{
+    void (*pfnPixelDraw)(const Graphics_Display *display, int16_t x, int16_t y,
+                         uint16_t value);
+    void (*pfnPixelDrawMultiple)(const Graphics_Display *display, int16_t x,
+                                 int16_t y, int16_t x0, int16_t count,
+                                 int16_t bPP, const uint8_t *data,
+                                 const uint32_t *pucPalette);
+    void (*pfnLineDrawH)(const Graphics_Display *display, int16_t x1,
+                         int16_t x2, int16_t y, uint16_t value);
+    void (*pfnLineDrawV)(const Graphics_Display *display, int16_t x,
+                         int16_t y1, int16_t y2, uint16_t value);
+    void (*pfnRectFill)(const Graphics_Display *display,
+                        const Graphics_Rectangle *rect, uint16_t value);
+    uint32_t (*pfnColorTranslate)(const Graphics_Display *display,
+                                  uint32_t value);
+    void (*pfnFlush)(const Graphics_Display *display);
+    void (*pfnClearDisplay)(const Graphics_Display *display, uint16_t value);
+};
+
+typedef struct Graphics_Font
+{
+    uint8_t format;
+    uint8_t maxWidth;
+    uint8_t height;
+    uint8_t baseline;
+    uint16_t offset[96];
+    const uint8_t *data;
+} Graphics_Font;
+
+#define FONT_FMT_UNCOMPRESSED           0x00
+#define FONT_FMT_PIXEL_RLE              0x01
+#define FONT_EX_MARKER                  0x80
+
+typedef struct Graphics_Context
+{
+    int32_t size;
+    const Graphics_Display *display;
+    Graphics_Rectangle clipRegion;
+    uint32_t foreground;
+    uint32_t background;
+    const Graphics_Font *font;
+} Graphics_Context;
+
+#define AUTO_STRING_LENGTH              -1
+#define OPAQUE_TEXT                     1
+#define TRANSPARENT_TEXT                0
+
+#define GRAPHICS_COLOR_BLACK            0x00000000
+#define GRAPHICS_COLOR_RED              0x00FF0000
+#define GRAPHICS_COLOR_WHITE            0x00FFFFFF
+
+// The fonts the firmware uses.  Their glyphs are synthetic, with roughly the
+// SDK fonts' metrics, and are only valid after HostFonts_init().
+extern Graphics_Font g_sFontFixed6x8;
+extern Graphics_Font g_sFontCmss12i;
+extern Graphics_Font g_sFontCmss18b;
+extern Graphics_Font g_sFontCmss24b;
+
+#define GrContextFontSet                Graphics_setFont
+
+extern void Graphics_initContext(Graphics_Context *context,
+                                 Graphics_Display *display,
+                                 const Graphics_Display_Functions *pFxns);
+extern void Graphics_setForegroundColor(Graphics_Context *context,
+                                        int32_t value);
+extern void Graphics_setBackgroundColor(Graphics_Context *context,
+                                        int32_t value);
+extern void Graphics_setFont(Graphics_Context *context,
+                             const Graphics_Font *font);
+extern void Graphics_clearDisplay(const Graphics_Context *context);
+extern void Graphics_flushBuffer(const Graphics_Context *context);
+extern int32_t Graphics_getStringWidth(const Graphics_Context *context,
+                                       const int8_t *string, int32_t length);
+extern void Graphics_drawString(const Graphics_Context *context,
+                                int8_t *string, int32_t length, int32_t x,
+                                int32_t y, bool opaque);
+extern void Graphics_drawStringCentered(const Graphics_Context *context,
+                                        int8_t *string, int32_t length,
+                                        int32_t x, int32_t y, bool opaque);
+extern void Graphics_fillRectangle(const Graphics_Context *context,
+                                   const Graphics_Rectangle *rect);
+
+#endif /* HOST_GRLIB_H_ */
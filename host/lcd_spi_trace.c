@@ -0,0 +1,747 @@
+/*
+ * lcd_spi_trace.c
+ *
+ * Runs the Crystalfontz128x128 driver primitives against the HostLcd register
+ * stand-in and the St7735Emu panel model, and reports, per primitive, how many
+ * command and data bytes went out on the bus and how many of them were moved
+ * by the uDMA.  Each span is checked against the number of data bytes its
+ * window needs, and the panel model flags pixels written past a window,
+ * spans ending mid-pixel and malformed windows.  A simulated
+ * word change (blank line, then the new word) is run once straight to the
+ * panel and once through the framebuffer to compare bus traffic.  Finally,
+ * opaque text drawn through grlib's glyph walk and through the FontAtlas
+ * blitter is decoded back into pixels and compared, for a run-length and an
+ * uncompressed synthetic font, and words drawn from the WordCache are checked
+ * against the same words drawn through the FontAtlas.  The primitives are
+ * then run again in RGB444, and a scene drawn in both colour modes is
+ * checked to decode to the same colours.  Partial mode is checked to show
+ * and flush only its band of rows.  Turning the buffered display is checked
+ * to show the same as a full repaint in the new orientation, while sending
+ * only the tiles that differ.
+ *
+ * Usage: lcd_spi_trace [-v] [-p dir]
+ *   -v      also dump every byte: C/D, hex, DMA flag
+ *   -p dir  write the panel contents after each check to dir/<name>.ppm
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <ti/grlib/grlib.h>
+#include <HAL/LcdDriver/Crystalfontz128x128_ST7735.h>
+#include <HAL/FontAtlas.h>
+#include <HAL/WordCache.h>
+#include "HostFonts.h"
+#include "HostLcd.h"
+#include "St7735Emu.h"
+
+typedef uint32_t Screen[ST7735EMU_HEIGHT][ST7735EMU_WIDTH];
+
+static bool verbose;
+static const char *ppmDir;
+static int failures;
+
+// Writes the panel contents to ppmDir/<name>.ppm, name lower-cased with
+// anything but letters and digits turned into '_'
+static void snapshot(const char *name)
+{
+    char path[256];
+    int length, i;
+
+    if (!ppmDir)
+    {
+        return;
+    }
+
+    length = snprintf(path, sizeof(path) - 4, "%s/", ppmDir);
+    for (i = 0; name[i] && (length < (int) sizeof(path) - 5); i++)
+    {
+        char c = name[i];
+        path[length++] = ((c >= 'A') && (c <= 'Z')) ? (c - 'A' + 'a') :
+                         (((c >= 'a') && (c <= 'z')) || ((c >= '0') && (c <= '9'))) ? c : '_';
+    }
+    strcpy(&path[length], ".ppm");
+
+    if (!St7735Emu_writePpm(path))
+    {
+        printf("    cannot write %s\n", path);
+        failures++;
+    }
+}
+
+static void report(const char *name, uint32_t expectedData)
+{
+    HostLcd_Stats stats = HostLcd_getStats();
+    uint32_t i, length, pixelData = 0, caset = 0, raset = 0, ramwr = 0;
+    const HostLcd_Byte *log = HostLcd_getLog(&length);
+    uint8_t command = CM_NOP;
+
+    // Pixel data is whatever follows a RAMWR
+    for (i = 0; i < length; i++)
+    {
+        if (!log[i].isData)
+        {
+            command = log[i].value;
+            caset += (command == CM_CASET);
+            raset += (command == CM_RASET);
+            ramwr += (command == CM_RAMWR);
+        }
+        else if (command == CM_RAMWR)
+        {
+            pixelData++;
+        }
+    }
+    St7735Emu_Stats panel = St7735Emu_endFrame();
+    bool protocolOk = !panel.windowOverruns && !panel.partialPixels &&
+                      !panel.badWindows && !panel.unknownCommands;
+    bool ok = protocolOk && !stats.dmaMissedRequests &&
+              ((expectedData == 0) || (pixelData == expectedData));
+
+    printf("%-22s cmd=%-3u data=%-6u caset=%-3u raset=%-3u ramwr=%-3u "
+           "dc=%-3u dma=%-6u transfers=%-4u irq=%-4u %s\n",
+           name, stats.commandBytes, stats.dataBytes, caset, raset, ramwr,
+           panel.dcToggles, stats.dmaBytes, stats.dmaTransfers,
+           stats.dmaInterrupts, ok ? "ok" : "MISMATCH");
+    if (!ok)
+    {
+        printf("    expected %u pixel data bytes, saw %u; panel saw %u window "
+               "overruns, %u partial pixels, %u bad windows, %u unknown "
+               "commands; %u uDMA requests missed\n", expectedData, pixelData,
+               panel.windowOverruns, panel.partialPixels, panel.badWindows,
+               panel.unknownCommands, stats.dmaMissedRequests);
+        failures++;
+    }
+    snapshot(name);
+
+    if (verbose)
+    {
+        for (i = 0; i < length; i++)
+        {
+            printf("    %c %02X%s\n", log[i].isData ? 'D' : 'C', log[i].value,
+                   log[i].viaDma ? " dma" : "");
+        }
+    }
+    HostLcd_reset();
+}
+
+// Draws a line of 1bpp glyphs row by row, the way opaque text reaches the
+// driver: one PixelDrawMultiple per glyph row
+static void drawGlyphLine(int16_t x, int16_t y, int16_t glyphs, int16_t width)
+{
+    static const uint8_t glyph[2] = {0x3C, 0x66};
+    static const uint32_t palette[2] = {0xFFFF, 0xF800};
+    int16_t g, row;
+
+    for (g = 0; g < glyphs; g++, x += width)
+    {
+        for (row = 0; row < 24; row++)
+        {
+            int16_t count = width;
+            if (x + count > 128)
+            {
+                count = 128 - x;
+            }
+            if (count > 0)
+            {
+                g_sCrystalfontz128x128_funcs.pfnPixelDrawMultiple(
+                        &g_sCrystalfontz128x128, x, y + row, 0, count, 1,
+                        glyph, palette);
+            }
+        }
+    }
+}
+
+static void wordChange(void)
+{
+    drawGlyphLine(0, 53, 11, 12);
+    drawGlyphLine(16, 53, 8, 12);
+    g_sCrystalfontz128x128_funcs.pfnFlush(&g_sCrystalfontz128x128);
+}
+
+static uint32_t busBytes(void)
+{
+    HostLcd_Stats stats = HostLcd_getStats();
+    return stats.commandBytes + stats.dataBytes;
+}
+
+// Protocol errors the panel model has seen outside report()
+static uint32_t panelErrors;
+
+// Ends the panel model's frame and adds up its protocol errors
+static void checkPanel(void)
+{
+    St7735Emu_Stats panel = St7735Emu_endFrame();
+
+    panelErrors += panel.windowOverruns + panel.partialPixels +
+                   panel.badWindows + panel.unknownCommands;
+}
+
+//*****************************************************************************
+//
+// Test fonts: the same synthetic glyphs run-length encoded and uncompressed
+//
+//*****************************************************************************
+#define TEST_FONT_HEIGHT   20
+#define TEST_FONT_BASELINE 15
+#define TEST_FONT_WIDTH    14
+
+static uint8_t rleData[HOSTFONTS_DATA_SIZE], rawData[HOSTFONTS_DATA_SIZE];
+static Graphics_Font rleFont, rawFont;
+
+static void buildFonts(void)
+{
+    HostFonts_build(&rleFont, rleData, FONT_FMT_PIXEL_RLE, TEST_FONT_WIDTH,
+                    TEST_FONT_HEIGHT, TEST_FONT_BASELINE, false);
+    HostFonts_build(&rawFont, rawData, FONT_FMT_UNCOMPRESSED, TEST_FONT_WIDTH,
+                    TEST_FONT_HEIGHT, TEST_FONT_BASELINE, false);
+}
+
+enum { PATH_GRLIB, PATH_ATLAS, PATH_CACHE };
+
+// Draws text through one path into a cleared panel and returns its bus bytes
+static uint32_t drawText(const Graphics_Context *context, int path,
+                         const char *text, int32_t x, int32_t y,
+                         Screen screen)
+{
+    uint32_t bytes;
+
+    g_sCrystalfontz128x128_funcs.pfnClearDisplay(&g_sCrystalfontz128x128,
+                                                 0x0000);
+    g_sCrystalfontz128x128_funcs.pfnFlush(&g_sCrystalfontz128x128);
+    HostLcd_reset();
+    if (path == PATH_CACHE)
+    {
+        WordCache_drawCentered(context, text, x, y, 0, LCD_HORIZONTAL_MAX - 1);
+    }
+    else if (path == PATH_ATLAS)
+    {
+        FontAtlas_drawString(context, text, x, y);
+    }
+    else
+    {
+        Graphics_drawString((Graphics_Context *) context, (int8_t *) text,
+                            AUTO_STRING_LENGTH, x, y, OPAQUE_TEXT);
+    }
+    g_sCrystalfontz128x128_funcs.pfnFlush(&g_sCrystalfontz128x128);
+    bytes = busBytes();
+    HostLcd_reset();
+    checkPanel();
+
+    St7735Emu_getScreen(screen);
+    return bytes;
+}
+
+static void compareText(const char *name, const Graphics_Font *font,
+                        const char *text, int32_t x, int32_t y)
+{
+    static Screen viaGrlib, viaAtlas;
+    Graphics_Context context = {
+        sizeof(Graphics_Context), &g_sCrystalfontz128x128,
+        {0, 0, LCD_HORIZONTAL_MAX - 1, LCD_VERTICAL_MAX - 1},
+        0xF800, 0xFFFF, font
+    };
+
+    uint32_t grlib = drawText(&context, PATH_GRLIB, text, x, y, viaGrlib);
+    uint32_t atlas = drawText(&context, PATH_ATLAS, text, x, y, viaAtlas);
+    bool ok = (memcmp(viaGrlib, viaAtlas, sizeof(viaGrlib)) == 0) &&
+              (panelErrors == 0);
+
+    printf("%-22s grlib=%-6u atlas=%-6u saved=%d%% %s\n", name, grlib, atlas,
+           (int)(100 - (100 * atlas) / grlib), ok ? "ok" : "PIXEL MISMATCH");
+    snapshot(name);
+    if (!ok)
+    {
+        failures++;
+    }
+}
+
+// Draws each word of a list through the cache and through the atlas, and
+// checks the pixels agree
+static void compareWords(const char *name, const char *const *words, int count,
+                         int rounds)
+{
+    static Screen viaAtlas, viaCache;
+    Graphics_Context context = {
+        sizeof(Graphics_Context), &g_sCrystalfontz128x128,
+        {0, 0, LCD_HORIZONTAL_MAX - 1, LCD_VERTICAL_MAX - 1},
+        0x001F, 0xFFFF, &rleFont
+    };
+    WordCache_Stats before = WordCache_getStats(), after;
+    bool ok = true;
+    int i;
+
+    for (i = 0; i < count * rounds; i++)
+    {
+        const char *word = words[i % count];
+        int32_t left = 65 - FontAtlas_getStringWidth(&rleFont, word) / 2;
+
+        g_sCrystalfontz128x128_funcs.pfnClearDisplay(&g_sCrystalfontz128x128,
+                                                     0x0000);
+        FontAtlas_drawStringField(&context, word, left,
+                                  65 - rleFont.baseline / 2, 0,
+                                  LCD_HORIZONTAL_MAX - 1);
+        HostLcd_reset();
+        St7735Emu_getScreen(viaAtlas);
+
+        drawText(&context, PATH_CACHE, word, 65, 65, viaCache);
+        ok = ok && (memcmp(viaAtlas, viaCache, sizeof(viaAtlas)) == 0);
+    }
+    ok = ok && (panelErrors == 0);
+
+    after = WordCache_getStats();
+    printf("%-22s hits=%-4u misses=%-4u evictions=%-4u %s\n", name,
+           after.hits - before.hits, after.misses - before.misses,
+           after.evictions - before.evictions, ok ? "ok" : "PIXEL MISMATCH");
+    snapshot(name);
+    if (!ok)
+    {
+        failures++;
+    }
+}
+
+// Draws a scene with every primitive, odd lengths included, in one colour
+// mode and returns its bus bytes; screen receives the decoded GRAM
+static uint32_t drawScene(uint8_t mode, bool buffered, Screen screen)
+{
+    const Graphics_Display *display = &g_sCrystalfontz128x128;
+    const Graphics_Display_Functions *fxns = &g_sCrystalfontz128x128_funcs;
+    static const uint8_t bits[4] = {0xF0, 0x3C, 0xA5, 0x81};
+    uint32_t palette[2], bytes;
+    int16_t x;
+
+    Crystalfontz128x128_SetColorMode(mode);
+    Crystalfontz128x128_SetBuffered(buffered);
+    HostLcd_reset();
+
+    palette[0] = fxns->pfnColorTranslate(display, 0x204080);
+    palette[1] = fxns->pfnColorTranslate(display, 0xF0E0D0);
+
+    Graphics_Rectangle all = {0, 0, 127, 127};
+    fxns->pfnRectFill(display, &all, fxns->pfnColorTranslate(display, 0xFFFFFF));
+    Graphics_Rectangle box = {3, 7, 43, 30};
+    fxns->pfnRectFill(display, &box, fxns->pfnColorTranslate(display, 0xFF8000));
+    fxns->pfnLineDrawH(display, 1, 101, 40, fxns->pfnColorTranslate(display, 0x00FF00));
+    fxns->pfnLineDrawV(display, 90, 2, 118, fxns->pfnColorTranslate(display, 0x0000FF));
+    fxns->pfnPixelDrawMultiple(display, 5, 50, 1, 29, 1, bits, palette);
+    for (x = 20; x < 27; x++)
+    {
+        fxns->pfnPixelDraw(display, x, 60, fxns->pfnColorTranslate(display, 0x123456));
+    }
+    Crystalfontz128x128_BlitMono(9, 70, 39, 81, bits, 0, palette[1], palette[0]);
+    fxns->pfnFlush(display);
+
+    bytes = busBytes();
+    Crystalfontz128x128_SetBuffered(false);
+    HostLcd_reset();
+    checkPanel();
+    St7735Emu_getScreen(screen);
+
+    return bytes;
+}
+
+// Draws a marker at the top-left corner of the screen in each orientation
+// and checks where the panel shows it
+static void checkOrientations(void)
+{
+    static const struct
+    {
+        uint8_t orientation;
+        const char *name;
+        int x, y;           // where screen (1, 2) appears on the panel
+    } cases[4] = {
+        { LCD_ORIENTATION_UP, "up", 1, 2 },
+        { LCD_ORIENTATION_LEFT, "left", 127 - 2, 1 },
+        { LCD_ORIENTATION_DOWN, "down", 127 - 1, 127 - 2 },
+        { LCD_ORIENTATION_RIGHT, "right", 2, 127 - 1 },
+    };
+    const Graphics_Display_Functions *fxns = &g_sCrystalfontz128x128_funcs;
+    bool ok = true;
+    int i;
+
+    for (i = 0; i < 4; i++)
+    {
+        Crystalfontz128x128_SetOrientation(cases[i].orientation);
+        fxns->pfnClearDisplay(&g_sCrystalfontz128x128, 0x0000);
+        fxns->pfnPixelDraw(&g_sCrystalfontz128x128, 1, 2, 0xFFFF);
+        HostLcd_reset();
+        checkPanel();
+        if (St7735Emu_getPixel(cases[i].x, cases[i].y) != 0xFFFFFF)
+        {
+            printf("    screen (1, 2) is not at panel (%d, %d) when %s\n",
+                   cases[i].x, cases[i].y, cases[i].name);
+            ok = false;
+        }
+    }
+    Crystalfontz128x128_SetOrientation(LCD_ORIENTATION_UP);
+    HostLcd_reset();
+    St7735Emu_endFrame();
+
+    ok = ok && (panelErrors == 0);
+    printf("%-22s %s\n", "Orientations", ok ? "ok" : "MISMATCH");
+    snapshot("Orientations");
+    if (!ok)
+    {
+        failures++;
+    }
+}
+
+// Fills the buffered screen while the panel is limited to rows 24..119, then
+// returns to normal mode, checking which rows each flush sends and which rows
+// the panel shows, upright and upside down.  Turned sideways the band would
+// be a column strip, which the controller cannot do.
+static void checkPartial(void)
+{
+    static const struct
+    {
+        uint8_t orientation;
+        const char *name;
+        int top, bottom;    // where screen rows 24..119 appear on the panel
+    } cases[2] = {
+        { LCD_ORIENTATION_UP, "up", 24, 119 },
+        { LCD_ORIENTATION_DOWN, "down", 127 - 119, 127 - 24 },
+    };
+    const Graphics_Display_Functions *fxns = &g_sCrystalfontz128x128_funcs;
+    uint32_t bandBytes = 0, restBytes = 0;
+    bool ok = true;
+    int i, y;
+
+    Crystalfontz128x128_SetBuffered(true);
+    for (i = 0; i < 2; i++)
+    {
+        Crystalfontz128x128_SetOrientation(cases[i].orientation);
+        fxns->pfnClearDisplay(&g_sCrystalfontz128x128, 0x0000);
+        fxns->pfnFlush(&g_sCrystalfontz128x128);
+        HostLcd_reset();
+
+        ok = ok && Crystalfontz128x128_SetPartialArea(24, 119) &&
+             St7735Emu_isPartial();
+        fxns->pfnClearDisplay(&g_sCrystalfontz128x128, 0xF800);
+        fxns->pfnFlush(&g_sCrystalfontz128x128);
+        bandBytes = HostLcd_getStats().dataBytes;
+        HostLcd_reset();
+        for (y = 0; y < ST7735EMU_HEIGHT; y++)
+        {
+            bool inBand = (y >= cases[i].top) && (y <= cases[i].bottom);
+            bool blank = St7735Emu_getPixel(64, y) == ST7735EMU_BLANK;
+            if (inBand == blank)
+            {
+                printf("    panel row %d %s when %s\n", y,
+                       blank ? "blank in the band" : "shown outside the band",
+                       cases[i].name);
+                ok = false;
+                break;
+            }
+        }
+
+        Crystalfontz128x128_SetNormalMode();
+        restBytes = HostLcd_getStats().dataBytes;
+        HostLcd_reset();
+        ok = ok && !St7735Emu_isPartial() &&
+             (St7735Emu_getPixel(64, 0) == St7735Emu_getPixel(64, 64)) &&
+             (St7735Emu_getPixel(64, 127) == St7735Emu_getPixel(64, 64));
+        checkPanel();
+    }
+
+    Crystalfontz128x128_SetOrientation(LCD_ORIENTATION_LEFT);
+    ok = ok && !Crystalfontz128x128_SetPartialArea(24, 119) &&
+         !St7735Emu_isPartial();
+    Crystalfontz128x128_SetOrientation(LCD_ORIENTATION_UP);
+    Crystalfontz128x128_SetBuffered(false);
+    HostLcd_reset();
+    checkPanel();
+
+    // A full-screen fill sends the 96 rows of the band (after PTLAR and a
+    // RASET), then the other 32 as two rectangles (a RASET each)
+    ok = ok && (bandBytes == 128 * 96 * 2 + 4 + 4) &&
+         (restBytes == 128 * 32 * 2 + 2 * 4) && (panelErrors == 0);
+    printf("%-22s band=%-6u rest=%-6u %s\n", "Partial rows 24..119",
+           bandBytes, restBytes, ok ? "ok" : "MISMATCH");
+    snapshot("Partial");
+    if (!ok)
+    {
+        failures++;
+    }
+}
+
+// Checks a scene decodes to the same colours in RGB565 and RGB444, once
+// drawn straight to the panel and once through the framebuffer
+static void compareModes(const char *name, bool buffered)
+{
+    static Screen via565, via444;
+    uint32_t bytes565 = drawScene(LCD_COLOR_MODE_RGB565, buffered, via565);
+    uint32_t bytes444 = drawScene(LCD_COLOR_MODE_RGB444, buffered, via444);
+    bool ok = true;
+    int x, y;
+
+    // Both widen to 8 bits per channel; the top four must agree
+    for (y = 0; y < ST7735EMU_HEIGHT; y++)
+    {
+        for (x = 0; x < ST7735EMU_WIDTH; x++)
+        {
+            ok = ok && (((via565[y][x] ^ via444[y][x]) & 0xF0F0F0) == 0);
+        }
+    }
+    ok = ok && (panelErrors == 0);
+
+    printf("%-22s rgb565=%-6u rgb444=%-6u saved=%d%% %s\n", name, bytes565,
+           bytes444, (int)(100 - (100 * bytes444) / bytes565),
+           ok ? "ok" : "PIXEL MISMATCH");
+    snapshot(name);
+    if (!ok)
+    {
+        failures++;
+    }
+    Crystalfontz128x128_SetColorMode(LCD_COLOR_MODE_RGB565);
+    HostLcd_reset();
+}
+
+// Turns the buffered display a half and a quarter turn each way, with a line
+// of text on it, then twice with the screen blank.  After each
+// turn's flush the panel must show what a full repaint shows, for fewer
+// bytes; a blank screen must only cost the MADCTL write.
+static void checkTurned(void)
+{
+    static const struct
+    {
+        uint8_t from, to;
+        const char *name;
+    } cases[4] = {
+        { LCD_ORIENTATION_UP, LCD_ORIENTATION_DOWN, "up to down" },
+        { LCD_ORIENTATION_UP, LCD_ORIENTATION_LEFT, "up to left" },
+        { LCD_ORIENTATION_UP, LCD_ORIENTATION_RIGHT, "up to right" },
+        { LCD_ORIENTATION_LEFT, LCD_ORIENTATION_UP, "left to up" },
+    };
+    const Graphics_Display_Functions *fxns = &g_sCrystalfontz128x128_funcs;
+    static Screen turned, repainted;
+    uint32_t turnBytes[4], fullBytes = 0, blankBytes = 0;
+    bool ok = true;
+    int i;
+
+    Crystalfontz128x128_SetBuffered(true);
+    for (i = 0; i < 4; i++)
+    {
+        Crystalfontz128x128_SetOrientation(cases[i].from);
+        fxns->pfnClearDisplay(&g_sCrystalfontz128x128, 0xFFFF);
+        drawGlyphLine(16, 53, 8, 12);
+        fxns->pfnFlush(&g_sCrystalfontz128x128);
+        HostLcd_reset();
+        checkPanel();
+
+        Crystalfontz128x128_SetOrientation(cases[i].to);
+        fxns->pfnFlush(&g_sCrystalfontz128x128);
+        turnBytes[i] = busBytes();
+        HostLcd_reset();
+        checkPanel();
+        St7735Emu_getScreen(turned);
+
+        Crystalfontz128x128_SetBuffered(false);
+        Crystalfontz128x128_SetBuffered(true);
+        fxns->pfnFlush(&g_sCrystalfontz128x128);
+        fullBytes = busBytes();
+        HostLcd_reset();
+        checkPanel();
+        St7735Emu_getScreen(repainted);
+
+        if (memcmp(turned, repainted, sizeof(Screen)) != 0)
+        {
+            printf("    turned %s does not match a repaint\n", cases[i].name);
+            ok = false;
+        }
+        ok = ok && (turnBytes[i] < fullBytes);
+    }
+
+    fxns->pfnClearDisplay(&g_sCrystalfontz128x128, 0xFFFF);
+    fxns->pfnFlush(&g_sCrystalfontz128x128);
+    HostLcd_reset();
+    Crystalfontz128x128_SetOrientation(LCD_ORIENTATION_LEFT);
+    Crystalfontz128x128_SetOrientation(LCD_ORIENTATION_UP);
+    fxns->pfnFlush(&g_sCrystalfontz128x128);
+    blankBytes = busBytes();
+    HostLcd_reset();
+    Crystalfontz128x128_SetBuffered(false);
+    checkPanel();
+
+    ok = ok && (blankBytes == 2 * 2) && (panelErrors == 0);
+    printf("%-22s half=%-5u left=%-5u right=%-5u back=%-5u full=%-6u "
+           "blank=%u %s\n", "Turned", turnBytes[0], turnBytes[1],
+           turnBytes[2], turnBytes[3], fullBytes, blankBytes,
+           ok ? "ok" : "MISMATCH");
+    snapshot("Turned");
+    if (!ok)
+    {
+        failures++;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const Graphics_Display *display = &g_sCrystalfontz128x128;
+    const Graphics_Display_Functions *fxns = &g_sCrystalfontz128x128_funcs;
+    static const uint8_t glyphRow[16] = {0xF0, 0x0F, 0xAA, 0x55, 0xFF, 0x00,
+                                         0x81, 0x18, 0xF0, 0x0F, 0xAA, 0x55,
+                                         0xFF, 0x00, 0x81, 0x18};
+    static const uint32_t palette[2] = {0xFFFF, 0xF800};
+
+    int arg;
+
+    for (arg = 1; arg < argc; arg++)
+    {
+        if (strcmp(argv[arg], "-v") == 0)
+        {
+            verbose = true;
+        }
+        else if ((strcmp(argv[arg], "-p") == 0) && (arg + 1 < argc))
+        {
+            ppmDir = argv[++arg];
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-v] [-p dir]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    St7735Emu_attach();
+
+    // Boot runs with interrupts masked, so the driver has to complete the
+    // uDMA fill without its interrupt
+    uint32_t polls = 1, initStart = DWT->CYCCNT;
+    Interrupt_disableMaster();
+    Crystalfontz128x128_StartInit();
+    while (!Crystalfontz128x128_PollInit())
+    {
+        polls++;
+    }
+    uint32_t initCycles = DWT->CYCCNT - initStart;
+    HostLcd_Stats initStats = HostLcd_getStats();
+    report("Init (masked, polled)", 0);
+    printf("    %u polls, %u us, %u of %u fill chunks completed by polling\n",
+           polls, initCycles / 48, initStats.dmaPolled,
+           initStats.dmaTransfers);
+    if ((initStats.dmaPolled != initStats.dmaTransfers) ||
+        St7735Emu_isSleeping() || !St7735Emu_isDisplayOn() ||
+        (St7735Emu_getColorMode() != LCD_COLOR_MODE))
+    {
+        printf("    panel not awake, on and in colour mode %02X\n",
+               LCD_COLOR_MODE);
+        failures++;
+    }
+    Interrupt_enableMaster();
+
+    Crystalfontz128x128_SetOrientation(LCD_ORIENTATION_UP);
+    report("SetOrientation", 0);
+
+    Graphics_Rectangle screen = {0, 0, 127, 127};
+    fxns->pfnRectFill(display, &screen, 0xF800);
+    report("RectFill 128x128", 128 * 128 * 2);
+
+    Graphics_Rectangle box = {10, 20, 29, 27};
+    fxns->pfnRectFill(display, &box, 0x1234);
+    report("RectFill 20x8", 20 * 8 * 2);
+
+    fxns->pfnLineDrawH(display, 5, 100, 64, 0x07E0);
+    report("LineDrawH 96", 96 * 2);
+
+    fxns->pfnLineDrawV(display, 64, 0, 127, 0x001F);
+    report("LineDrawV 128", 128 * 2);
+
+    fxns->pfnPixelDrawMultiple(display, 0, 10, 0, 128, 1, glyphRow, palette);
+    report("PixelDrawMultiple 128", 128 * 2);
+
+    fxns->pfnPixelDraw(display, 3, 4, 0xFFFF);
+    report("PixelDraw", 2);
+
+    int16_t x;
+    for (x = 40; x < 72; x++)
+    {
+        fxns->pfnPixelDraw(display, x, 4, 0x0F0F);
+    }
+    report("PixelDraw run of 32", 32 * 2);
+
+    // Commands between adjacent pixels end the run, so each pixel after one
+    // starts a RAMWR of its own
+    fxns->pfnPixelDraw(display, 40, 6, 0x0F0F);
+    Crystalfontz128x128_SetPartialArea(24, 119);
+    fxns->pfnPixelDraw(display, 41, 6, 0x0F0F);
+    Crystalfontz128x128_SetColorMode(LCD_COLOR_MODE_RGB565);
+    fxns->pfnPixelDraw(display, 42, 6, 0x0F0F);
+    Crystalfontz128x128_SetNormalMode();
+    fxns->pfnPixelDraw(display, 43, 6, 0x0F0F);
+    report("PixelDraw across cmds", 4 * 2);
+
+    fxns->pfnLineDrawH(display, 0, 127, 70, 0x07E0);
+    fxns->pfnLineDrawH(display, 0, 127, 70, 0xF800);
+    report("LineDrawH same window", 2 * 128 * 2);
+
+    fxns->pfnClearDisplay(display, 0x0000);
+    report("ClearDisplay", 128 * 128 * 2);
+
+    wordChange();
+    uint32_t direct = busBytes();
+    HostLcd_reset();
+
+    Crystalfontz128x128_SetBuffered(true);
+    fxns->pfnFlush(display);
+    HostLcd_reset();
+    wordChange();
+    uint32_t buffered = busBytes();
+    HostLcd_reset();
+    Crystalfontz128x128_SetBuffered(false);
+
+    printf("%-22s direct=%u buffered=%u saved=%d%%\n", "Word change", direct,
+           buffered, (int)(100 - (100 * buffered) / direct));
+
+    buildFonts();
+    compareText("Text RLE", &rleFont, "Astronaut", 4, 50);
+    compareText("Text uncompressed", &rawFont, "Astronaut", 4, 50);
+    compareText("Text clipped", &rleFont, "Superhero Wq~", -7, 120);
+    compareText("Text absent glyph", &rleFont, "A\tB", 30, 0);
+    Crystalfontz128x128_SetBuffered(true);
+    compareText("Text buffered", &rleFont, "Fireworks", 2, 60);
+    Crystalfontz128x128_SetBuffered(false);
+
+    static const char *const words[12] = {
+        "elephant", "Robot", "Pirate", "Chef", "Lion", "Ghost",
+        "Doctor", "Spider", "Rainbow", "Bowling", "Magician", "Campfire"
+    };
+    compareWords("WordCache 4 words", words, 4, 5);
+    WordCache_clear();
+    compareWords("WordCache 12 words", words, 12, 2);
+
+    checkOrientations();
+    checkPartial();
+    checkTurned();
+    compareModes("Scene direct", false);
+    compareModes("Scene buffered", true);
+
+    // The same primitives with three bytes per pixel pair
+    Crystalfontz128x128_SetColorMode(LCD_COLOR_MODE_RGB444);
+    report("SetColorMode RGB444", 0);
+
+    fxns->pfnRectFill(display, &screen, 0xF00);
+    report("444 RectFill 128x128", 128 * 128 * 3 / 2);
+
+    fxns->pfnRectFill(display, &box, 0x123);
+    report("444 RectFill 20x8", 20 * 8 * 3 / 2);
+
+    fxns->pfnLineDrawH(display, 5, 100, 64, 0x0F0);
+    report("444 LineDrawH 96", 96 * 3 / 2);
+
+    fxns->pfnLineDrawV(display, 64, 0, 126, 0x00F);
+    report("444 LineDrawV 127", 63 * 3 + 2);
+
+    fxns->pfnPixelDrawMultiple(display, 0, 10, 0, 127, 1, glyphRow, palette);
+    report("444 PixelDrawMulti 127", 63 * 3 + 2);
+
+    for (x = 40; x < 72; x++)
+    {
+        fxns->pfnPixelDraw(display, x, 4, 0xF0F);
+    }
+    report("444 PixelDraw x32", 32 * 2);
+
+    fxns->pfnClearDisplay(display, 0x000);
+    report("444 ClearDisplay", 128 * 128 * 3 / 2);
+    Crystalfontz128x128_SetColorMode(LCD_COLOR_MODE_RGB565);
+    HostLcd_reset();
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,569 @@
+/*
+ * orientation_check.c
+ *
+ * Checks the orientation engine (Orientation.c) against libm:
+ *   - Orientation_atan2() all round the circle and over a range of sizes,
+ *     for the angle and CORDIC's magnitude;
+ *   - pitch, roll and magnitude of samples of gravity from every direction
+ *     the board can face;
+ *   - a tilt down and back gives the same events on the same samples
+ *     whichever way the board is turned in its plane, and a push along
+ *     gravity on a board held leaning forward does not count as a tilt,
+ *     where thresholds on the raw Z counts do;
+ *   - a shake, hard or gentle, raises one SHAKE and no tilt, however far
+ *     the pitch swings;
+ *   - putting the board down on its back raises FLAT after the dwell and
+ *     FLAT_END on picking it up, and neither the face-up tilt it started
+ *     as nor bringing it back up through the thresholds passes the word,
+ *     while a tilt down held deep for longer than the flat dwell does not
+ *     go flat and scores when brought back;
+ *   - turning the board round in its plane raises one TURN to each quarter
+ *     after the dwell, holding it near the edge of a quarter or lying flat
+ *     turns nothing, and a tilt down does not turn it at any roll;
+ *   - the quiet band is the level band and the roll margin in counts, a
+ *     board held anywhere inside it stays quiet and sets nothing off, and
+ *     a tilt down leaves it before DOWN.
+ *
+ * Usage: orientation_check
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <Orientation.h>
+
+#define SAMPLE_HZ   100
+#define PI          3.14159265358979323846
+
+static int failures;
+static OrientationConfig config;
+
+static void check(bool ok, const char *name, const char *what)
+{
+    if (!ok)
+    {
+        printf("FAIL  %s: %s\n", name, what);
+        failures++;
+    }
+}
+
+static double degreesOf(int16_t angle)
+{
+    return angle * 360.0 / 65536.0;
+}
+
+// Distance between two angles in degrees, round the short way
+static double angleError(double a, double b)
+{
+    double d = fmod(a - b + 540.0, 360.0) - 180.0;
+    return fabs(d);
+}
+
+// The sample of g gravities, at the given pitch and roll in degrees
+static AccelSample gravity(double pitch, double roll, double g)
+{
+    double p = pitch * PI / 180.0, r = roll * PI / 180.0;
+    double oneG = config.oneG * g;
+    AccelSample s = {
+        (uint16_t) lround(config.zeroG + oneG * cos(p) * sin(r)),
+        (uint16_t) lround(config.zeroG + oneG * cos(p) * cos(r)),
+        (uint16_t) lround(config.zeroG + oneG * sin(p)),
+    };
+    return s;
+}
+
+static void checkAtan2(void)
+{
+    // Samples go in scaled up to at least a million, as a rule
+    static const double sizes[] = { 300.0, 4096.0, 1e6, 2.5e8 };
+    double worstAngle = 0, worstSize = 0;
+    unsigned s, step;
+
+    for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        for (step = 0; step < 360 * 8; step++)
+        {
+            double a = step * PI / (180 * 8);
+            int32_t x = (int32_t) lround(sizes[s] * cos(a));
+            int32_t y = (int32_t) lround(sizes[s] * sin(a));
+            int32_t magnitude;
+            double angle = degreesOf(Orientation_atan2(y, x, &magnitude));
+            double size = hypot(x, y) * 1.6467602578654548;
+            double e = angleError(angle, atan2(y, x) * 180.0 / PI);
+
+            if (sizes[s] < 1e6)
+            {
+                continue;
+            }
+            if (e > worstAngle)
+            {
+                worstAngle = e;
+            }
+            if (fabs(magnitude - size) / size > worstSize)
+            {
+                worstSize = fabs(magnitude - size) / size;
+            }
+        }
+    }
+    check(worstAngle < 0.01, "atan2", "angle off by more than 0.01 degrees");
+    check(worstSize < 0.0001, "atan2", "magnitude off by more than 0.01%");
+    printf("atan2         worst %.4f degrees, magnitude %.5f%%\n", worstAngle,
+           worstSize * 100);
+}
+
+static void checkAngles(void)
+{
+    double worstPitch = 0, worstRoll = 0, worstG = 0;
+    int pitch, roll;
+
+    for (pitch = -85; pitch <= 85; pitch += 5)
+    {
+        for (roll = -180; roll < 180; roll += 15)
+        {
+            Orientation orientation;
+            OrientationAngles angles;
+
+            Orientation_init(&orientation, &config);
+            Orientation_update(&orientation, gravity(pitch, roll, 1.0));
+            angles = Orientation_angles(&orientation);
+
+            if (angleError(degreesOf(angles.pitch), pitch) > worstPitch)
+            {
+                worstPitch = angleError(degreesOf(angles.pitch), pitch);
+            }
+            if (abs(pitch) <= 75
+                && angleError(degreesOf(angles.roll), roll) > worstRoll)
+            {
+                worstRoll = angleError(degreesOf(angles.roll), roll);
+            }
+            if (fabs(angles.magnitude - config.oneG) / config.oneG > worstG)
+            {
+                worstG = fabs(angles.magnitude - config.oneG) / config.oneG;
+            }
+        }
+    }
+    check(worstPitch < 0.1, "angles", "pitch off by more than 0.1 degrees");
+    check(worstRoll < 0.2, "angles", "roll off by more than 0.2 degrees");
+    check(worstG < 0.002, "angles", "magnitude off by more than 0.2%");
+    printf("angles        worst pitch %.3f, roll %.3f degrees, magnitude "
+           "%.3f%%\n", worstPitch, worstRoll, worstG * 100);
+}
+
+// Runs samples from a pose function through a fresh engine, recording the
+// sample each event first came on (or -1), and counting the rest
+typedef AccelSample (*Pose)(int n, double roll);
+
+typedef struct
+{
+    int first[8];
+    int count[8];
+} Events;
+
+static Events runPose(Pose pose, int samples, double roll)
+{
+    Orientation orientation;
+    Events events;
+    int n, bit;
+
+    Orientation_init(&orientation, &config);
+    for (bit = 0; bit < 8; bit++)
+    {
+        events.first[bit] = -1;
+        events.count[bit] = 0;
+    }
+    for (n = 0; n < samples; n++)
+    {
+        uint8_t e = Orientation_update(&orientation, pose(n, roll));
+
+        for (bit = 0; bit < 8; bit++)
+        {
+            if (e & (1 << bit))
+            {
+                if (events.first[bit] < 0)
+                {
+                    events.first[bit] = n;
+                }
+                events.count[bit]++;
+            }
+        }
+    }
+    return events;
+}
+
+static int eventCount(const Events *events, uint8_t event)
+{
+    int bit = 0;
+
+    while (!(event & (1 << bit)))
+    {
+        bit++;
+    }
+    return events->count[bit];
+}
+
+static int eventAt(const Events *events, uint8_t event)
+{
+    int bit = 0;
+
+    while (!(event & (1 << bit)))
+    {
+        bit++;
+    }
+    return events->first[bit];
+}
+
+// Upright for half a second, face down 45 degrees for half a second, and
+// back, sweeping in over 100 ms each way (no sample on a threshold)
+static AccelSample tiltDown(int n, double roll)
+{
+    double pitch = 0;
+
+    if (n >= 50 && n < 60)
+    {
+        pitch = -45.0 * (n - 50) / 10;
+    }
+    else if (n >= 60 && n < 110)
+    {
+        pitch = -45.0;
+    }
+    else if (n >= 110 && n < 120)
+    {
+        pitch = -45.0 * (120 - n) / 10;
+    }
+    return gravity(pitch, roll, 1.0);
+}
+
+// Leaning 15 degrees forward, with a 1.5 g push along gravity for 300 ms
+static AccelSample leanAndPush(int n, double roll)
+{
+    return gravity(-15.0, roll, (n >= 50 && n < 80) ? 1.5 : 1.0);
+}
+
+static void checkTiltAnyRoll(void)
+{
+    Events base = runPose(tiltDown, 200, 0.0);
+    bool same = true;
+    int roll, n, rawDown = 0;
+
+    check(eventCount(&base, ORIENTATION_DOWN) == 1
+          && eventCount(&base, ORIENTATION_DOWN_END) == 1, "any roll",
+          "a tilt down did not give one DOWN and one DOWN_END");
+    for (roll = -180; roll < 180; roll += 15)
+    {
+        Events events = runPose(tiltDown, 200, roll);
+
+        same &= eventAt(&events, ORIENTATION_DOWN)
+                == eventAt(&base, ORIENTATION_DOWN)
+                && eventAt(&events, ORIENTATION_DOWN_END)
+                == eventAt(&base, ORIENTATION_DOWN_END)
+                && eventCount(&events, ORIENTATION_DOWN) == 1;
+    }
+    check(same, "any roll", "the tilt depends on the roll");
+
+    // The push: the engine sees the same pitch, raw Z crosses 7000 counts
+    same = true;
+    for (roll = 0; roll < 360; roll += 45)
+    {
+        Events events = runPose(leanAndPush, 150, roll);
+
+        same &= !eventCount(&events, ORIENTATION_DOWN);
+    }
+    for (n = 0; n < 150; n++)
+    {
+        rawDown += leanAndPush(n, 0).z < 7000;
+    }
+    check(same, "any roll", "a push along gravity counted as a tilt");
+    check(rawDown > 0, "any roll", "the push did not reach raw Z's band");
+    printf("any roll      DOWN on sample %d, DOWN_END on %d at every roll; "
+           "push: %d raw Z samples past the band, no tilt\n",
+           eventAt(&base, ORIENTATION_DOWN),
+           eventAt(&base, ORIENTATION_DOWN_END), rawDown);
+}
+
+// A shake at 5 Hz for a second, between 0.2 and 1.8 g, rocking the pitch
+// 30 degrees either way
+static AccelSample shake(int n, double roll)
+{
+    if (n >= 50 && n < 150)
+    {
+        double phase = 2 * PI * 5 * (n - 50) / SAMPLE_HZ;
+
+        return gravity(-30.0 * sin(phase), roll, 1.0 + 0.8 * sin(phase));
+    }
+    return gravity(0.0, roll, 1.0);
+}
+
+// The same at half a g, which the filter shaves to less
+static AccelSample gentleShake(int n, double roll)
+{
+    if (n >= 50 && n < 150)
+    {
+        double phase = 2 * PI * 5 * (n - 50) / SAMPLE_HZ;
+
+        return gravity(-30.0 * sin(phase), roll, 1.0 + 0.45 * sin(phase));
+    }
+    return gravity(0.0, roll, 1.0);
+}
+
+// On its back for 3 s, then picked up again
+static AccelSample putDown(int n, double roll)
+{
+    return gravity((n >= 50 && n < 350) ? 88.0 : 0.0, roll, 1.0);
+}
+
+// The same, brought back up over 400 ms, through the face-up thresholds
+static AccelSample pickUp(int n, double roll)
+{
+    if (n >= 350 && n < 390)
+    {
+        return gravity(88.0 * (390 - n) / 40, roll, 1.0);
+    }
+    return putDown(n, roll);
+}
+
+// A "got it" held deep, face down 78 degrees for 3 s, swept in and back
+// over 200 ms each way
+static AccelSample deepTilt(int n, double roll)
+{
+    double pitch = 0;
+
+    if (n >= 50 && n < 70)
+    {
+        pitch = -78.0 * (n - 50) / 20;
+    }
+    else if (n >= 70 && n < 370)
+    {
+        pitch = -78.0;
+    }
+    else if (n >= 370 && n < 390)
+    {
+        pitch = -78.0 * (390 - n) / 20;
+    }
+    return gravity(pitch, roll, 1.0);
+}
+
+static void checkShakeAndFlat(void)
+{
+    Events shook = runPose(shake, 300, 0.0);
+    Events gentle = runPose(gentleShake, 300, 0.0);
+    Events lay = runPose(putDown, 500, 0.0);
+    Events picked = runPose(pickUp, 500, 0.0);
+    Events deep = runPose(deepTilt, 500, 0.0);
+
+    check(eventCount(&shook, ORIENTATION_SHAKE) == 1, "shake",
+          "not one SHAKE");
+    check(!eventCount(&shook, ORIENTATION_DOWN_END)
+          && !eventCount(&shook, ORIENTATION_UP_END), "shake",
+          "a shake scored or passed");
+    check(eventCount(&gentle, ORIENTATION_SHAKE) == 1
+          && !eventCount(&gentle, ORIENTATION_DOWN_END)
+          && !eventCount(&gentle, ORIENTATION_UP_END), "shake",
+          "a gentle shake was not one SHAKE, or scored or passed");
+
+    check(eventCount(&lay, ORIENTATION_FLAT) == 1
+          && eventAt(&lay, ORIENTATION_FLAT) == 50 + config.flatDwell - 1,
+          "flat", "FLAT not once, after the dwell");
+    check(eventCount(&lay, ORIENTATION_FLAT_END) == 1
+          && eventAt(&lay, ORIENTATION_FLAT_END) == 350, "flat",
+          "FLAT_END not once, on picking it up");
+    check(!eventCount(&lay, ORIENTATION_UP_END), "flat",
+          "putting it down passed the word");
+    check(eventCount(&picked, ORIENTATION_FLAT_END) == 1
+          && eventCount(&picked, ORIENTATION_UP)
+             == eventCount(&lay, ORIENTATION_UP)
+          && !eventCount(&picked, ORIENTATION_UP_END), "flat",
+          "picking it up through the thresholds tilted it");
+    check(!eventCount(&deep, ORIENTATION_FLAT)
+          && eventCount(&deep, ORIENTATION_DOWN) == 1
+          && eventCount(&deep, ORIENTATION_DOWN_END) == 1
+          && eventAt(&deep, ORIENTATION_DOWN_END) > 370, "flat",
+          "a tilt held deep went flat, or did not score on coming back");
+    printf("shake, flat   SHAKE on sample %d; FLAT on %d, FLAT_END on %d; "
+           "held deep: DOWN_END on %d\n",
+           eventAt(&shook, ORIENTATION_SHAKE), eventAt(&lay, ORIENTATION_FLAT),
+           eventAt(&lay, ORIENTATION_FLAT_END),
+           eventAt(&deep, ORIENTATION_DOWN_END));
+}
+
+// Roll for turn(): 0 for half a second, then to the given roll over 200 ms,
+// and held there
+static double turnRoll(int n, double roll)
+{
+    return n < 50 ? 0.0 : n < 70 ? roll * (n - 50) / 20 : roll;
+}
+
+// Turned in the screen's plane, upright
+static AccelSample turn(int n, double roll)
+{
+    return gravity(0.0, turnRoll(n, roll), 1.0);
+}
+
+// The same, lying on its back
+static AccelSample turnFlat(int n, double roll)
+{
+    return gravity(86.0, turnRoll(n, roll), 1.0);
+}
+
+// Runs a pose and returns the facing it ends in
+static uint8_t facingAfter(Pose pose, int samples, double roll)
+{
+    Orientation orientation;
+    int n;
+
+    Orientation_init(&orientation, &config);
+    for (n = 0; n < samples; n++)
+    {
+        Orientation_update(&orientation, pose(n, roll));
+    }
+    return Orientation_facing(&orientation);
+}
+
+static void checkTurns(void)
+{
+    static const struct
+    {
+        double roll;
+        uint8_t facing;
+    } cases[] = {
+        { 90.0, ORIENTATION_FACING_PLUS_X },
+        { 180.0, ORIENTATION_FACING_DOWN },
+        { -90.0, ORIENTATION_FACING_MINUS_X },
+        { 75.0, ORIENTATION_FACING_PLUS_X },
+        { 55.0, ORIENTATION_FACING_UP },     // inside the margin
+        { -40.0, ORIENTATION_FACING_UP },
+    };
+    bool ok = true;
+    unsigned i;
+    int roll, turnAt = -1;
+
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        Events events = runPose(turn, 150, cases[i].roll);
+        bool turns = cases[i].facing != ORIENTATION_FACING_UP;
+
+        if (facingAfter(turn, 150, cases[i].roll) != cases[i].facing
+            || eventCount(&events, ORIENTATION_TURN) != turns)
+        {
+            printf("    turned to %.0f degrees: facing %u, %d TURN\n",
+                   cases[i].roll, facingAfter(turn, 150, cases[i].roll),
+                   eventCount(&events, ORIENTATION_TURN));
+            ok = false;
+        }
+        if (cases[i].roll == 90.0)
+        {
+            turnAt = eventAt(&events, ORIENTATION_TURN);
+        }
+        ok &= !eventCount(&events, ORIENTATION_DOWN)
+              && !eventCount(&events, ORIENTATION_UP);
+    }
+    check(ok, "turn", "not one TURN to the right quarter");
+    check(turnAt > 50 && turnAt < 50 + 20 + config.turnDwell, "turn",
+          "TURN not within the dwell of reaching the quarter");
+
+    check(facingAfter(turnFlat, 150, 90.0) == ORIENTATION_FACING_UP, "turn",
+          "turned lying flat");
+    // Held turned from the start, the board turns before the tilt, if at all
+    // (no roll on the edge of a margin)
+    ok = true;
+    for (roll = -175; roll < 180; roll += 10)
+    {
+        Events events = runPose(tiltDown, 200, roll);
+
+        ok &= eventCount(&events, ORIENTATION_TURN) <= 1
+              && eventAt(&events, ORIENTATION_TURN) < 50;
+    }
+    check(ok, "turn", "a tilt down turned the facing");
+    printf("turn          to 90 degrees: TURN on sample %d, with a %u-sample "
+           "dwell\n", turnAt, config.turnDwell);
+}
+
+static bool inBand(AccelSample s, AccelSample low, AccelSample high)
+{
+    return s.x >= low.x && s.x <= high.x && s.y >= low.y && s.y <= high.y
+            && s.z >= low.z && s.z <= high.z;
+}
+
+// The quiet band is the level band and the roll margin in counts; a board
+// held anywhere inside it stays quiet and sets nothing off, and a tilt
+// leaves it before it counts
+static void checkQuiet(void)
+{
+    Orientation orientation;
+    AccelSample low, high, s;
+    double across = config.oneG * sin(PI / 4 - config.turnMargin * PI / 32768);
+    bool ok = true, quietWhenLeft = false;
+    int pitch, roll, n, left = -1;
+    Events events;
+
+    Orientation_init(&orientation, &config);
+    Orientation_quietBand(&orientation, &low, &high);
+    check(fabs(low.z - config.zeroG
+               - config.oneG * sin(config.tilt.downExit * PI / 32768)) <= 1
+          && fabs(high.z - config.zeroG
+                  - config.oneG * sin(config.tilt.upExit * PI / 32768)) <= 1,
+          "quiet", "Z band is not the level band");
+    check(fabs(high.x - config.zeroG - across) <= 1
+          && fabs(config.zeroG - low.x - across) <= 1 && low.y == 0
+          && high.y == UINT16_MAX, "quiet",
+          "X band is not the roll margin");
+
+    for (pitch = -10; pitch <= 30; pitch += 5)
+    {
+        for (roll = -25; roll <= 25; roll += 5)
+        {
+            s = gravity(pitch, roll, 1.0);
+            Orientation_init(&orientation, &config);
+            for (n = 0; n < 300; n++)
+            {
+                ok &= inBand(s, low, high)
+                      && !Orientation_update(&orientation, s);
+            }
+            ok &= Orientation_quiet(&orientation);
+        }
+    }
+    check(ok, "quiet", "held inside the band, not quiet");
+
+    Orientation_init(&orientation, &config);
+    for (n = 0; n < 200; n++)
+    {
+        s = tiltDown(n, 0.0);
+        if (left < 0 && !inBand(s, low, high))
+        {
+            left = n;
+            quietWhenLeft = Orientation_quiet(&orientation);
+        }
+        Orientation_update(&orientation, s);
+        if (n == 60)
+        {
+            ok = !Orientation_quiet(&orientation);
+        }
+    }
+    events = runPose(tiltDown, 200, 0.0);
+    check(quietWhenLeft && left >= 0
+          && left < eventAt(&events, ORIENTATION_DOWN), "quiet",
+          "a tilt set something off before leaving the band");
+    check(ok, "quiet", "quiet while tilted");
+    printf("quiet         Z %u..%u, X %u..%u; a tilt leaves on sample %d, "
+           "DOWN on %d\n", low.z, high.z, low.x, high.x, left,
+           eventAt(&events, ORIENTATION_DOWN));
+}
+
+int main(void)
+{
+    config = Orientation_defaultConfig(SAMPLE_HZ);
+
+    checkAtan2();
+    checkAngles();
+    checkTiltAnyRoll();
+    checkShakeAndFlat();
+    checkTurns();
+    checkQuiet();
+
+    if (failures)
+    {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
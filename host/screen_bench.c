@@ -0,0 +1,506 @@
+/*
+ * screen_bench.c
+ *
+ * Runs each of the game's screen routines (Screens.c) on the host against
+ * the St7735Emu panel model, with the graphics context bound to an
+ * instrumented copy of g_sCrystalfontz128x128_funcs that counts the calls
+ * to each primitive before passing them on to the driver.
+ * Crystalfontz128x128_BlitMono(), which the FontAtlas and the WordCache call
+ * directly, is counted through the linker (--wrap).
+ *
+ * Each routine is run in two configurations:
+ *   direct565  unbuffered, RGB565: every primitive goes straight to the panel
+ *   app        buffered, RGB444, flushed after the routine, as the firmware
+ *              runs it from applicationLoop()
+ *   game       app with the panel in partial mode over the game band, as
+ *              during a round; only the game screen's routines are run
+ *
+ * The game screen is also turned round as the board is, through
+ * Crystalfontz128x128_SetOrientation() and a flush, as followOrientation()
+ * in main.c does; unbuffered the driver cannot repaint a turned screen by
+ * itself, so those rows are only run buffered.
+ *
+ * One CSV row per configuration and routine goes to stdout: calls per
+ * primitive, CASET/RASET/RAMWR counts, command and data bytes, total SPI
+ * bytes and the time they take at LCD_SPI_CLOCK_SPEED.  The output has no
+ * timings from the host, so runs can be diffed.  With -b, each row is checked
+ * against a budget file of "config,screen,maxBytes" lines; a row over its
+ * budget is marked "over" and makes the exit status 1.
+ *
+ * Usage: screen_bench [-b budget.csv]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ti/grlib/grlib.h>
+#include <HAL/LcdDriver/Crystalfontz128x128_ST7735.h>
+#include <HAL/LcdDriver/HAL_MSP_EXP432P401R_Crystalfontz128x128_ST7735.h>
+#include <HAL/WordCache.h>
+#include "Screens.h"
+#include "Words.h"
+#include "HostFonts.h"
+#include "HostLcd.h"
+#include "St7735Emu.h"
+
+// Normally defined by HAL/Graphics.c, which needs the full grlib
+Graphics_Context g_sContext;
+
+//*****************************************************************************
+//
+// Instrumented driver table
+//
+//*****************************************************************************
+enum
+{
+    PRIM_PIXEL_DRAW,
+    PRIM_PIXEL_DRAW_MULTIPLE,
+    PRIM_LINE_DRAW_H,
+    PRIM_LINE_DRAW_V,
+    PRIM_RECT_FILL,
+    PRIM_CLEAR_DISPLAY,
+    PRIM_FLUSH,
+    PRIM_BLIT_MONO,
+    PRIMS
+};
+
+static const char *const primNames[PRIMS] = {
+    "pixelDraw", "pixelDrawMultiple", "lineDrawH", "lineDrawV", "rectFill",
+    "clearDisplay", "flush", "blitMono"
+};
+
+static uint32_t calls[PRIMS];
+
+static void Bench_pixelDraw(const Graphics_Display *display, int16_t x,
+                            int16_t y, uint16_t value)
+{
+    calls[PRIM_PIXEL_DRAW]++;
+    g_sCrystalfontz128x128_funcs.pfnPixelDraw(display, x, y, value);
+}
+
+static void Bench_pixelDrawMultiple(const Graphics_Display *display, int16_t x,
+                                    int16_t y, int16_t x0, int16_t count,
+                                    int16_t bPP, const uint8_t *data,
+                                    const uint32_t *pucPalette)
+{
+    calls[PRIM_PIXEL_DRAW_MULTIPLE]++;
+    g_sCrystalfontz128x128_funcs.pfnPixelDrawMultiple(display, x, y, x0, count,
+                                                      bPP, data, pucPalette);
+}
+
+static void Bench_lineDrawH(const Graphics_Display *display, int16_t x1,
+                            int16_t x2, int16_t y, uint16_t value)
+{
+    calls[PRIM_LINE_DRAW_H]++;
+    g_sCrystalfontz128x128_funcs.pfnLineDrawH(display, x1, x2, y, value);
+}
+
+static void Bench_lineDrawV(const Graphics_Display *display, int16_t x,
+                            int16_t y1, int16_t y2, uint16_t value)
+{
+    calls[PRIM_LINE_DRAW_V]++;
+    g_sCrystalfontz128x128_funcs.pfnLineDrawV(display, x, y1, y2, value);
+}
+
+static void Bench_rectFill(const Graphics_Display *display,
+                           const Graphics_Rectangle *rect, uint16_t value)
+{
+    calls[PRIM_RECT_FILL]++;
+    g_sCrystalfontz128x128_funcs.pfnRectFill(display, rect, value);
+}
+
+static uint32_t Bench_colorTranslate(const Graphics_Display *display,
+                                     uint32_t value)
+{
+    return g_sCrystalfontz128x128_funcs.pfnColorTranslate(display, value);
+}
+
+static void Bench_flush(const Graphics_Display *display)
+{
+    calls[PRIM_FLUSH]++;
+    g_sCrystalfontz128x128_funcs.pfnFlush(display);
+}
+
+static void Bench_clearDisplay(const Graphics_Display *display, uint16_t value)
+{
+    calls[PRIM_CLEAR_DISPLAY]++;
+    g_sCrystalfontz128x128_funcs.pfnClearDisplay(display, value);
+}
+
+static const Graphics_Display_Functions benchFuncs = {
+    Bench_pixelDraw,
+    Bench_pixelDrawMultiple,
+    Bench_lineDrawH,
+    Bench_lineDrawV,
+    Bench_rectFill,
+    Bench_colorTranslate,
+    Bench_flush,
+    Bench_clearDisplay
+};
+
+void __real_Crystalfontz128x128_BlitMono(int16_t x0, int16_t y0, int16_t x1,
+                                         int16_t y1, const uint8_t *pucBits,
+                                         uint16_t usStride,
+                                         uint16_t ulForeground,
+                                         uint16_t ulBackground);
+
+void __wrap_Crystalfontz128x128_BlitMono(int16_t x0, int16_t y0, int16_t x1,
+                                         int16_t y1, const uint8_t *pucBits,
+                                         uint16_t usStride,
+                                         uint16_t ulForeground,
+                                         uint16_t ulBackground)
+{
+    calls[PRIM_BLIT_MONO]++;
+    __real_Crystalfontz128x128_BlitMono(x0, y0, x1, y1, pucBits, usStride,
+                                        ulForeground, ulBackground);
+}
+
+//*****************************************************************************
+//
+// Scenarios.  The setup, if any, is drawn and flushed before counting starts.
+//
+//*****************************************************************************
+#define BENCH_WORD          0
+#define BENCH_OTHER_WORD    1
+#define BENCH_SCORE         10
+#define BENCH_SECONDS       59
+
+typedef struct
+{
+    const char *name;
+    void (*setup)(void);
+    void (*draw)(void);
+    bool inGame;        // drawn during a round
+    bool bufferedOnly;
+} Scenario;
+
+// Set by startConfig(): the panel is limited to the game band
+static bool partialConfig;
+
+static void drawWord(void)
+{
+    displayWord(BENCH_WORD);
+}
+
+static void drawOtherWord(void)
+{
+    displayWord(BENCH_OTHER_WORD);
+}
+
+static void drawScore(void)
+{
+    displayScore(BENCH_SCORE);
+}
+
+static void drawTime(void)
+{
+    displayTimeRemaining(BENCH_SECONDS);
+}
+
+static void drawNextSecond(void)
+{
+    displayTimeRemaining(BENCH_SECONDS - 1);
+}
+
+// Turns the display, putting the band back once upright or upside down
+static void turnTo(uint8_t orientation)
+{
+    Crystalfontz128x128_SetOrientation(orientation);
+    if (partialConfig)
+    {
+        Crystalfontz128x128_SetPartialArea(GAME_BAND_TOP, GAME_BAND_BOTTOM);
+    }
+}
+
+static void turnDown(void)
+{
+    turnTo(LCD_ORIENTATION_DOWN);
+}
+
+static void turnLeft(void)
+{
+    turnTo(LCD_ORIENTATION_LEFT);
+}
+
+static void turnUp(void)
+{
+    turnTo(LCD_ORIENTATION_UP);
+}
+
+static void drawEnd(void)
+{
+    end_game(BENCH_SCORE);
+}
+
+// In the order the game reaches them; the word is first drawn uncached, then
+// redrawn from the WordCache after another word has replaced it, and the time
+// is drawn whole after drawGame(), then one tick later.  The finished game
+// screen is then turned upside down, sideways and back upright.
+static const Scenario scenarios[] = {
+    { "drawTitle",                 NULL,          drawTitle,        false, false },
+    { "drawInstructions",          NULL,          drawInstructions, false, false },
+    { "drawGame",                  NULL,          drawGame,         true,  false },
+    { "displayWord.cold",          NULL,          drawWord,         true,  false },
+    { "displayWord.cached",        drawOtherWord, drawWord,         true,  false },
+    { "displayScore",              NULL,          drawScore,        true,  false },
+    { "displayTimeRemaining",      NULL,          drawTime,         true,  false },
+    { "displayTimeRemaining.tick", drawTime,      drawNextSecond,   true,  false },
+    { "turn.down",                 NULL,          turnDown,         true,  true },
+    { "turn.left",                 NULL,          turnLeft,         true,  true },
+    { "turn.up",                   NULL,          turnUp,           true,  true },
+    { "end_game",                  NULL,          drawEnd,          false, false },
+};
+
+#define SCENARIOS (sizeof(scenarios) / sizeof(scenarios[0]))
+
+typedef struct
+{
+    const char *name;
+    uint8_t colorMode;
+    bool buffered;
+    bool partial;       // panel limited to the game band
+} Config;
+
+static const Config configs[] = {
+    { "direct565", LCD_COLOR_MODE_RGB565, false, false },
+    { "app",       LCD_COLOR_MODE_RGB444, true,  false },
+    { "game",      LCD_COLOR_MODE_RGB444, true,  true },
+};
+
+#define CONFIGS (sizeof(configs) / sizeof(configs[0]))
+
+//*****************************************************************************
+//
+// Budgets
+//
+//*****************************************************************************
+#define MAX_BUDGETS 64
+
+typedef struct
+{
+    char config[32];
+    char screen[32];
+    uint32_t maxBytes;
+} Budget;
+
+static Budget budgets[MAX_BUDGETS];
+static int budgetCount;
+
+// Reads "config,screen,maxBytes" lines; blank lines, '#' comments and the
+// header line are skipped
+static bool loadBudgets(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    char line[128];
+    Budget budget;
+
+    if (!file)
+    {
+        perror(path);
+        return false;
+    }
+
+    while (fgets(line, sizeof(line), file))
+    {
+        if ((line[0] == '#') ||
+            (sscanf(line, " %31[^,\n],%31[^,\n],%u", budget.config,
+                    budget.screen, &budget.maxBytes) != 3))
+        {
+            continue;
+        }
+        if (budgetCount == MAX_BUDGETS)
+        {
+            fprintf(stderr, "%s: more than %d budgets\n", path, MAX_BUDGETS);
+            break;
+        }
+        budgets[budgetCount++] = budget;
+    }
+
+    fclose(file);
+    return true;
+}
+
+static const Budget *findBudget(const char *config, const char *screen)
+{
+    int i;
+
+    for (i = 0; i < budgetCount; i++)
+    {
+        if (!strcmp(budgets[i].config, config) &&
+            !strcmp(budgets[i].screen, screen))
+        {
+            return &budgets[i];
+        }
+    }
+    return NULL;
+}
+
+//*****************************************************************************
+//
+// Measurement
+//
+//*****************************************************************************
+
+// Ends the current bus frame and the primitive counts
+static St7735Emu_Stats endFrame(void)
+{
+    St7735Emu_Stats frame = St7735Emu_endFrame();
+
+    HostLcd_reset();
+    memset(calls, 0, sizeof(calls));
+    return frame;
+}
+
+// Draws routine and sends it, as applicationLoop() would
+static void drawPass(void (*routine)(void))
+{
+    routine();
+    Graphics_flushBuffer(&g_sContext);
+}
+
+// Puts the panel, the context and the caches in the state the game starts
+// in, in the configuration's mode
+static void startConfig(const Config *config)
+{
+    Crystalfontz128x128_SetNormalMode();
+    Crystalfontz128x128_SetBuffered(false);
+    partialConfig = config->partial;
+    Crystalfontz128x128_SetColorMode(config->colorMode);
+    Crystalfontz128x128_SetBuffered(config->buffered);
+
+    Graphics_setForegroundColor(&g_sContext, GRAPHICS_COLOR_RED);
+    Graphics_setBackgroundColor(&g_sContext, GRAPHICS_COLOR_WHITE);
+    GrContextFontSet(&g_sContext, &g_sFontFixed6x8);
+    WordCache_clear();
+
+    Graphics_clearDisplay(&g_sContext);
+    Graphics_flushBuffer(&g_sContext);
+    if (config->partial)
+    {
+        Crystalfontz128x128_SetPartialArea(GAME_BAND_TOP, GAME_BAND_BOTTOM);
+    }
+    endFrame();
+}
+
+static int runConfig(const Config *config)
+{
+    int over = 0;
+    unsigned s, p;
+
+    startConfig(config);
+
+    for (s = 0; s < SCENARIOS; s++)
+    {
+        const Scenario *scenario = &scenarios[s];
+        St7735Emu_Stats frame;
+        const Budget *budget;
+        uint32_t spiBytes;
+        const char *status;
+
+        if ((config->partial && !scenario->inGame) ||
+            (!config->buffered && scenario->bufferedOnly))
+        {
+            continue;
+        }
+
+        if (scenario->setup)
+        {
+            drawPass(scenario->setup);
+            endFrame();
+        }
+
+        drawPass(scenario->draw);
+        printf("%s,%s", config->name, scenario->name);
+        for (p = 0; p < PRIMS; p++)
+        {
+            printf(",%u", calls[p]);
+        }
+
+        frame = endFrame();
+        spiBytes = frame.commands + frame.dataBytes;
+        budget = findBudget(config->name, scenario->name);
+        status = !budget ? "none" :
+                 (spiBytes > budget->maxBytes) ? "over" : "ok";
+        if (budget && (spiBytes > budget->maxBytes))
+        {
+            over++;
+        }
+
+        printf(",%u,%u,%u,%u,%u,%u,%u,", frame.caset, frame.raset,
+               frame.ramwr, frame.commands, frame.dataBytes, spiBytes,
+               (uint32_t) (((uint64_t) spiBytes * 8 * 1000000 +
+                            LCD_SPI_CLOCK_SPEED / 2) / LCD_SPI_CLOCK_SPEED));
+        if (budget)
+        {
+            printf("%u", budget->maxBytes);
+        }
+        printf(",%s\n", status);
+
+        if (frame.windowOverruns || frame.partialPixels || frame.badWindows ||
+            frame.unknownCommands)
+        {
+            fprintf(stderr, "%s,%s: panel protocol errors\n", config->name,
+                    scenario->name);
+            over++;
+        }
+    }
+
+    return over;
+}
+
+int main(int argc, char *argv[])
+{
+    int arg, over = 0;
+    unsigned c, p;
+
+    for (arg = 1; arg < argc; arg++)
+    {
+        if ((strcmp(argv[arg], "-b") == 0) && (arg + 1 < argc))
+        {
+            if (!loadBudgets(argv[++arg]))
+            {
+                return 2;
+            }
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-b budget.csv]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    HostFonts_init();
+    St7735Emu_attach();
+
+    // Boot as the firmware does: masked, then with the uDMA interrupt live
+    Interrupt_disableMaster();
+    Crystalfontz128x128_StartInit();
+    while (!Crystalfontz128x128_PollInit())
+    {
+    }
+    Interrupt_enableMaster();
+    Crystalfontz128x128_SetOrientation(LCD_ORIENTATION_UP);
+
+    Graphics_initContext(&g_sContext, &g_sCrystalfontz128x128, &benchFuncs);
+    Words_initLayout();
+    FontAtlas_preload(&g_sFontFixed6x8, " 0123456789");
+
+    printf("config,screen");
+    for (p = 0; p < PRIMS; p++)
+    {
+        printf(",%s", primNames[p]);
+    }
+    printf(",caset,raset,ramwr,commandBytes,dataBytes,spiBytes,us,maxBytes,"
+           "status\n");
+
+    for (c = 0; c < CONFIGS; c++)
+    {
+        over += runConfig(&configs[c]);
+    }
+
+    if (over)
+    {
+        fprintf(stderr, "%d screen(s) over budget or malformed\n", over);
+    }
+    return over ? 1 : 0;
+}
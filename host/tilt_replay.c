@@ -0,0 +1,1143 @@
+/*
+ * tilt_replay.c
+ *
+ * Replays accelerometer traces through the round's play (Round.c: the
+ * AccelFilter, the Orientation engine and the tilt classifier, as
+ * drawAccelData() runs them) and measures how it does, so classifier
+ * variants and sample rates can be compared on numbers.
+ *
+ * With no trace given, it makes up -n random rounds at -f Hz, each a few
+ * gestures long, each gesture followed by a pause:
+ *   got        tipped face down, held, brought back: should score once
+ *   pass       tipped face up, held, brought back: should pass once
+ *   shake      shaken back and forth through the tilt thresholds
+ *   lean       leaning forward short of a tilt, with a push along gravity
+ *   flat       set down on its back for a few seconds and picked up
+ *   turn       turned a quarter or a half round, held, turned back: should
+ *              turn the display there and back
+ *   still      held upright (the start of the round)
+ * on a board held upright at a random angle, with the ADC's noise and
+ * single-sample spikes added.  A gesture's latency is from the start of the
+ * motion that should set it off - bringing the board back, or turning it -
+ * to the sample that does; anything a gesture should not set off, up to the
+ * next gesture, is a false trigger.  One CSV row per gesture goes to stdout:
+ * how many, detected, missed, false triggers, and the latency's mean, 95th
+ * percentile and worst.  With -b, it fails if a gesture's misses or false
+ * triggers, as a percentage of its count, or its 95th percentile latency is
+ * over its budget.
+ *
+ * Traces given on the command line, captures off the backchannel UART
+ * (HAL/Trace.h) or trace_decode's CSV of them, are replayed instead, each
+ * round from its start, and what the replay scores and passes is matched
+ * against what the board did, in a CSV row per trace.  The samples either
+ * side of a GAP event (the board's capture paused while its tilt window
+ * was armed, or dropping blocks) are replayed back to back, as the board's
+ * round saw them; gap_samples counts those it skipped.
+ *
+ * With -c, the made-up rounds are replayed as the firmware's window
+ * comparator wakes run them (TILT_WAKE_WINDOW in main.c): after a block
+ * that leaves the round quiet, whole blocks are slept through until a
+ * sample leaves Round_quietBand(), and that sample's block is the first
+ * replayed.  The budget is the same; what it costs shows as misses, false
+ * triggers and latency.
+ *
+ * The host's time per sample in Round_sample(), the traces a second and,
+ * with -c, the share of the samples slept through go to stderr.
+ *
+ * Usage: tilt_replay [-n traces] [-s seed] [-f sampleHz] [-m medianTaps]
+ *                    [-a alpha] [-d dwellMs] [-b budget.csv] [-x speed]
+ *                    [-w trace.csv] [-c] [-v] [trace ...]
+ *   -m, -a, -d  the classifier variant: median length, IIR alpha (of
+ *               16384) and tilt dwell; the game's by default
+ *   -b budget   gesture,maxMissedPct,maxFalsePct,maxP95Ms rows to hold the
+ *               made-up rounds to
+ *   -x speed    replay at that many times real time; 0, the default, as
+ *               fast as it goes
+ *   -w file     write the first made-up round, and what the replay did, as
+ *               trace_decode CSV
+ *   -v          describe each made-up round that fails
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <Round.h>
+#include "TraceDecoder.h"
+
+#define PI              3.14159265358979323846
+
+// Seconds a made-up round is at most, for the buffers
+#define ROUND_MAX_S     60
+
+// Replayed and recorded events further apart than this are not matched
+#define MATCH_US        1000000
+
+typedef enum
+{
+    GESTURE_STILL,
+    GESTURE_GOT,
+    GESTURE_PASS,
+    GESTURE_SHAKE,
+    GESTURE_LEAN,
+    GESTURE_FLAT,
+    GESTURE_TURN,
+    GESTURES
+} GestureKind;
+
+static const char *const gestureNames[GESTURES] = {
+    [GESTURE_STILL] = "still",
+    [GESTURE_GOT] = "got",
+    [GESTURE_PASS] = "pass",
+    [GESTURE_SHAKE] = "shake",
+    [GESTURE_LEAN] = "lean",
+    [GESTURE_FLAT] = "flat",
+    [GESTURE_TURN] = "turn",
+};
+
+// What each gesture should set off, and how many times
+static const uint8_t gestureExpects[GESTURES] = {
+    [GESTURE_GOT] = ROUND_SCORED,
+    [GESTURE_PASS] = ROUND_PASSED,
+    [GESTURE_TURN] = ROUND_TURNED,
+};
+static const int gestureExpectCount[GESTURES] = {
+    [GESTURE_GOT] = 1,
+    [GESTURE_PASS] = 1,
+    [GESTURE_TURN] = 2,     // there and back
+};
+
+typedef struct
+{
+    GestureKind kind;
+    uint32_t start;         // samples, up to the next gesture's start
+    uint32_t reference;     // the sample its latency is measured from
+} Gesture;
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t detected;
+    uint32_t missed;
+    uint32_t falseTriggers;
+
+    // Latencies of the detected, in ms
+    double *latencies;
+    uint32_t latencyCount, latencySpace;
+} GestureStats;
+
+typedef struct
+{
+    bool set;
+    double maxMissedPct, maxFalsePct, maxP95Ms;
+} Budget;
+
+// The options
+static uint32_t sampleHz = 100;
+static RoundConfig config;
+static double speed;
+static bool windowWakes, verbose;
+
+static GestureStats stats[GESTURES];
+static Budget budgets[GESTURES];
+
+// The host's time in Round_sample(), and for it all; and with -c, the
+// samples slept through
+static uint64_t replayNs, samplesReplayed, samplesSlept;
+
+static uint64_t hostClock(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t) t.tv_sec * 1000000000u + t.tv_nsec;
+}
+
+//*****************************************************************************
+//
+// Replaying.  At -x speed, samples are let through a block at a time, when
+// the clock says the block would have been read on the board.
+//
+//*****************************************************************************
+static uint64_t paceStartNs;
+
+static void paceStart(void)
+{
+    paceStartNs = hostClock();
+}
+
+static void paceTo(uint64_t us)
+{
+    uint64_t due, nowNs;
+
+    if (speed <= 0)
+    {
+        return;
+    }
+    due = paceStartNs + (uint64_t) (us * 1000.0 / speed);
+    nowNs = hostClock();
+    if (due > nowNs)
+    {
+        struct timespec wait = {
+            (time_t) ((due - nowNs) / 1000000000u),
+            (long) ((due - nowNs) % 1000000000u)
+        };
+        nanosleep(&wait, NULL);
+    }
+}
+
+static bool inQuietBand(AccelSample s, AccelSample low, AccelSample high)
+{
+    return s.x >= low.x && s.x <= high.x && s.y >= low.y && s.y <= high.y
+            && s.z >= low.z && s.z <= high.z;
+}
+
+// Runs samples[] through a fresh round, into did[]; with -c, sleeping
+// through the blocks of a quiet round that stay in its band
+static void replay(Round *round, const AccelSample *samples, uint32_t count,
+                   uint8_t *did)
+{
+    uint32_t i, block;
+    uint64_t start;
+    AccelSample low, high;
+    bool watching = false;
+
+    paceStart();
+    for (i = 0; i < count; i += block)
+    {
+        uint32_t j;
+
+        block = count - i < ACCEL_RING_BLOCK ? count - i : ACCEL_RING_BLOCK;
+        paceTo((uint64_t) (i + block) * 1000000 / sampleHz);
+
+        if (watching)
+        {
+            for (j = i; j < i + block && inQuietBand(samples[j], low, high);
+                 j++)
+            {
+            }
+            if (j == i + block)
+            {
+                memset(&did[i], 0, block);
+                samplesSlept += block;
+                continue;
+            }
+            watching = false;
+        }
+
+        start = hostClock();
+        for (j = i; j < i + block; j++)
+        {
+            did[j] = Round_sample(round, samples[j]);
+        }
+        replayNs += hostClock() - start;
+
+        if (windowWakes && Round_quiet(round))
+        {
+            Round_quietBand(round, &low, &high);
+            watching = true;
+        }
+    }
+    samplesReplayed += count;
+}
+
+//*****************************************************************************
+//
+// Made-up rounds
+//
+//*****************************************************************************
+typedef struct
+{
+    AccelSample *samples;
+    uint32_t count, space;
+
+    Gesture *gestures;
+    uint32_t gestureCount, gestureSpace;
+
+    // How the player holds the board, degrees
+    double pitch, roll;
+
+    uint32_t seed;
+} Trace;
+
+static double randomUnit(Trace *trace)
+{
+    trace->seed = trace->seed * 1103515245 + 12345;
+    return (trace->seed >> 8) / 16777216.0;
+}
+
+static double randomIn(Trace *trace, double low, double high)
+{
+    return low + (high - low) * randomUnit(trace);
+}
+
+static uint32_t samplesIn(double ms)
+{
+    uint32_t n = (uint32_t) lround(ms * sampleHz / 1000.0);
+
+    return n ? n : 1;
+}
+
+// 0 to 1, smoothly
+static double ease(double t)
+{
+    return (1.0 - cos(PI * t)) / 2.0;
+}
+
+// The sample of g gravities at the given pitch and roll in degrees, with the
+// ADC's noise, and now and then a spike on one axis
+static void emit(Trace *trace, double pitch, double roll, double g)
+{
+    const OrientationConfig *o = &config.orientation;
+    double p = pitch * PI / 180.0, r = roll * PI / 180.0;
+    double axes[ACCEL_RING_AXES] = {
+        o->oneG * g * cos(p) * sin(r),
+        o->oneG * g * cos(p) * cos(r),
+        o->oneG * g * sin(p),
+    };
+    uint16_t counts[ACCEL_RING_AXES];
+    int i;
+
+    for (i = 0; i < ACCEL_RING_AXES; i++)
+    {
+        double v = o->zeroG + axes[i]
+                   + randomIn(trace, -12, 12) + randomIn(trace, -12, 12);
+
+        v = v < 0 ? 0 : v > 16383 ? 16383 : v;
+        counts[i] = (uint16_t) lround(v);
+    }
+    if (randomUnit(trace) < 0.002)
+    {
+        i = (int) (randomUnit(trace) * ACCEL_RING_AXES);
+        counts[i] = randomUnit(trace) < 0.5 ? 0 : 16383;
+    }
+
+    if (trace->count < trace->space)
+    {
+        AccelSample s = { counts[0], counts[1], counts[2] };
+
+        trace->samples[trace->count++] = s;
+    }
+}
+
+// Held still at the given pose, swaying a little
+static void hold(Trace *trace, double ms, double pitch, double roll)
+{
+    uint32_t n = samplesIn(ms), i;
+    double sway = randomIn(trace, 0, 2 * PI);
+
+    for (i = 0; i < n; i++)
+    {
+        double t = (double) i / sampleHz;
+
+        emit(trace, pitch + 2.0 * sin(2 * PI * 0.7 * t + sway),
+             roll + 1.5 * sin(2 * PI * 0.4 * t + sway), 1.0);
+    }
+}
+
+// Moving from one pose to another over ms
+static void move(Trace *trace, double ms, double fromPitch, double toPitch,
+                 double fromRoll, double toRoll)
+{
+    uint32_t n = samplesIn(ms), i;
+
+    for (i = 0; i < n; i++)
+    {
+        double e = ease((double) (i + 1) / n);
+
+        emit(trace, fromPitch + (toPitch - fromPitch) * e,
+             fromRoll + (toRoll - fromRoll) * e, 1.0);
+    }
+}
+
+static void beginGesture(Trace *trace, GestureKind kind)
+{
+    Gesture *g;
+
+    if (trace->gestureCount == trace->gestureSpace)
+    {
+        return;
+    }
+    g = &trace->gestures[trace->gestureCount++];
+    g->kind = kind;
+    g->start = trace->count;
+    g->reference = trace->count;
+}
+
+static void markReference(Trace *trace)
+{
+    trace->gestures[trace->gestureCount - 1].reference = trace->count;
+}
+
+// Tipped to pitch and back
+static void tip(Trace *trace, double pitch)
+{
+    double base = trace->pitch, roll = trace->roll;
+
+    move(trace, randomIn(trace, 150, 400), base, pitch, roll, roll);
+    hold(trace, randomIn(trace, 250, 900), pitch, roll);
+    markReference(trace);
+    move(trace, randomIn(trace, 150, 400), pitch, base, roll, roll);
+}
+
+static void shake(Trace *trace)
+{
+    uint32_t n = samplesIn(randomIn(trace, 400, 1000)), i;
+    double hz = randomIn(trace, 3, 6);
+    double pitch = randomIn(trace, 20, 35), g = randomIn(trace, 0.5, 0.9);
+
+    for (i = 0; i < n; i++)
+    {
+        double phase = 2 * PI * hz * i / sampleHz;
+
+        emit(trace, trace->pitch - pitch * sin(phase), trace->roll,
+             1.0 + g * sin(phase));
+    }
+}
+
+static void lean(Trace *trace)
+{
+    double pitch = randomIn(trace, -17, -13);
+    uint32_t n, i, push, pushEnd;
+
+    move(trace, randomIn(trace, 200, 400), trace->pitch, pitch, trace->roll,
+         trace->roll);
+    n = samplesIn(randomIn(trace, 1000, 2000));
+    push = n / 3;
+    pushEnd = push + samplesIn(randomIn(trace, 200, 400));
+    for (i = 0; i < n; i++)
+    {
+        double g = (i >= push && i < pushEnd) ? randomIn(trace, 1.4, 1.6)
+                                              : 1.0;
+
+        emit(trace, pitch, trace->roll, g);
+    }
+    move(trace, randomIn(trace, 200, 400), pitch, trace->pitch, trace->roll,
+         trace->roll);
+}
+
+static void setDown(Trace *trace)
+{
+    double pitch = randomIn(trace, 84, 90);
+
+    move(trace, randomIn(trace, 300, 600), trace->pitch, pitch, trace->roll,
+         trace->roll);
+    hold(trace, randomIn(trace, 1800, 3000), pitch, trace->roll);
+    move(trace, randomIn(trace, 300, 600), pitch, trace->pitch, trace->roll,
+         trace->roll);
+}
+
+static void turn(Trace *trace)
+{
+    static const double quarters[] = { 90, -90, 180 };
+    double roll = trace->roll + quarters[(int) (randomUnit(trace) * 3)];
+    double ms = randomIn(trace, 300, 600);
+
+    move(trace, ms, trace->pitch, trace->pitch, trace->roll, roll);
+    hold(trace, randomIn(trace, 800, 1500), trace->pitch, roll);
+    move(trace, ms, trace->pitch, trace->pitch, roll, trace->roll);
+}
+
+// A round of random gestures, each followed by a pause
+static void makeTrace(Trace *trace, uint32_t seed)
+{
+    int gestures, i;
+
+    trace->count = 0;
+    trace->gestureCount = 0;
+    trace->seed = seed * 2654435761u + 1;
+    trace->pitch = randomIn(trace, -5, 10);
+    trace->roll = randomIn(trace, -10, 10);
+
+    beginGesture(trace, GESTURE_STILL);
+    hold(trace, randomIn(trace, 200, 600), trace->pitch, trace->roll);
+
+    gestures = 2 + (int) (randomUnit(trace) * 4);
+    for (i = 0; i < gestures; i++)
+    {
+        GestureKind kind = (GestureKind) (GESTURE_GOT + (int) (randomUnit(
+                trace) * (GESTURES - GESTURE_GOT)));
+
+        beginGesture(trace, kind);
+        switch (kind)
+        {
+        case GESTURE_GOT:
+            tip(trace, randomIn(trace, -75, -40));
+            break;
+        case GESTURE_PASS:
+            tip(trace, randomIn(trace, 50, 66));
+            break;
+        case GESTURE_SHAKE:
+            shake(trace);
+            break;
+        case GESTURE_LEAN:
+            lean(trace);
+            break;
+        case GESTURE_FLAT:
+            setDown(trace);
+            break;
+        default:
+            turn(trace);
+            break;
+        }
+        hold(trace, randomIn(trace, 400, 1000), trace->pitch, trace->roll);
+    }
+}
+
+static void addLatency(GestureStats *s, double ms)
+{
+    if (s->latencyCount == s->latencySpace)
+    {
+        s->latencySpace = s->latencySpace ? 2 * s->latencySpace : 1024;
+        s->latencies = realloc(s->latencies,
+                               s->latencySpace * sizeof(*s->latencies));
+        if (!s->latencies)
+        {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+    s->latencies[s->latencyCount++] = ms;
+}
+
+// Counts what each gesture set off; returns whether all were as they should
+static bool score(const Trace *trace, const uint8_t *did)
+{
+    uint32_t g;
+    bool good = true;
+
+    for (g = 0; g < trace->gestureCount; g++)
+    {
+        const Gesture *gesture = &trace->gestures[g];
+        uint32_t end = g + 1 < trace->gestureCount
+                ? trace->gestures[g + 1].start : trace->count;
+        GestureStats *s = &stats[gesture->kind];
+        uint8_t expects = gestureExpects[gesture->kind];
+        int seen = 0, falseTriggers = 0;
+        uint32_t i;
+
+        s->count++;
+        for (i = gesture->start; i < end; i++)
+        {
+            uint8_t wrong = did[i] & ~expects;
+
+            if (did[i] & expects)
+            {
+                if (++seen == 1)
+                {
+                    addLatency(s, (i - (double) gesture->reference) * 1000.0
+                                  / sampleHz);
+                }
+                else if (seen > gestureExpectCount[gesture->kind])
+                {
+                    falseTriggers++;
+                }
+            }
+            if (wrong && verbose)
+            {
+                printf("#     %s%s%s at %.2f s\n",
+                       (wrong & ROUND_SCORED) ? " scored" : "",
+                       (wrong & ROUND_PASSED) ? " passed" : "",
+                       (wrong & ROUND_TURNED) ? " turned" : "",
+                       (double) i / sampleHz);
+            }
+            while (wrong)
+            {
+                falseTriggers++;
+                wrong &= wrong - 1;
+            }
+        }
+
+        if (expects)
+        {
+            if (seen)
+            {
+                s->detected++;
+            }
+            else
+            {
+                s->missed++;
+            }
+        }
+        s->falseTriggers += falseTriggers;
+
+        if ((expects && !seen) || falseTriggers)
+        {
+            good = false;
+            if (verbose)
+            {
+                printf("#   %s at %.2f s: %d of %d, %d false\n",
+                       gestureNames[gesture->kind],
+                       (double) gesture->start / sampleHz, seen,
+                       gestureExpectCount[gesture->kind], falseTriggers);
+            }
+        }
+    }
+    return good;
+}
+
+// The made-up round and what the replay did with it, as trace_decode CSV
+static bool writeTrace(const char *path, const Trace *trace, const uint8_t *did)
+{
+    FILE *f = fopen(path, "w");
+    uint32_t i, scored = 0;
+    uint64_t periodUs = 1000000 / sampleHz;
+
+    if (!f)
+    {
+        return false;
+    }
+    fprintf(f, "time_us,kind,x,y,z,event,argument\n");
+    fprintf(f, "0,event,,,,round_start,0\n");
+    for (i = 0; i < trace->count; i++)
+    {
+        uint64_t us = i * periodUs;
+
+        fprintf(f, "%llu,sample,%u,%u,%u,,\n", (unsigned long long) us,
+                trace->samples[i].x, trace->samples[i].y, trace->samples[i].z);
+        if (did[i] & ROUND_SCORED)
+        {
+            scored++;
+            fprintf(f, "%llu,event,,,,scored,%u\n", (unsigned long long) us,
+                    scored > 255 ? 255 : scored);
+        }
+        if (did[i] & ROUND_PASSED)
+        {
+            fprintf(f, "%llu,event,,,,skipped,0\n", (unsigned long long) us);
+        }
+    }
+    return fclose(f) == 0;
+}
+
+static int compareDoubles(const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b;
+
+    return (x > y) - (x < y);
+}
+
+static bool loadBudgets(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    char line[128], name[32];
+    Budget budget;
+    int k;
+
+    if (!file)
+    {
+        perror(path);
+        return false;
+    }
+
+    while (fgets(line, sizeof(line), file))
+    {
+        if ((line[0] == '#') ||
+            (sscanf(line, " %31[^,\n],%lf,%lf,%lf", name,
+                    &budget.maxMissedPct, &budget.maxFalsePct,
+                    &budget.maxP95Ms) != 4))
+        {
+            continue;
+        }
+        for (k = 0; k < GESTURES && strcmp(gestureNames[k], name); k++)
+        {
+        }
+        if (k == GESTURES)
+        {
+            fprintf(stderr, "%s: no gesture %s\n", path, name);
+            continue;
+        }
+        budget.set = true;
+        budgets[k] = budget;
+    }
+
+    fclose(file);
+    return true;
+}
+
+// Whether a gesture's numbers are within its budget, saying why not if not
+static bool withinBudget(GestureKind kind, const GestureStats *s, double p95)
+{
+    const Budget *b = &budgets[kind];
+    double missedPct = s->count ? 100.0 * s->missed / s->count : 0;
+    double falsePct = s->count ? 100.0 * s->falseTriggers / s->count : 0;
+    bool within = true;
+
+    if (!b->set)
+    {
+        return true;
+    }
+    if (missedPct > b->maxMissedPct)
+    {
+        fprintf(stderr, "%s: %.1f%% missed, over %.1f%%\n", gestureNames[kind],
+                missedPct, b->maxMissedPct);
+        within = false;
+    }
+    if (falsePct > b->maxFalsePct)
+    {
+        fprintf(stderr, "%s: %.1f%% false triggers, over %.1f%%\n",
+                gestureNames[kind], falsePct, b->maxFalsePct);
+        within = false;
+    }
+    if (p95 > b->maxP95Ms)
+    {
+        fprintf(stderr, "%s: 95th percentile latency %.1f ms, over %.1f ms\n",
+                gestureNames[kind], p95, b->maxP95Ms);
+        within = false;
+    }
+    return within;
+}
+
+static int runMadeUp(uint32_t traces, uint32_t seed, const char *writePath)
+{
+    Trace trace;
+    Round round;
+    uint8_t *did;
+    uint32_t t, failed = 0, k;
+    uint64_t start = hostClock();
+    bool over = false, unwritten = false;
+    GestureStats total;
+
+    memset(&trace, 0, sizeof(trace));
+    trace.space = ROUND_MAX_S * sampleHz;
+    trace.samples = malloc(trace.space * sizeof(*trace.samples));
+    trace.gestureSpace = 64;
+    trace.gestures = malloc(trace.gestureSpace * sizeof(*trace.gestures));
+    did = malloc(trace.space);
+    if (!trace.samples || !trace.gestures || !did)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    Round_init(&round, &config);
+    for (t = 0; t < traces; t++)
+    {
+        makeTrace(&trace, seed + t);
+        Round_reset(&round);
+        replay(&round, trace.samples, trace.count, did);
+        if (!score(&trace, did))
+        {
+            failed++;
+            if (verbose)
+            {
+                printf("# trace %u (-s %u -n 1) failed\n", t, seed + t);
+            }
+        }
+        if (t == 0 && writePath && !writeTrace(writePath, &trace, did))
+        {
+            fprintf(stderr, "cannot write %s\n", writePath);
+            unwritten = true;
+        }
+    }
+
+    memset(&total, 0, sizeof(total));
+    printf("gesture,count,detected,missed,false,latency_mean_ms,"
+           "latency_p95_ms,latency_max_ms\n");
+    for (k = 0; k < GESTURES; k++)
+    {
+        GestureStats *s = &stats[k];
+        double p95 = 0;
+
+        total.count += s->count;
+        total.detected += s->detected;
+        total.missed += s->missed;
+        total.falseTriggers += s->falseTriggers;
+        if (!gestureExpects[k])
+        {
+            printf("%s,%u,,,%u,,,\n", gestureNames[k], s->count,
+                   s->falseTriggers);
+        }
+        else if (!s->latencyCount)
+        {
+            printf("%s,%u,%u,%u,%u,,,\n", gestureNames[k], s->count,
+                   s->detected, s->missed, s->falseTriggers);
+        }
+        else
+        {
+            double sum = 0;
+            uint32_t i;
+
+            qsort(s->latencies, s->latencyCount, sizeof(double),
+                  compareDoubles);
+            for (i = 0; i < s->latencyCount; i++)
+            {
+                sum += s->latencies[i];
+            }
+            p95 = s->latencies[(s->latencyCount * 95 - 1) / 100];
+            printf("%s,%u,%u,%u,%u,%.1f,%.1f,%.1f\n", gestureNames[k],
+                   s->count, s->detected, s->missed, s->falseTriggers,
+                   sum / s->latencyCount, p95,
+                   s->latencies[s->latencyCount - 1]);
+        }
+        if (!withinBudget((GestureKind) k, s, p95))
+        {
+            over = true;
+        }
+        free(s->latencies);
+    }
+    printf("total,%u,%u,%u,%u,,,\n", total.count, total.detected,
+           total.missed, total.falseTriggers);
+
+    fprintf(stderr, "%u traces, %llu samples at %u Hz: %.1f ns a sample, "
+            "%.0f traces a second; %u with a miss or a false trigger\n",
+            traces,
+            (unsigned long long) samplesReplayed, sampleHz,
+            samplesReplayed > samplesSlept
+                    ? (double) replayNs / (samplesReplayed - samplesSlept)
+                    : 0.0,
+            traces * 1e9 / (hostClock() - start + 1), failed);
+    if (windowWakes)
+    {
+        fprintf(stderr, "window comparator wakes: %.1f%% of the samples "
+                "slept through\n",
+                samplesReplayed ? 100.0 * samplesSlept / samplesReplayed : 0.0);
+    }
+
+    free(trace.samples);
+    free(trace.gestures);
+    free(did);
+    return (over || unwritten) ? 1 : 0;
+}
+
+//*****************************************************************************
+//
+// Recorded traces
+//
+//*****************************************************************************
+typedef struct
+{
+    TraceDecoded *records;
+    uint32_t count, space;
+} Recording;
+
+static bool addRecord(Recording *recording, const TraceDecoded *record)
+{
+    if (recording->count == recording->space)
+    {
+        recording->space = recording->space ? 2 * recording->space : 4096;
+        recording->records = realloc(recording->records, recording->space
+                                     * sizeof(*recording->records));
+        if (!recording->records)
+        {
+            return false;
+        }
+    }
+    recording->records[recording->count++] = *record;
+    return true;
+}
+
+// A row of trace_decode's CSV, or false if it is not one
+static bool parseRow(const char *line, TraceDecoded *record)
+{
+    unsigned long long us;
+    unsigned x, y, z, argument;
+    char name[32];
+    uint8_t e;
+
+    memset(record, 0, sizeof(*record));
+    if (sscanf(line, "%llu,sample,%u,%u,%u", &us, &x, &y, &z) == 4)
+    {
+        record->kind = TRACE_DECODED_SAMPLE;
+        record->us = us;
+        record->sample.x = x;
+        record->sample.y = y;
+        record->sample.z = z;
+        return true;
+    }
+    if (sscanf(line, "%llu,event,,,,%31[a-z_],%u", &us, name, &argument) == 3)
+    {
+        for (e = 0; e < 16; e++)
+        {
+            const char *known = TraceDecoder_eventName(e);
+
+            if (known && !strcmp(known, name))
+            {
+                record->kind = TRACE_DECODED_EVENT;
+                record->us = us;
+                record->event = e;
+                record->argument = argument;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Reads a capture, or trace_decode's CSV of one
+static bool readRecording(const char *path, Recording *recording)
+{
+    FILE *f = fopen(path, "rb");
+    char line[128];
+    TraceDecoded record;
+    bool ok = true;
+
+    if (!f)
+    {
+        return false;
+    }
+    recording->count = 0;
+    if (fgets(line, sizeof(line), f) && !strncmp(line, "time_us,", 8))
+    {
+        while (ok && fgets(line, sizeof(line), f))
+        {
+            if (parseRow(line, &record))
+            {
+                ok = addRecord(recording, &record);
+            }
+        }
+    }
+    else
+    {
+        TraceDecoder decoder;
+        int c;
+
+        rewind(f);
+        TraceDecoder_init(&decoder);
+        while (ok && (c = getc(f)) != EOF)
+        {
+            if (TraceDecoder_put(&decoder, (uint8_t) c, &record))
+            {
+                ok = addRecord(recording, &record);
+            }
+        }
+    }
+    fclose(f);
+    return ok;
+}
+
+typedef struct
+{
+    uint64_t us;
+    uint8_t what;           // ROUND_SCORED or ROUND_PASSED
+    bool matched;
+} Detection;
+
+static int runRecorded(const char *path, bool header)
+{
+    Recording recording = { NULL, 0, 0 };
+    Detection *board, *replayed;
+    uint32_t boardCount = 0, replayedCount = 0, i, j, matched = 0;
+    uint32_t samples = 0, rounds = 0, scored[2] = { 0 }, passed[2] = { 0 };
+    uint32_t gapSamples = 0;
+    double offsetSum = 0, offsetMax = 0;
+    Round round;
+    uint64_t start;
+
+    if (!readRecording(path, &recording))
+    {
+        fprintf(stderr, "cannot read %s\n", path);
+        free(recording.records);
+        return 1;
+    }
+    board = calloc(recording.count + 1, sizeof(*board));
+    replayed = calloc(recording.count + 1, sizeof(*replayed));
+    if (!board || !replayed)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    Round_init(&round, &config);
+    paceStart();
+    for (i = 0; i < recording.count; i++)
+    {
+        const TraceDecoded *r = &recording.records[i];
+
+        if (r->kind == TRACE_DECODED_EVENT)
+        {
+            if (r->event == TRACE_ROUND_START)
+            {
+                Round_reset(&round);
+                rounds++;
+            }
+            else if (r->event == TRACE_GAP)
+            {
+                gapSamples += r->argument;
+            }
+            else if (r->event == TRACE_SCORED || r->event == TRACE_SKIPPED)
+            {
+                board[boardCount].us = r->us;
+                board[boardCount].what = r->event == TRACE_SCORED
+                        ? ROUND_SCORED : ROUND_PASSED;
+                (r->event == TRACE_SCORED ? scored : passed)[0]++;
+                boardCount++;
+            }
+        }
+        else
+        {
+            uint8_t did;
+
+            paceTo(r->us - recording.records[0].us);
+            start = hostClock();
+            did = Round_sample(&round, r->sample);
+            replayNs += hostClock() - start;
+            samples++;
+            if (did & (ROUND_SCORED | ROUND_PASSED))
+            {
+                replayed[replayedCount].us = r->us;
+                replayed[replayedCount].what = did & (ROUND_SCORED
+                                                      | ROUND_PASSED);
+                (did & ROUND_SCORED ? scored : passed)[1]++;
+                replayedCount++;
+            }
+        }
+    }
+    samplesReplayed += samples;
+
+    // Each of the board's detections against the first of the replay's of
+    // the same kind near it
+    for (i = 0; i < boardCount; i++)
+    {
+        for (j = 0; j < replayedCount; j++)
+        {
+            int64_t offset = (int64_t) (replayed[j].us - board[i].us);
+
+            if (!replayed[j].matched && replayed[j].what == board[i].what
+                && offset < MATCH_US && -offset < MATCH_US)
+            {
+                double ms = offset / 1000.0;
+
+                replayed[j].matched = board[i].matched = true;
+                matched++;
+                offsetSum += ms;
+                if (fabs(ms) > fabs(offsetMax))
+                {
+                    offsetMax = ms;
+                }
+                break;
+            }
+        }
+    }
+
+    if (header)
+    {
+        printf("trace,samples,gap_samples,rounds,board_scored,board_passed,"
+               "scored,passed,matched,missing,extra,offset_mean_ms,"
+               "offset_max_ms\n");
+    }
+    printf("%s,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,", path, samples, gapSamples,
+           rounds, scored[0], passed[0], scored[1], passed[1], matched,
+           boardCount - matched, replayedCount - matched);
+    if (matched)
+    {
+        printf("%.1f,%.1f\n", offsetSum / matched, offsetMax);
+    }
+    else
+    {
+        printf(",\n");
+    }
+
+    free(recording.records);
+    free(board);
+    free(replayed);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t traces = 1000, seed = 1;
+    int medianTaps = -1, alpha = -1, dwellMs = -1;
+    const char *writePath = NULL;
+    int arg, first, result = 0;
+    uint64_t start;
+
+    for (arg = 1; arg < argc && argv[arg][0] == '-'; arg++)
+    {
+        if ((strcmp(argv[arg], "-n") == 0) && (arg + 1 < argc))
+        {
+            traces = (uint32_t) strtoul(argv[++arg], NULL, 0);
+        }
+        else if ((strcmp(argv[arg], "-s") == 0) && (arg + 1 < argc))
+        {
+            seed = (uint32_t) strtoul(argv[++arg], NULL, 0);
+        }
+        else if ((strcmp(argv[arg], "-f") == 0) && (arg + 1 < argc))
+        {
+            sampleHz = (uint32_t) strtoul(argv[++arg], NULL, 0);
+        }
+        else if ((strcmp(argv[arg], "-m") == 0) && (arg + 1 < argc))
+        {
+            medianTaps = atoi(argv[++arg]);
+        }
+        else if ((strcmp(argv[arg], "-a") == 0) && (arg + 1 < argc))
+        {
+            alpha = atoi(argv[++arg]);
+        }
+        else if ((strcmp(argv[arg], "-d") == 0) && (arg + 1 < argc))
+        {
+            dwellMs = atoi(argv[++arg]);
+        }
+        else if ((strcmp(argv[arg], "-b") == 0) && (arg + 1 < argc))
+        {
+            if (!loadBudgets(argv[++arg]))
+            {
+                return 2;
+            }
+        }
+        else if ((strcmp(argv[arg], "-x") == 0) && (arg + 1 < argc))
+        {
+            speed = atof(argv[++arg]);
+        }
+        else if ((strcmp(argv[arg], "-w") == 0) && (arg + 1 < argc))
+        {
+            writePath = argv[++arg];
+        }
+        else if (strcmp(argv[arg], "-c") == 0)
+        {
+            windowWakes = true;
+        }
+        else if (strcmp(argv[arg], "-v") == 0)
+        {
+            verbose = true;
+        }
+        else
+        {
+            break;
+        }
+    }
+    if ((arg < argc && argv[arg][0] == '-') || sampleHz < 10
+        || sampleHz > 2000
+        || (medianTaps >= 0 && (medianTaps < 1
+                                || medianTaps > ACCEL_FILTER_MEDIAN_MAX
+                                || !(medianTaps & 1)))
+        || (alpha >= 0 && (alpha < 1 || alpha > ACCEL_FILTER_ALPHA_ONE)))
+    {
+        fprintf(stderr, "usage: %s [-n traces] [-s seed] [-f sampleHz] "
+                "[-m medianTaps] [-a alpha] [-d dwellMs] [-b budget.csv] "
+                "[-x speed] [-w trace.csv] [-c] [-v] [trace ...]\n",
+                argv[0]);
+        return 2;
+    }
+
+    config = Round_defaultConfig(sampleHz);
+    if (medianTaps >= 0)
+    {
+        config.filter.medianTaps = (uint8_t) medianTaps;
+    }
+    if (alpha >= 0)
+    {
+        config.filter.alpha = (uint16_t) alpha;
+    }
+    if (dwellMs >= 0)
+    {
+        config.orientation.tilt.dwellSamples = Tilt_samplesIn(dwellMs,
+                                                              sampleHz);
+    }
+
+    if (arg == argc)
+    {
+        return runMadeUp(traces, seed, writePath);
+    }
+
+    start = hostClock();
+    for (first = arg; arg < argc; arg++)
+    {
+        result |= runRecorded(argv[arg], arg == first);
+    }
+    fprintf(stderr, "%llu samples: %.1f ns a sample, in %.1f ms\n",
+            (unsigned long long) samplesReplayed,
+            samplesReplayed ? (double) replayNs / samplesReplayed : 0.0,
+            (hostClock() - start) / 1e6);
+    return result;
+}
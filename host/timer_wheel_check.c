@@ -0,0 +1,409 @@
+/*
+ * timer_wheel_check.c
+ *
+ * Runs the TimerWheel on a simulated TIMER_A1 (HostTimerA.c) and checks that
+ * every timer's callback runs from the compare interrupt on exactly the ACLK
+ * cycle its tick starts: one-shot timers at delays either side of each
+ * level's span and past the top level, periodic timers over several turns of
+ * the wheel, cancels (including a periodic timer cancelling itself), and a
+ * few thousand timers started and cancelled at random, each against the tick
+ * it is due.  TimerWheel_nextDeadline() is checked to be the nearest expiry
+ * before every tick.  Being tickless, the wheel is also checked to take an
+ * interrupt per expiry and otherwise one per TIMER_WHEEL_MAX_SLEEP, and to
+ * catch up when its interrupt is held off.
+ *
+ * Usage: timer_wheel_check
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <HAL/TimerWheel.h>
+
+#include "HostTimerA.h"
+
+#define RANDOM_TIMERS   2000
+#define RANDOM_TICKS    (3u << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOT_BITS))
+
+static int failures;
+
+// ACLK cycle the wheel's tick 0 started on
+static uint64_t wheelStart;
+
+static uint64_t aclkOfTick(uint32_t tick)
+{
+    return wheelStart + (uint64_t) tick * TIMER_WHEEL_ACLK_PER_TICK;
+}
+
+static void startWheel(void)
+{
+    HostTimerA_reset();
+    TimerWheel_init();
+    wheelStart = HostTimerA_now();
+}
+
+//*****************************************************************************
+//
+// Timers under test.  Each records the ticks its callback ran on against
+// the ticks it was due.
+//
+//*****************************************************************************
+typedef struct
+{
+    TimerWheel_Timer timer;
+    uint32_t due;           // next tick the callback should run on
+    uint32_t period;
+    uint32_t runs;
+    uint32_t lateOrEarly;   // runs not on the due tick
+    bool cancelOnRun;
+    bool expectIdle;        // true when the callback should not run again
+} Probe;
+
+static void Probe_run(void *context)
+{
+    Probe *probe = context;
+
+    if (probe->expectIdle || (TimerWheel_now() != probe->due) ||
+        (HostTimerA_now() != aclkOfTick(probe->due)))
+    {
+        probe->lateOrEarly++;
+    }
+    probe->runs++;
+    probe->due += probe->period;
+    if (!probe->period || probe->cancelOnRun)
+    {
+        probe->expectIdle = true;
+    }
+    if (probe->cancelOnRun)
+    {
+        TimerWheel_cancel(&probe->timer);
+    }
+}
+
+// Restarts a probe; a pending timer must not be overwritten, so it is
+// cancelled first
+static void Probe_start(Probe *probe, uint32_t delay, uint32_t period)
+{
+    TimerWheel_cancel(&probe->timer);
+    probe->timer = TimerWheel_construct(Probe_run, probe);
+    probe->due = TimerWheel_now() + (delay ? delay : 1);
+    probe->period = period;
+    probe->runs = 0;
+    probe->lateOrEarly = 0;
+    probe->cancelOnRun = false;
+    probe->expectIdle = false;
+    TimerWheel_start(&probe->timer, delay, period);
+}
+
+// Runs ACLK on to the start of a tick, taking the compare interrupts on the
+// way
+static void runTo(uint32_t tick)
+{
+    HostTimerA_advanceTo(aclkOfTick(tick));
+}
+
+// Runs ACLK on n ticks, one at a time, checking before each that the next
+// deadline is the nearest due probe
+static void advance(uint32_t n, Probe *probes, int count, const char *name)
+{
+    uint32_t i;
+    int p;
+
+    for (i = 0; i < n; i++)
+    {
+        uint32_t deadline, nearest = 0;
+        bool pending = false, any = TimerWheel_nextDeadline(&deadline);
+
+        if (!count)
+        {
+            runTo(TimerWheel_now() + 1);
+            continue;
+        }
+
+        for (p = 0; p < count; p++)
+        {
+            if (TimerWheel_isPending(&probes[p].timer))
+            {
+                uint32_t ticks = probes[p].due - TimerWheel_now();
+                if (!pending || (ticks < nearest))
+                {
+                    nearest = ticks;
+                }
+                pending = true;
+            }
+        }
+
+        if ((any != pending) || (pending && (deadline != nearest)))
+        {
+            printf("FAIL  %s: tick %u: next deadline %s%u, nearest due %u\n",
+                   name, (unsigned) TimerWheel_now(), any ? "" : "none ",
+                   any ? (unsigned) deadline : 0, (unsigned) nearest);
+            failures++;
+            return;
+        }
+
+        runTo(TimerWheel_now() + 1);
+    }
+}
+
+static void check(bool ok, const char *name, const char *what)
+{
+    if (!ok)
+    {
+        printf("FAIL  %s: %s\n", name, what);
+        failures++;
+    }
+}
+
+// One-shot timers around each level boundary, started from a few phases of
+// the wheel so that every level's cascade is crossed
+static void checkOneShot(void)
+{
+    static const uint32_t delays[] = {
+        0, 1, 2, 63, 64, 65, 127, 128, 4095, 4096, 4097, 5000, 65536,
+        (1u << 18) - 1, 1u << 18, (1u << 18) + 1, 300000, 1000000
+    };
+    enum { COUNT = sizeof(delays) / sizeof(delays[0]) };
+    static const uint32_t phases[] = { 0, 1, 37, 63, 4095, 262100 };
+    static Probe probes[COUNT];
+    unsigned phase;
+    int i;
+
+    for (phase = 0; phase < sizeof(phases) / sizeof(phases[0]); phase++)
+    {
+        startWheel();
+        runTo(phases[phase]);
+
+        for (i = 0; i < COUNT; i++)
+        {
+            Probe_start(&probes[i], delays[i], 0);
+        }
+        advance(1000001, probes, COUNT, "one-shot");
+
+        for (i = 0; i < COUNT; i++)
+        {
+            if ((probes[i].runs != 1) || probes[i].lateOrEarly)
+            {
+                printf("FAIL  one-shot: delay %u from tick %u ran %u times, "
+                       "%u off its tick\n", (unsigned) delays[i],
+                       (unsigned) phases[phase], (unsigned) probes[i].runs,
+                       (unsigned) probes[i].lateOrEarly);
+                failures++;
+            }
+        }
+    }
+    printf("one-shot      %d delays from %d phases\n", COUNT,
+           (int) (sizeof(phases) / sizeof(phases[0])));
+}
+
+// The next deadline is the next expiry, not the next cascade, and counts
+// from the counter even while the wheel is behind it
+static void checkDeadline(void)
+{
+    static Probe probes[3];
+    uint32_t deadline, i;
+
+    startWheel();
+    check(!TimerWheel_nextDeadline(&deadline), "deadline",
+          "empty wheel has a deadline");
+
+    runTo(100);
+    Probe_start(&probes[0], 5, 0);
+    Probe_start(&probes[1], 17, 0);
+    Probe_start(&probes[2], 63, 0);
+    for (i = 0; i < 63; i++)
+    {
+        uint32_t nearest = (i < 5) ? 5 - i : (i < 17) ? 17 - i : 63 - i;
+
+        if (!TimerWheel_nextDeadline(&deadline) || (deadline != nearest))
+        {
+            printf("FAIL  deadline: %u ticks in: %u, expected %u\n",
+                   (unsigned) i, (unsigned) deadline, (unsigned) nearest);
+            failures++;
+            break;
+        }
+        runTo(100 + i + 1);
+    }
+    runTo(164);
+    check(!TimerWheel_nextDeadline(&deadline), "deadline",
+          "deadline left after the last timer ran");
+
+    // From tick 164, a timer 4000 ticks out waits in level 1 and is cascaded
+    // at tick 4160; the ISR does that on its way, so it is not a deadline
+    Probe_start(&probes[0], 4000, 0);
+    check(TimerWheel_nextDeadline(&deadline) && (deadline == 4000),
+          "deadline", "level 1 deadline is not its expiry");
+    TimerWheel_cancel(&probes[0].timer);
+    check(!TimerWheel_nextDeadline(&deadline), "deadline",
+          "deadline left after a cancel");
+
+    // Half a tick in, the wheel has not moved, but the counter has
+    HostTimerA_advanceTo(aclkOfTick(300) + TIMER_WHEEL_ACLK_PER_TICK / 2);
+    Probe_start(&probes[0], 10, 0);
+    check(TimerWheel_nextDeadline(&deadline) && (deadline == 10), "deadline",
+          "deadline does not count from the counter");
+    advance(11, probes, 1, "deadline");
+    check(probes[0].runs == 1 && !probes[0].lateOrEarly, "deadline",
+          "timer started mid-tick ran off its tick");
+
+    printf("deadline      exact in every level\n");
+}
+
+// Periodic timers keep their phase across cascades; one cancels itself on
+// its next run and one is cancelled from outside
+static void checkPeriodic(void)
+{
+    static Probe probes[5];
+
+    startWheel();
+    Probe_start(&probes[0], 1, 1);
+    Probe_start(&probes[1], 10, 1024);
+    Probe_start(&probes[2], 64, 64);
+    Probe_start(&probes[3], 5, 7);
+    Probe_start(&probes[4], 3, 4096);
+
+    advance(20000, probes, 5, "periodic");
+    check(probes[0].runs == 20000, "periodic", "1-tick period skipped a tick");
+    check(probes[1].runs == 20, "periodic", "1 s period ran a wrong count");
+    check(probes[2].runs == 312, "periodic", "64-tick period ran a wrong count");
+
+    probes[3].cancelOnRun = true;
+    TimerWheel_cancel(&probes[4].timer);
+    probes[4].expectIdle = true;
+    advance(10000, probes, 5, "periodic");
+    check(!TimerWheel_isPending(&probes[3].timer), "periodic",
+          "timer that cancelled itself is still pending");
+
+    for (int i = 0; i < 5; i++)
+    {
+        if (probes[i].lateOrEarly)
+        {
+            printf("FAIL  periodic: timer %d ran %u times off its tick\n", i,
+                   (unsigned) probes[i].lateOrEarly);
+            failures++;
+        }
+    }
+    printf("periodic      %u runs of the 1-tick timer\n",
+           (unsigned) probes[0].runs);
+}
+
+// The countdown's 1 s timer takes one interrupt a second, as does an empty
+// wheel; an interrupt held off for most of a counter wrap is caught up
+static void checkTickless(void)
+{
+    static Probe probes[2];
+    uint32_t interrupts;
+
+    startWheel();
+    Probe_start(&probes[0], 1024, 1024);
+    runTo(60 * 1024);
+    interrupts = TimerWheel_interruptCount();
+    check(probes[0].runs == 60 && !probes[0].lateOrEarly, "tickless",
+          "1 s timer ran a wrong count");
+    check(interrupts == 60, "tickless", "1 s timer took extra interrupts");
+
+    TimerWheel_cancel(&probes[0].timer);
+    runTo(120 * 1024);
+    check(TimerWheel_interruptCount() - interrupts == 60, "tickless",
+          "empty wheel woke other than once a sleep");
+
+    // An hour out is parked beyond the top level, and re-filed on the way
+    Probe_start(&probes[1], 3600 * 1024, 0);
+    runTo(3800 * 1024);
+    check(probes[1].runs == 1 && !probes[1].lateOrEarly, "tickless",
+          "hour timer ran off its tick");
+
+    // Held off from tick 100 to 1700 of a second: the timer due at 500 runs
+    // late, once, and the wheel is back on time after it
+    runTo(3801 * 1024 + 100);
+    Probe_start(&probes[0], 400, 0);
+    Interrupt_disableMaster();
+    runTo(3801 * 1024 + 1700);
+    Interrupt_enableMaster();
+    check(probes[0].runs == 1 && probes[0].lateOrEarly == 1, "tickless",
+          "held-off timer did not run late, once");
+    check(TimerWheel_now() == 3801 * 1024 + 1700, "tickless",
+          "wheel lost time while held off");
+    Probe_start(&probes[0], 5, 0);
+    runTo(3802 * 1024 + 1700);
+    check(probes[0].runs == 1 && !probes[0].lateOrEarly, "tickless",
+          "wheel off time after being held off");
+
+    printf("tickless      %u interrupts for a 1 s timer over 60 s\n",
+           (unsigned) interrupts);
+}
+
+// Random starts, restarts and cancels
+static void checkRandom(void)
+{
+    static Probe probes[RANDOM_TIMERS];
+    uint32_t tick, runs = 0, offTick = 0, cancels = 0;
+    int i;
+
+    srand(2564);
+    startWheel();
+    for (i = 0; i < RANDOM_TIMERS; i++)
+    {
+        probes[i].timer = TimerWheel_construct(Probe_run, &probes[i]);
+        probes[i].expectIdle = true;
+    }
+
+    for (tick = 0; tick < RANDOM_TICKS; tick++)
+    {
+        for (i = rand() % 4; i > 0; i--)
+        {
+            Probe *probe = &probes[rand() % RANDOM_TIMERS];
+
+            if (rand() % 3 == 0)
+            {
+                TimerWheel_cancel(&probe->timer);
+                probe->expectIdle = true;
+                cancels++;
+            }
+            else
+            {
+                uint32_t bits = rand() % 20;
+                uint32_t delay = (uint32_t) rand() % (1u << bits);
+                uint32_t period = (rand() % 4 == 0) ? 1 + rand() % 5000 : 0;
+
+                runs += probe->runs;
+                offTick += probe->lateOrEarly;
+                Probe_start(probe, delay, period);
+            }
+        }
+
+        // The deadline check walks every probe, so only do it now and then
+        advance(1, probes, (tick % 97) ? 0 : RANDOM_TIMERS, "random");
+    }
+
+    for (i = 0; i < RANDOM_TIMERS; i++)
+    {
+        runs += probes[i].runs;
+        offTick += probes[i].lateOrEarly;
+    }
+    if (offTick)
+    {
+        printf("FAIL  random: %u callbacks ran off their tick\n",
+               (unsigned) offTick);
+        failures++;
+    }
+    printf("random        %u callbacks, %u cancels, %u interrupts over %u "
+           "ticks\n", (unsigned) runs, (unsigned) cancels,
+           (unsigned) TimerWheel_interruptCount(), (unsigned) RANDOM_TICKS);
+}
+
+int main(void)
+{
+    checkOneShot();
+    checkDeadline();
+    checkPeriodic();
+    checkTickless();
+    checkRandom();
+
+    if (failures)
+    {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,764 @@
+/*
+ * trace_check.c
+ *
+ * Runs the trace recorder (HAL/Trace.c) against a model of the EUSCI_A0 UART
+ * sending at 115200 baud, and decodes what went out on the line with
+ * TraceDecoder.  Checks that:
+ *   - two rounds of samples, wandering slowly, jumping now and then, and
+ *     with a gap in the capture, come back exactly, each within half a
+ *     period of the time it was taken, and the events in their places, a
+ *     GAP event counting the samples the capture missed;
+ *   - with the line stopped, the ring fills, records are dropped and
+ *     counted, a LOST event says how many, and what was kept decodes;
+ *   - events recorded with the ring full are dropped, and the first to fit
+ *     after the gap goes out whole behind its SYNC, TIME, LOST and PERIOD;
+ *   - a decoder started partway through a round picks up the stream at the
+ *     next round, agreeing from there with one that saw it all;
+ *   - the UART holds the CPU out of LPM3 while bytes are going out, and
+ *     only then.
+ * Reports the bytes recorded per sample, and the host's time per
+ * Trace_sample() call.
+ *
+ * Usage: trace_check [-w capture]
+ *   -w capture  write what went out on the line in the round trip to a file,
+ *               for trace_decode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <HAL/Trace.h>
+#include <HAL/Timer.h>
+#include <HAL/Idle.h>
+#include "TraceDecoder.h"
+
+// 100 Hz, as the Sampler runs the ADC
+#define PERIOD_CYCLES       479003u
+#define PERIOD_US           (PERIOD_CYCLES / 48)
+
+// 10 bits a character
+#define BAUD                115200u
+#define CYCLES_PER_BYTE     (48000000u * 10 / BAUD)
+
+#define LINE_BYTES          (1 << 20)
+#define EXPECTED_MAX        (1 << 16)
+
+static int failures;
+static const char *capturePath;
+
+//*****************************************************************************
+//
+// The model.  A byte written to the transmit buffer goes straight to the
+// shift register if it is empty, and each character time the shift register
+// finishes a byte and takes the next from the buffer.  TXIFG is set while
+// the buffer is empty, and TXCPTIFG when a byte has gone and none follows.
+//
+//*****************************************************************************
+static uint8_t line[LINE_BYTES];
+static uint32_t lineLength;
+
+static uint8_t txByte, shiftByte;
+static bool txFull, shiftFull, completeFlag;
+static uint8_t interruptsEnabled;
+static bool masked;
+static uint8_t holds;
+
+static uint64_t now;
+
+extern void EUSCIA0_IRQHandler(void);
+
+uint64_t Clock_now()
+{
+    return now;
+}
+
+uint32_t Timer32_getValue(uint32_t timer)
+{
+    return LOADVALUE - (uint32_t) now;
+}
+
+void Idle_hold(uint8_t h)
+{
+    holds |= h;
+}
+
+void Idle_release(uint8_t h)
+{
+    holds &= ~h;
+}
+
+bool Interrupt_disableMaster(void)
+{
+    bool was = masked;
+
+    masked = true;
+    return was;
+}
+
+bool Interrupt_enableMaster(void)
+{
+    bool was = masked;
+
+    masked = false;
+    return was;
+}
+
+void Interrupt_enableInterrupt(uint32_t interruptNumber)
+{
+}
+
+void GPIO_setAsPeripheralModuleFunctionInputPin(uint_fast8_t port,
+                                                uint_fast16_t pins,
+                                                uint_fast8_t mode)
+{
+}
+
+bool UART_initModule(uint32_t moduleInstance,
+                     const eUSCI_UART_ConfigV1 *config)
+{
+    txFull = shiftFull = completeFlag = false;
+    interruptsEnabled = 0;
+    return true;
+}
+
+void UART_enableModule(uint32_t moduleInstance)
+{
+}
+
+void UART_transmitData(uint32_t moduleInstance, uint_fast8_t transmitData)
+{
+    if (txFull)
+    {
+        printf("    byte written over a full transmit buffer\n");
+        failures++;
+    }
+    if (!shiftFull)
+    {
+        shiftByte = transmitData;
+        shiftFull = true;
+    }
+    else
+    {
+        txByte = transmitData;
+        txFull = true;
+    }
+}
+
+void UART_enableInterrupt(uint32_t moduleInstance, uint_fast8_t mask)
+{
+    interruptsEnabled |= mask;
+}
+
+void UART_disableInterrupt(uint32_t moduleInstance, uint_fast8_t mask)
+{
+    interruptsEnabled &= ~mask;
+}
+
+uint_fast8_t UART_getEnabledInterruptStatus(uint32_t moduleInstance)
+{
+    uint_fast8_t status = 0;
+
+    if ((interruptsEnabled & EUSCI_A_UART_TRANSMIT_INTERRUPT) && !txFull)
+    {
+        status |= EUSCI_A_UART_TRANSMIT_INTERRUPT_FLAG;
+    }
+    if ((interruptsEnabled & EUSCI_A_UART_TRANSMIT_COMPLETE_INTERRUPT)
+        && completeFlag)
+    {
+        status |= EUSCI_A_UART_TRANSMIT_COMPLETE_INTERRUPT_FLAG;
+    }
+    return status;
+}
+
+void UART_clearInterruptFlag(uint32_t moduleInstance, uint_fast8_t mask)
+{
+    if (mask & EUSCI_A_UART_TRANSMIT_COMPLETE_INTERRUPT)
+    {
+        completeFlag = false;
+    }
+}
+
+uint_fast8_t UART_queryStatusFlags(uint32_t moduleInstance, uint_fast8_t mask)
+{
+    return (shiftFull || txFull) ? (mask & EUSCI_A_UART_BUSY) : 0;
+}
+
+// Takes the interrupt while one is pending, as the NVIC would
+static void serve(void)
+{
+    int i;
+
+    for (i = 0; i < 4 && !masked
+                && UART_getEnabledInterruptStatus(TRACE_UART_BASE); i++)
+    {
+        EUSCIA0_IRQHandler();
+    }
+}
+
+// Runs the line for the given number of character times
+static void runLine(uint32_t characters)
+{
+    while (characters--)
+    {
+        serve();
+        if (shiftFull)
+        {
+            if (lineLength < LINE_BYTES)
+            {
+                line[lineLength++] = shiftByte;
+            }
+            shiftFull = false;
+            completeFlag = !txFull;
+        }
+        if (txFull)
+        {
+            shiftByte = txByte;
+            shiftFull = true;
+            txFull = false;
+        }
+    }
+    serve();
+}
+
+// Runs the line until the ring and the UART are empty, at most a second
+static void drainLine(void)
+{
+    uint32_t limit = BAUD / 10;
+
+    while (((holds & IDLE_HOLD_UART) || shiftFull) && limit--)
+    {
+        runLine(1);
+    }
+}
+
+static void startCapture(void)
+{
+    lineLength = 0;
+    holds = 0;
+    memset(&g_traceStats, 0, sizeof(g_traceStats));
+    Trace_setEnabled(false);
+    Trace_init();
+}
+
+//*****************************************************************************
+//
+// What was recorded, to check the decoder's output against
+//
+//*****************************************************************************
+static TraceDecoded expected[EXPECTED_MAX];
+static int expectedCount;
+
+static uint32_t seed = 12345;
+
+static uint32_t randomNext(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 16;
+}
+
+static uint16_t wander(uint16_t v)
+{
+    uint32_t r = randomNext() % 100;
+    int32_t d;
+
+    if (r < 2)
+    {
+        d = (int32_t) (randomNext() % 4000) - 2000;      // a jump
+    }
+    else if (r < 10)
+    {
+        d = (int32_t) (randomNext() % 100) - 50;         // a shake
+    }
+    else
+    {
+        d = (int32_t) (randomNext() % 21) - 10;          // drifting
+    }
+    d += v;
+    return d < 0 ? 0 : d > 0x3FFF ? 0x3FFF : d;
+}
+
+static void expectEvent(uint64_t us, uint8_t event, uint8_t argument)
+{
+    TraceDecoded *e = &expected[expectedCount++];
+
+    memset(e, 0, sizeof(*e));
+    e->kind = TRACE_DECODED_EVENT;
+    e->us = us;
+    e->event = event;
+    e->argument = argument;
+}
+
+static AccelSample current = { 8192, 8192, 12000 };
+static uint64_t hostNs;
+static uint32_t hostCalls;
+
+static uint64_t hostClock(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t) t.tv_sec * 1000000000u + t.tv_nsec;
+}
+
+// Records a block of samples ending now, with an event after the samples
+// in `scoredAt` (bit i), then runs the line for the block's time if `runIt`
+static void recordBlock(uint8_t scoredAt, bool runIt)
+{
+    AccelBlock block;
+    uint64_t start;
+    int i;
+
+    block.endCycles = now;
+    block.periodCycles = PERIOD_CYCLES;
+    block.sequence = 0;
+    for (i = 0; i < ACCEL_RING_BLOCK; i++)
+    {
+        current.x = wander(current.x);
+        current.y = wander(current.y);
+        current.z = wander(current.z);
+        block.samples[i] = current;
+    }
+
+    Trace_startBlock(&block);
+    for (i = 0; i < ACCEL_RING_BLOCK; i++)
+    {
+        uint64_t us = (block.endCycles - (uint64_t) (ACCEL_RING_BLOCK - 1 - i)
+                       * PERIOD_CYCLES) / 48;
+        TraceDecoded *e = &expected[expectedCount++];
+
+        memset(e, 0, sizeof(*e));
+        e->kind = TRACE_DECODED_SAMPLE;
+        e->us = us;
+        e->sample = block.samples[i];
+
+        start = hostClock();
+        Trace_sample(block.samples[i]);
+        hostNs += hostClock() - start;
+        hostCalls++;
+
+        if (scoredAt & (1 << i))
+        {
+            Trace_event(TRACE_SCORED, i);
+            expectEvent(us, TRACE_SCORED, i);
+        }
+    }
+
+    now += (uint64_t) ACCEL_RING_BLOCK * PERIOD_CYCLES;
+    if (runIt)
+    {
+        runLine(ACCEL_RING_BLOCK * PERIOD_CYCLES / CYCLES_PER_BYTE);
+    }
+}
+
+// A round: its start, blocks with a few events, a gap, and its end
+static void recordRound(int blocks, uint8_t word)
+{
+    int b;
+
+    expectEvent(now / 48, TRACE_ROUND_START, 0);
+    Trace_eventNow(TRACE_ROUND_START, 0);
+    expectEvent(now / 48, TRACE_WORD_SHOWN, word);
+    Trace_event(TRACE_WORD_SHOWN, word);
+
+    now += PERIOD_CYCLES / 3;
+    for (b = 0; b < blocks; b++)
+    {
+        recordBlock(b % 7 == 3 ? 0x24 : 0, true);
+        if (b == blocks / 2)
+        {
+            // The main loop was held up, and the ring dropped some blocks:
+            // a GAP before the next block's first sample says how many
+            // samples
+            now += 5 * ACCEL_RING_BLOCK * PERIOD_CYCLES + 1234;
+            expectEvent((now - (ACCEL_RING_BLOCK - 1) * PERIOD_CYCLES) / 48,
+                        TRACE_GAP, 5 * ACCEL_RING_BLOCK);
+        }
+    }
+
+    expectEvent(now / 48, TRACE_ROUND_END, 42);
+    Trace_eventNow(TRACE_ROUND_END, 42);
+}
+
+static int decodeLine(uint32_t from, TraceDecoded *out, int max,
+                      TraceDecoder *decoder)
+{
+    uint32_t i;
+    int count = 0;
+
+    TraceDecoder_init(decoder);
+    for (i = from; i < lineLength; i++)
+    {
+        if (TraceDecoder_put(decoder, line[i], &out[count]) && count < max - 1)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+// Whether a decoded record is the expected one, its time within half a
+// period
+static bool matches(const TraceDecoded *d, const TraceDecoded *e)
+{
+    int64_t off = (int64_t) (d->us - e->us);
+
+    if (d->kind != e->kind || off > PERIOD_US / 2 || -off > PERIOD_US / 2)
+    {
+        return false;
+    }
+    if (d->kind == TRACE_DECODED_SAMPLE)
+    {
+        return d->sample.x == e->sample.x && d->sample.y == e->sample.y
+               && d->sample.z == e->sample.z;
+    }
+    return d->event == e->event && d->argument == e->argument;
+}
+
+static void describe(const char *what, const TraceDecoded *d)
+{
+    if (d->kind == TRACE_DECODED_SAMPLE)
+    {
+        printf("    %s: sample %u,%u,%u at %llu us\n", what, d->sample.x,
+               d->sample.y, d->sample.z, (unsigned long long) d->us);
+    }
+    else
+    {
+        printf("    %s: %s %u at %llu us\n", what,
+               TraceDecoder_eventName(d->event), d->argument,
+               (unsigned long long) d->us);
+    }
+}
+
+static TraceDecoded decoded[EXPECTED_MAX];
+static TraceDecoded partial[EXPECTED_MAX];
+
+static void checkRoundTrip(void)
+{
+    TraceDecoder decoder;
+    int count, i;
+    uint32_t bytes;
+
+    printf("Round trip\n");
+    expectedCount = 0;
+    now = 3 * 48000000ull;
+    startCapture();
+
+    recordRound(200, 7);
+    now += 48000000ull;
+    recordRound(150, 9);
+    drainLine();
+    bytes = g_traceStats.bytes;
+
+    if (holds & IDLE_HOLD_UART)
+    {
+        printf("    the UART still holds the CPU awake after the ring "
+               "emptied\n");
+        failures++;
+    }
+    if (lineLength != bytes)
+    {
+        printf("    %u bytes recorded, %u went out\n", bytes, lineLength);
+        failures++;
+    }
+    if (g_traceStats.lost)
+    {
+        printf("    %u records dropped with the line running\n",
+               g_traceStats.lost);
+        failures++;
+    }
+
+    if (capturePath)
+    {
+        FILE *f = fopen(capturePath, "wb");
+
+        if (!f || fwrite(line, 1, lineLength, f) != lineLength)
+        {
+            printf("    cannot write %s\n", capturePath);
+            failures++;
+        }
+        if (f)
+        {
+            fclose(f);
+        }
+    }
+
+    count = decodeLine(0, decoded, EXPECTED_MAX, &decoder);
+    if (count != expectedCount || decoder.stats.errors)
+    {
+        printf("    decoded %d records with %u errors, expected %d\n", count,
+               decoder.stats.errors, expectedCount);
+        failures++;
+    }
+    for (i = 0; i < count && i < expectedCount; i++)
+    {
+        if (!matches(&decoded[i], &expected[i]))
+        {
+            printf("    record %d\n", i);
+            describe("expected", &expected[i]);
+            describe("decoded", &decoded[i]);
+            failures++;
+            break;
+        }
+    }
+    printf("    %u samples and %u events in %u bytes: %.2f bytes a sample, "
+           "%.0f%% of the line\n", g_traceStats.samples, g_traceStats.events,
+           bytes, (double) bytes / g_traceStats.samples,
+           100.0 * bytes / g_traceStats.samples * CYCLES_PER_BYTE
+           / PERIOD_CYCLES);
+
+    // Partway through the first round: nothing until the second round's
+    // start, then the same as the whole stream
+    {
+        int from;
+        int partialCount = decodeLine(lineLength / 4, partial, EXPECTED_MAX,
+                                      &decoder);
+
+        for (from = 0; from < count; from++)
+        {
+            if (decoded[from].kind == TRACE_DECODED_EVENT
+                && decoded[from].event == TRACE_ROUND_END)
+            {
+                break;
+            }
+        }
+        if (partialCount != count - from)
+        {
+            printf("    from a quarter of the way: %d records, expected %d\n",
+                   partialCount, count - from);
+            failures++;
+        }
+        for (i = 0; i < partialCount && from + i < count; i++)
+        {
+            if (memcmp(&partial[i], &decoded[from + i], sizeof(partial[i])))
+            {
+                printf("    from a quarter of the way, record %d\n", i);
+                describe("expected", &decoded[from + i]);
+                describe("decoded", &partial[i]);
+                failures++;
+                break;
+            }
+        }
+        printf("    from a quarter of the way: %u bytes skipped, picked up "
+               "at the round's end\n", decoder.stats.skipped);
+    }
+}
+
+static void checkOverflow(void)
+{
+    TraceDecoder decoder;
+    int count, i, j, lostEvents = 0;
+    uint32_t lostCount = 0;
+    int b;
+
+    printf("Overflow\n");
+    expectedCount = 0;
+    now = 10 * 48000000ull;
+    startCapture();
+
+    expectEvent(now / 48, TRACE_ROUND_START, 0);
+    Trace_eventNow(TRACE_ROUND_START, 0);
+    now += PERIOD_CYCLES / 3;
+
+    // The line stopped (no one reading the backchannel) for 400 blocks
+    for (b = 0; b < 400; b++)
+    {
+        recordBlock(0, false);
+    }
+    if (!(holds & IDLE_HOLD_UART))
+    {
+        printf("    the UART does not hold the CPU awake with bytes to "
+               "send\n");
+        failures++;
+    }
+    if (!g_traceStats.lost)
+    {
+        printf("    nothing dropped with the line stopped\n");
+        failures++;
+    }
+    for (b = 0; b < 40; b++)
+    {
+        recordBlock(0, true);
+    }
+    drainLine();
+
+    count = decodeLine(0, decoded, EXPECTED_MAX, &decoder);
+
+    // What was decoded is what was recorded, less what was dropped
+    for (i = 0, j = 0; i < count; i++)
+    {
+        if (decoded[i].kind == TRACE_DECODED_EVENT
+            && decoded[i].event == TRACE_LOST)
+        {
+            lostEvents++;
+            lostCount += decoded[i].argument;
+            continue;
+        }
+        while (j < expectedCount && !matches(&decoded[i], &expected[j]))
+        {
+            j++;
+        }
+        if (j == expectedCount)
+        {
+            printf("    record %d was not recorded\n", i);
+            describe("decoded", &decoded[i]);
+            failures++;
+            break;
+        }
+        j++;
+    }
+    if (decoder.stats.errors || count != (int) (g_traceStats.samples
+                                                + g_traceStats.events
+                                                + lostEvents))
+    {
+        printf("    decoded %d records with %u errors, %u recorded\n", count,
+               decoder.stats.errors,
+               g_traceStats.samples + g_traceStats.events);
+        failures++;
+    }
+
+    // One gap, and its count saturates
+    if (lostEvents != 1 || lostCount != (g_traceStats.lost > 255
+                                         ? 255 : g_traceStats.lost))
+    {
+        printf("    %d LOST events counting %u, %u dropped\n", lostEvents,
+               lostCount, g_traceStats.lost);
+        failures++;
+    }
+    printf("    %u of %d samples kept, %u dropped, marked by %d LOST "
+           "events\n", g_traceStats.samples, 440 * ACCEL_RING_BLOCK,
+           g_traceStats.lost, lostEvents);
+}
+
+// Events with the ring full, and the first after it has room again, which
+// has the most that comes before a record ahead of it
+static void checkEventsWhileFull(void)
+{
+    TraceDecoder decoder;
+    uint32_t lostBefore;
+    uint64_t scoredUs;
+    int count, i, b;
+
+    printf("Events with the ring full\n");
+    expectedCount = 0;
+    now = 20 * 48000000ull;
+    startCapture();
+    Trace_eventNow(TRACE_ROUND_START, 0);
+    now += PERIOD_CYCLES / 3;
+
+    for (b = 0; b < 400 && !g_traceStats.lost; b++)
+    {
+        recordBlock(0, false);
+    }
+    lostBefore = g_traceStats.lost;
+    Trace_event(TRACE_SKIPPED, 0);
+    if (g_traceStats.lost != lostBefore + 1)
+    {
+        printf("    an event with the ring full was not dropped\n");
+        failures++;
+    }
+
+    // Room for a few records, then an event at the time the next sample
+    // would have had
+    runLine(2 * TRACE_EVENT_RECORD_MAX);
+    scoredUs = (now - (ACCEL_RING_BLOCK - 1) * (uint64_t) PERIOD_CYCLES) / 48;
+    lostBefore = g_traceStats.lost;
+    Trace_event(TRACE_SCORED, 17);
+    if (g_traceStats.lost != lostBefore)
+    {
+        printf("    the event after the gap was dropped with room for it\n");
+        failures++;
+    }
+    for (b = 0; b < 40; b++)
+    {
+        recordBlock(0, true);
+    }
+    drainLine();
+
+    count = decodeLine(0, decoded, EXPECTED_MAX, &decoder);
+    for (i = 0; i < count; i++)
+    {
+        if (decoded[i].kind == TRACE_DECODED_EVENT
+            && decoded[i].event == TRACE_SCORED)
+        {
+            break;
+        }
+    }
+    if (decoder.stats.errors || i == count || i == 0
+        || decoded[i - 1].kind != TRACE_DECODED_EVENT
+        || decoded[i - 1].event != TRACE_LOST)
+    {
+        printf("    %u errors decoding, %s\n", decoder.stats.errors,
+               i == count ? "the event after the gap is missing"
+                          : "the event after the gap is not behind a LOST");
+        failures++;
+    }
+    else
+    {
+        TraceDecoded scored;
+
+        memset(&scored, 0, sizeof(scored));
+        scored.kind = TRACE_DECODED_EVENT;
+        scored.us = scoredUs;
+        scored.event = TRACE_SCORED;
+        scored.argument = 17;
+        if (!matches(&decoded[i], &scored))
+        {
+            describe("expected", &scored);
+            describe("decoded", &decoded[i]);
+            failures++;
+        }
+    }
+    printf("    %u dropped, the event after the gap in %u bytes at most\n",
+           g_traceStats.lost, (unsigned) TRACE_EVENT_RECORD_MAX);
+}
+
+// The host's time per call, with the line always keeping up
+static void reportCost(void)
+{
+    int b;
+
+    expectedCount = 0;
+    hostNs = 0;
+    hostCalls = 0;
+    startCapture();
+    Trace_eventNow(TRACE_ROUND_START, 0);
+    for (b = 0; b < 4000; b++)
+    {
+        if (expectedCount > EXPECTED_MAX - 2 * ACCEL_RING_BLOCK)
+        {
+            expectedCount = 0;
+        }
+        lineLength = 0;
+        recordBlock(0, true);
+    }
+    printf("Cost\n    %.1f ns a Trace_sample() call on the host, "
+           "%u bytes at most a call\n", (double) hostNs / hostCalls,
+           (unsigned) TRACE_RECORD_MAX);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc == 3 && !strcmp(argv[1], "-w"))
+    {
+        capturePath = argv[2];
+    }
+    else if (argc != 1)
+    {
+        fprintf(stderr, "usage: %s [-w capture]\n", argv[0]);
+        return 2;
+    }
+
+    checkRoundTrip();
+    checkOverflow();
+    checkEventsWhileFull();
+    reportCost();
+
+    if (failures)
+    {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}
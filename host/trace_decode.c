@@ -0,0 +1,65 @@
+/*
+ * trace_decode.c
+ *
+ * Turns the byte stream of the accelerometer trace recorder (HAL/Trace.h),
+ * as captured off the backchannel UART, into CSV: one row per sample and per
+ * event, with its time in microseconds.  The stream may start anywhere; the
+ * decoder picks it up at the first SYNC.  A summary goes to stderr.
+ *
+ * Usage: trace_decode [capture]     (stdin if no file is given)
+ *
+ * Output: time_us,kind,x,y,z,event,argument
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "TraceDecoder.h"
+
+int main(int argc, char *argv[])
+{
+    FILE *in = stdin;
+    TraceDecoder decoder;
+    TraceDecoded decoded;
+    int c;
+
+    if (argc > 2)
+    {
+        fprintf(stderr, "usage: %s [capture]\n", argv[0]);
+        return 2;
+    }
+    if (argc == 2 && !(in = fopen(argv[1], "rb")))
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    TraceDecoder_init(&decoder);
+    printf("time_us,kind,x,y,z,event,argument\n");
+    while ((c = getc(in)) != EOF)
+    {
+        if (!TraceDecoder_put(&decoder, (uint8_t) c, &decoded))
+        {
+            continue;
+        }
+        if (decoded.kind == TRACE_DECODED_SAMPLE)
+        {
+            printf("%" PRIu64 ",sample,%u,%u,%u,,\n", decoded.us,
+                   decoded.sample.x, decoded.sample.y, decoded.sample.z);
+        }
+        else
+        {
+            printf("%" PRIu64 ",event,,,,%s,%u\n", decoded.us,
+                   TraceDecoder_eventName(decoded.event), decoded.argument);
+        }
+    }
+    if (in != stdin)
+    {
+        fclose(in);
+    }
+
+    fprintf(stderr, "%u bytes (%u skipped), %u syncs, %u samples, "
+            "%u events, %u errors\n", decoder.stats.bytes,
+            decoder.stats.skipped, decoder.stats.syncs, decoder.stats.samples,
+            decoder.stats.events, decoder.stats.errors);
+    return 0;
+}
@@ -7,22 +7,60 @@
 
 #include "Application.h"
 
-/* Graphic library context */
-Graphics_Context g_sContext;
-
-/* ADC results buffer */
-static uint16_t resultsBuffer[3];
-volatile uint8_t waitToPrint = 4;
+/* The X, Y and Z inputs, in the order each sample converts them */
+static const uint8_t accelInputs[ACCEL_RING_AXES] = {
+    ADC_INPUT_A14, ADC_INPUT_A13, ADC_INPUT_A11
+};
+
+/* Set to 1 to sleep through the samples while the round is quiet
+ * (Round_quiet()): the capture pauses, and ADC14's window comparators wake
+ * the CPU when an X or Z sample leaves Round_quietBand().  0 has every block
+ * wake it, and traces every sample of the round, for tilt_replay. */
+#ifndef TILT_WAKE_WINDOW
+#define TILT_WAKE_WINDOW 1
+#endif
+
+#if TILT_WAKE_WINDOW
+/* The conversion memories that hold X and Z */
+static uint32_t xMems = 0, zMems = 0;
+
+/* Set while the window comparators watch a quiet round; the ADC ISR clears
+ * it when a sample leaves the band */
+static volatile bool tiltWindowArmed = false;
+#endif
 /* Words to display */
 static int word_index = 0;
 
 /* Score variable */
 static int score = 0;
+#define TRACE_SCORE(s) ((uint8_t) ((s) > 255 ? 255 : (s)))
 static volatile bool initialized = false;
 /* Timer-related variables */
 #define LCD_WIDTH 128    // LCD screen width for centering text
 #define TIMER_VALUE 60   //timer value is 60 seconds
 #define CLK_FRQ 48000000 //clock frequency
+/* Accelerometer samples a second in each state; only a round reads them */
+static const uint16_t sampleRateHz[] = {
+    [Title] = 0,
+    [Instructions] = 0,
+    [Game] = 100,
+    [Results] = 0,
+    [Scores] = 0,
+};
+
+/* Every sample of a round goes through the filter and on into the
+ * orientation engine, whose tilts score and pass words (Round.h) */
+static Round gameRound;
+
+/* The display orientation for each way the board can be turned; the screen
+ * is square, so the layout is the same in all four */
+static const uint8_t lcdOrientation[4] = {
+    [ORIENTATION_FACING_UP] = LCD_ORIENTATION_UP,
+    [ORIENTATION_FACING_PLUS_X] = LCD_ORIENTATION_LEFT,
+    [ORIENTATION_FACING_DOWN] = LCD_ORIENTATION_DOWN,
+    [ORIENTATION_FACING_MINUS_X] = LCD_ORIENTATION_RIGHT,
+};
+
 /* Buzzer GPIO Pin */
 #define BUZZER_PORT GPIO_PORT_P2
 #define BUZZER_PIN GPIO_PIN7
@@ -40,9 +78,9 @@ void sleep()
     // asleep except for fractions of second here and there.
 
     TurnOn_LLG();
-    // Enters the Low Power Mode 0 - the processor is asleep and only responds to
-    // interrupts
-    PCM_gotoLPM0();
+    // Sleeps until the next interrupt, in LPM3 if only the TimerWheel and the
+    // buttons need to run and in LPM0 otherwise
+    Idle_sleep();
     TurnOff_LLG();
 }
 
@@ -50,8 +88,13 @@ int main(void)
 {
     initialize();
     HAL hal = *(HAL_construct());
+    BootProfile_mark(BOOT_HAL);
     Application app = applicationConstruct();
 
+    /* Draw the title screen now instead of after the first wake-up */
+    applicationLoop(&app, &hal);
+    BootProfile_mark(BOOT_TITLE);
+
     while (1)
     {
         sleep();  // Low-power mode
@@ -62,10 +105,12 @@ int main(void)
 
 void initialize()
 {
+    uint32_t i;
 
     /* Halting WDT and disabling master interrupts */
     MAP_WDT_A_holdTimer();
     MAP_Interrupt_disableMaster();
+    BootProfile_start();
 
     /* Set the core voltage level to VCORE1 */
     MAP_PCM_setCoreVoltageLevel(PCM_VCORE1);
@@ -81,18 +126,15 @@ void initialize()
     MAP_CS_initClockSignal(CS_SMCLK, CS_DCOCLK_SELECT, CS_CLOCK_DIVIDER_1);
     MAP_CS_initClockSignal(CS_ACLK, CS_REFOCLK_SELECT, CS_CLOCK_DIVIDER_1);
 
-    /* Initializes display */
-    Crystalfontz128x128_Init();
-    Crystalfontz128x128_SetOrientation(LCD_ORIENTATION_UP);
+    BootProfile_mark(BOOT_CLOCKS);
 
-    /* Initializes graphics context */
-    Graphics_initContext(&g_sContext, &g_sCrystalfontz128x128,
-                         &g_sCrystalfontz128x128_funcs);
-    Graphics_setForegroundColor(&g_sContext, GRAPHICS_COLOR_RED);
-    Graphics_setBackgroundColor(&g_sContext, GRAPHICS_COLOR_WHITE);
-    GrContextFontSet(&g_sContext, &g_sFontFixed6x8);
-
-    //  drawTitle();
+    /* Starts the display's power-up sequence; its delays run on the cycle
+     * counter while the rest of the hardware is set up.  The UI only uses
+     * flat colours, so 12-bit pixels lose nothing and cut flush traffic by
+     * a quarter */
+    Crystalfontz128x128_SetColorMode(LCD_COLOR_MODE_RGB444);
+    Crystalfontz128x128_StartInit();
+    BootProfile_mark(BOOT_LCD_START);
 
     /* Configures ADC input pins */
     MAP_GPIO_setAsPeripheralModuleFunctionInputPin(
@@ -105,31 +147,82 @@ void initialize()
     MAP_ADC14_initModule(ADC_CLOCKSOURCE_ADCOSC, ADC_PREDIVIDER_64,
     ADC_DIVIDER_8,
                          0);
-    MAP_ADC14_configureMultiSequenceMode(ADC_MEM0, ADC_MEM2, true);
-    MAP_ADC14_configureConversionMemory(ADC_MEM0, ADC_VREFPOS_AVCC_VREFNEG_VSS,
-    ADC_INPUT_A14,
-                                        ADC_NONDIFFERENTIAL_INPUTS);
-    MAP_ADC14_configureConversionMemory(ADC_MEM1, ADC_VREFPOS_AVCC_VREFNEG_VSS,
-    ADC_INPUT_A13,
-                                        ADC_NONDIFFERENTIAL_INPUTS);
-    MAP_ADC14_configureConversionMemory(ADC_MEM2, ADC_VREFPOS_AVCC_VREFNEG_VSS,
-    ADC_INPUT_A11,
-                                        ADC_NONDIFFERENTIAL_INPUTS);
-
-    /* Enabling ADC interrupt */
-    MAP_ADC14_enableInterrupt(ADC_INT2);
-    MAP_Interrupt_enableInterrupt(INT_ADC14);
+    /* One sequence is a block of samples, X, Y and Z each, which the uDMA
+     * copies into AccelRing in one go */
+    for (i = 0; i < ACCEL_RING_MEMS; i++)
+    {
+        MAP_ADC14_configureConversionMemory(1u << i,
+                                            ADC_VREFPOS_AVCC_VREFNEG_VSS,
+                                            accelInputs[i % ACCEL_RING_AXES],
+                                            ADC_NONDIFFERENTIAL_INPUTS);
+#if TILT_WAKE_WINDOW
+        if (i % ACCEL_RING_AXES == 0)
+            xMems |= 1u << i;
+        else if (i % ACCEL_RING_AXES == 2)
+            zMems |= 1u << i;
+#endif
+    }
 
-    /* Timer32 configuration */
-initTimer();
+#if TILT_WAKE_WINDOW
+    /* Every Z memory feeds window comparator 0 and every X memory window 1,
+     * whose interrupts are the only ones the ADC raises itself
+     * (armTiltWindow()) */
+    MAP_ADC14_enableComparatorWindow(zMems, ADC_COMP_WINDOW0);
+    MAP_ADC14_enableComparatorWindow(xMems, ADC_COMP_WINDOW1);
+    MAP_Interrupt_enableInterrupt(INT_ADC14);
+#endif
 
+    /* The sequence is converted on TIMER_A0's trigger, at the rate the
+     * current state asks for (sampleRateHz); the uDMA interrupts once a
+     * block */
+    AccelRing_init();
+    Sampler_init(ADC_MEM0, 1u << (ACCEL_RING_MEMS - 1), ACCEL_RING_AXES);
+    {
+        RoundConfig roundConfig = Round_defaultConfig(sampleRateHz[Game]);
 
-    /* Start ADC conversion */
-    MAP_ADC14_enableSampleTimer(ADC_AUTOMATIC_ITERATION);
-    MAP_ADC14_enableConversion();
-    MAP_ADC14_toggleConversionTrigger();
+        Round_init(&gameRound, &roundConfig);
+    }
+    /* Every raw sample the round sees and the game's events go out on the
+     * backchannel UART, for tuning the thresholds off-board; the samples
+     * skipped while the tilt window is armed are marked as a gap */
+    Trace_init();
+    Crystalfontz128x128_PollInit();
+    BootProfile_mark(BOOT_ADC);
+
+    /* Timer32 and TimerWheel configuration */
+    initTimer();
+    Crystalfontz128x128_PollInit();
+    BootProfile_mark(BOOT_TIMERS);
 
     initButtons();
+    Crystalfontz128x128_PollInit();
+    BootProfile_mark(BOOT_BUTTONS);
+
+    /* Whatever is left of the display's power-up */
+    while (!Crystalfontz128x128_PollInit())
+    {
+        g_bootProfile.lcdPolls++;
+    }
+    BootProfile_mark(BOOT_LCD_WAIT);
+
+    Crystalfontz128x128_SetOrientation(LCD_ORIENTATION_UP);
+
+    /* Draw off-screen; applicationLoop() flushes the changed regions */
+    Crystalfontz128x128_SetBuffered(true);
+
+    /* Initializes the graphics context shared with the HAL */
+    Graphics_initContext(&g_sContext, &g_sCrystalfontz128x128,
+                         &g_sCrystalfontz128x128_funcs);
+    Graphics_setForegroundColor(&g_sContext, GRAPHICS_COLOR_RED);
+    Graphics_setBackgroundColor(&g_sContext, GRAPHICS_COLOR_WHITE);
+    GrContextFontSet(&g_sContext, &g_sFontFixed6x8);
+
+    /* Lay out the word list and decode its glyphs now rather than on the
+     * first word change */
+    Words_initLayout();
+    FontAtlas_preload(&g_sFontFixed6x8, " 0123456789");
+    BootProfile_mark(BOOT_GRAPHICS);
+
     MAP_Interrupt_enableMaster();
 
 }
@@ -145,12 +238,13 @@ Application applicationConstruct()
 
 void initTimer()
 {
-    MAP_Timer32_initModule(TIMER32_0_BASE, TIMER32_PRESCALER_1, TIMER32_32BIT,
-    TIMER32_PERIODIC_MODE);
-    MAP_Timer32_setCount(TIMER32_0_BASE, TIMER_COUNT_VALUE); // 60-second timer (48 MHz)
-    MAP_Interrupt_enableInterrupt(INT_T32_INT1);
-    MAP_Timer32_enableInterrupt(TIMER32_0_BASE);
-    MAP_Timer32_startTimer(TIMER32_0_BASE, true);
+    /* Free-running clock for the software timers (debouncing) */
+    initSWTimerClock();
+
+    /* Callback timers (round countdown, button debouncing) on one ACLK
+     * counter, and the idle manager that sleeps until the next of them */
+    TimerWheel_init();
+    Idle_init();
 
 }
 
@@ -191,6 +285,13 @@ void applicationLoop(Application *app, HAL *hal)
     }
 
     }
+
+    /* Sample the accelerometer at the rate the state the pass left us in
+     * needs */
+    Sampler_setRate(sampleRateHz[app->state]);
+
+    /* Send whatever this pass drew to the panel in one go */
+    Graphics_flushBuffer(&g_sContext);
 }
 
 void handleResults(Application *app, HAL *hal)
@@ -198,7 +299,7 @@ void handleResults(Application *app, HAL *hal)
     if(app->printScreen)
     {
 
-           end_game();
+           end_game(score);
            app->printScreen = false;
            score = 0;
            JSBtapped();
@@ -291,22 +392,109 @@ void handleInstructions(Application *app, HAL *hal)
     }
 }
 
+#if TILT_WAKE_WINDOW
+/* Tilt-detection mode for a quiet round: the capture pauses and the window
+ * comparators are set to Round_quietBand(), with their LO and HI interrupts
+ * on, so the CPU sleeps through every sample until one leaves it.  The ISR
+ * disarms them, which resumes the capture with the sequence under way, and
+ * the round is back to a wake a block until it is quiet again.  Only these
+ * two pause and resume it, so the ring runs whenever the window is not
+ * armed. */
+static void armTiltWindow(void)
+{
+    AccelSample low, high;
+
+    Round_quietBand(&gameRound, &low, &high);
+    /* The thresholds cannot change mid-conversion (410 us).  This runs just
+     * after a block ends, between samples, so that is rare; rather than
+     * wait, the next block tries again */
+    if (!MAP_ADC14_setComparatorWindowValue(ADC_COMP_WINDOW0,
+                                            (int16_t) low.z,
+                                            (int16_t) high.z)
+        || !MAP_ADC14_setComparatorWindowValue(ADC_COMP_WINDOW1,
+                                               (int16_t) low.x,
+                                               (int16_t) high.x))
+        return;
+
+    /* Flags from the old thresholds mean nothing; one raised from here on
+     * interrupts as soon as it is enabled */
+    MAP_ADC14_clearInterruptFlag(ADC_LO_INT | ADC_HI_INT);
+    AccelRing_pause();
+    tiltWindowArmed = true;
+    MAP_ADC14_enableInterrupt(ADC_LO_INT | ADC_HI_INT);
+}
+
+/* With LO and HI masked first, the ISR cannot disarm it meanwhile */
+static void disarmTiltWindow()
+{
+    MAP_ADC14_disableInterrupt(ADC_LO_INT | ADC_HI_INT);
+    if (tiltWindowArmed)
+    {
+        tiltWindowArmed = false;
+        AccelRing_resume();
+    }
+}
+
+/* A watched sample left the quiet band: one wake, and the capture runs again
+ * from the sequence it is in */
+void ADC14_IRQHandler(void)
+{
+    uint64_t status = MAP_ADC14_getEnabledInterruptStatus();
+    MAP_ADC14_clearInterruptFlag(status);
+
+    if (status & (ADC_LO_INT | ADC_HI_INT))
+    {
+        disarmTiltWindow();
+    }
+}
+#endif
+
 void handleGame(Application *app, HAL *hal)
 {
     if (app->printScreen)
     {
         resetgameOver();
         app->printScreen = false;
-        MAP_Timer32_haltTimer(TIMER32_0_BASE);
-              MAP_Timer32_setCount(TIMER32_0_BASE, 2880000000); // 60-second timer (48 MHz)
-        MAP_Timer32_startTimer(TIMER32_0_BASE, true);
+        startCountdown(TIMER_VALUE);
+        /* Round_reset() starts the orientation engine facing up, so the
+         * display has to as well, whichever way the last round left it */
+        Crystalfontz128x128_SetOrientation(LCD_ORIENTATION_UP);
+        /* Only the band with the heading, word, score and time is scanned
+         * during a round; the blank rows around it are left undriven, which
+         * looks the same on the normally-white panel */
+        Crystalfontz128x128_SetPartialArea(GAME_BAND_TOP, GAME_BAND_BOTTOM);
         drawGame();
-        displayWord();
-                   displayScore();
+        displayWord(word_index);
+                   displayScore(score);
+        Round_reset(&gameRound);
+        Trace_eventNow(TRACE_ROUND_START, 0);
+        Trace_event(TRACE_WORD_SHOWN, word_index);
     }
 
+    /* The time only changes on the 1 Hz tick */
+    if (countdownTicked())
+        displayTimeRemaining(get_remaining_time());
+
+    /* Whatever blocks of samples came in since the last wake.  If they
+     * leave the round quiet, sleep through the next until one leaves the
+     * band; only on a block, as a crossing's own wake brings none and the
+     * round is still as quiet as it was before it */
+#if TILT_WAKE_WINDOW
+    if (drawAccelData() && !tiltWindowArmed && Round_quiet(&gameRound))
+        armTiltWindow();
+#else
     drawAccelData();
+#endif
+
     if(gameIsOver() /*|| LB1tapped()*/){
+#if TILT_WAKE_WINDOW
+        disarmTiltWindow();
+#endif
+        Trace_eventNow(TRACE_ROUND_END, TRACE_SCORE(score));
+        /* The menus do not sample the accelerometer, so they are drawn
+         * upright */
+        Crystalfontz128x128_SetOrientation(LCD_ORIENTATION_UP);
+        Crystalfontz128x128_SetNormalMode();
         app->state = Results;
         app->printScreen = true;
         resetgameOver();
@@ -315,246 +503,77 @@ void handleGame(Application *app, HAL *hal)
 
 }
 
-void drawTitle()
-{
-    Graphics_clearDisplay(&g_sContext);
-    Graphics_drawStringCentered(&g_sContext, (int8_t*) "Welcome to Charades:",
-    AUTO_STRING_LENGTH,
-                                64, 30, OPAQUE_TEXT);
-    Graphics_drawStringCentered(&g_sContext, (int8_t*) "Press BB1 to proceed.",
-    AUTO_STRING_LENGTH,
-                                64, 60, OPAQUE_TEXT);
-    Graphics_drawStringCentered(&g_sContext, (int8_t*) "Press BB2 for instr.",
-    AUTO_STRING_LENGTH,
-                                64, 90, OPAQUE_TEXT);
-}
-
-void drawInstructions()
-{
-    GrContextFontSet(&g_sContext, &g_sFontCmss12i);
-
-    Graphics_clearDisplay(&g_sContext);
-    Graphics_drawStringCentered(&g_sContext, (int8_t*) "Instructions:",
-    AUTO_STRING_LENGTH,
-                                64, 10, OPAQUE_TEXT);
-    Graphics_drawStringCentered(&g_sContext, (int8_t*) "Look up:'",
-    AUTO_STRING_LENGTH,
-                                64, 25, OPAQUE_TEXT);
-    Graphics_drawStringCentered(&g_sContext, (int8_t*) "'Charades Heads Up!'",
-    AUTO_STRING_LENGTH,
-                                64, 40, OPAQUE_TEXT);
-    Graphics_drawStringCentered(&g_sContext,
-                                (int8_t*) "Follow the instructions",
-                                AUTO_STRING_LENGTH,
-                                64, 55, OPAQUE_TEXT);
-    Graphics_drawStringCentered(&g_sContext, (int8_t*) "keeping the LCD",
-    AUTO_STRING_LENGTH,
-                                64, 70, OPAQUE_TEXT);
-    Graphics_drawStringCentered(&g_sContext, (int8_t*) "perpendicular",
-    AUTO_STRING_LENGTH,
-                                64, 85, OPAQUE_TEXT);
-    Graphics_drawStringCentered(&g_sContext, (int8_t*) "to the ground",
-    AUTO_STRING_LENGTH,
-                                64, 100, OPAQUE_TEXT);
-    GrContextFontSet(&g_sContext, &g_sFontFixed6x8);
-
-}
-
-void drawSettings()
-{
-    Graphics_clearDisplay(&g_sContext);
-    Graphics_drawStringCentered(&g_sContext, (int8_t*) "Settings:",
-    AUTO_STRING_LENGTH,
-                                64, 30, OPAQUE_TEXT);
-    Graphics_drawStringCentered(&g_sContext, (int8_t*) "Press bb1 for animals",
-        AUTO_STRING_LENGTH,
-                                    64, 60, OPAQUE_TEXT);
-    Graphics_drawStringCentered(&g_sContext, (int8_t*) "Press bb2 for objects",
-            AUTO_STRING_LENGTH,
-                                        64, 90, OPAQUE_TEXT);
-}
-
-void drawGame()
-{
-    Graphics_clearDisplay(&g_sContext);
-    Graphics_drawStringCentered(&g_sContext, (int8_t*) "Charades:",
-    AUTO_STRING_LENGTH,
-                                64, 30, OPAQUE_TEXT);
-    Graphics_drawString(&g_sContext, "Time:   s",
-       AUTO_STRING_LENGTH,
-                                   30, 110, OPAQUE_TEXT);
-    Graphics_drawString(&g_sContext, "Score: ",
-       AUTO_STRING_LENGTH,
-                                   40, 90, OPAQUE_TEXT);
-   /* Graphics_drawString(&g_sContext, "Word: ",
-       AUTO_STRING_LENGTH,
-                                   10, 50, OPAQUE_TEXT);*/
-}
-
-void displayWord()
-{
-    char word[20];
-        sprintf(word, " %s", words[word_index]);
-        GrContextFontSet(&g_sContext, &g_sFontCmss24b);
-
-        Graphics_drawStringCentered(&g_sContext, "                ",
-             AUTO_STRING_LENGTH,
-                                         65, 65, OPAQUE_TEXT);
-        Graphics_drawStringCentered(&g_sContext, (int8_t*) word,
-        AUTO_STRING_LENGTH,
-                                    65, 65, OPAQUE_TEXT);
-        GrContextFontSet(&g_sContext, &g_sFontFixed6x8);
-
-}
-
-void displayScore()
-{
-    char scoreStr[10];
-    sprintf(scoreStr, " %d", score);
-    Graphics_drawString(&g_sContext, "        ",
-    AUTO_STRING_LENGTH,
-                                75, 90, OPAQUE_TEXT);
-    Graphics_drawString(&g_sContext, (int8_t*) scoreStr,
-    AUTO_STRING_LENGTH,
-                                75, 90, OPAQUE_TEXT);
-}
-
 void next_word()
 {
-    word_index = rand() % 30;
-}
-int get_remaining_time()
-{
-    int time = MAP_Timer32_getValue(TIMER32_0_BASE);
-    int time_remaining = time / 48000000;
-    return time_remaining;
+    word_index = rand() % WORD_COUNT;
 }
 
-void end_game()
+/* Turns the display to face the way the board is held.  It is one MADCTL
+ * write, and the next flush only sends the tiles that come out different */
+void followOrientation(uint8_t facing)
 {
-    char final_score[30];
-    Graphics_clearDisplay(&g_sContext);
-    sprintf(final_score, "Your final score: %d ", score);
-    Graphics_drawStringCentered(&g_sContext, (int8_t*) final_score,
-    AUTO_STRING_LENGTH,
-                                64, 50, OPAQUE_TEXT);
-    Graphics_drawStringCentered(&g_sContext, "Press JSB to return.",
-     AUTO_STRING_LENGTH,
-                                 64, 90, OPAQUE_TEXT);
+    if (lcdOrientation[facing] == Lcd_Orientation)
+        return;
 
+    Crystalfontz128x128_SetOrientation(lcdOrientation[facing]);
+    /* Sideways the band would be a column strip, so the driver went back to
+     * normal mode; upright or upside down it comes back */
+    Crystalfontz128x128_SetPartialArea(GAME_BAND_TOP, GAME_BAND_BOTTOM);
 }
 
-void displayTimeRemaining()
+/* Runs the blocks that came in through the round, and draws what it did.
+ * Returns whether there were any. */
+bool drawAccelData()
 {
-    char timeStr[10];
-    uint32_t timer_value = MAP_Timer32_getValue(TIMER32_0_BASE);
-    uint32_t remaining_time = timer_value / 48000000;
-    sprintf(timeStr, "%d", remaining_time);
- /*   Graphics_drawStringCentered(&g_sContext, "  ",
-    AUTO_STRING_LENGTH,
-                                70, 110, OPAQUE_TEXT);*/
-    if(remaining_time == 9)
-    {
-       Graphics_drawString(&g_sContext, "  ",
-      AUTO_STRING_LENGTH,
-                                  64, 110, OPAQUE_TEXT);
-    }
-
-    Graphics_drawString(&g_sContext, (int8_t*) timeStr,
-     AUTO_STRING_LENGTH,
-                                 64, 110, OPAQUE_TEXT);
-}
+    AccelBlock block;
+    bool sampled = false, changed = false, turned = false;
+    int i;
 
-void drawAccelData()
-{
-    switch (my_state)
+    while (AccelRing_read(&block))
     {
-    case NORMAL:
-        //MAP_Timer32_startTimer(TIMER32_0_BASE, true);
-//        if (get_remaining_time() == 0)
-//        {
-//            Graphics_clearDisplay(&g_sContext);
-//           // end_game();
-//        }
-
-
-     //   displayWord();
-      //  displayScore();
-        waitToPrint = (waitToPrint + 1 % 5);
-
-        if(waitToPrint == 0)
-        displayTimeRemaining();  // Display the remaining time
-
-        if (resultsBuffer[2] < 7000)
+        sampled = true;
+        Trace_startBlock(&block);
+        for (i = 0; i < ACCEL_RING_BLOCK; i++)
         {
-           // Graphics_clearDisplay(&g_sContext);
-           // next_word();
-            my_state = DOWN;
-           // displayWord();
-           // displayScore();
-
-
-        }
-        else if (resultsBuffer[2] > 10500)
-        {
-          //  Graphics_clearDisplay(&g_sContext);
-            //next_word();
-            my_state = UP;
-           // displayWord();
-           // displayScore();
-
-        }
-        break;
-    case DOWN:
-        waitToPrint = (waitToPrint + 1 % 5);
-        if(waitToPrint == 0)
-                displayTimeRemaining();  // Display the remaining time      //  displayWord();
-      //  displayScore();
-        if (resultsBuffer[2] > 7500)
-        {
-            score++;
-
-            my_state = NORMAL;
-            next_word();
-
-           displayWord();
-           displayScore();
-
-
-        }
-        // my_state = NORMAL;
-        break;
-    case UP:
-        waitToPrint = (waitToPrint + 1 % 5);
-
-        if(waitToPrint == 0)
-                displayTimeRemaining();  // Display the remaining time
-        if (resultsBuffer[2] < 10000)
-        {
-            next_word();
-            displayWord();
-           displayScore();
-            my_state = NORMAL;
+            uint8_t did;
 
+            /* Raw, so a replay can run its own filter */
+            Trace_sample(block.samples[i]);
+            did = Round_sample(&gameRound, block.samples[i]);
 
+            if (did & ROUND_SCORED)
+            {
+                score++;
+                Trace_event(TRACE_SCORED, TRACE_SCORE(score));
+            }
+            if (did & ROUND_PASSED)
+            {
+                Trace_event(TRACE_SKIPPED, 0);
+            }
+            if (did & (ROUND_SCORED | ROUND_PASSED))
+            {
+                next_word();
+                Trace_event(TRACE_WORD_SHOWN, word_index);
+                changed = true;
+            }
+            if (did & ROUND_TURNED)
+            {
+                turned = true;
+            }
         }
-        break;
     }
-}
-
-
 
-void ADC14_IRQHandler(void)
-{
-    uint64_t status = MAP_ADC14_getEnabledInterruptStatus();
-    MAP_ADC14_clearInterruptFlag(status);
-
-    if (status & ADC_INT2)
+    if (turned)
     {
-        resultsBuffer[0] = ADC14_getResult(ADC_MEM0);
-        resultsBuffer[1] = ADC14_getResult(ADC_MEM1);
-        resultsBuffer[2] = ADC14_getResult(ADC_MEM2);
+        followOrientation(Round_facing(&gameRound));
+    }
 
+    /* Drawn once, however many words went by in the blocks */
+    if (changed)
+    {
+        displayWord(word_index);
+        displayScore(score);
     }
+    return sampled;
 }
 